@@ -0,0 +1,65 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+typedef void (*BenchFunction)(uint32_t iterations);
+
+// Heap use since the last reset, counted by the allocator hooks in
+// bench_alloc.cpp (operator new/delete, and malloc/calloc/realloc on glibc)
+struct BenchAllocStats {
+    uint64_t allocations;
+    uint64_t bytes;
+};
+
+class BenchAlloc {
+public:
+    static void reset();
+    static BenchAllocStats read();
+};
+
+// One benchmark's figures, per iteration
+struct BenchResult {
+    const char* name;
+    uint32_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+// Minimal benchmark registry for the native_bench environment
+// Benchmarks register themselves at static-init time through BENCHMARK()
+// and bench_main.cpp runs them, optionally filtered by name. Time and heap
+// use are measured over the whole function; one that needs setup calls
+// benchStart() once it is done, so only the loop counts.
+class BenchRegistry {
+public:
+    static const int MAX_BENCHMARKS = 64;
+
+    static void add(const char* name, BenchFunction function, uint32_t iterations);
+    static int runAll(const char* filter, BenchResult* results, int capacity);
+    static void restartMeasurement();
+};
+
+inline void benchStart() {
+    BenchRegistry::restartMeasurement();
+}
+
+struct BenchRegistrar {
+    BenchRegistrar(const char* name, BenchFunction function, uint32_t iterations) {
+        BenchRegistry::add(name, function, iterations);
+    }
+};
+
+// Keeps the optimiser from discarding a computed value
+template <typename T>
+inline void benchKeep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#define BENCHMARK(name, count) \
+    static void name(uint32_t iterations); \
+    static BenchRegistrar name##Registrar(#name, name, count); \
+    static void name(uint32_t iterations)
+
+#endif // BENCH_H
@@ -0,0 +1,119 @@
+#include "bench.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Interposed allocator: every heap allocation in the benchmark binary goes
+// through these, so a hot path that allocates shows up as allocations/op
+// however deeply the allocation is buried (std::string inside String,
+// std::to_string, a container growing). Frees are not counted; bytes are
+// what was asked for, not what the allocator rounded up to.
+
+static std::atomic<uint64_t> allocations(0);
+static std::atomic<uint64_t> allocatedBytes(0);
+
+static inline void countAllocation(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void BenchAlloc::reset() {
+    allocations.store(0, std::memory_order_relaxed);
+    allocatedBytes.store(0, std::memory_order_relaxed);
+}
+
+BenchAllocStats BenchAlloc::read() {
+    BenchAllocStats stats;
+    stats.allocations = allocations.load(std::memory_order_relaxed);
+    stats.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+#if defined(__GLIBC__)
+// glibc exports its allocator under these names, so malloc() itself can be
+// replaced and C code (snprintf's own buffers, strdup) is counted as well.
+// operator new then reaches the counters through malloc.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void __libc_free(void* pointer);
+
+void* malloc(size_t size) {
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) {
+    __libc_free(pointer);
+}
+}
+
+static inline void* allocate(size_t size) {
+    void* pointer = malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+#else
+// Elsewhere only C++ allocations are seen
+static inline void* allocate(size_t size) {
+    countAllocation(size);
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+#endif
+
+void* operator new(size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](size_t size) {
+    return allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
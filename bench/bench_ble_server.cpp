@@ -0,0 +1,69 @@
+#include "bench.h"
+#include "ble_server.h"
+#include "temperature_units.h"
+#include "scheduler.h"
+#include "logger.h"
+#include "sim_ble.h"
+
+// Characteristic updates for one reading against the fake NimBLE stack:
+// the three legacy values plus the encoded packed payload. The fake keeps
+// each value in a std::string, so heap use here is the fake's as much as
+// ours; once the strings have grown it should be zero.
+
+static void startServer() {
+    Serial.setEnabled(false);
+    Logger::reset();
+    Scheduler::reset();
+    NativeClock::set(0);
+    SimBLE::reset();
+    BLEServerManager::init();
+}
+
+BENCHMARK(ble_update_temperature, 5000000) {
+    startServer();
+    TemperatureReading reading = { 0, 0, 2250, 2500, 1800, CELSIUS };
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        reading.sequence = i;
+        reading.current = (int16_t)(1800 + (i & 0x1FF));
+        BLEServerManager::updateTemperature(reading);
+    }
+    benchKeep(SimBLE::getSetValueCount());
+    Serial.setEnabled(true);
+}
+
+// Update plus notify to one central subscribed to every temperature value
+BENCHMARK(ble_update_and_notify, 2000000) {
+    startServer();
+    uint16_t central = SimBLE::connect(247);
+    SimBLE::subscribe(central, TEMPERATURE_CHAR_UUID);
+    SimBLE::subscribe(central, TEMP_MAX_CHAR_UUID);
+    SimBLE::subscribe(central, TEMP_MIN_CHAR_UUID);
+    SimBLE::subscribe(central, TEMP_PACKED_CHAR_UUID);
+    TemperatureReading reading = { 0, 0, 2250, 2500, 1800, CELSIUS };
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        // Keep the notify budget topped up so every pass sends
+        NativeClock::advance(1000);
+        reading.sequence = i;
+        reading.current = (int16_t)(1800 + (i & 0x1FF));
+        BLEServerManager::updateTemperature(reading);
+        BLEServerManager::notifyTemperature();
+    }
+    benchKeep(SimBLE::getNotifyCount());
+    SimBLE::disconnect(central);
+    Serial.setEnabled(true);
+}
+
+// Time to advertise: building the GATT database and starting advertising,
+// from a stack torn down by the previous pass
+BENCHMARK(ble_server_init, 20000) {
+    startServer();
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        SimBLE::reset();
+        BLEServerManager::init();
+    }
+    benchKeep(SimBLE::getAdvertisingStarts());
+    Serial.setEnabled(true);
+}
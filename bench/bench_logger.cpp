@@ -0,0 +1,73 @@
+#include "bench.h"
+#include "logger.h"
+
+// What the caller pays to produce one log line. The String variants are the
+// pattern the logger replaced: one heap allocation per concatenated piece,
+// then a blocking UART write on target.
+
+BENCHMARK(log_string_concat, 2000000) {
+    size_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        String newValue = "Count: " + String((unsigned long)i);
+        String line = "Sent notification: " + newValue;
+        total += line.length();
+    }
+    benchKeep(total);
+}
+
+BENCHMARK(log_logger_format, 2000000) {
+    char line[LOG_LINE_SIZE];
+    size_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        total += Logger::format(line, sizeof(line), LOG_LEVEL_INFO,
+                                "Sent notification: Count: %lu", (unsigned long)i);
+    }
+    benchKeep(total);
+}
+
+BENCHMARK(log_string_status, 1000000) {
+    size_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        String line = "WiFi RSSI: " + String((int)(i & 0x7F) - 128) + " dBm";
+        String status = "Status: BLE Server running, Connected: " + String((i & 1) ? "Yes" : "No");
+        total += line.length() + status.length();
+    }
+    benchKeep(total);
+}
+
+BENCHMARK(log_logger_status, 1000000) {
+    char line[LOG_LINE_SIZE];
+    size_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        total += Logger::format(line, sizeof(line), LOG_LEVEL_INFO,
+                                "WiFi RSSI: %d dBm", (int)(i & 0x7F) - 128);
+        total += Logger::format(line, sizeof(line), LOG_LEVEL_INFO,
+                                "Status: BLE Server running, Connected: %s", (i & 1) ? "Yes" : "No");
+    }
+    benchKeep(total);
+}
+
+// Format, queue and drain to a muted Serial: the whole native path
+BENCHMARK(log_logger_write, 2000000) {
+    Serial.setEnabled(false);
+    Logger::reset();
+    for (uint32_t i = 0; i < iterations; i++) {
+        LOG_INFO("Sent notification: Count: %lu", (unsigned long)i);
+    }
+    Serial.setEnabled(true);
+    benchKeep(Logger::getDropped());
+}
+
+// Queue only: what a producer adds on target, where the drain task pops
+BENCHMARK(log_ring_push_pop, 10000000) {
+    static LogRing ring;
+    ring.clear();
+    static const char line[] = "[I] Sent notification: Count: 123456\n";
+    char out[64];
+    size_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        ring.push(line, sizeof(line) - 1);
+        total += ring.pop(out, sizeof(out));
+    }
+    benchKeep(total);
+}
@@ -0,0 +1,145 @@
+#include "bench.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// pio run -e native_bench && .pio/build/native_bench/program [filter] [--out file] [--baseline file]
+// Results are also written as CSV (bench_results.csv unless --out says
+// otherwise), one row per benchmark, so runs from two releases can be
+// diffed; --baseline compares against such a file right away.
+
+struct BenchEntry {
+    const char* name;
+    BenchFunction function;
+    uint32_t iterations;
+};
+
+static BenchEntry entries[BenchRegistry::MAX_BENCHMARKS];
+static int entryCount = 0;
+static std::chrono::steady_clock::time_point measureStart;
+
+static const char* CSV_HEADER = "name,iterations,ns_per_op,allocs_per_op,bytes_per_op";
+static const double REGRESSION_THRESHOLD = 0.10;   // flag ns/op more than 10% up
+
+void BenchRegistry::add(const char* name, BenchFunction function, uint32_t iterations) {
+    if (entryCount < MAX_BENCHMARKS) {
+        entries[entryCount].name = name;
+        entries[entryCount].function = function;
+        entries[entryCount].iterations = iterations;
+        entryCount++;
+    }
+}
+
+void BenchRegistry::restartMeasurement() {
+    BenchAlloc::reset();
+    measureStart = std::chrono::steady_clock::now();
+}
+
+int BenchRegistry::runAll(const char* filter, BenchResult* results, int capacity) {
+    int ran = 0;
+    std::printf("%-44s %10s %12s %10s %10s\n", "benchmark", "iters", "ns/op", "allocs/op", "B/op");
+    for (int i = 0; i < entryCount && ran < capacity; i++) {
+        const BenchEntry& entry = entries[i];
+        if (filter != nullptr && std::strstr(entry.name, filter) == nullptr) {
+            continue;
+        }
+
+        restartMeasurement();
+        entry.function(entry.iterations);
+        std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+        BenchAllocStats heap = BenchAlloc::read();
+
+        BenchResult& result = results[ran];
+        result.name = entry.name;
+        result.iterations = entry.iterations;
+        result.nsPerOp = std::chrono::duration<double, std::nano>(stop - measureStart).count() / entry.iterations;
+        result.allocsPerOp = (double)heap.allocations / entry.iterations;
+        result.bytesPerOp = (double)heap.bytes / entry.iterations;
+        std::printf("%-44s %10u %12.2f %10.2f %10.1f\n", result.name, result.iterations,
+                    result.nsPerOp, result.allocsPerOp, result.bytesPerOp);
+        ran++;
+    }
+    return ran;
+}
+
+static bool writeResults(const char* path, const BenchResult* results, int count) {
+    FILE* file = std::fopen(path, "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "%s\n", CSV_HEADER);
+    for (int i = 0; i < count; i++) {
+        std::fprintf(file, "%s,%u,%.2f,%.3f,%.1f\n", results[i].name, results[i].iterations,
+                     results[i].nsPerOp, results[i].allocsPerOp, results[i].bytesPerOp);
+    }
+    std::fclose(file);
+    return true;
+}
+
+// Prints the change against a previous results file; returns the number of
+// benchmarks that got slower than the threshold or started allocating
+static int compareWithBaseline(const char* path, const BenchResult* results, int count) {
+    FILE* file = std::fopen(path, "r");
+    if (file == nullptr) {
+        std::printf("Baseline %s not found\n", path);
+        return 0;
+    }
+    std::printf("\n%-44s %12s %12s %8s %10s\n", "vs baseline", "old ns/op", "new ns/op", "change", "allocs/op");
+    int regressions = 0;
+    char line[256];
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        char name[128];
+        unsigned iterations;
+        double nsPerOp, allocsPerOp, bytesPerOp;
+        if (std::sscanf(line, "%127[^,],%u,%lf,%lf,%lf", name, &iterations, &nsPerOp, &allocsPerOp,
+                        &bytesPerOp) != 5) {
+            continue;   // header or a damaged row
+        }
+        for (int i = 0; i < count; i++) {
+            if (std::strcmp(results[i].name, name) != 0) {
+                continue;
+            }
+            double change = nsPerOp > 0 ? results[i].nsPerOp / nsPerOp - 1.0 : 0.0;
+            bool slower = change > REGRESSION_THRESHOLD;
+            bool allocating = results[i].allocsPerOp > allocsPerOp + 0.005;
+            std::printf("%-44s %12.2f %12.2f %+7.1f%% %4.2f->%-4.2f%s\n", name, nsPerOp, results[i].nsPerOp,
+                        change * 100.0, allocsPerOp, results[i].allocsPerOp,
+                        slower || allocating ? "  REGRESSION" : "");
+            if (slower || allocating) {
+                regressions++;
+            }
+        }
+    }
+    std::fclose(file);
+    return regressions;
+}
+
+int main(int argc, char** argv) {
+    const char* filter = nullptr;
+    const char* outPath = "bench_results.csv";
+    const char* baselinePath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    static BenchResult results[BenchRegistry::MAX_BENCHMARKS];
+    int count = BenchRegistry::runAll(filter, results, BenchRegistry::MAX_BENCHMARKS);
+    if (count == 0) {
+        return 1;
+    }
+    if (!writeResults(outPath, results, count)) {
+        std::printf("Could not write %s\n", outPath);
+        return 1;
+    }
+    std::printf("Results written to %s\n", outPath);
+    if (baselinePath != nullptr && compareWithBaseline(baselinePath, results, count) > 0) {
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "bench.h"
+#include "scheduler.h"
+#include "logger.h"
+#include "ble_server.h"
+#include "sim_ble.h"
+
+// One pass of the firmware's main loop, as the simulator runs it: every
+// lane's due jobs, then the sleep to the next deadline (which only moves
+// the virtual clock). A pass covers at most a second of firmware time.
+
+void setup();
+void loop();
+
+static void bootFirmware() {
+    Serial.setEnabled(false);
+    Logger::reset();
+    Scheduler::reset();
+    NativeClock::set(0);
+    SimBLE::reset();
+    setup();
+}
+
+BENCHMARK(main_loop_pass, 200000) {
+    bootFirmware();
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        loop();
+    }
+    benchKeep(millis());
+    Serial.setEnabled(true);
+}
+
+// The same with a central connected and subscribed, so readings go out
+BENCHMARK(main_loop_pass_connected, 200000) {
+    bootFirmware();
+    uint16_t central = SimBLE::connect(247);
+    SimBLE::subscribe(central, CHARACTERISTIC_UUID);
+    SimBLE::subscribe(central, TEMPERATURE_CHAR_UUID);
+    SimBLE::subscribe(central, TEMP_PACKED_CHAR_UUID);
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        loop();
+    }
+    benchKeep(SimBLE::getNotifyCount());
+    SimBLE::disconnect(central);
+    Serial.setEnabled(true);
+}
+
+// Nothing due: the cost of waking a lane for no work
+BENCHMARK(scheduler_idle_pass, 20000000) {
+    bootFirmware();
+    loop();
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        Scheduler::runDue();
+    }
+    benchKeep(Scheduler::taskCount());
+    Serial.setEnabled(true);
+}
@@ -0,0 +1,59 @@
+#include "bench.h"
+#include "flash_storage.h"
+#include "sample_log.h"
+#include <unistd.h>
+
+// Boot recovery of a completely full 1 MB log: the index scan reads and
+// CRC-checks every sector once, then the newest history's worth is replayed.
+// The host reads a memory-mapped file, so this is the CPU share of the boot
+// budget; on the chip the SPI flash reads come on top (see sample_log.h).
+
+static const char* IMAGE_PATH = "/tmp/esp32_sample_log_bench.img";
+static const uint32_t PARTITION_SIZE = SampleLog::MAX_SECTORS * 4096;
+
+static FileFlashStorage flash;
+static uint32_t replayed = 0;
+
+static void countSample(const LoggedSample&) {
+    replayed++;
+}
+
+static void fillLog() {
+    flash.open(IMAGE_PATH, PARTITION_SIZE);
+    flash.format();
+    SampleLog log;
+    log.begin(&flash);
+    // Enough to wrap the ring once, so every sector holds a full load
+    for (uint32_t i = 0; i < 120000; i++) {
+        LoggedSample sample = { i * 30000, (int16_t)(i % 4000), 4000, 0 };
+        log.append(sample);
+    }
+}
+
+BENCHMARK(sample_log_recover_full, 50) {
+    fillLog();
+    benchStart();
+    SampleLog log;
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        log.begin(&flash);
+        total += log.replay(4096, countSample);
+    }
+    flash.close();
+    unlink(IMAGE_PATH);
+    benchKeep(total);
+}
+
+BENCHMARK(sample_log_append, 1000000) {
+    flash.open(IMAGE_PATH, PARTITION_SIZE);
+    flash.format();
+    SampleLog log;
+    log.begin(&flash);
+    for (uint32_t i = 0; i < iterations; i++) {
+        LoggedSample sample = { i * 30000, (int16_t)(i % 4000), 4000, 0 };
+        log.append(sample);
+    }
+    flash.close();
+    unlink(IMAGE_PATH);
+    benchKeep(log.getRecordsWritten());
+}
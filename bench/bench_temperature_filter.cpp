@@ -0,0 +1,62 @@
+#include "bench.h"
+#include "temperature_filter.h"
+#include "temperature_service.h"
+
+// Per-input cost of each filter stage on its own and of the combinations the
+// service can be built with. Inputs are noisy readings around 20 C with an
+// occasional spike, so the median's sort does real work.
+
+template <typename Filter>
+static void runFilter(uint32_t iterations) {
+    Filter filter;
+    uint32_t state = 1;
+    int32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        state = state * 1103515245u + 12345u;
+        int32_t input = 2000 + (int32_t)((state >> 16) % 200) - 100;
+        if ((state >> 8) % 64 == 0) {
+            input += 5000;
+        }
+        int32_t output;
+        if (filter.process(input, output)) {
+            total += output;
+        }
+    }
+    benchKeep(total);
+}
+
+BENCHMARK(filter_passthrough, 20000000) {
+    runFilter<FilterPipeline<> >(iterations);
+}
+
+BENCHMARK(filter_oversample4, 20000000) {
+    runFilter<FilterPipeline<OversampleStage<4> > >(iterations);
+}
+
+BENCHMARK(filter_median3, 20000000) {
+    runFilter<FilterPipeline<MedianStage<3> > >(iterations);
+}
+
+BENCHMARK(filter_median5, 20000000) {
+    runFilter<FilterPipeline<MedianStage<5> > >(iterations);
+}
+
+BENCHMARK(filter_median9, 20000000) {
+    runFilter<FilterPipeline<MedianStage<9> > >(iterations);
+}
+
+BENCHMARK(filter_ema2, 20000000) {
+    runFilter<FilterPipeline<EmaStage<2> > >(iterations);
+}
+
+BENCHMARK(filter_median3_ema2, 20000000) {
+    runFilter<FilterPipeline<MedianStage<3>, EmaStage<2> > >(iterations);
+}
+
+BENCHMARK(filter_oversample4_median3_ema2, 20000000) {
+    runFilter<FilterPipeline<OversampleStage<4>, MedianStage<3>, EmaStage<2> > >(iterations);
+}
+
+BENCHMARK(filter_service_default, 20000000) {
+    runFilter<TemperatureFilter>(iterations);
+}
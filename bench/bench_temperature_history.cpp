@@ -0,0 +1,71 @@
+#include "bench.h"
+#include "temperature_history.h"
+#include "history_rollup.h"
+
+// Insert millions of samples into a full-size history (wraps many times)
+BENCHMARK(history_add, 4000000) {
+    TemperatureHistory history;
+    history.begin();
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < iterations; i++) {
+        state = state * 1103515245u + 12345u;
+        history.add(i * 30000u, (int16_t)((state >> 16) % 4000));
+    }
+    benchKeep(history.getNextSequence());
+}
+
+// Worst case for the deques: a monotonically falling series keeps them full
+BENCHMARK(history_add_monotonic, 4000000) {
+    TemperatureHistory history;
+    history.begin();
+    for (uint32_t i = 0; i < iterations; i++) {
+        history.add(i * 30000u, (int16_t)(30000 - (i % 60000)));
+    }
+    benchKeep(history.getNextSequence());
+}
+
+BENCHMARK(history_get_stats, 4000000) {
+    TemperatureHistory history;
+    history.begin();
+    for (uint32_t i = 0; i < history.getCapacity(); i++) {
+        history.add(i * 30000u, (int16_t)(i % 997));
+    }
+    WindowStats stats;
+    float total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        history.getStats((HistoryWindow)(i % WINDOW_COUNT), stats);
+        total += stats.mean;
+    }
+    benchKeep(total);
+}
+
+// Fold samples into all three rollup tiers, opening buckets as they go
+BENCHMARK(history_rollup_add, 4000000) {
+    static HistoryRollup rollup;
+    rollup.clear();
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < iterations; i++) {
+        state = state * 1103515245u + 12345u;
+        rollup.add(i * 30000u, (int16_t)((state >> 16) % 4000));
+    }
+    benchKeep(rollup.getNextSequence(TIER_1_MIN));
+}
+
+// Range requests over a full history: a binary search per tier
+BENCHMARK(history_tier_select, 1000000) {
+    TemperatureHistory history;
+    history.begin();
+    static HistoryRollup rollup;
+    rollup.clear();
+    for (uint32_t i = 0; i < 4 * history.getCapacity(); i++) {
+        history.add(i * 30000u, (int16_t)(i % 997));
+        rollup.add(i * 30000u, (int16_t)(i % 997));
+    }
+    const uint32_t ranges[4] = { 3600000UL, 86400000UL, 604800000UL, 0 };
+    uint32_t total = 0;
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        total += HistoryTierSelector::select(history, rollup, ranges[i % 4], 200).points;
+    }
+    benchKeep(total);
+}
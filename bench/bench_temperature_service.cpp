@@ -0,0 +1,87 @@
+#include "bench.h"
+#include "temperature_service.h"
+#include "temperature_units.h"
+#include "temperature_payload.h"
+#include "scheduler.h"
+#include "logger.h"
+
+// The sampling hot path end to end, and the conversions and encoding every
+// published reading goes through
+
+static void startService() {
+    Serial.setEnabled(false);
+    Logger::reset();
+    Scheduler::reset();
+    NativeClock::set(0);
+    TemperatureService::clearSensors();
+    TemperatureService::init();
+}
+
+// A due sample: start the fake sensor, filter, queue, publish into the
+// history and the seqlock
+BENCHMARK(temperature_update_due, 1000000) {
+    startService();
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::update();
+    }
+    benchKeep(TemperatureService::getSequence());
+    Serial.setEnabled(true);
+}
+
+// What a caller polling update() pays between samples
+BENCHMARK(temperature_update_idle, 20000000) {
+    startService();
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        TemperatureService::update();
+    }
+    benchKeep(TemperatureService::getSequence());
+    Serial.setEnabled(true);
+}
+
+BENCHMARK(temperature_snapshot_fahrenheit, 20000000) {
+    startService();
+    TemperatureService::setUnit(FAHRENHEIT);
+    TemperatureReading reading;
+    int32_t total = 0;
+    benchStart();
+    for (uint32_t i = 0; i < iterations; i++) {
+        TemperatureService::getReading(reading);
+        total += reading.current;
+    }
+    benchKeep(total);
+    TemperatureService::setUnit(CELSIUS);
+    Serial.setEnabled(true);
+}
+
+// Inputs vary per iteration so nothing folds at compile time
+BENCHMARK(units_to_fahrenheit, 100000000) {
+    int32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        total += TemperatureUnits::fromCentiCelsius((int32_t)(i & 0x3FFF) - 8192, FAHRENHEIT);
+    }
+    benchKeep(total);
+}
+
+BENCHMARK(units_to_celsius, 100000000) {
+    int32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        total += TemperatureUnits::fromCentiCelsius((int32_t)(i & 0x3FFF) - 8192, CELSIUS);
+    }
+    benchKeep(total);
+}
+
+BENCHMARK(payload_encode, 50000000) {
+    TemperatureReading reading = { 0, 0, 2250, 2500, 1800, CELSIUS };
+    uint8_t out[TEMPERATURE_PAYLOAD_SIZE];
+    size_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        reading.sequence = i;
+        reading.current = (int16_t)(i & 0x0FFF);
+        total += TemperaturePayload::encode(reading, out, sizeof(out));
+        benchKeep(out[10]);
+    }
+    benchKeep(total);
+}
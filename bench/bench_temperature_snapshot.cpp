@@ -0,0 +1,101 @@
+#include "bench.h"
+#include "seqlock.h"
+#include "temperature_service.h"
+#include <mutex>
+#include <thread>
+
+// Reader cost of a consistent temperature snapshot, alone and while another
+// thread publishes as fast as it can. The mutex variant is the obvious
+// alternative: readers and the writer serialise on one lock.
+
+struct BenchState {
+    uint32_t sequence;
+    uint32_t timestamp;
+    float current;
+    float max;
+    float min;
+};
+
+static Seqlock<BenchState> seqlockState;
+static BenchState mutexState;
+static std::mutex stateMutex;
+static volatile bool publishing = false;
+
+static void publishSeqlock() {
+    BenchState state = { 0, 0, 20.0f, 25.0f, 15.0f };
+    while (__atomic_load_n(&publishing, __ATOMIC_ACQUIRE)) {
+        state.sequence++;
+        state.timestamp += 30000;
+        seqlockState.write(state);
+    }
+}
+
+static void publishMutex() {
+    uint32_t sequence = 0;
+    while (__atomic_load_n(&publishing, __ATOMIC_ACQUIRE)) {
+        std::lock_guard<std::mutex> guard(stateMutex);
+        mutexState.sequence = ++sequence;
+        mutexState.timestamp += 30000;
+    }
+}
+
+BENCHMARK(snapshot_service_read, 10000000) {
+    TemperatureService::init();
+    TemperatureSnapshot snapshot;
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        TemperatureService::getSnapshot(snapshot);
+        total += snapshot.sequence;
+    }
+    benchKeep(total);
+}
+
+BENCHMARK(snapshot_seqlock_read, 10000000) {
+    BenchState state;
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        seqlockState.read(state);
+        total += state.sequence;
+    }
+    benchKeep(total);
+}
+
+BENCHMARK(snapshot_seqlock_read_contended, 10000000) {
+    __atomic_store_n(&publishing, true, __ATOMIC_RELEASE);
+    std::thread writer(publishSeqlock);
+    BenchState state;
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        seqlockState.read(state);
+        total += state.sequence;
+    }
+    __atomic_store_n(&publishing, false, __ATOMIC_RELEASE);
+    writer.join();
+    benchKeep(total);
+}
+
+BENCHMARK(snapshot_mutex_read, 10000000) {
+    BenchState state;
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        std::lock_guard<std::mutex> guard(stateMutex);
+        state = mutexState;
+        total += state.sequence;
+    }
+    benchKeep(total);
+}
+
+BENCHMARK(snapshot_mutex_read_contended, 10000000) {
+    __atomic_store_n(&publishing, true, __ATOMIC_RELEASE);
+    std::thread writer(publishMutex);
+    BenchState state;
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        std::lock_guard<std::mutex> guard(stateMutex);
+        state = mutexState;
+        total += state.sequence;
+    }
+    __atomic_store_n(&publishing, false, __ATOMIC_RELEASE);
+    writer.join();
+    benchKeep(total);
+}
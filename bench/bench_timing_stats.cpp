@@ -0,0 +1,33 @@
+#include "bench.h"
+#include "timing_stats.h"
+
+BENCHMARK(timing_histogram_record, 20000000) {
+    LatencyHistogram histogram;
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < iterations; i++) {
+        state = state * 1103515245u + 12345u;
+        histogram.record(state >> 12);
+    }
+    benchKeep(histogram.getMax());
+}
+
+// Cost of one probe around an empty scope: two clock reads plus a record
+BENCHMARK(timing_scoped_timer, 5000000) {
+    TimingStats::reset();
+    for (uint32_t i = 0; i < iterations; i++) {
+        ScopedTimer timer(PROBE_LOOP);
+    }
+    TimingSummary summary;
+    TimingStats::getSummary(PROBE_LOOP, summary);
+    benchKeep(summary.count);
+}
+
+BENCHMARK(timing_encode_snapshot, 1000000) {
+    uint8_t snapshot[TIMING_SNAPSHOT_SIZE];
+    size_t total = 0;
+    for (uint32_t i = 0; i < iterations; i++) {
+        TimingStats::record(PROBE_BLE, i & 0xFFFF);
+        total += TimingStats::encodeSnapshot(snapshot, sizeof(snapshot));
+    }
+    benchKeep(total);
+}
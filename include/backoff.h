@@ -0,0 +1,29 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdint.h>
+
+// Exponential backoff with jitter
+// The delay for attempt n is drawn from [d/2, d] with d = min(base * 2^n, max),
+// so retries spread out over time and several devices do not retry in lockstep.
+class ExponentialBackoff {
+private:
+    uint32_t baseMs;
+    uint32_t maxMs;
+    uint32_t attempts;
+    uint32_t rngState;
+
+    uint32_t nextRandom();
+
+public:
+    ExponentialBackoff(uint32_t baseMs, uint32_t maxMs, uint32_t seed = 1);
+
+    // Takes effect from the next delay; the attempt count is kept
+    void configure(uint32_t baseMs, uint32_t maxMs);
+    uint32_t nextDelay();
+    void reset();
+    void seed(uint32_t seed);
+    uint32_t getAttempts() const;
+};
+
+#endif // BACKOFF_H
@@ -0,0 +1,108 @@
+#ifndef BLE_CONNECTIONS_H
+#define BLE_CONNECTIONS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "link_tuning.h"
+
+// Connection slots; NimBLE reads the same setting from its own config
+#ifndef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#define CONFIG_BT_NIMBLE_MAX_CONNECTIONS 3
+#endif
+
+#define BLE_CONN_HANDLE_INVALID  0xFFFF
+#define BLE_NO_SEQUENCE          0xFFFFFFFFu
+
+// Characteristics a connection can subscribe to, one bit each
+enum BLENotifyTarget {
+    NOTIFY_COUNTER = 0,
+    NOTIFY_TEMPERATURE,
+    NOTIFY_TEMP_MAX,
+    NOTIFY_TEMP_MIN,
+    NOTIFY_TEMP_PACKED,
+    NOTIFY_HISTORY,
+    NOTIFY_DIAGNOSTICS,
+    NOTIFY_TARGET_COUNT
+};
+
+// Any of the temperature characteristics
+#define NOTIFY_TEMPERATURE_MASK ((1u << NOTIFY_TEMPERATURE) | (1u << NOTIFY_TEMP_MAX) | \
+                                 (1u << NOTIFY_TEMP_MIN) | (1u << NOTIFY_TEMP_PACKED))
+
+// Token bucket limiting the notifications queued for one connection
+// A full bucket allows a burst of `burst` notifications; one token comes back
+// every `refillMs`. Keeps a history dump to one peer from exhausting the
+// controller's buffers while other peers still get their updates.
+class NotifyBudget {
+private:
+    uint16_t tokens;
+    uint16_t burst;
+    uint32_t refillMs;
+    uint32_t refilledAt;
+
+public:
+    NotifyBudget();
+
+    void reset(uint16_t burst, uint32_t refillMs, uint32_t now);
+    bool take(uint32_t now);
+    uint16_t available(uint32_t now);
+};
+
+// State kept for one connected peer
+// Slots are claimed and released by the NimBLE host task (connect, MTU,
+// subscribe, disconnect callbacks) and read by the BLE task. `handle` is
+// written last when a slot is claimed and first when it is released, so the
+// BLE task never acts on a half-initialised slot; a notification racing a
+// disconnect is simply rejected by the stack.
+struct BLEConnection {
+    volatile uint16_t handle;
+    volatile uint16_t mtu;
+    volatile uint16_t dataLength;         // LL payload requested with DLE
+    uint16_t interval;                    // negotiated parameters, refreshed by the BLE task
+    uint16_t latency;
+    uint16_t timeout;
+    volatile uint32_t subscriptions;      // bit per BLENotifyTarget
+    uint32_t lastNotifiedSeq;             // sample sequence last sent to this peer
+    volatile bool temperatureBehind;      // missed a temperature notification
+    volatile bool historyRequested;
+    volatile uint32_t historyRequestSeq;
+    volatile bool historyRequestRanged;   // range request: tier picked when the dump starts
+    volatile uint32_t historyRequestRange;        // ms before the newest sample, 0 = all
+    volatile uint16_t historyRequestPoints;       // point budget, 0 = no limit
+    bool historyActive;
+    uint8_t historyTier;                  // HistoryTier being streamed
+    uint32_t historyNextSeq;              // sample or bucket sequence number
+    NotifyBudget budget;
+    LinkTuning link;
+
+    bool isOpen() const { return handle != BLE_CONN_HANDLE_INVALID; }
+    bool isSubscribed(BLENotifyTarget target) const { return (subscriptions & (1u << target)) != 0; }
+};
+
+// Fixed-size table of connected peers, indexed by NimBLE connection handle
+class BLEConnectionTable {
+public:
+    static const int MAX_CONNECTIONS = CONFIG_BT_NIMBLE_MAX_CONNECTIONS;
+    static const uint16_t DEFAULT_MTU = 23;
+    static const uint16_t NOTIFY_BURST = 12;          // notifications per burst
+    static const uint32_t NOTIFY_REFILL_MS = 20;      // sustained 50 notifications/s per peer
+
+private:
+    BLEConnection slots[MAX_CONNECTIONS];
+
+public:
+    BLEConnectionTable();
+
+    void clear();
+    BLEConnection* add(uint16_t handle, uint32_t now);
+    bool remove(uint16_t handle);
+    BLEConnection* find(uint16_t handle);
+    BLEConnection& at(int index) { return slots[index]; }
+    int count() const;
+
+    bool setMTU(uint16_t handle, uint16_t mtu);
+    bool setSubscribed(uint16_t handle, BLENotifyTarget target, bool subscribed);
+    int countSubscribed(BLENotifyTarget target) const;
+};
+
+#endif // BLE_CONNECTIONS_H
@@ -0,0 +1,211 @@
+#ifndef BLE_GATT_TABLE_H
+#define BLE_GATT_TABLE_H
+
+#include <stdint.h>
+
+// Native builds pick up the in-process fake from sim/
+#include <NimBLEDevice.h>
+
+// Custom service
+#define SERVICE_UUID        "12345678-1234-1234-1234-123456789abc"
+#define CHARACTERISTIC_UUID "87654321-4321-4321-4321-cba987654321"
+#define DIAGNOSTICS_CHAR_UUID    "12345678-1234-1234-1234-123456789ac3"
+#define CONFIG_CHAR_UUID         "12345678-1234-1234-1234-123456789ac4"
+
+// Environmental Sensing Service (standard BLE service)
+#define ENV_SENSING_SERVICE_UUID "0000181A-0000-1000-8000-00805f9b34fb"
+#define TEMPERATURE_CHAR_UUID    "00002A6E-0000-1000-8000-00805f9b34fb"
+#define TEMP_MAX_CHAR_UUID       "00002A6F-0000-1000-8000-00805f9b34fb"
+#define TEMP_MIN_CHAR_UUID       "00002A70-0000-1000-8000-00805f9b34fb"
+#define TEMP_CONFIG_CHAR_UUID    "00002A71-0000-1000-8000-00805f9b34fb"
+#define TEMP_HISTORY_CHAR_UUID   "12345678-1234-1234-1234-123456789ac1"
+#define TEMP_PACKED_CHAR_UUID    "12345678-1234-1234-1234-123456789ac2"
+
+// Compile-time parsing of "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx"
+
+constexpr int gattHexDigit(char c) {
+    return (c >= '0' && c <= '9') ? c - '0' :
+           (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+           (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+}
+
+// Offset of the n-th hex digit, skipping the dashes
+constexpr int gattDigitOffset(int n) {
+    return n + (n >= 8) + (n >= 12) + (n >= 16) + (n >= 20);
+}
+
+// Byte i of the little-endian value: the text is written most significant first
+constexpr uint8_t gattUUIDByte(const char* text, int i) {
+    return (uint8_t)((gattHexDigit(text[gattDigitOffset(30 - 2 * i)]) << 4) |
+                     gattHexDigit(text[gattDigitOffset(31 - 2 * i)]));
+}
+
+constexpr bool gattIsUUID128(const char* text, int i = 0) {
+    return i == 36 ? text[i] == '\0' :
+           (i == 8 || i == 13 || i == 18 || i == 23) ? (text[i] == '-' && gattIsUUID128(text, i + 1)) :
+           (gattHexDigit(text[i]) >= 0 && gattIsUUID128(text, i + 1));
+}
+
+// A 128-bit UUID parsed by the compiler, kept in NimBLE's byte order
+struct GattUUID128 {
+    const char* text;
+    uint8_t bytes[16];
+
+    constexpr GattUUID128(const char* uuid)
+        : text(uuid),
+          bytes{ gattUUIDByte(uuid, 0),  gattUUIDByte(uuid, 1),  gattUUIDByte(uuid, 2),  gattUUIDByte(uuid, 3),
+                 gattUUIDByte(uuid, 4),  gattUUIDByte(uuid, 5),  gattUUIDByte(uuid, 6),  gattUUIDByte(uuid, 7),
+                 gattUUIDByte(uuid, 8),  gattUUIDByte(uuid, 9),  gattUUIDByte(uuid, 10), gattUUIDByte(uuid, 11),
+                 gattUUIDByte(uuid, 12), gattUUIDByte(uuid, 13), gattUUIDByte(uuid, 14), gattUUIDByte(uuid, 15) } {}
+};
+
+constexpr bool gattUUIDEqual(const GattUUID128& a, const GattUUID128& b, int i = 0) {
+    return i == 16 || (a.bytes[i] == b.bytes[i] && gattUUIDEqual(a, b, i + 1));
+}
+
+enum GattService {
+    GATT_SERVICE_CUSTOM = 0,
+    GATT_SERVICE_ENV_SENSING,
+    GATT_SERVICE_COUNT
+};
+
+enum GattCharacteristic {
+    GATT_CHAR_COUNTER = 0,
+    GATT_CHAR_DIAGNOSTICS,
+    GATT_CHAR_CONFIG,
+    GATT_CHAR_TEMPERATURE,
+    GATT_CHAR_TEMP_MAX,
+    GATT_CHAR_TEMP_MIN,
+    GATT_CHAR_TEMP_PACKED,
+    GATT_CHAR_TEMP_CONFIG,
+    GATT_CHAR_TEMP_HISTORY,
+    GATT_CHARACTERISTIC_COUNT
+};
+
+// Callback objects a characteristic is wired to; each is a static in
+// ble_server.cpp
+enum GattCallbacks {
+    GATT_CALLBACKS_NONE = 0,
+    GATT_CALLBACKS_SUBSCRIPTION,    // SubscriptionCallbacks
+    GATT_CALLBACKS_COUNTER,         // MyCharacteristicCallbacks
+    GATT_CALLBACKS_CONFIG,          // ConfigCallbacks
+    GATT_CALLBACKS_TEMP_CONFIG,     // TempConfigCallbacks
+    GATT_CALLBACKS_HISTORY,         // TempHistoryCallbacks
+    GATT_CALLBACKS_COUNT
+};
+
+// Whether the callbacks record CCCD writes in the connection table, which
+// every notifiable characteristic needs
+constexpr bool gattTracksSubscriptions(GattCallbacks callbacks) {
+    return callbacks == GATT_CALLBACKS_SUBSCRIPTION || callbacks == GATT_CALLBACKS_COUNTER ||
+           callbacks == GATT_CALLBACKS_HISTORY;
+}
+
+constexpr bool gattHandlesWrites(GattCallbacks callbacks) {
+    return callbacks == GATT_CALLBACKS_COUNTER || callbacks == GATT_CALLBACKS_CONFIG ||
+           callbacks == GATT_CALLBACKS_TEMP_CONFIG || callbacks == GATT_CALLBACKS_HISTORY;
+}
+
+struct GattServiceDef {
+    GattService id;
+    GattUUID128 uuid;
+    bool advertised;
+};
+
+struct GattCharacteristicDef {
+    GattCharacteristic id;
+    GattService service;
+    GattUUID128 uuid;
+    uint32_t properties;        // NIMBLE_PROPERTY flags
+    GattCallbacks callbacks;
+};
+
+// The GATT database, in registration order. BLEServerManager::init() walks
+// these tables; test/test_gatt_table/test_gatt_table.cpp checks them with static_assert.
+constexpr GattServiceDef GATT_SERVICES[GATT_SERVICE_COUNT] = {
+    { GATT_SERVICE_CUSTOM,      SERVICE_UUID,             true },
+    { GATT_SERVICE_ENV_SENSING, ENV_SENSING_SERVICE_UUID, true },
+};
+
+constexpr GattCharacteristicDef GATT_CHARACTERISTICS[GATT_CHARACTERISTIC_COUNT] = {
+    // Counter demo value, also written by clients
+    { GATT_CHAR_COUNTER, GATT_SERVICE_CUSTOM, CHARACTERISTIC_UUID,
+      NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::INDICATE,
+      GATT_CALLBACKS_COUNTER },
+    // Timing percentiles, links and memory watermarks
+    { GATT_CHAR_DIAGNOSTICS, GATT_SERVICE_CUSTOM, DIAGNOSTICS_CHAR_UUID,
+      NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY, GATT_CALLBACKS_SUBSCRIPTION },
+    // Every runtime setting in one characteristic; writes need a paired link,
+    // since they include the passkey
+    { GATT_CHAR_CONFIG, GATT_SERVICE_CUSTOM, CONFIG_CHAR_UUID,
+      NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_ENC | NIMBLE_PROPERTY::WRITE_AUTHEN,
+      GATT_CALLBACKS_CONFIG },
+    { GATT_CHAR_TEMPERATURE, GATT_SERVICE_ENV_SENSING, TEMPERATURE_CHAR_UUID,
+      NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY, GATT_CALLBACKS_SUBSCRIPTION },
+    { GATT_CHAR_TEMP_MAX, GATT_SERVICE_ENV_SENSING, TEMP_MAX_CHAR_UUID,
+      NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY, GATT_CALLBACKS_SUBSCRIPTION },
+    { GATT_CHAR_TEMP_MIN, GATT_SERVICE_ENV_SENSING, TEMP_MIN_CHAR_UUID,
+      NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY, GATT_CALLBACKS_SUBSCRIPTION },
+    // Packed current/max/min: one notification per reading, never torn
+    { GATT_CHAR_TEMP_PACKED, GATT_SERVICE_ENV_SENSING, TEMP_PACKED_CHAR_UUID,
+      NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY, GATT_CALLBACKS_SUBSCRIPTION },
+    // Unit plus notify policy, stored settings like the config characteristic's
+    { GATT_CHAR_TEMP_CONFIG, GATT_SERVICE_ENV_SENSING, TEMP_CONFIG_CHAR_UUID,
+      NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_ENC | NIMBLE_PROPERTY::WRITE_AUTHEN,
+      GATT_CALLBACKS_TEMP_CONFIG },
+    // Write a start sequence, receive the samples as notifications
+    { GATT_CHAR_TEMP_HISTORY, GATT_SERVICE_ENV_SENSING, TEMP_HISTORY_CHAR_UUID,
+      NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY, GATT_CALLBACKS_HISTORY },
+};
+
+// Table checks, usable in static_assert
+
+#define GATT_KNOWN_PROPERTIES \
+    (NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_ENC | NIMBLE_PROPERTY::READ_AUTHEN | \
+     NIMBLE_PROPERTY::READ_AUTHOR | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR | \
+     NIMBLE_PROPERTY::WRITE_ENC | NIMBLE_PROPERTY::WRITE_AUTHEN | NIMBLE_PROPERTY::WRITE_AUTHOR | \
+     NIMBLE_PROPERTY::BROADCAST | NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::INDICATE)
+
+// Known flags only; notifiable ones track subscriptions, writable ones handle writes
+constexpr bool gattPropertiesValid(const GattCharacteristicDef& def) {
+    return def.properties != 0 && (def.properties & ~(uint32_t)GATT_KNOWN_PROPERTIES) == 0 &&
+           (!(def.properties & (NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::INDICATE)) ||
+            gattTracksSubscriptions(def.callbacks)) &&
+           (!(def.properties & (NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR)) ||
+            gattHandlesWrites(def.callbacks));
+}
+
+constexpr bool gattServicesValid(int i = 0) {
+    return i == GATT_SERVICE_COUNT ||
+           (GATT_SERVICES[i].id == i && gattIsUUID128(GATT_SERVICES[i].uuid.text) && gattServicesValid(i + 1));
+}
+
+constexpr bool gattCharacteristicsValid(int i = 0) {
+    return i == GATT_CHARACTERISTIC_COUNT ||
+           (GATT_CHARACTERISTICS[i].id == i && GATT_CHARACTERISTICS[i].service < GATT_SERVICE_COUNT &&
+            gattIsUUID128(GATT_CHARACTERISTICS[i].uuid.text) &&
+            gattPropertiesValid(GATT_CHARACTERISTICS[i]) && gattCharacteristicsValid(i + 1));
+}
+
+constexpr bool gattServiceUUIDUniqueFrom(int i, int j) {
+    return j == GATT_SERVICE_COUNT ||
+           (!gattUUIDEqual(GATT_SERVICES[i].uuid, GATT_SERVICES[j].uuid) && gattServiceUUIDUniqueFrom(i, j + 1));
+}
+
+constexpr bool gattServiceUUIDsUnique(int i = 0) {
+    return i == GATT_SERVICE_COUNT || (gattServiceUUIDUniqueFrom(i, i + 1) && gattServiceUUIDsUnique(i + 1));
+}
+
+// Unique across the whole server, so a UUID finds one characteristic
+constexpr bool gattCharacteristicUUIDUniqueFrom(int i, int j) {
+    return j == GATT_CHARACTERISTIC_COUNT ||
+           (!gattUUIDEqual(GATT_CHARACTERISTICS[i].uuid, GATT_CHARACTERISTICS[j].uuid) &&
+            gattCharacteristicUUIDUniqueFrom(i, j + 1));
+}
+
+constexpr bool gattCharacteristicUUIDsUnique(int i = 0) {
+    return i == GATT_CHARACTERISTIC_COUNT ||
+           (gattCharacteristicUUIDUniqueFrom(i, i + 1) && gattCharacteristicUUIDsUnique(i + 1));
+}
+
+#endif // BLE_GATT_TABLE_H
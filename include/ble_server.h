@@ -1,34 +1,29 @@
 #ifndef BLE_SERVER_H
 #define BLE_SERVER_H
 
-#ifdef ARDUINO
-#include <Arduino.h>
-#include <NimBLEDevice.h>
-#else
-#include <cstdint>
-#include <string>
-
-using String = std::string;
-
-inline void delay(uint32_t) {}
-inline unsigned long millis() { return 0; }
-
-class NimBLEServer;
-class NimBLEService;
-class NimBLECharacteristic;
-#endif
+#include "platform.h"
+#include "temperature_payload.h"
+#include "notify_policy.h"
+#include "ble_connections.h"
+#include "config_store.h"
+// Service and characteristic UUIDs; pulls in NimBLE (or the fake in sim/)
+#include "ble_gatt_table.h"
 
 // BLE Configuration
 #define DEVICE_NAME         "ESP32-S3-BLE-Device"
-#define SERVICE_UUID        "12345678-1234-1234-1234-123456789abc"
-#define CHARACTERISTIC_UUID "87654321-4321-4321-4321-cba987654321"
 
-// Environmental Sensing Service (standard BLE service)
-#define ENV_SENSING_SERVICE_UUID "0000181A-0000-1000-8000-00805f9b34fb"
-#define TEMPERATURE_CHAR_UUID    "00002A6E-0000-1000-8000-00805f9b34fb"
-#define TEMP_MAX_CHAR_UUID       "00002A6F-0000-1000-8000-00805f9b34fb"
-#define TEMP_MIN_CHAR_UUID       "00002A70-0000-1000-8000-00805f9b34fb"
-#define TEMP_CONFIG_CHAR_UUID    "00002A71-0000-1000-8000-00805f9b34fb"
+// ATT limits used to size notification payloads
+#define BLE_DEFAULT_MTU          23
+#define BLE_MAX_MTU              517
+#define BLE_NOTIFY_OVERHEAD      3
+
+// Advertising duty cycle: fast while a central is likely looking for us,
+// slow otherwise
+enum BLEAdvertisingMode {
+    ADVERTISING_OFF = 0,    // not advertising, e.g. every connection slot taken
+    ADVERTISING_FAST = 1,
+    ADVERTISING_SLOW = 2
+};
 
 // BLE Server class declaration
 class BLEServerManager {
@@ -36,35 +31,118 @@ private:
     static NimBLEServer* pServer;
     static NimBLEService* pService;
     static NimBLECharacteristic* pCharacteristic;
+    static NimBLECharacteristic* pDiagnosticsCharacteristic;
+    static NimBLECharacteristic* pConfigCharacteristic;
     static NimBLEService* pTempService;
     static NimBLECharacteristic* pTempCharacteristic;
     static NimBLECharacteristic* pTempMaxCharacteristic;
     static NimBLECharacteristic* pTempMinCharacteristic;
     static NimBLECharacteristic* pTempConfigCharacteristic;
-    static bool deviceConnected;
-    static bool oldDeviceConnected;
+    static NimBLECharacteristic* pTempHistoryCharacteristic;
+    static NimBLECharacteristic* pTempPackedCharacteristic;
+    static BLEConnectionTable connections;
+    static volatile bool connectionsChanged;
+    static volatile bool notifyPolicyChanged;
     static uint32_t value;
+    static int loopTaskId;
+    static int counterTaskId;
+    static int historyTaskId;
+    static int temperatureTaskId;
+    static int diagnosticsTaskId;
+    static int advertisingTaskId;
+    static int knownConnections;
+    static BLEAdvertisingMode advertisingMode;
+    static uint32_t fastAdvertisingSince;
+    static NotifyPolicy notifyPolicy;
+    static TemperatureReading publishedReading;
+    static uint8_t notifiedUnit;
+    // Where init() leaves each entry of the GATT tables
+    static NimBLEService** const serviceSlots[GATT_SERVICE_COUNT];
+    static NimBLECharacteristic** const characteristicSlots[GATT_CHARACTERISTIC_COUNT];
+
+    static const uint32_t CONNECTION_CHECK_INTERVAL = 1000;   // fallback poll, callbacks trigger it early
+    static const uint32_t COUNTER_NOTIFY_INTERVAL = 3000;     // 3 seconds between counter notifications
+    static const uint32_t ADVERTISING_RESTART_DELAY = 500;    // let the stack settle after a disconnect
+    static const uint32_t HISTORY_IDLE_INTERVAL = 60000;      // dump job idles until a request triggers it
+    static const uint32_t HISTORY_STREAM_INTERVAL = 20;       // pacing between bursts of history frames
+    static const int HISTORY_FRAMES_PER_PASS = 4;             // frames queued per burst
+    static const uint32_t DIAGNOSTICS_INTERVAL = 10000;        // timing snapshot refresh
+    static const size_t LINK_DIAGNOSTICS_SIZE = 1 + BLEConnectionTable::MAX_CONNECTIONS * LINK_INFO_SIZE;
+    static const uint8_t TEMP_CONFIG_SIZE = 1 + NOTIFY_POLICY_CONFIG_SIZE;  // unit + notify policy
+
+    static NimBLECharacteristic* targetCharacteristic(BLENotifyTarget target);
+    static bool notifyConnection(BLEConnection& connection, BLENotifyTarget target,
+                                 const uint8_t* data, size_t length, uint32_t now);
+    static int notifySubscribers(BLENotifyTarget target, const uint8_t* data, size_t length);
+    static bool streamHistoryTo(BLEConnection& connection, uint32_t now);
+    static void notifyTemperatureTo(BLEConnection& connection, uint32_t now);
+    static void notifyCounter();
+    static void restartAdvertising();
+    static void refreshLink(BLEConnection& connection);
+    static void tuneLink(BLEConnection& connection, uint32_t now);
+    static void setAdvertisingMode(BLEAdvertisingMode mode);
+    static void slowAdvertising();
+    static void streamHistory();
+    static void publishTemperature();
+    static void temperatureChanged();
+    static void updateConfigValue();
+    static void configChanged(ConfigKey key, uint32_t value);
+    static void publishDiagnostics();
 
 public:
+    // Advertising intervals in 0.625 ms units: 20-30 ms for the first 30 s
+    // after boot or a disconnect, then 1022.5-1285 ms
+    static const uint16_t FAST_ADVERTISING_MIN = 32;
+    static const uint16_t FAST_ADVERTISING_MAX = 48;
+    static const uint16_t SLOW_ADVERTISING_MIN = 1636;
+    static const uint16_t SLOW_ADVERTISING_MAX = 2056;
+    static const uint32_t FAST_ADVERTISING_TIME = 30000;
+
     static void init();
     static void loop();
     static bool isConnected();
-    static void updateValue(const String& newValue);
+    static int getConnectionCount();
+    static BLEAdvertisingMode getAdvertisingMode();
+    static void updateValue(const char* newValue);
     static void notify();
-    static void setDeviceConnectionState(bool connected);
-    static void updateTemperature(float current, float max, float min);
+    static void updateTemperature(const TemperatureReading& reading);
     static void notifyTemperature();
+
+    // Connection events from the NimBLE host task
+    static void onConnect(uint16_t connHandle);
+    static void onDisconnect(uint16_t connHandle);
+    static void onSubscribe(uint16_t connHandle, NimBLECharacteristic* characteristic, bool subscribed);
+    static void requestHistoryDump(uint16_t connHandle, uint32_t fromSeq);
+    static void requestHistoryRange(uint16_t connHandle, uint32_t rangeMs, uint16_t maxPoints);
+    static void setPeerMTU(uint16_t connHandle, uint16_t mtu);
+    static uint16_t getPeerMTU(uint16_t connHandle);
+    static bool getLinkInfo(uint16_t connHandle, LinkInfo& info);
+    static bool isSubscribed(uint16_t connHandle, BLENotifyTarget target);
+    static uint32_t getLastNotifiedSequence(uint16_t connHandle);
+    // The policy lives in the ConfigStore; the temperature job picks up a change
+    static bool setNotifyPolicy(const NotifyPolicyConfig& config);
+    static NotifyPolicyConfig getNotifyPolicy();
+    // A rejected config write leaves the stored settings untouched;
+    // `secureLink` says the writer's link is encrypted and authenticated
+    static void configWritten(NimBLECharacteristic* characteristic, bool secureLink);
 };
 
-#ifdef ARDUINO
 // Callback classes
 class MyServerCallbacks: public NimBLEServerCallbacks {
 public:
-    void onConnect(NimBLEServer* pServer);
-    void onDisconnect(NimBLEServer* pServer);
+    void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc);
+    void onDisconnect(NimBLEServer* pServer, ble_gap_conn_desc* desc);
+    void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc);
 };
 
-class MyCharacteristicCallbacks: public NimBLECharacteristicCallbacks {
+// Tracks CCCD writes in the connection table; notifiable characteristics use
+// this or a subclass
+class SubscriptionCallbacks: public NimBLECharacteristicCallbacks {
+public:
+    void onSubscribe(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc, uint16_t subValue);
+};
+
+class MyCharacteristicCallbacks: public SubscriptionCallbacks {
 public:
     void onRead(NimBLECharacteristic* pCharacteristic);
     void onWrite(NimBLECharacteristic* pCharacteristic);
@@ -74,6 +152,15 @@ class TempConfigCallbacks: public NimBLECharacteristicCallbacks {
 public:
     void onWrite(NimBLECharacteristic* pCharacteristic);
 };
-#endif
+
+class ConfigCallbacks: public NimBLECharacteristicCallbacks {
+public:
+    void onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc);
+};
+
+class TempHistoryCallbacks: public SubscriptionCallbacks {
+public:
+    void onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc);
+};
 
 #endif // BLE_SERVER_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include <stdint.h>
+
+// Fast start: setup() brings BLE advertising up right after the settings are
+// loaded, has no fixed delays, and leaves starting the WiFi driver to the
+// network lane once setup() returns. Build with -D FAST_START=0 for the old
+// order, with a 1 s pause for a serial monitor to attach and WiFi started
+// before BLE.
+#ifndef FAST_START
+#define FAST_START 1
+#endif
+
+// Boot milestones, in the order a fast start normally reaches them
+enum BootPhase {
+    BOOT_SETUP = 0,         // setup() entered
+    BOOT_CONFIG,            // settings loaded
+    BOOT_ADVERTISING,       // GATT server up and advertising
+    BOOT_SENSORS,           // temperature service initialised
+    BOOT_SETUP_DONE,        // setup() about to return
+    BOOT_WIFI_START,        // WiFi driver started and association begun
+    BOOT_FIRST_SAMPLE,      // first live temperature reading applied
+    BOOT_WIFI_CONNECTED,    // first association with an IP address
+    BOOT_PHASE_COUNT
+};
+
+// Timestamps of the boot milestones, in microseconds since reset
+// Each phase keeps the first time it was marked, so the profile describes
+// this boot even after WiFi reconnects or services are re-initialised.
+// mark() may be called from any task. On the ESP32 the clock starts when the
+// application does, so the ROM and second-stage bootloader (some 100-300 ms,
+// depending on flash and logging settings) come on top of every figure.
+class BootProfile {
+public:
+    // The report waits long enough for a normal WiFi association
+    static const uint32_t REPORT_DELAY = 30000;
+
+private:
+    static uint32_t times[BOOT_PHASE_COUNT];
+    static uint32_t claimed;    // bit per phase, set by the first mark()
+    static uint32_t reached;    // bit per phase, set once its time is stored
+
+public:
+    // Forgets every phase; the next boot starts over
+    static void reset();
+
+    static void mark(BootPhase phase);
+    static bool isReached(BootPhase phase);
+    // Time the phase was first marked, in microseconds since reset
+    static bool getTime(BootPhase phase, uint32_t& micros);
+    static const char* getName(BootPhase phase);
+
+    // Logs every phase reached so far with its time since reset
+    static void printReport();
+};
+
+#endif // BOOT_PROFILE_H
@@ -0,0 +1,63 @@
+#ifndef CONFIG_STORAGE_H
+#define CONFIG_STORAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Non-volatile home of the encoded configuration
+// Holds one blob, replaced as a whole by save(). NvsConfigStorage keeps it
+// in an NVS namespace on the chip, where a save either lands completely or
+// not at all; native builds use MemoryConfigStorage, which counts saves and
+// can be preloaded with any blob for the compatibility tests.
+class ConfigStorage {
+public:
+    virtual ~ConfigStorage() {}
+    // Copies the stored blob into `data`; false if there is none or it does
+    // not fit
+    virtual bool load(uint8_t* data, size_t capacity, size_t& length) = 0;
+    virtual bool save(const uint8_t* data, size_t length) = 0;
+};
+
+#ifdef ARDUINO
+
+class NvsConfigStorage : public ConfigStorage {
+private:
+    const char* nvsNamespace;
+
+public:
+    explicit NvsConfigStorage(const char* nvsNamespace);
+
+    bool load(uint8_t* data, size_t capacity, size_t& length);
+    bool save(const uint8_t* data, size_t length);
+};
+
+#else
+
+#include <vector>
+
+class MemoryConfigStorage : public ConfigStorage {
+private:
+    std::vector<uint8_t> blob;
+    bool stored;
+    bool failing;
+
+public:
+    uint32_t saveCount;
+
+    MemoryConfigStorage();
+
+    void reset();
+    // Replaces the stored blob, as an earlier firmware would have left it
+    void setContents(const uint8_t* data, size_t length);
+    const std::vector<uint8_t>& getContents() const;
+    bool hasContents() const;
+    // Makes every save fail, like a full NVS partition
+    void setFailing(bool fail);
+
+    bool load(uint8_t* data, size_t capacity, size_t& length);
+    bool save(const uint8_t* data, size_t length);
+};
+
+#endif
+
+#endif // CONFIG_STORAGE_H
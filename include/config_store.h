@@ -0,0 +1,139 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config_storage.h"
+
+// Pairing passkey until a central sets another one; override it in
+// platformio.ini like the WiFi credentials:
+//   -D BLE_PASSKEY=246810
+#ifndef BLE_PASSKEY
+#define BLE_PASSKEY 123456
+#endif
+
+// Runtime settings, in schema order
+enum ConfigKey {
+    CONFIG_TEMP_UNIT = 0,           // TemperatureUnit
+    CONFIG_SAMPLE_INTERVAL,         // ms between samples
+    CONFIG_NOTIFY_ABS_DEADBAND,     // hundredths of a degree
+    CONFIG_NOTIFY_REL_DEADBAND,     // per-mille
+    CONFIG_NOTIFY_MIN_INTERVAL,     // ms
+    CONFIG_NOTIFY_MAX_INTERVAL,     // ms
+    CONFIG_WIFI_TIMEOUT,            // ms per connection attempt
+    CONFIG_WIFI_BACKOFF_BASE,       // ms, first retry delay
+    CONFIG_WIFI_BACKOFF_MAX,        // ms, longest retry delay
+    CONFIG_BLE_PASSKEY,             // six digits, write-only
+    CONFIG_KEY_COUNT
+};
+
+// Setting flags
+#define CONFIG_FLAG_SECRET 0x01     // never encoded for reading over BLE
+
+// One row of the compile-time schema
+struct ConfigField {
+    uint8_t tag;                // wire tag, never reused for another meaning
+    const char* name;
+    uint8_t size;               // encoded width in bytes: 1, 2 or 4
+    uint32_t minValue;
+    uint32_t maxValue;
+    uint32_t defaultValue;
+    uint8_t flags;
+};
+
+// A single change within a batch
+struct ConfigUpdate {
+    ConfigKey key;
+    uint32_t value;
+};
+
+// Wire and storage format (little-endian), used by the config
+// characteristic and the NVS blob alike:
+//   [0]  format version, CONFIG_FORMAT_VERSION
+//   then one record per setting, in any order:
+//        [tag][length 1..4][value, `length` bytes]
+// Unknown tags are skipped, so older and newer firmware and apps can read
+// each other's blobs; a setting without a record keeps its value (writes)
+// or its default (stored blobs).
+#define CONFIG_FORMAT_VERSION 1
+#define CONFIG_RECORD_HEADER  2
+#define CONFIG_MAX_ENCODED_SIZE (1 + CONFIG_KEY_COUNT * (CONFIG_RECORD_HEADER + 4))
+
+// Invoked once per setting whose value changed, after the whole batch is in
+// Runs in the task that made the change (the NimBLE host task for BLE
+// writes), so like a TemperatureChangeCallback it must only hand off:
+// store the value or call Scheduler::trigger().
+typedef void (*ConfigChangeCallback)(ConfigKey key, uint32_t value);
+
+// Typed registry of the runtime settings
+// Every setting is a uint32 checked against its schema range; a batch
+// (apply(), a BLE write) is also checked against the cross-field rules
+// (notify min <= max, backoff base <= max) and goes in all or nothing.
+// get() is safe from any task and never blocks.
+//
+// Changes are persisted by the "config-save" job in the lane that called
+// init() (the network lane, with the other flash writes), once no further
+// change came in for SAVE_DELAY, so dragging a slider in an app costs one
+// NVS write rather than dozens. init() restores the saved values; a stored
+// value that is out of range, or a blob that breaks a cross-field rule,
+// falls back to the defaults instead of keeping the device from booting.
+class ConfigStore {
+public:
+    static const uint32_t SAVE_DELAY = 5000;            // quiet time before a save
+    static const uint32_t SAVE_IDLE_INTERVAL = 3600000; // save job idles until a change triggers it
+    static const int MAX_SUBSCRIBERS = 8;
+
+private:
+    static const ConfigField schema[CONFIG_KEY_COUNT];
+    static uint32_t values[CONFIG_KEY_COUNT];
+    static ConfigStorage* storage;
+    static ConfigChangeCallback subscribers[MAX_SUBSCRIBERS];
+    static int subscriberCount;
+    static volatile bool dirty;
+    static volatile uint32_t changedAt;
+    static uint32_t saveFailures;
+    static int saveTaskId;
+
+    static bool inRange(int key, uint32_t value);
+    static bool consistent(const uint32_t* candidate);
+    static int findTag(uint8_t tag);
+    static bool decode(const uint8_t* data, size_t length, uint32_t* candidate, bool* updated,
+                       bool strict, bool allowSecrets);
+    static bool commit(const uint32_t* candidate, const bool* updated);
+    static void loadDefaults();
+    friend struct ConfigDefaultsLoader;
+    static void saveJob();
+    static bool save();
+
+public:
+    // Restores the saved settings and registers the save job in the current lane
+    static void init();
+    // Storage for the settings, set before init(); nullptr keeps them in RAM only
+    static void setStorage(ConfigStorage* newStorage);
+    // Back to the defaults, persisted like any other change
+    static void resetToDefaults();
+
+    static uint32_t get(ConfigKey key);
+    static const ConfigField& getField(ConfigKey key);
+    // False, changing nothing, if a value is out of range or breaks a cross-field rule
+    static bool set(ConfigKey key, uint32_t value);
+    static bool apply(const ConfigUpdate* updates, int count);
+
+    // Adding the same callback twice has no effect
+    static bool subscribe(ConfigChangeCallback callback);
+    static void clearSubscribers();
+
+    // Encoded for reading over BLE (secrets left out) or for storage (everything)
+    static size_t encode(uint8_t* buffer, size_t capacity, bool includeSecrets = false);
+    // A BLE write: all records are applied, or none if any is malformed or
+    // invalid. Secret settings (the passkey) are refused, with the rest of
+    // the write, unless the link is encrypted and authenticated.
+    static bool applyEncoded(const uint8_t* data, size_t length, bool secureLink = false);
+
+    // Saves a pending change right away, e.g. before a restart
+    static bool flush();
+    static bool isDirty();
+    static uint32_t getSaveFailures();
+};
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,98 @@
+#ifndef FLASH_STORAGE_H
+#define FLASH_STORAGE_H
+
+#include <stdint.h>
+
+// Raw flash area used by the sample log
+// Behaves like NOR flash: erase() sets one whole sector to 0xFF and write()
+// can only clear bits, so a region must be erased before it is rewritten.
+// Offsets are relative to the start of the area. PartitionFlashStorage
+// drives a data partition on the chip; native builds use FileFlashStorage,
+// which keeps the image in a memory-mapped file and can cut the power in the
+// middle of any write or erase for the recovery tests.
+class FlashStorage {
+public:
+    virtual ~FlashStorage() {}
+    virtual uint32_t size() = 0;
+    virtual uint32_t sectorSize() = 0;
+    virtual bool read(uint32_t offset, void* data, uint32_t length) = 0;
+    virtual bool write(uint32_t offset, const void* data, uint32_t length) = 0;
+    virtual bool erase(uint32_t offset) = 0;
+};
+
+#ifdef ARDUINO
+
+#include <esp_partition.h>
+
+class PartitionFlashStorage : public FlashStorage {
+private:
+    const char* label;
+    const esp_partition_t* partition;
+
+public:
+    explicit PartitionFlashStorage(const char* label);
+
+    // Looks the partition up by label, as size() does on first use; false
+    // if the partition table has none
+    bool begin();
+
+    uint32_t size();
+    uint32_t sectorSize();
+    bool read(uint32_t offset, void* data, uint32_t length);
+    bool write(uint32_t offset, const void* data, uint32_t length);
+    bool erase(uint32_t offset);
+};
+
+#else
+
+#include <vector>
+
+class FileFlashStorage : public FlashStorage {
+private:
+    uint8_t* image;
+    uint32_t imageSize;
+    uint32_t sector;
+    int fd;
+    bool powerCutArmed;
+    uint32_t powerBudget;     // bytes that may still change before the cut
+    bool powered;
+    uint32_t noise;           // garbles the byte being written when the power goes
+    std::vector<uint32_t> sectorErases;
+
+    bool inRange(uint32_t offset, uint32_t length) const;
+    uint32_t spend(uint32_t length);
+
+public:
+    uint32_t bytesWritten;
+    uint32_t eraseCount;
+    uint32_t readCount;       // read() calls, to bound the work of a scan
+    uint32_t bytesRead;
+
+    FileFlashStorage();
+    ~FileFlashStorage();
+
+    // Maps `path`, creating it erased (all 0xFF) if it is new or the wrong size
+    bool open(const char* path, uint32_t size, uint32_t sectorSize = 4096);
+    void close();
+    // Erases the whole image
+    void format();
+
+    // Power-cut injection: once `bytes` more bytes have been programmed or
+    // erased, the operation in progress stops part-way (the byte being
+    // written ends up with random bits cleared) and every later write and
+    // erase fails, until restorePower() - the equivalent of a reboot
+    void cutPowerAfter(uint32_t bytes, uint32_t seed = 1);
+    void restorePower();
+    bool isPowered() const;
+    uint32_t getEraseCount(uint32_t sectorIndex) const;
+
+    uint32_t size();
+    uint32_t sectorSize();
+    bool read(uint32_t offset, void* data, uint32_t length);
+    bool write(uint32_t offset, const void* data, uint32_t length);
+    bool erase(uint32_t offset);
+};
+
+#endif
+
+#endif // FLASH_STORAGE_H
@@ -0,0 +1,138 @@
+#ifndef HISTORY_CODEC_H
+#define HISTORY_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "temperature_history.h"
+#include "history_rollup.h"
+
+// LEB128-style unsigned varints with zigzag mapping for signed deltas
+class Varint {
+public:
+    static const size_t MAX_BYTES = 5;
+
+    static size_t encode(uint32_t value, uint8_t* out);
+    static size_t decode(const uint8_t* data, size_t length, uint32_t& value);
+
+    static uint32_t zigzag(int32_t value) {
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+    static int32_t unzigzag(uint32_t value) {
+        return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+    }
+};
+
+// History dump frame layout (little-endian):
+//   [0]     version
+//   [1]     flags (HISTORY_FLAG_LAST on the final frame of a dump)
+//   [2..5]  sequence number of the first sample
+//   [6]     sample count
+//   then    varint timestamp + zigzag varint value of the first sample,
+//           followed by zigzag(delta-of-delta timestamp) + zigzag(delta value)
+//           for every further sample
+#define HISTORY_FRAME_VERSION   1
+#define HISTORY_FRAME_HEADER    7
+#define HISTORY_FLAG_LAST       0x01
+
+struct HistoryFrameHeader {
+    uint8_t version;
+    uint8_t flags;
+    uint32_t firstSeq;
+    uint8_t count;
+};
+
+// Builds one frame sample by sample until it would exceed the buffer
+class HistoryFrameEncoder {
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t length;
+    uint8_t count;
+    uint32_t lastTimestamp;
+    uint32_t lastDelta;
+    int16_t lastValue;
+
+public:
+    HistoryFrameEncoder(uint8_t* buffer, size_t capacity);
+
+    bool begin(uint32_t firstSeq);
+    bool add(const HistorySample& sample);
+    size_t finish(bool last);
+    uint8_t getCount() const;
+
+    // Fill one frame from the history starting at nextSeq (clamped to the
+    // oldest stored sample) and advance nextSeq past the encoded samples
+    static size_t encodeRange(const TemperatureHistory& history, uint32_t& nextSeq,
+                              uint8_t* buffer, size_t capacity);
+};
+
+class HistoryFrameDecoder {
+public:
+    // Returns the number of decoded samples, or -1 for a malformed frame
+    static int decode(const uint8_t* data, size_t length, HistoryFrameHeader& header,
+                      HistorySample* samples, size_t maxSamples);
+};
+
+// Rollup dump frame layout (little-endian):
+//   [0]     version
+//   [1]     flags (HISTORY_FLAG_LAST on the final frame of a dump)
+//   [2]     tier (HistoryTier)
+//   [3..6]  sequence number of the first bucket
+//   [7]     bucket count
+//   then per bucket: zigzag varint start in tier widths (absolute for the
+//           first bucket, then the step from the previous one), zigzag
+//           varint mean (absolute, then the delta), varint mean - min,
+//           varint max - mean, varint sample count
+#define HISTORY_ROLLUP_FRAME_VERSION    2
+#define HISTORY_ROLLUP_FRAME_HEADER     8
+
+struct RollupFrameHeader {
+    uint8_t version;
+    uint8_t flags;
+    uint8_t tier;
+    uint32_t firstSeq;
+    uint8_t count;
+};
+
+// One decoded bucket, in centi-degrees Celsius
+struct RollupPoint {
+    uint32_t start;     // ms
+    int16_t mean;
+    int16_t min;
+    int16_t max;
+    uint16_t count;
+};
+
+// Builds one rollup frame bucket by bucket until it would exceed the buffer
+class RollupFrameEncoder {
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t length;
+    uint8_t count;
+    uint32_t width;
+    uint32_t lastIndex;
+    int16_t lastMean;
+
+public:
+    RollupFrameEncoder(uint8_t* buffer, size_t capacity);
+
+    bool begin(HistoryTier tier, uint32_t firstSeq);
+    bool add(const RollupBucket& bucket);
+    size_t finish(bool last);
+    uint8_t getCount() const;
+
+    // Fill one frame from a tier starting at nextSeq (clamped to the oldest
+    // stored bucket) and advance nextSeq past the encoded buckets
+    static size_t encodeRange(const HistoryRollup& rollup, HistoryTier tier, uint32_t& nextSeq,
+                              uint8_t* buffer, size_t capacity);
+};
+
+class RollupFrameDecoder {
+public:
+    // Returns the number of decoded buckets, or -1 for a malformed frame
+    static int decode(const uint8_t* data, size_t length, RollupFrameHeader& header,
+                      RollupPoint* points, size_t maxPoints);
+};
+
+#endif // HISTORY_CODEC_H
@@ -0,0 +1,99 @@
+#ifndef HISTORY_ROLLUP_H
+#define HISTORY_ROLLUP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "temperature_history.h"
+
+// Resolutions the history can be served at, finest first
+enum HistoryTier {
+    TIER_RAW = 0,       // every sample, from TemperatureHistory
+    TIER_1_MIN,
+    TIER_15_MIN,
+    TIER_1_HOUR,
+    TIER_COUNT
+};
+
+// Aggregate of the samples whose timestamps fall in one bucket, in
+// centi-degrees Celsius
+struct RollupBucket {
+    uint32_t start;     // ms, a multiple of the tier's width
+    int32_t sum;
+    uint16_t count;
+    int16_t min;
+    int16_t max;
+
+    // Rounded to the nearest centi-degree, so always within [min, max]
+    int16_t mean() const;
+};
+
+// Min/max/mean/count buckets of the history at 1 minute, 15 minutes and
+// 1 hour. add() folds a sample into the newest bucket of every tier, or
+// opens a new one when its timestamp crosses a bucket boundary, so it is
+// O(1) and never rescans anything. Each tier is a ring in a fixed array with
+// a sequence number per bucket, like TemperatureHistory, so a dump can
+// stream from a position while new buckets arrive. Intervals without
+// samples have no bucket. Timestamps must not go backwards; a sample older
+// than the newest bucket is counted in it.
+class HistoryRollup {
+public:
+    // Powers of two, so sequence numbers map to slots with a mask
+    static const uint32_t BUCKETS_1_MIN = 256;      // ~4 hours
+    static const uint32_t BUCKETS_15_MIN = 256;     // ~2.7 days
+    static const uint32_t BUCKETS_1_HOUR = 256;     // ~10 days
+
+private:
+    static const int ROLLUP_TIERS = TIER_COUNT - 1;
+
+    struct Tier {
+        RollupBucket* buckets;
+        uint32_t width;       // ms
+        uint32_t mask;
+        uint32_t nextSeq;     // sequence number of the next bucket
+    };
+
+    RollupBucket storage[BUCKETS_1_MIN + BUCKETS_15_MIN + BUCKETS_1_HOUR];
+    Tier tiers[ROLLUP_TIERS];
+
+    const Tier* find(HistoryTier tier) const;
+
+public:
+    HistoryRollup();
+
+    void clear();
+    void add(uint32_t timestamp, int16_t value);
+
+    // Bucket width in ms; 0 for TIER_RAW
+    static uint32_t getWidth(HistoryTier tier);
+
+    uint32_t getCapacity(HistoryTier tier) const;
+    uint32_t size(HistoryTier tier) const;
+    uint32_t getFirstSequence(HistoryTier tier) const;
+    uint32_t getNextSequence(HistoryTier tier) const;
+    bool getBucket(HistoryTier tier, uint32_t seq, RollupBucket& bucket) const;
+
+    // Sequence number of the oldest stored bucket holding time no more than
+    // `rangeMs` before `newest`
+    uint32_t findFirst(HistoryTier tier, uint32_t newest, uint32_t rangeMs) const;
+};
+
+// Where a range request is served from
+struct HistorySelection {
+    HistoryTier tier;
+    uint32_t firstSeq;    // sample or bucket sequence number to start at
+    uint32_t points;      // samples or buckets from there to the newest
+};
+
+// Picks the finest tier that can serve the `rangeMs` before the newest
+// sample within `maxPoints` (0 = no limit): it must hold no more points than
+// that in the range, and must reach back to the start of the range unless it
+// never dropped anything. The hourly tier reaches furthest; when even it
+// has too many, its newest `maxPoints` buckets are served. Each tier is binary searched
+// for the start of the range.
+class HistoryTierSelector {
+public:
+    static HistorySelection select(const TemperatureHistory& raw, const HistoryRollup& rollup,
+                                   uint32_t rangeMs, uint32_t maxPoints);
+};
+
+#endif // HISTORY_ROLLUP_H
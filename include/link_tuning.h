@@ -0,0 +1,87 @@
+#ifndef LINK_TUNING_H
+#define LINK_TUNING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Connection parameter sets requested from the central
+enum LinkProfile {
+    LINK_PROFILE_NONE = 0,  // nothing requested yet
+    LINK_PROFILE_BULK,      // short interval, no latency: discovery and history dumps
+    LINK_PROFILE_IDLE       // long interval with slave latency: periodic notifications only
+};
+
+// Connection parameters in controller units
+struct LinkParams {
+    uint16_t minInterval;   // 1.25 ms
+    uint16_t maxInterval;   // 1.25 ms
+    uint16_t latency;       // connection events the peripheral may skip
+    uint16_t timeout;       // supervision timeout, 10 ms
+};
+
+// What one connection negotiated, plus its measured bulk throughput
+struct LinkInfo {
+    uint16_t handle;
+    uint16_t mtu;
+    uint16_t dataLength;    // LL payload octets requested with DLE
+    uint16_t interval;      // 1.25 ms units, as reported by the stack
+    uint16_t latency;
+    uint16_t timeout;       // 10 ms units
+    uint8_t profile;        // LinkProfile last requested
+    uint32_t throughput;    // bytes/s of the running or last bulk transfer
+};
+
+// Wire format of one link on the diagnostics characteristic (little-endian):
+//   [0..1]   connection handle
+//   [2..3]   ATT MTU
+//   [4..5]   LL data length
+//   [6..7]   connection interval, 1.25 ms units
+//   [8..9]   slave latency
+//   [10]     profile (LinkProfile)
+//   [11..14] bulk throughput, bytes/s
+#define LINK_INFO_SIZE 15
+
+// Connection parameter choice and throughput accounting for one peer
+// A new connection starts in the bulk profile, so service discovery and a
+// first history dump run at a 7.5-15 ms interval. IDLE_AFTER ms after the
+// last bulk traffic the link asks for 100-200 ms with a slave latency of 4:
+// an idle peer then costs the radio about one event per second, while a
+// notification still goes out within one interval. Requests are only made
+// when the wanted profile changes; the central has the final say, and the
+// negotiated values are what the stack reports back.
+class LinkTuning {
+private:
+    uint8_t requested;
+    uint32_t lastBulkAt;
+    bool measuring;
+    uint32_t bulkStartedAt;
+    uint32_t bulkBytes;
+    uint32_t throughput;
+
+public:
+    // LL payload with data length extension; an ATT MTU of DATA_LENGTH
+    // minus the 4-byte L2CAP header fills exactly one LL packet
+    static const uint16_t DATA_LENGTH = 251;
+    static const uint16_t PREFERRED_MTU = DATA_LENGTH - 4;
+    static const uint32_t IDLE_AFTER = 5000;    // ms without bulk traffic
+    static const LinkParams BULK_PARAMS;
+    static const LinkParams IDLE_PARAMS;
+
+    LinkTuning();
+
+    void reset(uint32_t now);
+    // Returns the profile to request now, or LINK_PROFILE_NONE if the last
+    // request still stands
+    LinkProfile update(bool bulkPending, uint32_t now);
+    LinkProfile getRequested() const;
+    static const LinkParams& paramsFor(LinkProfile profile);
+
+    void startBulk(uint32_t now);
+    void addBulkBytes(size_t bytes);
+    void finishBulk(uint32_t now);
+    uint32_t getThroughput(uint32_t now) const;
+
+    static size_t encodeInfo(const LinkInfo& info, uint8_t* buffer, size_t capacity);
+};
+
+#endif // LINK_TUNING_H
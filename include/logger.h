@@ -0,0 +1,99 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "platform.h"
+
+// Log levels, numbered like the Arduino core's CORE_DEBUG_LEVEL
+#define LOG_LEVEL_NONE      0
+#define LOG_LEVEL_ERROR     1
+#define LOG_LEVEL_WARN      2
+#define LOG_LEVEL_INFO      3
+#define LOG_LEVEL_DEBUG     4
+#define LOG_LEVEL_VERBOSE   5
+
+// Calls above LOG_LEVEL compile to nothing, arguments included
+#ifndef LOG_LEVEL
+#ifdef CORE_DEBUG_LEVEL
+#define LOG_LEVEL CORE_DEBUG_LEVEL
+#else
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+#define LOG_LINE_SIZE       160     // longest formatted line, including the newline
+#define LOG_BUFFER_SIZE     2048    // bytes queued for the UART; power of two
+
+// Lock-free single-producer/single-consumer byte ring
+// Indices run freely and are masked on access, so a full ring holds exactly
+// CAPACITY bytes. push() is all-or-nothing: a line either fits or is dropped.
+class LogRing {
+public:
+    static const uint32_t CAPACITY = LOG_BUFFER_SIZE;
+
+    LogRing();
+
+    void clear();
+    bool push(const char* data, size_t length);
+    size_t pop(char* out, size_t capacity);
+    size_t available() const;
+
+private:
+    char buffer[CAPACITY];
+    uint32_t head;      // written by the producer
+    uint32_t tail;      // written by the consumer
+};
+
+// printf-style logging that never blocks the caller
+// Lines are formatted into a stack buffer and queued in a LogRing. On target a
+// low-priority task drains the ring to Serial; on native write() drains it
+// inline so output stays in order with the simulator. When the ring is full,
+// or another task is in the middle of queueing a line, the line is dropped
+// and counted instead of waiting.
+class Logger {
+private:
+    static LogRing ring;
+    static volatile bool producerBusy;
+    static volatile uint32_t dropped;
+
+    static void enqueue(const char* line, size_t length);
+
+public:
+    static const uint32_t DRAIN_STACK_SIZE = 3072;    // stack of the drain task, "log"
+
+    static void begin();
+    static void write(uint8_t level, const char* format, ...)
+        __attribute__((format(printf, 2, 3)));
+    static size_t format(char* out, size_t capacity, uint8_t level, const char* format, ...)
+        __attribute__((format(printf, 4, 5)));
+    static void flush();
+    static uint32_t getDropped();
+    static void reset();
+};
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Logger::write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) Logger::write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) Logger::write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Logger::write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#endif // LOGGER_H
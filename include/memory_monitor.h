@@ -0,0 +1,104 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "memory_probe.h"
+
+// Heap fragmentation, in percent of the free heap outside the largest free
+// block, above which a warning is raised; override in platformio.ini
+#ifndef MEMORY_FRAGMENTATION_WARNING
+#define MEMORY_FRAGMENTATION_WARNING 50
+#endif
+
+// Memory state since boot
+struct MemoryStats {
+    HeapInfo heap;                  // internal RAM at the last sample
+    uint32_t minFreeHeap;           // lowest free heap, sampled or reported by the allocator
+    uint32_t minLargestFreeBlock;   // lowest largest free block sampled
+    uint8_t fragmentation;          // percent, at the last sample
+    uint8_t maxFragmentation;
+    bool fragmented;                // fragmentation above the warning threshold
+    bool hasPsram;
+    HeapInfo psram;
+    uint32_t minFreePsram;
+    uint32_t samples;
+    uint32_t fragmentationWarnings; // times the threshold was crossed upwards
+};
+
+// Stack use of one watched task
+struct TaskStackStats {
+    const char* name;
+    uint32_t stackSize;     // bytes, as passed to xTaskCreate
+    uint32_t minUnused;     // high-water mark: bytes never touched since boot
+    bool seen;              // false until the task exists
+};
+
+// Wire format appended to the diagnostics characteristic (little-endian):
+//   [0]      version
+//   [1]      flags: bit 0 fragmentation warning, bit 1 PSRAM present
+//   [2..5]   free heap
+//   [6..9]   largest free block
+//   [10..13] minimum free heap since boot
+//   [14..17] minimum largest free block since boot
+//   [18..21] free PSRAM
+//   [22..25] minimum free PSRAM since boot
+//   [26]     fragmentation, percent
+//   [27]     number of tasks
+//   then per watched task, in watch order: stack size and minimum unused
+//   stack (u16 each, bytes; unused 0xFFFF while the task does not exist)
+#define MEMORY_SNAPSHOT_VERSION     1
+#define MEMORY_SNAPSHOT_HEADER      28
+#define MEMORY_SNAPSHOT_TASK_SIZE   4
+#define MEMORY_FLAG_FRAGMENTED      0x01
+#define MEMORY_FLAG_PSRAM           0x02
+
+// Samples free heap, largest free block, PSRAM and the stack high-water
+// marks of the watched tasks from the "memory" job, keeping the lowest
+// values seen since boot. A warning is logged once each time fragmentation
+// rises above the threshold, and again only after it fell back
+// FRAGMENTATION_HYSTERESIS points below it; a task whose unused stack drops
+// under STACK_WARNING_BYTES is reported once. Everything is fixed-size, so
+// watching memory does not use any.
+class MemoryMonitor {
+public:
+    static const uint32_t SAMPLE_INTERVAL = 10000;
+    static const int MAX_TASKS = 8;
+    static const uint8_t FRAGMENTATION_HYSTERESIS = 10;
+    static const uint32_t STACK_WARNING_BYTES = 512;
+
+private:
+    static MemoryProbe* probe;
+    static MemoryStats stats;
+    static TaskStackStats tasks[MAX_TASKS];
+    static bool stackWarned[MAX_TASKS];
+    static int taskCount;
+    static uint8_t fragmentationThreshold;
+    static int sampleTaskId;
+
+public:
+    // Takes a first sample and registers the sample job in the current lane
+    static void init();
+    // Clears the statistics and the watched tasks
+    static void reset();
+    // Memory source, set before init(); defaults to the chip (or the fake)
+    static void setProbe(MemoryProbe* newProbe);
+    static void setFragmentationThreshold(uint8_t percent);
+    // Tasks are looked up by name at every sample, so they may start later
+    static bool watchTask(const char* name, uint32_t stackSize);
+
+    static void sample();
+    static const MemoryStats& getStats();
+    static int getTaskCount();
+    static bool getTaskStack(int index, TaskStackStats& task);
+    // Percent of the free space outside the largest free block
+    static uint8_t fragmentationOf(const HeapInfo& heap);
+
+    static size_t getSnapshotSize();
+    static size_t encodeSnapshot(uint8_t* buffer, size_t capacity);
+    static void printSummary();
+};
+
+#define MEMORY_SNAPSHOT_MAX_SIZE (MEMORY_SNAPSHOT_HEADER + MemoryMonitor::MAX_TASKS * MEMORY_SNAPSHOT_TASK_SIZE)
+
+#endif // MEMORY_MONITOR_H
@@ -0,0 +1,93 @@
+#ifndef MEMORY_PROBE_H
+#define MEMORY_PROBE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// One heap region as the allocator sees it, in bytes
+struct HeapInfo {
+    uint32_t totalBytes;
+    uint32_t freeBytes;
+    uint32_t largestFreeBlock;  // biggest single allocation that would succeed
+    uint32_t minFreeBytes;      // the allocator's own low-water mark since boot
+};
+
+// Memory readings used by MemoryMonitor
+// EspMemoryProbe asks the ESP-IDF heap and FreeRTOS; native builds use
+// FakeMemoryProbe, which models the internal heap from the live allocations
+// of the process and lets tests script fragmentation, PSRAM and stacks.
+class MemoryProbe {
+public:
+    virtual ~MemoryProbe() {}
+    // Internal RAM, where NimBLE, WiFi and every String live
+    virtual bool readHeap(HeapInfo& heap) = 0;
+    // External PSRAM; false on boards without it
+    virtual bool readPsram(HeapInfo& psram) = 0;
+    // Bytes of the named task's stack never touched since it started; false
+    // if there is no such task (yet)
+    virtual bool readStackHighWater(const char* taskName, uint32_t& unusedBytes) = 0;
+};
+
+#ifdef ARDUINO
+
+class EspMemoryProbe : public MemoryProbe {
+public:
+    bool readHeap(HeapInfo& heap);
+    bool readPsram(HeapInfo& psram);
+    bool readStackHighWater(const char* taskName, uint32_t& unusedBytes);
+};
+
+#else
+
+// Bytes the native build has live on the heap
+// Fed by the operator new/delete replacement in sim/heap_hook.cpp, which
+// the benchmark build leaves out in favour of its own counting allocator.
+class NativeHeap {
+public:
+    static void allocated(size_t size);
+    static void released(size_t size);
+    static uint32_t getLiveBytes();
+    // Highest live total since the last resetPeak()
+    static uint32_t getPeakBytes();
+    static void resetPeak();
+};
+
+class FakeMemoryProbe : public MemoryProbe {
+public:
+    static const int MAX_STACKS = 8;
+    static const uint32_t DEFAULT_HEAP_SIZE = 327680;   // internal RAM left to an ESP32-S3 app
+
+private:
+    struct ScriptedStack {
+        const char* name;
+        uint32_t unusedBytes;
+    };
+
+    uint32_t heapSize;
+    uint32_t baseline;          // live bytes at reset(), i.e. not the firmware's
+    bool heapScripted;
+    HeapInfo scriptedHeap;
+    bool hasPsram;
+    HeapInfo psramInfo;
+    ScriptedStack stacks[MAX_STACKS];
+    int stackCount;
+
+public:
+    FakeMemoryProbe();
+
+    // Starts counting from the current live total, with nothing scripted
+    void reset();
+    void setHeapSize(uint32_t bytes);
+    // Replaces the hook-backed heap with fixed values, e.g. a fragmented heap
+    void scriptHeap(uint32_t freeBytes, uint32_t largestFreeBlock);
+    void setPsram(uint32_t totalBytes, uint32_t freeBytes);
+    void setStackHighWater(const char* taskName, uint32_t unusedBytes);
+
+    bool readHeap(HeapInfo& heap);
+    bool readPsram(HeapInfo& psram);
+    bool readStackHighWater(const char* taskName, uint32_t& unusedBytes);
+};
+
+#endif
+
+#endif // MEMORY_PROBE_H
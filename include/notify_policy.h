@@ -0,0 +1,61 @@
+#ifndef NOTIFY_POLICY_H
+#define NOTIFY_POLICY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Change-detection settings for value notifications
+struct NotifyPolicyConfig {
+    uint16_t absoluteDeadband;  // hundredths of a degree
+    uint16_t relativeDeadband;  // per-mille of the last notified value
+    uint32_t minInterval;       // ms, rate limit between notifications
+    uint32_t maxInterval;       // ms, heartbeat when the value does not move
+};
+
+// Wire format of the settings on the config characteristic (little-endian),
+// following the unit byte:
+//   [0..1] absolute deadband, hundredths of a degree
+//   [2..3] relative deadband, per-mille
+//   [4..5] minimum notify interval, milliseconds
+//   [6..7] maximum notify interval, seconds
+#define NOTIFY_POLICY_CONFIG_SIZE 8
+
+// Decides when a value is worth notifying
+// A value is significant when it moved by at least the larger of the
+// absolute and relative deadbands since the last notification. Significant
+// values go out as soon as minInterval allows; otherwise a heartbeat is
+// sent every maxInterval.
+class NotifyPolicy {
+private:
+    NotifyPolicyConfig config;
+    bool notifiedOnce;
+    bool forced;
+    bool hasLatest;
+    int16_t lastValue;
+    int16_t latestValue;
+    uint32_t lastNotifyTime;
+
+    bool isSignificant(int16_t value) const;
+
+public:
+    static const uint16_t DEFAULT_ABSOLUTE_DEADBAND = 10;    // 0.1 degree
+    static const uint16_t DEFAULT_RELATIVE_DEADBAND = 0;
+    static const uint32_t DEFAULT_MIN_INTERVAL = 1000;       // 1 second
+    static const uint32_t DEFAULT_MAX_INTERVAL = 30000;      // 30 seconds
+
+    NotifyPolicy();
+
+    bool configure(const NotifyPolicyConfig& newConfig);
+    const NotifyPolicyConfig& getConfig() const;
+    void reset();
+    void forceNext();
+
+    bool evaluate(int16_t value, uint32_t now);
+    void markNotified(int16_t value, uint32_t now);
+    uint32_t timeUntilDue(uint32_t now) const;
+
+    static size_t encodeConfig(const NotifyPolicyConfig& config, uint8_t* buffer, size_t capacity);
+    static bool decodeConfig(const uint8_t* data, size_t length, NotifyPolicyConfig& config);
+};
+
+#endif // NOTIFY_POLICY_H
@@ -0,0 +1,75 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <cstdint>
+#include <string>
+
+// Subset of the Arduino String API on top of std::string
+class String : public std::string {
+public:
+    String() {}
+    String(const char* text) : std::string(text ? text : "") {}
+    String(const std::string& text) : std::string(text) {}
+    explicit String(char c) : std::string(1, c) {}
+    explicit String(int value) : std::string(std::to_string(value)) {}
+    explicit String(unsigned int value) : std::string(std::to_string(value)) {}
+    explicit String(long value) : std::string(std::to_string(value)) {}
+    explicit String(unsigned long value) : std::string(std::to_string(value)) {}
+    explicit String(double value, unsigned char decimalPlaces = 2);
+};
+
+// Virtual millisecond clock for native builds.
+// delay() advances it, so code paced by millis()/delay() can be driven
+// deterministically from tests.
+class NativeClock {
+private:
+    static uint32_t nowMs;
+
+public:
+    static uint32_t now() { return nowMs; }
+    static void set(uint32_t ms) { nowMs = ms; }
+    static void advance(uint32_t ms) { nowMs += ms; }
+};
+
+inline unsigned long millis() { return NativeClock::now(); }
+inline unsigned long micros() { return NativeClock::now() * 1000UL; }
+inline void delay(uint32_t ms) { NativeClock::advance(ms); }
+
+// Minimal stand-in for the Arduino Serial object, writing to stdout
+class NativeSerial {
+private:
+    bool enabled;
+
+public:
+    NativeSerial() : enabled(true) {}
+
+    // The host simulator mutes firmware output for long runs
+    void setEnabled(bool on) { enabled = on; }
+    bool isEnabled() const { return enabled; }
+
+    void begin(unsigned long) {}
+    void print(const char* text);
+    void print(const String& text);
+    void print(char c);
+    void print(int number);
+    void print(unsigned int number);
+    void print(long number);
+    void print(unsigned long number);
+    void print(double number);
+    void println();
+    size_t write(const char* buffer, size_t size);
+
+    template <typename T>
+    void println(const T& value) {
+        print(value);
+        println();
+    }
+};
+
+extern NativeSerial Serial;
+#endif
+
+#endif // PLATFORM_H
@@ -0,0 +1,74 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stdint.h>
+#include "scheduler.h"
+
+// Power configuration
+// POWER_MIN_CPU_MHZ is the clock while every lane waits; without power
+// management support in the SDK the CPU runs at it all the time.
+#ifndef POWER_MIN_CPU_MHZ
+#define POWER_MIN_CPU_MHZ 80
+#endif
+
+// Waits shorter than this are not worth a light-sleep entry and exit
+#ifndef POWER_LIGHT_SLEEP_MIN_MS
+#define POWER_LIGHT_SLEEP_MIN_MS 10
+#endif
+
+enum PowerState {
+    POWER_ACTIVE = 0,       // at least one lane is running
+    POWER_IDLE = 1,         // every lane waits, CPU clocked down
+    POWER_LIGHT_SLEEP = 2,  // every lane waits long enough to light-sleep
+    POWER_STATE_COUNT = 3
+};
+
+// CPU power states driven by the scheduler
+// Each lane reports when it blocks in Scheduler::sleepUntilNext() and when
+// it wakes up again. Once every lane waits, the earliest of their deadlines
+// is the next time any module has work: a wait of at least
+// POWER_LIGHT_SLEEP_MIN_MS is spent in light sleep, a shorter one idle at
+// the reduced clock.
+//
+// On the chip, begin() hands the mechanics to esp_pm: frequency scaling
+// between the default clock and POWER_MIN_CPU_MHZ, plus automatic light
+// sleep when FreeRTOS tickless idle is built in. FreeRTOS then sleeps until
+// the earliest lane deadline by itself, and the WiFi and BLE drivers hold
+// the chip awake while they need it. The counters record what the scheduler
+// allowed, in microseconds; the host simulator turns them into an energy
+// estimate.
+class PowerManager {
+public:
+    static const uint32_t ALL_LANES = (1u << Scheduler::MAX_LANES) - 1;
+
+private:
+    static uint32_t idleLanes;                      // bit per waiting lane
+    static uint32_t wakeAt[Scheduler::MAX_LANES];   // millis() each waiting lane wakes at
+    static PowerState state;
+    static uint32_t stateSince;                     // micros()
+    static uint64_t residency[POWER_STATE_COUNT];
+    static uint32_t wakeups;
+    static bool lightSleepEnabled;
+
+    static void switchTo(PowerState newState, uint32_t nowMicros);
+
+public:
+    // Configures frequency scaling and light sleep; call once from setup()
+    static void begin();
+    // Clears the counters; every lane counts as running again
+    static void reset();
+
+    // Called by the scheduler around a lane's sleep, from that lane's task
+    static void enterIdle(uint32_t laneMask, uint32_t waitMs);
+    static void exitIdle(uint32_t laneMask);
+
+    static PowerState getState();
+    static const char* getStateName(PowerState powerState);
+    // Time spent in a state so far, including the current stretch
+    static uint64_t getResidency(PowerState powerState);
+    // Returns from IDLE or LIGHT_SLEEP to ACTIVE
+    static uint32_t getWakeups();
+    static bool isLightSleepEnabled();
+};
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,95 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+typedef void (*TaskCallback)();
+
+// Cooperative task scheduler
+// Jobs live in a fixed-size binary min-heap ordered by deadline (ties run in
+// registration order), so the main loop only runs what is due and then
+// sleeps until the next deadline. Periodic jobs are fixed-rate: the next
+// deadline is derived from the previous one, not from when the job ran.
+//
+// Jobs are grouped into lanes, one per FreeRTOS task that runs a scheduler
+// loop. Each lane has its own heap and is only ever run and modified by its
+// own task; the lane a job joins is the calling task's current lane. Job ids
+// are unique across lanes, and trigger() may be called from any task.
+class Scheduler {
+public:
+    static const int MAX_TASKS = 16;      // jobs per lane
+    static const int MAX_LANES = 3;
+    static const int MAX_JOBS = MAX_TASKS * MAX_LANES;
+    static const int INVALID_TASK = -1;
+
+private:
+    struct Task {
+        TaskCallback callback;
+        const char* name;
+        uint32_t period;      // 0 = one-shot
+        uint32_t deadline;
+        uint32_t order;       // registration sequence, breaks deadline ties
+        uint32_t runCount;
+        uint32_t maxLateness; // worst observed (run time - deadline)
+        int heapIndex;        // -1 when the slot is free
+    };
+
+    struct Lane {
+        Task tasks[MAX_TASKS];
+        int heap[MAX_TASKS];
+        int heapSize;
+        uint32_t nextOrder;
+        volatile uint32_t pendingMask;
+        void* owner;          // FreeRTOS task sleeping on this lane
+
+        bool runsBefore(int a, int b) const;
+        void place(int pos, int slot);
+        void siftUp(int pos);
+        void siftDown(int pos);
+        void removeAt(int pos);
+        void applyPendingTriggers(uint32_t now);
+    };
+
+    static Lane lanes[MAX_LANES];
+
+    static Lane& current();
+    static Task* find(int id);
+
+public:
+    static void reset();
+
+    // Lane used by the calling task for registration and runDue()
+    static void setLane(int lane);
+    static int getLane();
+
+    static int addPeriodic(const char* name, TaskCallback callback, uint32_t period,
+                           uint32_t firstDelay, uint32_t now);
+    static int addPeriodic(const char* name, TaskCallback callback, uint32_t period,
+                           uint32_t firstDelay = 0);
+    static int addOneShot(const char* name, TaskCallback callback, uint32_t delayMs,
+                          uint32_t now);
+    static int addOneShot(const char* name, TaskCallback callback, uint32_t delayMs);
+    static bool cancel(int id);
+    static bool setPeriod(int id, uint32_t period);
+    static bool isScheduled(int id);
+
+    // Run a job on the next pass of its lane. Safe to call from other tasks
+    // (BLE host callbacks, WiFi events, other lanes); also wakes the lane.
+    static void trigger(int id);
+    static void wake(int lane);
+    static void wake();
+
+    static int runDue(uint32_t now);
+    static int runDue();
+    static uint32_t timeUntilNext(uint32_t now);
+    // On native every lane shares the simulator thread, so this sleeps until
+    // the earliest deadline of any lane
+    static void sleepUntilNext(uint32_t maxSleep);
+
+    static int taskCount();
+    static const char* getName(int id);
+    static uint32_t getRunCount(int id);
+    static uint32_t getMaxLateness(int id);
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,89 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+// Single-writer sequence lock around a small plain struct
+// The writer never waits: it makes the sequence odd, copies the value in and
+// makes it even again. Readers never block the writer; they copy the value
+// out and retry if the sequence was odd or changed meanwhile, so a read
+// either returns one complete write or tries again. Values are copied a word
+// at a time with relaxed atomics, which keeps a torn copy that is about to
+// be discarded from being undefined behaviour.
+//
+// A reader that keeps missing backs off, so one that preempted the writer
+// mid-write on the same core lets it finish instead of spinning forever.
+template <typename T>
+class Seqlock {
+public:
+    Seqlock() : sequence(0) {
+        for (uint32_t i = 0; i < WORDS; i++) {
+            words[i] = 0;
+        }
+    }
+
+    // Only ever called from one task
+    void write(const T& value) {
+        uint32_t in[WORDS];
+        memcpy(in, &value, sizeof(T));
+        uint32_t start = sequence;
+        __atomic_store_n(&sequence, start + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        for (uint32_t i = 0; i < WORDS; i++) {
+            __atomic_store_n(&words[i], in[i], __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&sequence, start + 2, __ATOMIC_RELEASE);
+    }
+
+    // Any number of tasks; retries only while a write is in progress
+    void read(T& value) const {
+        uint32_t out[WORDS];
+        for (uint32_t attempt = 1;; attempt++) {
+            uint32_t start = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+            if ((start & 1u) == 0) {
+                for (uint32_t i = 0; i < WORDS; i++) {
+                    out[i] = __atomic_load_n(&words[i], __ATOMIC_RELAXED);
+                }
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&sequence, __ATOMIC_RELAXED) == start) {
+                    memcpy(&value, out, sizeof(T));
+                    return;
+                }
+            }
+            if (attempt % SPINS_BEFORE_BACKOFF == 0) {
+                backoff();
+            }
+        }
+    }
+
+    // Number of completed writes
+    uint32_t getVersion() const {
+        return __atomic_load_n(&sequence, __ATOMIC_ACQUIRE) >> 1;
+    }
+
+private:
+    static_assert(sizeof(T) % sizeof(uint32_t) == 0, "Seqlock values must be whole 32-bit words");
+    static const uint32_t WORDS = sizeof(T) / sizeof(uint32_t);
+    static const uint32_t SPINS_BEFORE_BACKOFF = 16;
+
+    static void backoff() {
+#ifdef ARDUINO
+        vTaskDelay(1);
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    uint32_t sequence;
+    uint32_t words[WORDS];
+};
+
+#endif // SEQLOCK_H
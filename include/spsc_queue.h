@@ -0,0 +1,64 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+
+// Lock-free single-producer/single-consumer queue of fixed-size items
+// One task pushes, one task pops; neither ever blocks or takes a lock, so it
+// can hand data between FreeRTOS tasks on different cores and between
+// std::threads in the native tests alike. Indices run freely and are masked
+// on access, so a full queue holds exactly CAPACITY items. The producer
+// publishes an item with a release store of `head` after copying it in; the
+// consumer frees the slot the same way through `tail`.
+template <typename T, uint32_t N>
+class SpscQueue {
+public:
+    static const uint32_t CAPACITY = N;
+
+    SpscQueue() : head(0), tail(0) {}
+
+    // Consumer side, or before either side has started
+    void clear() {
+        __atomic_store_n(&tail, __atomic_load_n(&head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    }
+
+    // Producer side; fails instead of overwriting when the queue is full
+    bool push(const T& item) {
+        uint32_t writeIndex = head;
+        if (writeIndex - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= CAPACITY) {
+            return false;
+        }
+        items[writeIndex & (CAPACITY - 1)] = item;
+        __atomic_store_n(&head, writeIndex + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& item) {
+        uint32_t readIndex = tail;
+        if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == readIndex) {
+            return false;
+        }
+        item = items[readIndex & (CAPACITY - 1)];
+        __atomic_store_n(&tail, readIndex + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Either side; only a snapshot while the other side is running
+    uint32_t size() const {
+        return __atomic_load_n(&head, __ATOMIC_ACQUIRE) - __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    static_assert((N & (N - 1)) == 0 && N > 0, "SpscQueue capacity must be a power of two");
+
+    T items[N];
+    uint32_t head;      // written by the producer
+    uint32_t tail;      // written by the consumer
+};
+
+#endif // SPSC_QUEUE_H
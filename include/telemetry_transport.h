@@ -0,0 +1,101 @@
+#ifndef TELEMETRY_TRANSPORT_H
+#define TELEMETRY_TRANSPORT_H
+
+#include "platform.h"
+
+// Outcome of the publish in progress
+enum TelemetryPublishResult {
+    TELEMETRY_PUBLISH_BUSY = 0,
+    TELEMETRY_PUBLISH_ACKED = 1,    // the server has taken the whole batch
+    TELEMETRY_PUBLISH_FAILED = 2
+};
+
+// Outbound link used by TelemetryUplink
+// publish() hands over one encoded batch and returns at once; poll() reports
+// when the server has acknowledged it. HttpTelemetryTransport POSTs from its
+// own task, so a slow server never stalls the network lane; native builds use
+// FakeTelemetryTransport, an in-process stand-in for the server that tests
+// and the host simulator script.
+class TelemetryTransport {
+public:
+    virtual ~TelemetryTransport() {}
+    // Copies `payload` and starts sending it; false while a previous publish
+    // is still in progress. Payloads longer than maxPayload() are refused.
+    virtual bool publish(const char* payload, size_t length) = 0;
+    virtual size_t maxPayload() const = 0;
+    virtual TelemetryPublishResult poll() = 0;
+    // Gives up on the publish in progress; its result is never reported
+    virtual void cancel() = 0;
+};
+
+#ifdef ARDUINO
+
+class HttpTelemetryTransport : public TelemetryTransport {
+public:
+    static const size_t MAX_PAYLOAD = 1024;
+    static const uint16_t TIMEOUT_MS = 5000;
+
+private:
+    const char* url;
+    TaskHandle_t task;
+    char body[MAX_PAYLOAD];
+    size_t bodyLength;
+    volatile bool busy;                 // cleared by the worker task
+    volatile bool abandoned;
+    volatile TelemetryPublishResult result;
+
+    static void worker(void* parameter);
+
+public:
+    explicit HttpTelemetryTransport(const char* url);
+
+    bool publish(const char* payload, size_t length);
+    size_t maxPayload() const;
+    TelemetryPublishResult poll();
+    void cancel();
+};
+
+#else
+
+#include <vector>
+
+class FakeTelemetryTransport : public TelemetryTransport {
+public:
+    static const size_t DEFAULT_MAX_PAYLOAD = 1024;    // as HttpTelemetryTransport
+
+private:
+    bool busy;
+    bool online;
+    uint32_t latency;
+    uint32_t startedAt;
+    size_t payloadLimit;
+    std::string inFlight;
+
+    void record(const std::string& payload);
+
+public:
+    // Every sample sequence number in acknowledged batches, duplicates included
+    std::vector<uint32_t> sequences;
+    std::string lastPayload;
+    int publishCount;
+    int ackCount;
+    int cancelCount;
+
+    FakeTelemetryTransport();
+
+    // Scripting hooks for tests and the host simulator
+    void reset();
+    void setOnline(bool isOnline);      // offline: every publish fails
+    void setLatency(uint32_t ms);       // time from publish() to the ack
+    void setMaxPayload(size_t length);
+    bool isBusy() const;
+
+    bool publish(const char* payload, size_t length);
+    size_t maxPayload() const;
+    TelemetryPublishResult poll();
+    void cancel();
+};
+
+#endif
+
+#endif // TELEMETRY_TRANSPORT_H
@@ -0,0 +1,135 @@
+#ifndef TELEMETRY_UPLINK_H
+#define TELEMETRY_UPLINK_H
+
+#include "platform.h"
+#include "spsc_queue.h"
+#include "backoff.h"
+#include "telemetry_transport.h"
+
+// Telemetry configuration
+// Set the endpoint in platformio.ini, like the WiFi credentials:
+//   -D TELEMETRY_URL='"http://192.168.1.10:8080/telemetry"'
+// An empty URL turns the uplink off on the device.
+#ifndef TELEMETRY_URL
+#define TELEMETRY_URL ""
+#endif
+
+// A batch is published once it holds TELEMETRY_BATCH_SAMPLES samples, or
+// TELEMETRY_BATCH_INTERVAL ms after its first sample went in
+#ifndef TELEMETRY_BATCH_SAMPLES
+#define TELEMETRY_BATCH_SAMPLES 16
+#endif
+
+#ifndef TELEMETRY_BATCH_INTERVAL
+#define TELEMETRY_BATCH_INTERVAL 300000
+#endif
+
+// A backlog longer than this (after an outage or a reboot) is downsampled
+// evenly, so catching up never takes more than about this many samples
+#ifndef TELEMETRY_BACKLOG_SAMPLES
+#define TELEMETRY_BACKLOG_SAMPLES 240
+#endif
+
+// One history sample on its way to the server
+struct TelemetrySample {
+    uint32_t sequence;
+    uint32_t timestamp;
+    int16_t centiCelsius;
+};
+
+// Batched, acknowledged upload of the temperature history over WiFi
+// Split between two tasks like TemperatureService: collect() runs in the
+// publishing task, which owns the history, and copies new samples into a
+// bounded lock-free queue. When the queue is full it simply stops; the
+// samples wait in the history, so a slow or absent link costs nothing but
+// history depth. A backlog longer than TELEMETRY_BACKLOG_SAMPLES is thinned
+// out evenly (the newest sample is always kept), and samples the history
+// overwrote before they were collected are counted as dropped.
+//
+// loop() runs in the network task. It moves queued samples into a batch,
+// publishes it through the transport while WiFiManager is connected and
+// polls for the acknowledgement. A batch is only discarded once acked: a
+// failure backs off and a lost connection cancels the publish, and the same
+// batch goes out again, so the upload resumes after the last acked sequence
+// number. Each pass does at most one publish and never waits on the network.
+// A batch that does not fit the transport's maxPayload() goes out as the
+// longest prefix that does, and the rest follows in the next publish.
+//
+// Payload (JSON): {"uptime":<millis()>,"samples":[[sequence,timestamp,centiCelsius],...]}
+// Timestamps are on the device's millis() clock; the server places them
+// against the uptime sent with the batch.
+class TelemetryUplink {
+public:
+    static const uint32_t QUEUE_SIZE = 64;
+    static const uint32_t BATCH_SAMPLES = TELEMETRY_BATCH_SAMPLES;
+    static const uint32_t BATCH_INTERVAL = TELEMETRY_BATCH_INTERVAL;
+    static const uint32_t BACKLOG_SAMPLES = TELEMETRY_BACKLOG_SAMPLES;
+    static const uint32_t CHECK_INTERVAL = 1000;      // network task pass
+    static const uint32_t COLLECT_INTERVAL = 10000;   // publishing task pass
+    static const uint32_t PUBLISH_TIMEOUT = 15000;    // ack wait before giving up
+    static const size_t PAYLOAD_SIZE = 40 + 32 * TELEMETRY_BATCH_SAMPLES;
+
+private:
+    static TelemetryTransport* transport;
+    static SpscQueue<TelemetrySample, QUEUE_SIZE> queue;
+
+    // Publishing task
+    static bool collecting;
+    static uint32_t cursor;             // next history sequence to collect
+    static uint32_t stride;             // > 1 while a long backlog is thinned out
+    static volatile uint32_t droppedSamples;
+    static volatile uint32_t downsampledSamples;
+
+    // Network task
+    static TelemetrySample batch[BATCH_SAMPLES];
+    static uint32_t batchCount;
+    static uint32_t batchSent;          // samples in the publish in flight
+    static uint32_t batchStartedAt;
+    static bool inFlight;
+    static uint32_t publishStartedAt;
+    static bool linkUp;
+    static bool retryPending;
+    static uint32_t retryAt;
+    static ExponentialBackoff backoff;
+    static bool hasAcked;
+    static uint32_t ackedSequence;
+    static uint32_t publishedBatches;
+    static uint32_t failedPublishes;
+    static uint32_t oversizedBatches;
+    static char payload[PAYLOAD_SIZE];
+    static int loopTaskId;
+
+    static void fillBatch(uint32_t now);
+    static void publishBatch(uint32_t now);
+    static void finishPublish(TelemetryPublishResult result, uint32_t now);
+    static size_t encodeBatch(uint32_t now, size_t limit, uint32_t& count);
+
+    static_assert(TELEMETRY_BATCH_SAMPLES > 0 && TELEMETRY_BATCH_SAMPLES <= QUEUE_SIZE,
+                  "TELEMETRY_BATCH_SAMPLES must fit the outbound queue");
+#ifdef ARDUINO
+    static_assert(PAYLOAD_SIZE <= HttpTelemetryTransport::MAX_PAYLOAD,
+                  "a full TELEMETRY_BATCH_SAMPLES batch must fit one HTTP publish");
+#endif
+
+public:
+    // Registers loop() in the current lane; collect() is registered by the
+    // caller in the lane that publishes samples. Starts from the oldest sample
+    // in the history.
+    static void init();
+    static void setTransport(TelemetryTransport* newTransport);
+    static bool isEnabled();
+
+    static void collect();
+    static void loop();
+
+    // Safe from any task, as a snapshot
+    static bool getAckedSequence(uint32_t& sequence);
+    static uint32_t getPublishedBatches();
+    static uint32_t getFailedPublishes();
+    static uint32_t getOversizedBatches();  // batches split for the transport limit
+    static uint32_t getQueuedSamples();
+    static uint32_t getDroppedSamples();
+    static uint32_t getDownsampledSamples();
+};
+
+#endif // TELEMETRY_UPLINK_H
@@ -0,0 +1,184 @@
+#ifndef TEMPERATURE_FILTER_H
+#define TEMPERATURE_FILTER_H
+
+#include <stdint.h>
+
+// Fixed-point filter stages for centi-degree readings
+// Every stage has the same two calls: process() takes one input and returns
+// true with an output, or false while it is still collecting, and reset()
+// forgets everything. Stages keep their state in fixed-size members, so a
+// pipeline never allocates and its size is known at compile time.
+
+// Averages every N consecutive inputs into one output, rounded half away
+// from zero. N == 1 passes inputs straight through.
+template <uint8_t N>
+class OversampleStage {
+public:
+    static const uint8_t INPUTS_PER_OUTPUT = N;
+
+    OversampleStage() {
+        reset();
+    }
+
+    bool process(int32_t input, int32_t& output) {
+        sum += input;
+        if (++count < N) {
+            return false;
+        }
+        output = (sum + (sum < 0 ? -(int32_t)N / 2 : (int32_t)N / 2)) / (int32_t)N;
+        reset();
+        return true;
+    }
+
+    void reset() {
+        sum = 0;
+        count = 0;
+    }
+
+private:
+    static_assert(N > 0, "OversampleStage needs at least one input per output");
+
+    int32_t sum;
+    uint8_t count;
+};
+
+// Median of the last K inputs; a spike shorter than half the window never
+// reaches the output. Until the window has filled, the median of the inputs
+// so far (the mean of the middle two for an even count). K == 1 passes
+// inputs straight through.
+template <uint8_t K>
+class MedianStage {
+public:
+    static const uint8_t INPUTS_PER_OUTPUT = 1;
+
+    MedianStage() {
+        reset();
+    }
+
+    bool process(int32_t input, int32_t& output) {
+        // Keep a sorted copy of the window: drop the oldest value, insert the new one
+        uint8_t size = filled;
+        if (filled == K) {
+            uint8_t oldest = 0;
+            while (sorted[oldest] != window[next]) {
+                oldest++;
+            }
+            for (; oldest + 1 < size; oldest++) {
+                sorted[oldest] = sorted[oldest + 1];
+            }
+            size--;
+        } else {
+            filled++;
+        }
+        uint8_t position = size;
+        while (position > 0 && sorted[position - 1] > input) {
+            sorted[position] = sorted[position - 1];
+            position--;
+        }
+        sorted[position] = input;
+        window[next] = input;
+        next = (uint8_t)((next + 1) % K);
+
+        uint8_t middle = filled / 2;
+        if (filled % 2 == 1) {
+            output = sorted[middle];
+        } else {
+            int32_t sum = sorted[middle - 1] + sorted[middle];
+            output = (sum + (sum < 0 ? -1 : 1)) / 2;
+        }
+        return true;
+    }
+
+    void reset() {
+        next = 0;
+        filled = 0;
+    }
+
+private:
+    static_assert(K % 2 == 1 && K <= 15, "MedianStage needs an odd window of at most 15");
+
+    int32_t window[K];      // in arrival order
+    int32_t sorted[K];      // the same values, ascending
+    uint8_t next;
+    uint8_t filled;
+};
+
+// Exponential moving average with alpha = 1 / 2^SHIFT
+// The average carries 8 extra fractional bits so small steps are not lost to
+// truncation; the first input seeds it. SHIFT == 0 passes inputs straight
+// through.
+template <uint8_t SHIFT>
+class EmaStage {
+public:
+    static const uint8_t INPUTS_PER_OUTPUT = 1;
+
+    EmaStage() {
+        reset();
+    }
+
+    bool process(int32_t input, int32_t& output) {
+        int32_t scaled = input * (1 << FRACTION_BITS);
+        if (!seeded) {
+            average = scaled;
+            seeded = true;
+        } else {
+            // Arithmetic shift: rounds toward minus infinity for either sign
+            average += (scaled - average) >> SHIFT;
+        }
+        output = (average + (1 << (FRACTION_BITS - 1))) >> FRACTION_BITS;
+        return true;
+    }
+
+    void reset() {
+        average = 0;
+        seeded = false;
+    }
+
+private:
+    static const uint8_t FRACTION_BITS = 8;
+    static_assert(SHIFT <= 8, "EmaStage alpha below 1/256 is not supported");
+
+    int32_t average;
+    bool seeded;
+};
+
+// Stages composed at compile time, applied left to right
+// An input that a stage holds back (oversampling) ends the pass there.
+template <typename... Stages>
+class FilterPipeline;
+
+template <>
+class FilterPipeline<> {
+public:
+    static const uint32_t INPUTS_PER_OUTPUT = 1;
+
+    bool process(int32_t input, int32_t& output) {
+        output = input;
+        return true;
+    }
+
+    void reset() {}
+};
+
+template <typename Head, typename... Tail>
+class FilterPipeline<Head, Tail...> {
+public:
+    // Raw inputs needed for each output
+    static const uint32_t INPUTS_PER_OUTPUT = Head::INPUTS_PER_OUTPUT * FilterPipeline<Tail...>::INPUTS_PER_OUTPUT;
+
+    bool process(int32_t input, int32_t& output) {
+        int32_t intermediate;
+        return head.process(input, intermediate) && tail.process(intermediate, output);
+    }
+
+    void reset() {
+        head.reset();
+        tail.reset();
+    }
+
+private:
+    Head head;
+    FilterPipeline<Tail...> tail;
+};
+
+#endif // TEMPERATURE_FILTER_H
@@ -0,0 +1,86 @@
+#ifndef TEMPERATURE_HISTORY_H
+#define TEMPERATURE_HISTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Rolling statistics windows kept alongside the history
+enum HistoryWindow {
+    WINDOW_1_MIN = 0,
+    WINDOW_1_HOUR = 1,
+    WINDOW_24_HOURS = 2,
+    WINDOW_COUNT = 3
+};
+
+// One stored reading: timestamp in ms and value in centi-degrees Celsius
+struct HistorySample {
+    uint32_t timestamp;
+    int16_t value;
+};
+
+// Statistics over one window, in centi-degrees Celsius
+struct WindowStats {
+    uint32_t count;
+    float mean;
+    float variance;  // population variance, centi-degrees squared
+    int16_t min;
+    int16_t max;
+};
+
+// Fixed-capacity temperature history
+// Samples live in a power-of-two ring buffer allocated once by begin() (in
+// PSRAM when available). Every sample gets a sequence number; each window
+// keeps running sums plus monotonic min/max deques of sequence numbers, so
+// add() and getStats() are O(1) amortised and never rescan the buffer.
+class TemperatureHistory {
+private:
+    struct Window {
+        uint32_t span;        // window length in ms
+        uint32_t firstSeq;    // oldest sample still inside the window
+        uint32_t count;
+        int64_t sum;
+        int64_t sumSquares;
+        uint32_t* minDeque;   // ascending values, front is the minimum
+        uint32_t* maxDeque;   // descending values, front is the maximum
+        uint32_t minHead, minTail;
+        uint32_t maxHead, maxTail;
+    };
+
+    uint32_t capacity;
+    uint32_t mask;
+    uint32_t nextSeq;         // sequence number of the next sample
+    uint32_t* timestamps;
+    int16_t* values;
+    void* storage;
+    Window windows[WINDOW_COUNT];
+
+    int16_t valueAt(uint32_t seq) const;
+    uint32_t timestampAt(uint32_t seq) const;
+    void pushToWindow(Window& window, uint32_t seq);
+    void popFromWindow(Window& window);
+    void clearWindow(Window& window);
+
+public:
+    static const uint32_t DEFAULT_CAPACITY = 4096;  // ~34 hours at one sample per 30 s
+
+    TemperatureHistory();
+    ~TemperatureHistory();
+
+    bool begin(uint32_t requestedCapacity = DEFAULT_CAPACITY);
+    void end();
+    void clear();
+
+    void add(uint32_t timestamp, int16_t value);
+    void expire(uint32_t now);
+    bool setWindowSpan(HistoryWindow window, uint32_t spanMs);
+    uint32_t getWindowSpan(HistoryWindow window) const;
+    bool getStats(HistoryWindow window, WindowStats& stats) const;
+
+    uint32_t getCapacity() const;
+    uint32_t size() const;
+    uint32_t getFirstSequence() const;
+    uint32_t getNextSequence() const;
+    bool getSample(uint32_t seq, HistorySample& sample) const;
+};
+
+#endif // TEMPERATURE_HISTORY_H
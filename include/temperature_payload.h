@@ -0,0 +1,38 @@
+#ifndef TEMPERATURE_PAYLOAD_H
+#define TEMPERATURE_PAYLOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Packed temperature notification, version 1 (16 bytes, little-endian):
+//   [0]       version
+//   [1]       unit (0 = Celsius, 1 = Fahrenheit)
+//   [2..5]    sample sequence number
+//   [6..9]    sample timestamp, ms since boot
+//   [10..11]  current temperature, hundredths of the unit
+//   [12..13]  maximum temperature, hundredths of the unit
+//   [14..15]  minimum temperature, hundredths of the unit
+// Later versions may only append fields; decoders ignore trailing bytes.
+#define TEMPERATURE_PAYLOAD_VERSION 1
+#define TEMPERATURE_PAYLOAD_SIZE    16
+
+// One consistent current/max/min triple as sent over BLE
+struct TemperatureReading {
+    uint32_t sequence;
+    uint32_t timestamp;
+    int16_t current;
+    int16_t max;
+    int16_t min;
+    uint8_t unit;
+};
+
+class TemperaturePayload {
+public:
+    static size_t encode(const TemperatureReading& reading, uint8_t* out, size_t capacity);
+    static bool decode(const uint8_t* data, size_t length, TemperatureReading& reading);
+
+    // Hundredths of a degree, saturated to the int16_t range
+    static int16_t toFixedPoint(float temperature);
+};
+
+#endif // TEMPERATURE_PAYLOAD_H
@@ -0,0 +1,132 @@
+#ifndef TEMPERATURE_SENSOR_H
+#define TEMPERATURE_SENSOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "seqlock.h"
+
+// Outcome of polling a conversion
+enum SensorPoll {
+    SENSOR_BUSY = 0,      // still converting, poll again later
+    SENSOR_READY = 1,     // result written
+    SENSOR_ERROR = 2      // conversion failed (bus error, CRC, disconnected)
+};
+
+// Temperature sensor driver
+// Conversions are split in two so no driver ever blocks the sampling task:
+// startConversion() kicks one off and returns, pollResult() returns
+// SENSOR_BUSY until the result is in. A 1-Wire sensor that needs 750 ms per
+// conversion is simply polled a few dozen times meanwhile. Results are
+// hundredths of a degree Celsius.
+class TemperatureSensor {
+public:
+    virtual ~TemperatureSensor() {}
+    virtual const char* name() = 0;
+    virtual bool startConversion(uint32_t now) = 0;
+    virtual SensorPoll pollResult(uint32_t now, int16_t& centiCelsius) = 0;
+};
+
+// The original fake generator, a value between -15.5 and -5.5 C derived from
+// the time the conversion started; always ready on the first poll
+class FakeTemperatureSensor : public TemperatureSensor {
+private:
+    uint32_t startedAt;
+
+public:
+    FakeTemperatureSensor();
+
+    const char* name();
+    bool startConversion(uint32_t now);
+    SensorPoll pollResult(uint32_t now, int16_t& centiCelsius);
+};
+
+// Plays back a fixed sequence of readings, wrapping at the end
+// Each conversion takes `conversionMs`; entries equal to REPLAY_ERROR report
+// SENSOR_ERROR instead of a value. Deterministic, for tests and the simulator.
+class ReplayTemperatureSensor : public TemperatureSensor {
+public:
+    static const int16_t REPLAY_ERROR = INT16_MIN;
+
+private:
+    const char* sensorName;
+    const int16_t* values;
+    size_t count;
+    size_t position;
+    uint32_t conversionMs;
+    uint32_t startedAt;
+    bool converting;
+
+public:
+    uint32_t startCount;
+    uint32_t pollCount;
+
+    ReplayTemperatureSensor(const char* name, const int16_t* values, size_t count, uint32_t conversionMs = 0);
+
+    void reset();
+
+    const char* name();
+    bool startConversion(uint32_t now);
+    SensorPoll pollResult(uint32_t now, int16_t& centiCelsius);
+};
+
+// Per-sensor counters and range, in centi-degrees Celsius
+struct SensorStats {
+    uint32_t readings;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t lastTimestamp;   // when the last good conversion started
+    int32_t last;
+    int32_t min;
+    int32_t max;
+};
+
+// Receives each finished conversion; index 0 is the primary sensor
+typedef void (*SensorReadingHandler)(int index, uint32_t timestamp, int16_t centiCelsius);
+
+// Fixed-size set of sensors sampled together without blocking
+// startAll() starts a conversion on every idle sensor; poll() then checks the
+// pending ones once each and never waits. Each pass starts one sensor further
+// along, so with many sensors a slow one can not always be served first.
+// A conversion that does not finish within CONVERSION_TIMEOUT is abandoned.
+// Only the sampling task calls start/poll; getStats() is safe from any task.
+class SensorRegistry {
+public:
+    static const int MAX_SENSORS = 4;
+    static const uint32_t CONVERSION_TIMEOUT = 1500;  // ms; a DS18B20 needs 750
+
+private:
+    struct Slot {
+        TemperatureSensor* sensor;
+        bool pending;
+        uint32_t startedAt;
+        SensorStats stats;        // written by the sampling task
+        Seqlock<SensorStats> published;
+    };
+
+    Slot slots[MAX_SENSORS];
+    int sensorCount;
+    int nextPoll;
+
+    void publish(Slot& slot);
+
+public:
+    SensorRegistry();
+
+    void clear();
+    int add(TemperatureSensor* sensor);
+    int count() const;
+    TemperatureSensor* get(int index);
+
+    void startAll(uint32_t now);
+    // Starts one idle sensor again, e.g. from the reading handler
+    bool start(int index, uint32_t now);
+    // Returns true while any conversion is still pending
+    bool poll(uint32_t now, SensorReadingHandler handler);
+    bool isPending() const;
+    // Forget conversions in flight, e.g. when the service restarts
+    void cancelAll();
+
+    bool getStats(int index, SensorStats& stats) const;
+};
+
+#endif // TEMPERATURE_SENSOR_H
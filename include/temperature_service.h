@@ -1,37 +1,182 @@
 #ifndef TEMPERATURE_SERVICE_H
 #define TEMPERATURE_SERVICE_H
 
-#include <Arduino.h>
+#include "platform.h"
+#include "temperature_history.h"
+#include "history_rollup.h"
+#include "temperature_payload.h"
+#include "spsc_queue.h"
+#include "seqlock.h"
+#include "temperature_units.h"
+#include "temperature_sensor.h"
+#include "temperature_filter.h"
+#include "sample_log.h"
+#include "config_store.h"
 
-// Temperature unit configuration
-enum TemperatureUnit {
-    CELSIUS = 0,
-    FAHRENHEIT = 1
+// Filter applied to the primary sensor's readings, see temperature_filter.h
+// Each published sample averages TEMPERATURE_OVERSAMPLE back-to-back
+// conversions, then passes a sliding median over TEMPERATURE_MEDIAN_WINDOW
+// samples and an EMA with alpha = 1 / 2^TEMPERATURE_EMA_SHIFT.
+#ifndef TEMPERATURE_OVERSAMPLE
+#define TEMPERATURE_OVERSAMPLE 4
+#endif
+
+#ifndef TEMPERATURE_MEDIAN_WINDOW
+#define TEMPERATURE_MEDIAN_WINDOW 3
+#endif
+
+#ifndef TEMPERATURE_EMA_SHIFT
+#define TEMPERATURE_EMA_SHIFT 2
+#endif
+
+typedef FilterPipeline<OversampleStage<TEMPERATURE_OVERSAMPLE>,
+                       MedianStage<TEMPERATURE_MEDIAN_WINDOW>,
+                       EmaStage<TEMPERATURE_EMA_SHIFT> > TemperatureFilter;
+
+// Rolling statistics over one history window, in the configured unit
+struct TemperatureStats {
+    uint32_t count;
+    float mean;
+    float variance;
+    float min;
+    float max;
+};
+
+// Current, max and min in hundredths of one unit, all from the same sample
+struct TemperatureSnapshot {
+    uint32_t sequence;
+    uint32_t timestamp;
+    int16_t current;
+    int16_t max;
+    int16_t min;
+    TemperatureUnit unit;
+};
+
+// One filtered reading on its way from the sampling task to the publisher
+struct TemperatureSample {
+    uint32_t timestamp;
+    int16_t centiCelsius;
 };
 
+// Invoked whenever a new reading or unit makes the published values stale
+// Called from the sampling task when a sample is queued, so it must only
+// hand off (e.g. Scheduler::trigger()), never touch the service state.
+typedef void (*TemperatureChangeCallback)();
+
 // Temperature service class
+// Split between two tasks: acquire() runs in the sampling task and only
+// starts a conversion on every registered sensor, polling them until done
+// without blocking; the primary (first) sensor's readings are filtered and
+// queued, the others only feed their per-sensor stats. processSamples() runs in the
+// publishing task and owns everything derived from the samples (current,
+// max/min, history and its rollups, sequence). sample() does both for
+// single-task callers.
+//
+// Values are kept as hundredths of a degree Celsius and published through a
+// seqlock, so any task can take a consistent snapshot without locking.
+//
+// With a flash area set (the "samplelog" partition on the chip), every
+// published sample is also handed to writeLog() in the network task, which
+// appends it to a SampleLog; init() restores max/min and the history from it. The
+// unit is applied, in integers, when the snapshot is taken; setUnit() never
+// rewrites the stored values, so toggling the unit can not drift them and a
+// reader can not see a mix of Celsius and Fahrenheit.
+//
+// The unit and the sample interval are ConfigStore settings: setUnit()
+// stores the unit there, and a new interval takes effect with a sample
+// taken right away.
 class TemperatureService {
+public:
+    static const uint32_t SAMPLE_QUEUE_SIZE = 8;
+    static const uint32_t LOG_QUEUE_SIZE = 32;      // ~16 minutes of samples
+
 private:
-    static float currentTemp;
-    static float maxTemp;
-    static float minTemp;
-    static TemperatureUnit unit;
-    static unsigned long lastUpdateTime;
-    static const unsigned long UPDATE_INTERVAL = 30000; // 30 seconds in milliseconds
+    // Published state in centi-degrees Celsius; all words so the seqlock can copy it
+    struct State {
+        uint32_t sequence;
+        uint32_t timestamp;
+        int32_t current;
+        int32_t max;
+        int32_t min;
+    };
+
+    static State state;                 // owned by the publishing task
+    static Seqlock<State> published;
+    static volatile TemperatureUnit unit;
+    static uint32_t lastSampleMicros;
+    static uint32_t sampleInterval;     // CONFIG_SAMPLE_INTERVAL as last applied
+    static const uint32_t POLL_INTERVAL = 20;           // while a conversion is pending
+    static int updateTaskId;
+    static int pollTaskId;
+    static bool hasReading;
+    static SensorRegistry sensors;
+    static TemperatureFilter filter;    // owned by the sampling task
+    static uint32_t groupStartedAt;     // first conversion of the sample being oversampled
+    static uint32_t groupReadings;
+    static bool restarted;
+    static TemperatureHistory history;
+    static HistoryRollup rollup;        // 1 min/15 min/1 h buckets of the history
+    static volatile bool dirty;
+    static TemperatureChangeCallback changeCallback;
+    static SpscQueue<TemperatureSample, SAMPLE_QUEUE_SIZE> samples;
+    static volatile uint32_t droppedSamples;
+    static FlashStorage* logStorage;
+    static SampleLog sampleLog;         // owned by the network task after init()
+    static uint32_t logOffset;          // this boot's millis() minus log time
+    static SpscQueue<LoggedSample, LOG_QUEUE_SIZE> logQueue;
+    static volatile uint32_t droppedLogSamples;
     
-    static float generateFakeTemperature();
-    static float celsiusToFahrenheit(float celsius);
-    static float fahrenheitToCelsius(float fahrenheit);
+    static void markDirty();
+    static void applyUnit(TemperatureUnit newUnit);
+    static void configChanged(ConfigKey key, uint32_t value);
+    static void applySample(const TemperatureSample& reading);
+    static void pollSensors();
+    static void pollJob();
+    static void sensorReading(int index, uint32_t timestamp, int16_t centiCelsius);
+    static void restoreFromLog();
+    static void restoreSample(const LoggedSample& sample);
+    static float fromCentiCelsius(float centiCelsius, TemperatureUnit target);
 
 public:
     static void init();
     static void update();
+    static void sample();
+    static void acquire();
+    static int processSamples();
+    static uint32_t getDroppedSamples();
+
+    // Flash area for the persistent sample log, set before init(); nullptr
+    // turns logging off. writeLog() runs in the network task.
+    static void setLogStorage(FlashStorage* storage);
+    static void writeLog();
+    static bool flushLog();
+    static uint32_t getDroppedLogSamples();
+
+    // Sensors are registered before init(); the fake sensor is used if none are.
+    // The first one registered is the primary.
+    static int addSensor(TemperatureSensor* sensor);
+    static void clearSensors();
+    static int getSensorCount();
+    static const char* getSensorName(int index);
+    static bool getSensorStats(int index, SensorStats& stats);
+
+    // Safe from any task; lock-free, never blocks the publishing task
+    static void getSnapshot(TemperatureSnapshot& snapshot);
+    // Single values in degrees of the current unit, each from its own snapshot
     static float getCurrentTemperature();
     static float getMaxTemperature();
     static float getMinTemperature();
     static TemperatureUnit getUnit();
     static void setUnit(TemperatureUnit newUnit);
     static bool shouldUpdate();
+    static uint32_t getSequence();
+    static void getReading(TemperatureReading& reading);
+    static const TemperatureHistory& getHistory();
+    static const HistoryRollup& getRollup();
+    static bool getWindowStats(HistoryWindow window, TemperatureStats& stats);
+    static bool isDirty();
+    static bool takeDirty();
+    static void setChangeCallback(TemperatureChangeCallback callback);
 };
 
 #endif // TEMPERATURE_SERVICE_H
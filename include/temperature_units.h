@@ -0,0 +1,47 @@
+#ifndef TEMPERATURE_UNITS_H
+#define TEMPERATURE_UNITS_H
+
+#include <stdint.h>
+
+// Temperature unit configuration
+enum TemperatureUnit {
+    CELSIUS = 0,
+    FAHRENHEIT = 1
+};
+
+// Fixed-point temperature conversions
+// Readings are kept as hundredths of a degree Celsius and only converted when
+// they are presented (BLE encode, serial). Conversions work on int32_t so the
+// intermediate never overflows, and saturate when narrowed to int16_t.
+// Everything is constexpr, so constant inputs fold at compile time and the
+// checks below run in every build.
+class TemperatureUnits {
+public:
+    static constexpr int16_t saturate(int32_t value) {
+        return value > INT16_MAX ? (int16_t)INT16_MAX
+             : value < INT16_MIN ? (int16_t)INT16_MIN
+             : (int16_t)value;
+    }
+
+    // F = C * 9/5 + 32 in hundredths, rounded half away from zero; nine
+    // fifths of a whole number of hundredths never lands on a tie
+    static constexpr int32_t celsiusToFahrenheit(int32_t centiCelsius) {
+        return (centiCelsius * 18 + (centiCelsius < 0 ? -5 : 5)) / 10 + 3200;
+    }
+
+    // Hundredths of the requested unit, saturated to the int16_t wire range
+    static constexpr int16_t fromCentiCelsius(int32_t centiCelsius, TemperatureUnit unit) {
+        return saturate(unit == FAHRENHEIT ? celsiusToFahrenheit(centiCelsius) : centiCelsius);
+    }
+};
+
+static_assert(TemperatureUnits::celsiusToFahrenheit(0) == 3200, "0 C is 32 F");
+static_assert(TemperatureUnits::celsiusToFahrenheit(10000) == 21200, "100 C is 212 F");
+static_assert(TemperatureUnits::celsiusToFahrenheit(-4000) == -4000, "-40 C is -40 F");
+static_assert(TemperatureUnits::celsiusToFahrenheit(-1) == 3198, "-0.01 C rounds to 31.98 F");
+static_assert(TemperatureUnits::fromCentiCelsius(INT16_MAX, FAHRENHEIT) == INT16_MAX,
+              "327.67 C saturates in Fahrenheit");
+static_assert(TemperatureUnits::fromCentiCelsius(-20000, FAHRENHEIT) == INT16_MIN,
+              "-200 C saturates in Fahrenheit");
+
+#endif // TEMPERATURE_UNITS_H
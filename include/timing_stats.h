@@ -0,0 +1,131 @@
+#ifndef TIMING_STATS_H
+#define TIMING_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "platform.h"
+
+// With dynamic frequency scaling the CPU clock, and so the cycle counter's
+// rate, changes under a running timer; the 1 MHz esp_timer does not
+#if defined(ARDUINO) && CONFIG_PM_ENABLE
+#include <esp_timer.h>
+#define TIMING_USE_ESP_TIMER 1
+#else
+#define TIMING_USE_ESP_TIMER 0
+#endif
+
+// Code sections and intervals tracked by TimingStats
+enum TimingProbe {
+    PROBE_LOOP = 0,          // one Scheduler::runDue() pass
+    PROBE_WIFI,              // WiFiManager::loop()
+    PROBE_TEMPERATURE,       // TemperatureService::acquire(), once per sample
+    PROBE_BLE,               // BLEServerManager::loop()
+    PROBE_BLE_TEMP,          // temperature publish/notify job
+    PROBE_BLE_HISTORY,       // history dump streaming pass
+    PROBE_SAMPLE_JITTER,     // deviation of the sampling interval from its period
+    PROBE_SENSOR_POLL,       // background poll of a pending conversion
+    PROBE_COUNT
+};
+
+// Percentiles of one probe, in microseconds
+struct TimingSummary {
+    uint32_t count;
+    uint32_t mean;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t max;
+};
+
+// Log-linear histogram of microsecond values
+// Values below 8 get exact buckets; above that every power of two is split
+// into 4 linear sub-buckets, so a bucket is at most 25% wide. Values of
+// 2^28 us (~4.5 minutes) and above share the last bucket; max stays exact.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 2;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 27;
+    static const int BUCKET_COUNT = 2 * SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    void clear();
+    void record(uint32_t value);
+    uint32_t getCount() const;
+    uint32_t getMax() const;
+    uint32_t getMean() const;
+    // Upper bound of the bucket holding the q-th quantile (0..1000 per-mille)
+    uint32_t percentile(uint16_t perMille) const;
+
+    static int bucketFor(uint32_t value);
+    static uint32_t bucketUpperBound(int bucket);
+
+private:
+    uint32_t count;
+    uint64_t sum;
+    uint32_t maxValue;
+    uint32_t buckets[BUCKET_COUNT];
+};
+
+// Wire format of the diagnostics characteristic (little-endian):
+//   [0]     version
+//   [1]     number of probes
+//   then per probe, in TimingProbe order: count, p50, p99, max (u32 each, us)
+#define TIMING_SNAPSHOT_VERSION     1
+#define TIMING_SNAPSHOT_PROBE_SIZE  16
+#define TIMING_SNAPSHOT_SIZE        (2 + PROBE_COUNT * TIMING_SNAPSHOT_PROBE_SIZE)
+
+// Fixed set of histograms fed by ScopedTimer; no heap allocation
+class TimingStats {
+private:
+    static LatencyHistogram histograms[PROBE_COUNT];
+    static uint32_t cyclesPerMicro;
+
+public:
+    static void reset();
+    // Call after every fixed clock change; unused with TIMING_USE_ESP_TIMER
+    static void setCpuFrequency(uint32_t mhz);
+    static void record(TimingProbe probe, uint32_t micros);
+    static bool getSummary(TimingProbe probe, TimingSummary& summary);
+    static const char* getName(TimingProbe probe);
+    static size_t encodeSnapshot(uint8_t* buffer, size_t capacity);
+    static void printSummary();
+
+    // Free-running tick counter: CPU cycles on target at a fixed clock,
+    // microseconds under frequency scaling and on native
+    static uint32_t ticks() {
+#if TIMING_USE_ESP_TIMER
+        return (uint32_t)esp_timer_get_time();
+#elif defined(ARDUINO)
+        return ESP.getCycleCount();
+#else
+        return nativeMicros();
+#endif
+    }
+    static uint32_t ticksToMicros(uint32_t elapsedTicks) {
+#if defined(ARDUINO) && !TIMING_USE_ESP_TIMER
+        return elapsedTicks / cyclesPerMicro;
+#else
+        return elapsedTicks;
+#endif
+    }
+
+#ifndef ARDUINO
+    static uint32_t nativeMicros();
+#endif
+};
+
+// Records the time spent in the enclosing scope
+class ScopedTimer {
+private:
+    TimingProbe probe;
+    uint32_t start;
+
+public:
+    explicit ScopedTimer(TimingProbe probe) : probe(probe), start(TimingStats::ticks()) {}
+    ~ScopedTimer() {
+        TimingStats::record(probe, TimingStats::ticksToMicros(TimingStats::ticks() - start));
+    }
+};
+
+#endif // TIMING_STATS_H
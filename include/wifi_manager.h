@@ -1,18 +1,9 @@
 #ifndef WIFI_MANAGER_H
 #define WIFI_MANAGER_H
 
-#ifdef ARDUINO
-#include <Arduino.h>
-#include <WiFi.h>
-#else
-#include <cstdint>
-#include <string>
-
-using String = std::string;
-
-inline void delay(uint32_t) {}
-inline unsigned long millis() { return 0; }
-#endif
+#include "platform.h"
+#include "wifi_radio.h"
+#include "backoff.h"
 
 // WiFi Configuration
 // Note: For security, WiFi credentials should be defined in platformio.ini using build_flags
@@ -30,22 +21,48 @@ inline unsigned long millis() { return 0; }
 #define WIFI_PASSWORD    "YourPassword"    // Change this to your WiFi password
 #endif
 
-#define WIFI_TIMEOUT_MS  20000             // WiFi connection timeout in milliseconds
+#define WIFI_TIMEOUT_MS  20000             // default connection timeout, see CONFIG_WIFI_TIMEOUT
+
+// Connection state machine: IDLE -> CONNECTING -> CONNECTED, with BACKOFF
+// between failed attempts. loop() advances it one step and never blocks.
+// The attempt timeout and the backoff range are ConfigStore settings, read
+// as each attempt runs and fails.
+enum WiFiState {
+    WIFI_STATE_IDLE = 0,
+    WIFI_STATE_CONNECTING = 1,
+    WIFI_STATE_CONNECTED = 2,
+    WIFI_STATE_BACKOFF = 3
+};
 
 // WiFi Manager class
 class WiFiManager {
 private:
-    static bool connected;
-    static unsigned long lastConnectionAttempt;
+    static WiFiRadio* radio;
+    static WiFiState state;
+    static bool autoReconnect;
+    static unsigned long stateEnteredAt;
+    static unsigned long retryDelay;
     static int connectionAttempts;
-    static const int MAX_CONNECTION_ATTEMPTS = 3;
-    static const unsigned long RECONNECT_INTERVAL = 30000; // 30 seconds
+    static volatile uint32_t pendingEvents;
+    static ExponentialBackoff backoff;
+    static const unsigned long CHECK_INTERVAL = 1000;      // connection upkeep period
+    static int loopTaskId;
+
+    static void enterState(WiFiState newState, unsigned long now);
+    static void startAttempt(unsigned long now);
+    static void failAttempt(unsigned long now, const char* reason);
+    static void onRadioEvent(WiFiRadioEvent event);
 
 public:
     static void init();
     static void connect();
     static void disconnect();
     static void loop();
+    static void setRadio(WiFiRadio* newRadio);
+    static WiFiState getState();
+    static const char* getStateName();
+    static int getConnectionAttempts();
+    static unsigned long getRetryDelay();
     static bool isConnected();
     static String getIPAddress();
     static String getMACAddress();
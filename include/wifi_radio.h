@@ -0,0 +1,89 @@
+#ifndef WIFI_RADIO_H
+#define WIFI_RADIO_H
+
+#include "platform.h"
+
+// Link state as seen by the WiFi connection state machine
+enum WiFiLinkStatus {
+    RADIO_LINK_DOWN = 0,
+    RADIO_LINK_UP = 1,
+    RADIO_LINK_FAILED = 2  // association rejected or SSID not found
+};
+
+// Asynchronous radio events forwarded to WiFiManager
+enum WiFiRadioEvent {
+    RADIO_EVENT_GOT_IP = 0,
+    RADIO_EVENT_DISCONNECTED = 1
+};
+
+typedef void (*WiFiRadioEventHandler)(WiFiRadioEvent event);
+
+// Radio abstraction used by WiFiManager
+// ArduinoWiFiRadio drives the real WiFi stack; native builds use FakeWiFiRadio
+// so every state machine transition can be scripted from tests and the host
+// simulator.
+class WiFiRadio {
+public:
+    virtual ~WiFiRadio() {}
+    virtual void setStationMode() = 0;
+    virtual void begin(const char* ssid, const char* password) = 0;
+    virtual void disconnect() = 0;
+    virtual WiFiLinkStatus status() = 0;
+    virtual void setEventHandler(WiFiRadioEventHandler handler) = 0;
+    virtual uint32_t randomSeed() = 0;
+    virtual String localIP() = 0;
+    virtual String macAddress() = 0;
+    virtual int rssi() = 0;
+    virtual String ssid() = 0;
+};
+
+#ifdef ARDUINO
+
+class ArduinoWiFiRadio : public WiFiRadio {
+public:
+    void setStationMode();
+    void begin(const char* ssid, const char* password);
+    void disconnect();
+    WiFiLinkStatus status();
+    void setEventHandler(WiFiRadioEventHandler handler);
+    uint32_t randomSeed();
+    String localIP();
+    String macAddress();
+    int rssi();
+    String ssid();
+};
+
+#else
+
+class FakeWiFiRadio : public WiFiRadio {
+private:
+    WiFiLinkStatus linkStatus;
+    WiFiRadioEventHandler eventHandler;
+    String connectedSsid;
+
+public:
+    int beginCount;
+    int disconnectCount;
+
+    FakeWiFiRadio();
+
+    // Scripting hooks for tests and the host simulator
+    void reset();
+    void setLinkStatus(WiFiLinkStatus status);
+    void emit(WiFiRadioEvent event);
+
+    void setStationMode();
+    void begin(const char* ssid, const char* password);
+    void disconnect();
+    WiFiLinkStatus status();
+    void setEventHandler(WiFiRadioEventHandler handler);
+    uint32_t randomSeed();
+    String localIP();
+    String macAddress();
+    int rssi();
+    String ssid();
+};
+
+#endif
+
+#endif // WIFI_RADIO_H
@@ -0,0 +1,265 @@
+#ifndef SIM_NIMBLE_DEVICE_H
+#define SIM_NIMBLE_DEVICE_H
+
+// In-process stand-in for the subset of NimBLE-Arduino 1.4 used by the
+// firmware. Only on the include path of native builds; the central side of
+// every connection is driven through SimBLE (sim_ble.h).
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#ifndef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#define CONFIG_BT_NIMBLE_MAX_CONNECTIONS 3
+#endif
+
+#define BLE_HS_IO_DISPLAY_ONLY   0
+#define BLE_HS_CONN_HANDLE_NONE  0xFFFF
+#define BLE_ATT_MTU_DFLT         23
+#define BLE_ATT_ATTR_MAX_LEN     512
+
+// Flat stand-in for the NimBLE mbuf chain carrying an attribute value
+struct os_mbuf {
+    uint16_t om_len;
+    uint8_t om_data[BLE_ATT_ATTR_MAX_LEN];
+};
+
+// NimBLE host calls the firmware uses directly: notify one connection
+// regardless of its CCCD. Returns 0 on success; always consumes `om`.
+struct os_mbuf* ble_hs_mbuf_from_flat(const void* buf, uint16_t len);
+int ble_gattc_notify_custom(uint16_t conn_handle, uint16_t att_handle, struct os_mbuf* om);
+
+// Security of a link; the stack sets it once pairing encrypted the link
+struct ble_gap_sec_state {
+    unsigned encrypted:1;
+    unsigned authenticated:1;   // paired with MITM protection (passkey)
+    unsigned bonded:1;
+    unsigned key_size:5;
+};
+
+struct ble_gap_conn_desc {
+    uint16_t conn_handle;
+    uint16_t conn_itvl;
+    uint16_t conn_latency;
+    uint16_t supervision_timeout;
+    struct ble_gap_sec_state sec_state;
+};
+
+// Server-initiated MTU exchange; the result arrives through onMTUChange()
+struct ble_gatt_error;
+typedef int ble_gatt_mtu_fn(uint16_t conn_handle, const struct ble_gatt_error* error, uint16_t mtu, void* arg);
+int ble_gattc_exchange_mtu(uint16_t conn_handle, ble_gatt_mtu_fn* cb, void* cb_arg);
+
+// Parameters of one connection as the stack currently has them
+class NimBLEConnInfo {
+private:
+    ble_gap_conn_desc desc;
+    uint16_t mtu;
+
+public:
+    NimBLEConnInfo() : mtu(0) { desc = ble_gap_conn_desc(); desc.conn_handle = BLE_HS_CONN_HANDLE_NONE; }
+    NimBLEConnInfo(const ble_gap_conn_desc& desc, uint16_t mtu) : desc(desc), mtu(mtu) {}
+
+    uint16_t getConnHandle() const { return desc.conn_handle; }
+    uint16_t getConnInterval() const { return desc.conn_itvl; }
+    uint16_t getConnLatency() const { return desc.conn_latency; }
+    uint16_t getConnTimeout() const { return desc.supervision_timeout; }
+    uint16_t getMTU() const { return mtu; }
+};
+
+namespace NIMBLE_PROPERTY {
+enum {
+    READ = 0x0001,
+    READ_ENC = 0x0002,
+    READ_AUTHEN = 0x0004,
+    READ_AUTHOR = 0x0008,
+    WRITE = 0x0010,
+    WRITE_NR = 0x0020,
+    WRITE_ENC = 0x0040,
+    WRITE_AUTHEN = 0x0080,
+    WRITE_AUTHOR = 0x0100,
+    BROADCAST = 0x0200,
+    NOTIFY = 0x0400,
+    INDICATE = 0x0800
+};
+}
+
+class NimBLEServer;
+class NimBLEService;
+class NimBLECharacteristic;
+
+// 128-bit UUID, kept little-endian like ble_uuid128_t. Only the
+// "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx" text form and 16-byte binary
+// values are supported; anything else yields the all-zero UUID.
+class NimBLEUUID {
+private:
+    uint8_t value[16];
+
+public:
+    NimBLEUUID();
+    NimBLEUUID(const char* uuid);
+    NimBLEUUID(const std::string& uuid);
+    // Binary form; msbFirst says the bytes are in the order they are written
+    NimBLEUUID(const uint8_t* data, size_t size, bool msbFirst);
+
+    // Lowercase text form
+    std::string toString() const;
+    bool operator==(const NimBLEUUID& other) const;
+    bool operator!=(const NimBLEUUID& other) const { return !(*this == other); }
+};
+
+class NimBLEServerCallbacks {
+public:
+    virtual ~NimBLEServerCallbacks() {}
+    virtual void onConnect(NimBLEServer* pServer) {}
+    virtual void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {}
+    virtual void onDisconnect(NimBLEServer* pServer) {}
+    virtual void onDisconnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {}
+    virtual void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) {}
+};
+
+class NimBLECharacteristicCallbacks {
+public:
+    virtual ~NimBLECharacteristicCallbacks() {}
+    virtual void onRead(NimBLECharacteristic* pCharacteristic) {}
+    virtual void onRead(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc) {}
+    virtual void onWrite(NimBLECharacteristic* pCharacteristic) {}
+    virtual void onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc) {}
+    virtual void onSubscribe(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc,
+                             uint16_t subValue) {}
+};
+
+class NimBLECharacteristic {
+private:
+    NimBLEUUID uuid;
+    uint32_t properties;
+    uint16_t maxLength;
+    uint16_t handle;
+    std::string value;
+    NimBLECharacteristicCallbacks* callbacks;
+    std::vector<uint16_t> subscribers;
+    uint32_t setValueCount;
+    uint32_t notifyCount;
+    uint32_t notifyBytes;
+
+    friend class SimBLE;
+
+public:
+    NimBLECharacteristic(const NimBLEUUID& uuid, uint32_t properties, uint16_t maxLength);
+
+    void setValue(const uint8_t* data, size_t length);
+    void setValue(const std::string& newValue);
+    void setValue(const char* text);
+    std::string getValue() const { return value; }
+    void setCallbacks(NimBLECharacteristicCallbacks* pCallbacks) { callbacks = pCallbacks; }
+    NimBLECharacteristicCallbacks* getCallbacks() const { return callbacks; }
+    NimBLEUUID getUUID() const { return uuid; }
+    uint16_t getHandle() const { return handle; }
+    uint32_t getProperties() const { return properties; }
+    size_t getSubscribedCount() const { return subscribers.size(); }
+
+    // Sends the current value to every subscribed connection, truncated to its MTU
+    void notify(bool is_notification = true);
+    void notify(const uint8_t* data, size_t length, bool is_notification = true);
+    void indicate() { notify(false); }
+};
+
+class NimBLEService {
+private:
+    NimBLEUUID uuid;
+    std::vector<NimBLECharacteristic*> characteristics;
+    bool started;
+
+    friend class SimBLE;
+
+public:
+    explicit NimBLEService(const NimBLEUUID& uuid);
+    ~NimBLEService();
+
+    NimBLECharacteristic* createCharacteristic(const char* uuid,
+                                               uint32_t properties = NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE,
+                                               uint16_t maxLength = BLE_ATT_ATTR_MAX_LEN);
+    NimBLECharacteristic* createCharacteristic(const NimBLEUUID& uuid,
+                                               uint32_t properties = NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE,
+                                               uint16_t maxLength = BLE_ATT_ATTR_MAX_LEN);
+    NimBLECharacteristic* getCharacteristic(const char* uuid);
+    NimBLEUUID getUUID() const { return uuid; }
+    bool start();
+    bool isStarted() const { return started; }
+};
+
+class NimBLEAdvertising {
+private:
+    std::vector<NimBLEUUID> serviceUUIDs;
+    bool advertising;
+    bool scanResponse;
+    uint16_t minInterval;
+    uint16_t maxInterval;
+
+    friend class SimBLE;
+
+public:
+    NimBLEAdvertising();
+
+    void addServiceUUID(const char* uuid) { serviceUUIDs.push_back(NimBLEUUID(uuid)); }
+    void addServiceUUID(const NimBLEUUID& uuid) { serviceUUIDs.push_back(uuid); }
+    void setScanResponse(bool enabled) { scanResponse = enabled; }
+    void setMinPreferred(uint16_t) {}
+    void setMaxPreferred(uint16_t) {}
+    void setMinInterval(uint16_t interval) { minInterval = interval; }
+    void setMaxInterval(uint16_t interval) { maxInterval = interval; }
+    uint16_t getMinInterval() const { return minInterval; }
+    uint16_t getMaxInterval() const { return maxInterval; }
+    bool start(uint32_t duration = 0);
+    bool stop();
+    bool isAdvertising() const { return advertising; }
+};
+
+class NimBLEServer {
+private:
+    std::vector<NimBLEService*> services;
+    NimBLEServerCallbacks* callbacks;
+    bool deleteCallbacks;
+    bool advertiseOnDisconnectEnabled;
+
+    friend class SimBLE;
+
+public:
+    NimBLEServer();
+    ~NimBLEServer();
+
+    void setCallbacks(NimBLEServerCallbacks* pCallbacks, bool deleteCallbacks = true);
+    NimBLEService* createService(const char* uuid);
+    NimBLEService* createService(const NimBLEUUID& uuid);
+    NimBLEService* getServiceByUUID(const char* uuid);
+    bool startAdvertising();
+    bool stopAdvertising();
+    void advertiseOnDisconnect(bool enabled) { advertiseOnDisconnectEnabled = enabled; }
+    size_t getConnectedCount();
+    uint16_t getPeerMTU(uint16_t connHandle);
+    NimBLEConnInfo getPeerIDInfo(uint16_t connHandle);
+    void updateConnParams(uint16_t connHandle, uint16_t minInterval, uint16_t maxInterval,
+                          uint16_t latency, uint16_t timeout);
+    void setDataLen(uint16_t connHandle, uint16_t octets);
+    int disconnect(uint16_t connHandle, uint8_t reason = 0x13);
+};
+
+class NimBLEDevice {
+public:
+    static void init(const std::string& deviceName);
+    static void deinit(bool clearAll = false);
+    static void setSecurityAuth(bool bonding, bool mitm, bool sc) {}
+    static void setSecurityPasskey(uint32_t passkey) {}
+    static void setSecurityIOCap(uint8_t ioCap) {}
+    static void setPower(int powerLevel) {}
+    static bool setMTU(uint16_t mtu);
+    static uint16_t getMTU();
+    static NimBLEServer* createServer();
+    static NimBLEServer* getServer();
+    static NimBLEAdvertising* getAdvertising();
+    static bool startAdvertising();
+    static bool stopAdvertising();
+};
+
+#endif // SIM_NIMBLE_DEVICE_H
@@ -0,0 +1,67 @@
+#include "memory_probe.h"
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new/delete of the simulator and the unit
+// tests so FakeMemoryProbe sees the firmware's heap use: every block carries
+// its size in a header, and NativeHeap counts what is live. Only C++
+// allocations are seen; the firmware has no malloc() of its own. The
+// benchmark build leaves this file out, since bench/bench_alloc.cpp
+// replaces the same operators.
+
+static const size_t HEADER_SIZE = 16;   // keeps blocks 16-byte aligned
+
+static void* allocate(size_t size) {
+    void* block = std::malloc(size + HEADER_SIZE);
+    if (block == nullptr) {
+        return nullptr;
+    }
+    *(size_t*)block = size;
+    NativeHeap::allocated(size);
+    return (char*)block + HEADER_SIZE;
+}
+
+static void release(void* pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    void* block = (char*)pointer - HEADER_SIZE;
+    NativeHeap::released(*(size_t*)block);
+    std::free(block);
+}
+
+void* operator new(size_t size) {
+    void* pointer = allocate(size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    release(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    release(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    release(pointer);
+}
@@ -0,0 +1,753 @@
+#include "NimBLEDevice.h"
+#include "sim_ble.h"
+#include "platform.h"
+#include <string.h>
+
+// Default of CONFIG_BT_NIMBLE_ATT_PREFERRED_MTU in the Arduino core
+static const uint16_t DEFAULT_PREFERRED_MTU = 256;
+
+static NimBLEServer* server = nullptr;
+static NimBLEAdvertising* advertising = nullptr;
+static uint16_t preferredMtu = DEFAULT_PREFERRED_MTU;
+static uint16_t nextAttributeHandle = 1;
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Parses the 36-character text form into little-endian bytes, as NimBLE does
+static bool parseUUID(const char* text, uint8_t* value) {
+    if (text == nullptr || strlen(text) != 36) {
+        return false;
+    }
+    int nibble = 0;
+    for (int i = 0; i < 36; i++) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (text[i] != '-') {
+                return false;
+            }
+            continue;
+        }
+        int digit = hexDigit(text[i]);
+        if (digit < 0) {
+            return false;
+        }
+        uint8_t& byte = value[15 - nibble / 2];
+        byte = (nibble % 2 == 0) ? (uint8_t)(digit << 4) : (uint8_t)(byte | digit);
+        nibble++;
+    }
+    return true;
+}
+
+NimBLEUUID::NimBLEUUID() {
+    memset(value, 0, sizeof(value));
+}
+
+NimBLEUUID::NimBLEUUID(const char* uuid) {
+    if (!parseUUID(uuid, value)) {
+        memset(value, 0, sizeof(value));
+    }
+}
+
+NimBLEUUID::NimBLEUUID(const std::string& uuid) {
+    if (!parseUUID(uuid.c_str(), value)) {
+        memset(value, 0, sizeof(value));
+    }
+}
+
+NimBLEUUID::NimBLEUUID(const uint8_t* data, size_t size, bool msbFirst) {
+    memset(value, 0, sizeof(value));
+    if (size != sizeof(value)) {
+        return;
+    }
+    for (size_t i = 0; i < sizeof(value); i++) {
+        value[i] = msbFirst ? data[sizeof(value) - 1 - i] : data[i];
+    }
+}
+
+std::string NimBLEUUID::toString() const {
+    static const char DIGITS[] = "0123456789abcdef";
+    std::string text;
+    text.reserve(36);
+    for (int byte = 15; byte >= 0; byte--) {
+        text += DIGITS[value[byte] >> 4];
+        text += DIGITS[value[byte] & 0x0F];
+        if (byte == 12 || byte == 10 || byte == 8 || byte == 6) {
+            text += '-';
+        }
+    }
+    return text;
+}
+
+bool NimBLEUUID::operator==(const NimBLEUUID& other) const {
+    return memcmp(value, other.value, sizeof(value)) == 0;
+}
+
+// Characteristic
+
+NimBLECharacteristic::NimBLECharacteristic(const NimBLEUUID& uuid, uint32_t properties, uint16_t maxLength)
+    : uuid(uuid), properties(properties), maxLength(maxLength), handle(nextAttributeHandle++), callbacks(nullptr),
+      setValueCount(0), notifyCount(0), notifyBytes(0) {}
+
+void NimBLECharacteristic::setValue(const uint8_t* data, size_t length) {
+    if (length > maxLength) {
+        length = maxLength;
+    }
+    value.assign((const char*)data, length);
+    setValueCount++;
+}
+
+void NimBLECharacteristic::setValue(const std::string& newValue) {
+    setValue((const uint8_t*)newValue.data(), newValue.size());
+}
+
+void NimBLECharacteristic::setValue(const char* text) {
+    setValue(std::string(text ? text : ""));
+}
+
+void NimBLECharacteristic::notify(bool /*is_notification*/) {
+    SimBLE::deliverNotification(this, (const uint8_t*)value.data(), value.size());
+}
+
+void NimBLECharacteristic::notify(const uint8_t* data, size_t length, bool /*is_notification*/) {
+    SimBLE::deliverNotification(this, data, length);
+}
+
+// Host API
+
+struct os_mbuf* ble_hs_mbuf_from_flat(const void* buf, uint16_t len) {
+    if (len > BLE_ATT_ATTR_MAX_LEN) {
+        return nullptr;
+    }
+    os_mbuf* om = new os_mbuf;
+    om->om_len = len;
+    memcpy(om->om_data, buf, len);
+    return om;
+}
+
+int ble_gattc_notify_custom(uint16_t conn_handle, uint16_t att_handle, struct os_mbuf* om) {
+    if (om == nullptr) {
+        return -1;
+    }
+    bool sent = SimBLE::deliverTo(conn_handle, att_handle, om->om_data, om->om_len);
+    delete om;
+    return sent ? 0 : -1;
+}
+
+int ble_gattc_exchange_mtu(uint16_t conn_handle, ble_gatt_mtu_fn* /*cb*/, void* /*cb_arg*/) {
+    return SimBLE::serverExchangeMTU(conn_handle) ? 0 : -1;
+}
+
+// Service
+
+NimBLEService::NimBLEService(const NimBLEUUID& uuid) : uuid(uuid), started(false) {}
+
+NimBLEService::~NimBLEService() {
+    for (size_t i = 0; i < characteristics.size(); i++) {
+        delete characteristics[i];
+    }
+}
+
+NimBLECharacteristic* NimBLEService::createCharacteristic(const char* uuid, uint32_t properties,
+                                                          uint16_t maxLength) {
+    return createCharacteristic(NimBLEUUID(uuid), properties, maxLength);
+}
+
+NimBLECharacteristic* NimBLEService::createCharacteristic(const NimBLEUUID& uuid, uint32_t properties,
+                                                          uint16_t maxLength) {
+    NimBLECharacteristic* characteristic = new NimBLECharacteristic(uuid, properties, maxLength);
+    characteristics.push_back(characteristic);
+    return characteristic;
+}
+
+NimBLECharacteristic* NimBLEService::getCharacteristic(const char* uuid) {
+    NimBLEUUID target(uuid);
+    for (size_t i = 0; i < characteristics.size(); i++) {
+        if (characteristics[i]->getUUID() == target) {
+            return characteristics[i];
+        }
+    }
+    return nullptr;
+}
+
+bool NimBLEService::start() {
+    started = true;
+    return true;
+}
+
+// Advertising
+
+NimBLEAdvertising::NimBLEAdvertising()
+    : advertising(false), scanResponse(true), minInterval(0), maxInterval(0) {}
+
+bool NimBLEAdvertising::start(uint32_t /*duration*/) {
+    // The controller cannot advertise connectable once every slot is taken
+    if (advertising || SimBLE::getConnectionCount() >= SimBLE::MAX_CONNECTIONS) {
+        return false;
+    }
+    advertising = true;
+    SimBLE::recordAdvertisingStart();
+    return true;
+}
+
+bool NimBLEAdvertising::stop() {
+    advertising = false;
+    return true;
+}
+
+// Server
+
+NimBLEServer::NimBLEServer()
+    : callbacks(nullptr), deleteCallbacks(false), advertiseOnDisconnectEnabled(true) {}
+
+NimBLEServer::~NimBLEServer() {
+    for (size_t i = 0; i < services.size(); i++) {
+        delete services[i];
+    }
+    if (deleteCallbacks) {
+        delete callbacks;
+    }
+}
+
+void NimBLEServer::setCallbacks(NimBLEServerCallbacks* pCallbacks, bool shouldDelete) {
+    if (deleteCallbacks && callbacks != pCallbacks) {
+        delete callbacks;
+    }
+    callbacks = pCallbacks;
+    deleteCallbacks = shouldDelete;
+}
+
+NimBLEService* NimBLEServer::createService(const char* uuid) {
+    return createService(NimBLEUUID(uuid));
+}
+
+NimBLEService* NimBLEServer::createService(const NimBLEUUID& uuid) {
+    NimBLEService* service = new NimBLEService(uuid);
+    services.push_back(service);
+    return service;
+}
+
+NimBLEService* NimBLEServer::getServiceByUUID(const char* uuid) {
+    NimBLEUUID target(uuid);
+    for (size_t i = 0; i < services.size(); i++) {
+        if (services[i]->getUUID() == target) {
+            return services[i];
+        }
+    }
+    return nullptr;
+}
+
+bool NimBLEServer::startAdvertising() {
+    return NimBLEDevice::startAdvertising();
+}
+
+bool NimBLEServer::stopAdvertising() {
+    return NimBLEDevice::stopAdvertising();
+}
+
+size_t NimBLEServer::getConnectedCount() {
+    return SimBLE::getConnectionCount();
+}
+
+uint16_t NimBLEServer::getPeerMTU(uint16_t connHandle) {
+    return SimBLE::getMTU(connHandle);
+}
+
+NimBLEConnInfo NimBLEServer::getPeerIDInfo(uint16_t connHandle) {
+    ble_gap_conn_desc desc;
+    if (!SimBLE::getConnDesc(connHandle, desc)) {
+        return NimBLEConnInfo();
+    }
+    return NimBLEConnInfo(desc, SimBLE::getMTU(connHandle));
+}
+
+void NimBLEServer::updateConnParams(uint16_t connHandle, uint16_t minInterval, uint16_t maxInterval,
+                                    uint16_t latency, uint16_t timeout) {
+    SimBLE::updateParams(connHandle, minInterval, maxInterval, latency, timeout);
+}
+
+void NimBLEServer::setDataLen(uint16_t connHandle, uint16_t octets) {
+    SimBLE::setDataLength(connHandle, octets);
+}
+
+int NimBLEServer::disconnect(uint16_t connHandle, uint8_t /*reason*/) {
+    return SimBLE::disconnect(connHandle) ? 0 : -1;
+}
+
+// Device
+
+void NimBLEDevice::init(const std::string& /*deviceName*/) {
+    if (advertising == nullptr) {
+        advertising = new NimBLEAdvertising();
+        delay(SimBLE::getInitCost());
+    }
+}
+
+void NimBLEDevice::deinit(bool /*clearAll*/) {
+    delete server;
+    server = nullptr;
+    delete advertising;
+    advertising = nullptr;
+    preferredMtu = DEFAULT_PREFERRED_MTU;
+}
+
+bool NimBLEDevice::setMTU(uint16_t mtu) {
+    if (mtu < BLE_ATT_MTU_DFLT || mtu > 527) {
+        return false;
+    }
+    preferredMtu = mtu;
+    return true;
+}
+
+uint16_t NimBLEDevice::getMTU() {
+    return preferredMtu;
+}
+
+NimBLEServer* NimBLEDevice::createServer() {
+    // Like NimBLE, there is only ever one server instance
+    if (server == nullptr) {
+        server = new NimBLEServer();
+    }
+    return server;
+}
+
+NimBLEServer* NimBLEDevice::getServer() {
+    return server;
+}
+
+NimBLEAdvertising* NimBLEDevice::getAdvertising() {
+    if (advertising == nullptr) {
+        advertising = new NimBLEAdvertising();
+    }
+    return advertising;
+}
+
+bool NimBLEDevice::startAdvertising() {
+    return getAdvertising()->start();
+}
+
+bool NimBLEDevice::stopAdvertising() {
+    return getAdvertising()->stop();
+}
+
+// Central side
+
+std::vector<SimBLE::Connection> SimBLE::connections;
+uint16_t SimBLE::nextHandle = 1;
+uint32_t SimBLE::connectCount = 0;
+uint32_t SimBLE::advertisingStarts = 0;
+SimNotifyHandler SimBLE::notifyHandler = nullptr;
+uint32_t SimBLE::initCost = 0;
+
+void SimBLE::reset() {
+    // Let the firmware see every link go down before the stack disappears
+    if (server != nullptr) {
+        server->advertiseOnDisconnectEnabled = false;
+    }
+    while (!connections.empty()) {
+        disconnect(connections.back().handle);
+    }
+    NimBLEDevice::deinit(true);
+    nextAttributeHandle = 1;
+    nextHandle = 1;
+    connectCount = 0;
+    advertisingStarts = 0;
+    notifyHandler = nullptr;
+    initCost = 0;
+}
+
+void SimBLE::setInitCost(uint32_t ms) {
+    initCost = ms;
+}
+
+uint32_t SimBLE::getInitCost() {
+    return initCost;
+}
+
+SimBLE::Connection* SimBLE::findConnection(uint16_t connHandle) {
+    for (size_t i = 0; i < connections.size(); i++) {
+        if (connections[i].handle == connHandle) {
+            return &connections[i];
+        }
+    }
+    return nullptr;
+}
+
+uint16_t SimBLE::connect(uint16_t mtu) {
+    if (server == nullptr || advertising == nullptr || !advertising->isAdvertising() ||
+        connections.size() >= MAX_CONNECTIONS) {
+        return BLE_HS_CONN_HANDLE_NONE;
+    }
+
+    // A connection ends connectable advertising, as on the real controller
+    advertising->stop();
+
+    Connection connection;
+    connection.handle = nextHandle++;
+    connection.mtu = BLE_ATT_MTU_DFLT;
+    connection.centralMtu = mtu < BLE_ATT_MTU_DFLT ? BLE_ATT_MTU_DFLT : mtu;
+    connection.dataLength = 27;
+    connection.paramUpdates = 0;
+    connection.desc.conn_handle = connection.handle;
+    connection.desc.conn_itvl = 24;           // 30 ms in 1.25 ms units
+    connection.desc.conn_latency = 0;
+    connection.desc.supervision_timeout = 400; // 4 s in 10 ms units
+    connection.desc.sec_state = ble_gap_sec_state();
+    connections.push_back(connection);
+    connectCount++;
+
+    ble_gap_conn_desc desc = connection.desc;
+    if (server->callbacks != nullptr) {
+        server->callbacks->onConnect(server);
+        server->callbacks->onConnect(server, &desc);
+    }
+    Connection* opened = findConnection(connection.handle);
+    if (opened != nullptr && opened->mtu == BLE_ATT_MTU_DFLT && mtu > BLE_ATT_MTU_DFLT) {
+        exchangeMTU(connection.handle, mtu);
+    }
+    return connection.handle;
+}
+
+void SimBLE::removeSubscriber(uint16_t connHandle) {
+    if (server == nullptr) {
+        return;
+    }
+    for (size_t s = 0; s < server->services.size(); s++) {
+        NimBLEService* service = server->services[s];
+        for (size_t c = 0; c < service->characteristics.size(); c++) {
+            std::vector<uint16_t>& subscribers = service->characteristics[c]->subscribers;
+            for (size_t i = 0; i < subscribers.size(); i++) {
+                if (subscribers[i] == connHandle) {
+                    subscribers.erase(subscribers.begin() + i);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool SimBLE::disconnect(uint16_t connHandle) {
+    for (size_t i = 0; i < connections.size(); i++) {
+        if (connections[i].handle != connHandle) {
+            continue;
+        }
+        ble_gap_conn_desc desc = connections[i].desc;
+        connections.erase(connections.begin() + i);
+        removeSubscriber(connHandle);
+
+        if (server != nullptr) {
+            if (server->callbacks != nullptr) {
+                server->callbacks->onDisconnect(server);
+                server->callbacks->onDisconnect(server, &desc);
+            }
+            if (server->advertiseOnDisconnectEnabled) {
+                server->startAdvertising();
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool SimBLE::exchangeMTU(uint16_t connHandle, uint16_t mtu) {
+    Connection* connection = findConnection(connHandle);
+    if (connection == nullptr) {
+        return false;
+    }
+    // The negotiated MTU is the smaller of both sides' preferences
+    uint16_t negotiated = mtu < preferredMtu ? mtu : preferredMtu;
+    if (negotiated < BLE_ATT_MTU_DFLT) {
+        negotiated = BLE_ATT_MTU_DFLT;
+    }
+    connection->mtu = negotiated;
+    if (server != nullptr && server->callbacks != nullptr) {
+        ble_gap_conn_desc desc = connection->desc;
+        server->callbacks->onMTUChange(negotiated, &desc);
+    }
+    return true;
+}
+
+bool SimBLE::serverExchangeMTU(uint16_t connHandle) {
+    Connection* connection = findConnection(connHandle);
+    return connection != nullptr && exchangeMTU(connHandle, connection->centralMtu);
+}
+
+// The central accepts any valid request and picks the shortest interval allowed
+bool SimBLE::updateParams(uint16_t connHandle, uint16_t minInterval, uint16_t maxInterval,
+                          uint16_t latency, uint16_t timeout) {
+    Connection* connection = findConnection(connHandle);
+    if (connection == nullptr || minInterval < 6 || minInterval > maxInterval || maxInterval > 3200 ||
+        latency > 499 || timeout < 10 || timeout > 3200) {
+        return false;
+    }
+    connection->desc.conn_itvl = minInterval;
+    connection->desc.conn_latency = latency;
+    connection->desc.supervision_timeout = timeout;
+    connection->paramUpdates++;
+    return true;
+}
+
+bool SimBLE::setDataLength(uint16_t connHandle, uint16_t octets) {
+    Connection* connection = findConnection(connHandle);
+    if (connection == nullptr || octets < 27 || octets > 251) {
+        return false;
+    }
+    connection->dataLength = octets;
+    return true;
+}
+
+bool SimBLE::subscribe(uint16_t connHandle, const char* uuid, bool enable) {
+    Connection* connection = findConnection(connHandle);
+    NimBLECharacteristic* characteristic = findCharacteristic(uuid);
+    if (connection == nullptr || characteristic == nullptr ||
+        !(characteristic->properties & (NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::INDICATE))) {
+        return false;
+    }
+
+    std::vector<uint16_t>& subscribers = characteristic->subscribers;
+    bool subscribed = false;
+    for (size_t i = 0; i < subscribers.size(); i++) {
+        if (subscribers[i] == connHandle) {
+            if (!enable) {
+                subscribers.erase(subscribers.begin() + i);
+            }
+            subscribed = true;
+            break;
+        }
+    }
+    if (enable && !subscribed) {
+        subscribers.push_back(connHandle);
+    }
+
+    if (characteristic->callbacks != nullptr) {
+        ble_gap_conn_desc desc = connection->desc;
+        characteristic->callbacks->onSubscribe(characteristic, &desc, enable ? 1 : 0);
+    }
+    return true;
+}
+
+bool SimBLE::pair(uint16_t connHandle, bool authenticated) {
+    Connection* connection = findConnection(connHandle);
+    if (connection == nullptr) {
+        return false;
+    }
+    connection->desc.sec_state.encrypted = 1;
+    connection->desc.sec_state.authenticated = authenticated ? 1 : 0;
+    connection->desc.sec_state.key_size = 16;
+    return true;
+}
+
+bool SimBLE::write(uint16_t connHandle, const char* uuid, const uint8_t* data, size_t length) {
+    Connection* connection = findConnection(connHandle);
+    NimBLECharacteristic* characteristic = findCharacteristic(uuid);
+    if (connection == nullptr || characteristic == nullptr ||
+        !(characteristic->properties & (NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR))) {
+        return false;
+    }
+    // The host refuses these before the server sees them, as NimBLE does
+    // with an insufficient encryption/authentication ATT error
+    const ble_gap_sec_state& security = connection->desc.sec_state;
+    if (((characteristic->properties & NIMBLE_PROPERTY::WRITE_ENC) && !security.encrypted) ||
+        ((characteristic->properties & NIMBLE_PROPERTY::WRITE_AUTHEN) && !security.authenticated)) {
+        return false;
+    }
+
+    // Peer writes land in the value without counting as a firmware setValue
+    characteristic->value.assign((const char*)data, length > characteristic->maxLength ? characteristic->maxLength : length);
+    if (characteristic->callbacks != nullptr) {
+        ble_gap_conn_desc desc = connection->desc;
+        characteristic->callbacks->onWrite(characteristic);
+        characteristic->callbacks->onWrite(characteristic, &desc);
+    }
+    return true;
+}
+
+bool SimBLE::read(uint16_t connHandle, const char* uuid, std::string& value) {
+    Connection* connection = findConnection(connHandle);
+    NimBLECharacteristic* characteristic = findCharacteristic(uuid);
+    if (connection == nullptr || characteristic == nullptr ||
+        !(characteristic->properties & NIMBLE_PROPERTY::READ)) {
+        return false;
+    }
+
+    if (characteristic->callbacks != nullptr) {
+        ble_gap_conn_desc desc = connection->desc;
+        characteristic->callbacks->onRead(characteristic);
+        characteristic->callbacks->onRead(characteristic, &desc);
+    }
+    value = characteristic->value;
+    return true;
+}
+
+NimBLECharacteristic* SimBLE::findCharacteristic(const char* uuid) {
+    if (server == nullptr) {
+        return nullptr;
+    }
+    NimBLEUUID target(uuid);
+    for (size_t s = 0; s < server->services.size(); s++) {
+        NimBLEService* service = server->services[s];
+        for (size_t c = 0; c < service->characteristics.size(); c++) {
+            if (service->characteristics[c]->uuid == target) {
+                return service->characteristics[c];
+            }
+        }
+    }
+    return nullptr;
+}
+
+NimBLECharacteristic* SimBLE::findCharacteristic(uint16_t attHandle) {
+    if (server == nullptr) {
+        return nullptr;
+    }
+    for (size_t s = 0; s < server->services.size(); s++) {
+        NimBLEService* service = server->services[s];
+        for (size_t c = 0; c < service->characteristics.size(); c++) {
+            if (service->characteristics[c]->handle == attHandle) {
+                return service->characteristics[c];
+            }
+        }
+    }
+    return nullptr;
+}
+
+size_t SimBLE::getConnectionCount() {
+    return connections.size();
+}
+
+uint16_t SimBLE::getMTU(uint16_t connHandle) {
+    Connection* connection = findConnection(connHandle);
+    return connection != nullptr ? connection->mtu : 0;
+}
+
+bool SimBLE::getConnDesc(uint16_t connHandle, ble_gap_conn_desc& desc) {
+    Connection* connection = findConnection(connHandle);
+    if (connection == nullptr) {
+        return false;
+    }
+    desc = connection->desc;
+    return true;
+}
+
+uint16_t SimBLE::getDataLength(uint16_t connHandle) {
+    Connection* connection = findConnection(connHandle);
+    return connection != nullptr ? connection->dataLength : 0;
+}
+
+uint32_t SimBLE::getParamUpdates(uint16_t connHandle) {
+    Connection* connection = findConnection(connHandle);
+    return connection != nullptr ? connection->paramUpdates : 0;
+}
+
+bool SimBLE::isAdvertising() {
+    return advertising != nullptr && advertising->isAdvertising();
+}
+
+uint32_t SimBLE::getAdvertisingStarts() {
+    return advertisingStarts;
+}
+
+uint32_t SimBLE::getConnectCount() {
+    return connectCount;
+}
+
+uint32_t SimBLE::getNotifyCount(const char* uuid) {
+    NimBLECharacteristic* characteristic = findCharacteristic(uuid);
+    return characteristic != nullptr ? characteristic->notifyCount : 0;
+}
+
+void SimBLE::sumCounters(uint32_t& notifies, uint32_t& bytes, uint32_t& setValues) {
+    notifies = 0;
+    bytes = 0;
+    setValues = 0;
+    if (server == nullptr) {
+        return;
+    }
+    for (size_t s = 0; s < server->services.size(); s++) {
+        NimBLEService* service = server->services[s];
+        for (size_t c = 0; c < service->characteristics.size(); c++) {
+            notifies += service->characteristics[c]->notifyCount;
+            bytes += service->characteristics[c]->notifyBytes;
+            setValues += service->characteristics[c]->setValueCount;
+        }
+    }
+}
+
+uint32_t SimBLE::getNotifyCount() {
+    uint32_t notifies, bytes, setValues;
+    sumCounters(notifies, bytes, setValues);
+    return notifies;
+}
+
+uint32_t SimBLE::getNotifyBytes() {
+    uint32_t notifies, bytes, setValues;
+    sumCounters(notifies, bytes, setValues);
+    return bytes;
+}
+
+uint32_t SimBLE::getSetValueCount(const char* uuid) {
+    NimBLECharacteristic* characteristic = findCharacteristic(uuid);
+    return characteristic != nullptr ? characteristic->setValueCount : 0;
+}
+
+uint32_t SimBLE::getSetValueCount() {
+    uint32_t notifies, bytes, setValues;
+    sumCounters(notifies, bytes, setValues);
+    return setValues;
+}
+
+void SimBLE::setNotifyHandler(SimNotifyHandler handler) {
+    notifyHandler = handler;
+}
+
+void SimBLE::recordAdvertisingStart() {
+    advertisingStarts++;
+}
+
+void SimBLE::countDelivery(NimBLECharacteristic* characteristic, Connection* connection,
+                           const uint8_t* data, size_t length) {
+    size_t sent = length;
+    if (sent > (size_t)(connection->mtu - 3)) {
+        sent = connection->mtu - 3;
+    }
+    characteristic->notifyCount++;
+    characteristic->notifyBytes += sent;
+    if (notifyHandler != nullptr) {
+        notifyHandler(connection->handle, characteristic->uuid, data, sent);
+    }
+}
+
+void SimBLE::deliverNotification(NimBLECharacteristic* characteristic, const uint8_t* data, size_t length) {
+    // NimBLE only sends to connections that enabled notifications
+    for (size_t i = 0; i < characteristic->subscribers.size(); i++) {
+        Connection* connection = findConnection(characteristic->subscribers[i]);
+        if (connection != nullptr) {
+            countDelivery(characteristic, connection, data, length);
+        }
+    }
+}
+
+bool SimBLE::deliverTo(uint16_t connHandle, uint16_t attHandle, const uint8_t* data, size_t length) {
+    // Like ble_gattc_notify_custom(), this ignores the peer's CCCD
+    Connection* connection = findConnection(connHandle);
+    NimBLECharacteristic* characteristic = findCharacteristic(attHandle);
+    if (connection == nullptr || characteristic == nullptr) {
+        return false;
+    }
+    countDelivery(characteristic, connection, data, length);
+    return true;
+}
+
+void SimBLE::visitCharacteristics(void (*visitor)(NimBLECharacteristic* characteristic)) {
+    if (server == nullptr) {
+        return;
+    }
+    for (size_t s = 0; s < server->services.size(); s++) {
+        NimBLEService* service = server->services[s];
+        for (size_t c = 0; c < service->characteristics.size(); c++) {
+            visitor(service->characteristics[c]);
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#include "power_model.h"
+
+double PowerModel::averageMilliamps(const PowerInputs& inputs) {
+    if (inputs.elapsedMs == 0) {
+        return 0.0;
+    }
+    // Charge in mA*s
+    double charge = 0.0;
+    charge += ACTIVE_MA * inputs.activeUs / 1e6;
+    charge += IDLE_MA * inputs.idleUs / 1e6;
+    charge += LIGHT_SLEEP_MA * inputs.lightSleepUs / 1e6;
+    charge += (ACTIVE_MA - LIGHT_SLEEP_MA) * inputs.wakeups * WAKEUP_ACTIVE_MS / 1000.0;
+    charge += ADVERTISING_EVENT_MAS * inputs.fastAdvertisingMs / FAST_ADVERTISING_MS;
+    charge += ADVERTISING_EVENT_MAS * inputs.slowAdvertisingMs / SLOW_ADVERTISING_MS;
+    charge += BLE_CONNECTED_MA * inputs.bleConnectedMs / 1000.0;
+    charge += NOTIFICATION_MAS * inputs.notifications;
+    charge += WIFI_CONNECTED_MA * inputs.wifiConnectedMs / 1000.0;
+    charge += PUBLISH_MAS * inputs.publishes;
+    return charge / (inputs.elapsedMs / 1000.0);
+}
+
+double PowerModel::milliampHoursPerDay(const PowerInputs& inputs) {
+    return averageMilliamps(inputs) * 24.0;
+}
@@ -0,0 +1,46 @@
+#ifndef POWER_MODEL_H
+#define POWER_MODEL_H
+
+#include <stdint.h>
+
+// What the simulated schedule did, in the units the model charges for
+struct PowerInputs {
+    uint64_t elapsedMs;
+    uint64_t activeUs;          // PowerManager residency
+    uint64_t idleUs;
+    uint64_t lightSleepUs;
+    uint32_t wakeups;
+    uint64_t fastAdvertisingMs; // time spent advertising per mode
+    uint64_t slowAdvertisingMs;
+    uint64_t bleConnectedMs;    // at least one central connected
+    uint32_t notifications;
+    uint64_t wifiConnectedMs;
+    uint32_t publishes;         // telemetry uplink requests
+};
+
+// Rough ESP32-S3 energy estimate for the host simulator
+// Currents are datasheet-level averages at 3.3 V, good for comparing
+// schedules, not for sizing a battery to the last mAh. Time the simulator
+// spends inside a job is zero on the virtual clock, so each wakeup is
+// charged WAKEUP_ACTIVE_MS at the active current instead.
+class PowerModel {
+public:
+    static constexpr double ACTIVE_MA = 40.0;           // CPU at 240 MHz, radios off
+    static constexpr double IDLE_MA = 15.0;             // clocked down, waiting
+    static constexpr double LIGHT_SLEEP_MA = 0.25;
+    static constexpr double WAKEUP_ACTIVE_MS = 1.0;     // one lane pass plus sleep exit
+    static constexpr double ADVERTISING_EVENT_MAS = 0.2;    // 3 channels, ~2 ms at ~100 mA
+    static constexpr double FAST_ADVERTISING_MS = 25.0;     // mean of 20-30 ms
+    static constexpr double SLOW_ADVERTISING_MS = 1150.0;   // mean of 1022.5-1285 ms
+    static constexpr double BLE_CONNECTED_MA = 2.0;     // connection events
+    static constexpr double NOTIFICATION_MAS = 0.05;
+    static constexpr double WIFI_CONNECTED_MA = 20.0;   // modem sleep between DTIM beacons
+    static constexpr double PUBLISH_MAS = 60.0;         // ~0.5 s of TX/RX per request
+
+    // Average current over the inputs' elapsed time
+    static double averageMilliamps(const PowerInputs& inputs);
+    // The same current drawn for a whole day
+    static double milliampHoursPerDay(const PowerInputs& inputs);
+};
+
+#endif // POWER_MODEL_H
@@ -0,0 +1,94 @@
+#ifndef SIM_BLE_H
+#define SIM_BLE_H
+
+#include "NimBLEDevice.h"
+
+// Receives every notification the fake stack delivers to a central
+typedef void (*SimNotifyHandler)(uint16_t connHandle, const NimBLEUUID& uuid,
+                                 const uint8_t* data, size_t length);
+
+// Central side of the fake NimBLE stack
+// Connections, subscriptions and writes are delivered synchronously through
+// the same callbacks the real host task would invoke. Counters let tests and
+// the host simulator measure what the firmware put on the air.
+class SimBLE {
+private:
+    struct Connection {
+        uint16_t handle;
+        uint16_t mtu;
+        uint16_t centralMtu;        // largest MTU the central supports
+        uint16_t dataLength;        // LL payload octets, 27 until DLE
+        uint32_t paramUpdates;
+        ble_gap_conn_desc desc;
+    };
+
+    static std::vector<Connection> connections;
+    static uint16_t nextHandle;
+    static uint32_t connectCount;
+    static uint32_t advertisingStarts;
+    static SimNotifyHandler notifyHandler;
+    static uint32_t initCost;
+
+    static Connection* findConnection(uint16_t connHandle);
+    static NimBLECharacteristic* findCharacteristic(uint16_t attHandle);
+    static void countDelivery(NimBLECharacteristic* characteristic, Connection* connection,
+                              const uint8_t* data, size_t length);
+    static void removeSubscriber(uint16_t connHandle);
+    static void sumCounters(uint32_t& notifies, uint32_t& bytes, uint32_t& setValues);
+
+public:
+    static const uint16_t MAX_CONNECTIONS = CONFIG_BT_NIMBLE_MAX_CONNECTIONS;
+
+    // Tears down the fake stack; the next NimBLEDevice::init() starts clean
+    static void reset();
+    // Simulated time NimBLEDevice::init() takes to start the controller and
+    // host; 0 after reset()
+    static void setInitCost(uint32_t ms);
+    static uint32_t getInitCost();
+
+    // Returns the new connection handle, or BLE_HS_CONN_HANDLE_NONE if the
+    // device is not advertising or has no free connection slot. `mtu` is the
+    // largest the central supports; it asks for it unless the server already
+    // exchanged MTUs while handling the connect.
+    static uint16_t connect(uint16_t mtu = BLE_ATT_MTU_DFLT);
+    static bool disconnect(uint16_t connHandle);
+    static bool exchangeMTU(uint16_t connHandle, uint16_t mtu);
+    // Encrypts the link, as if pairing completed; `authenticated` is a
+    // passkey pairing, false a "just works" one
+    static bool pair(uint16_t connHandle, bool authenticated = true);
+    static bool subscribe(uint16_t connHandle, const char* uuid, bool enable = true);
+    // False without calling back, like an ATT error, if the characteristic
+    // is not writable or needs a link security this one lacks
+    static bool write(uint16_t connHandle, const char* uuid, const uint8_t* data, size_t length);
+    static bool read(uint16_t connHandle, const char* uuid, std::string& value);
+
+    static NimBLECharacteristic* findCharacteristic(const char* uuid);
+    static size_t getConnectionCount();
+    static uint16_t getMTU(uint16_t connHandle);
+    static bool getConnDesc(uint16_t connHandle, ble_gap_conn_desc& desc);
+    static uint16_t getDataLength(uint16_t connHandle);
+    static uint32_t getParamUpdates(uint16_t connHandle);
+    static bool isAdvertising();
+    static uint32_t getAdvertisingStarts();
+    static uint32_t getConnectCount();
+
+    // Notification and setValue counters, per characteristic or in total
+    static uint32_t getNotifyCount(const char* uuid);
+    static uint32_t getNotifyCount();
+    static uint32_t getNotifyBytes();
+    static uint32_t getSetValueCount(const char* uuid);
+    static uint32_t getSetValueCount();
+    static void setNotifyHandler(SimNotifyHandler handler);
+
+    // Hooks for the fake stack itself
+    static void recordAdvertisingStart();
+    static bool serverExchangeMTU(uint16_t connHandle);
+    static bool updateParams(uint16_t connHandle, uint16_t minInterval, uint16_t maxInterval,
+                             uint16_t latency, uint16_t timeout);
+    static bool setDataLength(uint16_t connHandle, uint16_t octets);
+    static void deliverNotification(NimBLECharacteristic* characteristic, const uint8_t* data, size_t length);
+    static bool deliverTo(uint16_t connHandle, uint16_t attHandle, const uint8_t* data, size_t length);
+    static void visitCharacteristics(void (*visitor)(NimBLECharacteristic* characteristic));
+};
+
+#endif // SIM_BLE_H
@@ -0,0 +1,43 @@
+#include "sim_wifi.h"
+
+SimWiFiRadio::SimWiFiRadio(uint32_t associateDelayMs)
+    : accessPointUp(true), associating(false), associateDelay(associateDelayMs), beganAt(0),
+      startupCost(0) {}
+
+void SimWiFiRadio::setAccessPoint(bool up) {
+    accessPointUp = up;
+    if (!up && status() == RADIO_LINK_UP) {
+        emit(RADIO_EVENT_DISCONNECTED);
+    }
+}
+
+bool SimWiFiRadio::isAccessPointUp() const {
+    return accessPointUp;
+}
+
+void SimWiFiRadio::poll(uint32_t now) {
+    if (associating && accessPointUp && now - beganAt >= associateDelay) {
+        associating = false;
+        emit(RADIO_EVENT_GOT_IP);
+    }
+}
+
+void SimWiFiRadio::setStartupCost(uint32_t ms) {
+    startupCost = ms;
+}
+
+void SimWiFiRadio::setStationMode() {
+    FakeWiFiRadio::setStationMode();
+    delay(startupCost);
+}
+
+void SimWiFiRadio::begin(const char* ssid, const char* password) {
+    FakeWiFiRadio::begin(ssid, password);
+    associating = true;
+    beganAt = (uint32_t)millis();
+}
+
+void SimWiFiRadio::disconnect() {
+    FakeWiFiRadio::disconnect();
+    associating = false;
+}
@@ -0,0 +1,35 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+#include "wifi_radio.h"
+
+// FakeWiFiRadio with a scripted access point: a begin() while the access
+// point is up associates after a fixed delay, and taking the access point
+// down drops the station like a real beacon loss would. Starting the driver
+// in station mode can be given a cost in simulated time, to model boot.
+class SimWiFiRadio : public FakeWiFiRadio {
+private:
+    bool accessPointUp;
+    bool associating;
+    uint32_t associateDelay;
+    uint32_t beganAt;
+    uint32_t startupCost;
+
+public:
+    static const uint32_t DEFAULT_ASSOCIATE_DELAY = 2000;
+
+    explicit SimWiFiRadio(uint32_t associateDelayMs = DEFAULT_ASSOCIATE_DELAY);
+
+    void setAccessPoint(bool up);
+    bool isAccessPointUp() const;
+    void poll(uint32_t now);
+    // Simulated time setStationMode() takes to start the driver
+    void setStartupCost(uint32_t ms);
+
+    void setStationMode();
+
+    void begin(const char* ssid, const char* password);
+    void disconnect();
+};
+
+#endif // SIM_WIFI_H
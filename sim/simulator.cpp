@@ -0,0 +1,195 @@
+#include "simulator.h"
+#include "sim_ble.h"
+#include "platform.h"
+#include "scheduler.h"
+#include "wifi_manager.h"
+#include "telemetry_uplink.h"
+#include "ble_server.h"
+#include "power_manager.h"
+#include "boot_profile.h"
+#include <cstdio>
+
+// Firmware entry points from main.cpp
+void setup();
+void loop();
+
+Simulator::Event Simulator::events[Simulator::MAX_EVENTS];
+int Simulator::eventCount = 0;
+uint64_t Simulator::elapsed = 0;
+uint32_t Simulator::lastClock = 0;
+uint64_t Simulator::loopPasses = 0;
+SimWiFiRadio Simulator::radio;
+FakeTelemetryTransport Simulator::telemetry;
+PowerInputs Simulator::power;
+
+void Simulator::begin() {
+    SimBLE::reset();
+    SimBLE::setInitCost(BLE_INIT_COST);
+    Scheduler::reset();
+    NativeClock::set(0);
+    BootProfile::reset();
+    radio.reset();
+    radio.setAccessPoint(true);
+    radio.setStartupCost(WIFI_STARTUP_COST);
+    WiFiManager::setRadio(&radio);
+    telemetry.reset();
+    TelemetryUplink::setTransport(&telemetry);
+
+    eventCount = 0;
+    elapsed = 0;
+    lastClock = 0;
+    loopPasses = 0;
+    power = PowerInputs();
+
+    setup();
+    advanceElapsed();
+}
+
+bool Simulator::addEvent(const char* name, uint64_t at, uint64_t period, SimAction action) {
+    if (eventCount >= MAX_EVENTS || action == nullptr) {
+        return false;
+    }
+    Event& event = events[eventCount++];
+    event.name = name;
+    event.next = at;
+    event.period = period;
+    event.action = action;
+    return true;
+}
+
+void Simulator::advanceElapsed() {
+    // millis() wraps after 49 days; the simulated time keeps counting
+    uint32_t now = NativeClock::now();
+    elapsed += (uint32_t)(now - lastClock);
+    lastClock = now;
+}
+
+void Simulator::runDueEvents() {
+    for (int i = 0; i < eventCount; i++) {
+        Event& event = events[i];
+        if (event.action == nullptr || event.next > elapsed) {
+            continue;
+        }
+        event.action();
+        if (event.period > 0) {
+            event.next += event.period;
+        } else {
+            event.action = nullptr;
+        }
+    }
+}
+
+void Simulator::runFor(uint64_t durationMs) {
+    uint64_t end = elapsed + durationMs;
+    while (elapsed < end) {
+        // Events land on the first pass after they are due, at most one idle sleep late
+        runDueEvents();
+        radio.poll(NativeClock::now());
+        loop();
+        loopPasses++;
+        // The pass ended in a sleep, spent in the state the pass left behind
+        uint64_t before = elapsed;
+        advanceElapsed();
+        accountPower(elapsed - before);
+    }
+}
+
+void Simulator::accountPower(uint64_t durationMs) {
+    switch (BLEServerManager::getAdvertisingMode()) {
+        case ADVERTISING_FAST: power.fastAdvertisingMs += durationMs; break;
+        case ADVERTISING_SLOW: power.slowAdvertisingMs += durationMs; break;
+        default: break;
+    }
+    if (SimBLE::getConnectionCount() > 0) {
+        power.bleConnectedMs += durationMs;
+    }
+    if (WiFiManager::isConnected()) {
+        power.wifiConnectedMs += durationMs;
+    }
+}
+
+uint64_t Simulator::getElapsed() {
+    return elapsed;
+}
+
+uint64_t Simulator::getLoopPasses() {
+    return loopPasses;
+}
+
+SimWiFiRadio& Simulator::getRadio() {
+    return radio;
+}
+
+FakeTelemetryTransport& Simulator::getTelemetry() {
+    return telemetry;
+}
+
+PowerInputs Simulator::getPowerInputs() {
+    PowerInputs inputs = power;
+    inputs.elapsedMs = elapsed;
+    inputs.activeUs = PowerManager::getResidency(POWER_ACTIVE);
+    inputs.idleUs = PowerManager::getResidency(POWER_IDLE);
+    inputs.lightSleepUs = PowerManager::getResidency(POWER_LIGHT_SLEEP);
+    inputs.wakeups = PowerManager::getWakeups();
+    inputs.notifications = SimBLE::getNotifyCount();
+    inputs.publishes = telemetry.publishCount;
+    return inputs;
+}
+
+static void printCharacteristic(NimBLECharacteristic* characteristic) {
+    std::string uuid = characteristic->getUUID().toString();
+    std::printf("  %-38s %10u %10u\n", uuid.c_str(),
+                (unsigned)SimBLE::getNotifyCount(uuid.c_str()),
+                (unsigned)SimBLE::getSetValueCount(uuid.c_str()));
+}
+
+void Simulator::printReport(double wallSeconds) {
+    double simulatedSeconds = elapsed / 1000.0;
+    std::printf("\n=== Simulation report ===\n");
+    std::printf("Simulated time:   %.2f h in %.3f s wall", simulatedSeconds / 3600.0, wallSeconds);
+    if (wallSeconds > 0) {
+        std::printf(" (%.0fx)", simulatedSeconds / wallSeconds);
+    }
+    std::printf("\n");
+    std::printf("Loop passes:      %llu (%.3f per simulated second)\n",
+                (unsigned long long)loopPasses, simulatedSeconds > 0 ? loopPasses / simulatedSeconds : 0.0);
+
+    std::printf("BLE connections:  %u, advertising starts: %u\n",
+                (unsigned)SimBLE::getConnectCount(), (unsigned)SimBLE::getAdvertisingStarts());
+    std::printf("Notifications:    %u (%u bytes), setValue calls: %u\n",
+                (unsigned)SimBLE::getNotifyCount(), (unsigned)SimBLE::getNotifyBytes(),
+                (unsigned)SimBLE::getSetValueCount());
+    std::printf("  %-38s %10s %10s\n", "characteristic", "notifies", "setValue");
+    SimBLE::visitCharacteristics(printCharacteristic);
+
+    std::printf("WiFi:             %s, %d begin() calls\n",
+                WiFiManager::getStateName(), radio.beginCount);
+    std::printf("Telemetry:        %u batches acked (%u samples), %u failed, %u oversized, %u downsampled\n",
+                (unsigned)telemetry.ackCount, (unsigned)telemetry.sequences.size(),
+                (unsigned)TelemetryUplink::getFailedPublishes(),
+                (unsigned)TelemetryUplink::getOversizedBatches(),
+                (unsigned)TelemetryUplink::getDownsampledSamples());
+
+    PowerInputs inputs = getPowerInputs();
+    double total = inputs.activeUs + inputs.idleUs + inputs.lightSleepUs;
+    if (total > 0) {
+        std::printf("Power:            %.1f%% active, %.1f%% idle, %.1f%% light sleep, %u wakeups\n",
+                    100.0 * inputs.activeUs / total, 100.0 * inputs.idleUs / total,
+                    100.0 * inputs.lightSleepUs / total, (unsigned)inputs.wakeups);
+    }
+    std::printf("Advertising:      %.2f h fast, %.2f h slow, BLE connected %.2f h\n",
+                inputs.fastAdvertisingMs / 3600000.0, inputs.slowAdvertisingMs / 3600000.0,
+                inputs.bleConnectedMs / 3600000.0);
+    std::printf("Energy estimate:  %.2f mA average, %.0f mAh per day\n",
+                PowerModel::averageMilliamps(inputs), PowerModel::milliampHoursPerDay(inputs));
+
+    std::printf("Scheduler jobs:\n");
+    std::printf("  %-16s %10s %14s\n", "job", "runs", "max late (ms)");
+    for (int id = 0; id < Scheduler::MAX_JOBS; id++) {
+        const char* name = Scheduler::getName(id);
+        if (name != nullptr) {
+            std::printf("  %-16s %10u %14u\n", name, (unsigned)Scheduler::getRunCount(id),
+                        (unsigned)Scheduler::getMaxLateness(id));
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdint.h>
+#include "sim_wifi.h"
+#include "telemetry_transport.h"
+#include "power_model.h"
+
+typedef void (*SimAction)();
+
+// Runs the real setup()/loop() from main.cpp on the virtual clock
+// Time only moves when the firmware sleeps in Scheduler::sleepUntilNext(),
+// so a simulated day takes as many loop passes as it would on the device.
+class Simulator {
+private:
+    struct Event {
+        const char* name;
+        uint64_t next;
+        uint64_t period;
+        SimAction action;
+    };
+
+    static const int MAX_EVENTS = 16;
+
+    static Event events[MAX_EVENTS];
+    static int eventCount;
+    static uint64_t elapsed;
+    static uint32_t lastClock;
+    static uint64_t loopPasses;
+    static SimWiFiRadio radio;
+    static FakeTelemetryTransport telemetry;
+    static PowerInputs power;
+
+    static void advanceElapsed();
+    static void accountPower(uint64_t durationMs);
+    static void runDueEvents();
+
+public:
+    static const uint64_t SECOND = 1000ULL;
+    static const uint64_t MINUTE = 60 * SECOND;
+    static const uint64_t HOUR = 60 * MINUTE;
+    static const uint64_t DAY = 24 * HOUR;
+
+    // Boot costs of the radio stacks, rough figures for an ESP32-S3: NimBLE
+    // controller and host start, and the WiFi driver's init, start and RF
+    // calibration. They only need to be the right size for the boot order to
+    // show in the boot profile.
+    static const uint32_t BLE_INIT_COST = 80;
+    static const uint32_t WIFI_STARTUP_COST = 250;
+
+    // Resets the clock, the fake radios, the scheduler and the boot profile,
+    // then runs setup()
+    static void begin();
+
+    // Scripted actions at a simulated time, repeating every period if non-zero
+    static bool addEvent(const char* name, uint64_t at, uint64_t period, SimAction action);
+
+    // Runs loop() passes until the given amount of simulated time has passed
+    static void runFor(uint64_t durationMs);
+
+    static uint64_t getElapsed();
+    static uint64_t getLoopPasses();
+    static SimWiFiRadio& getRadio();
+    static FakeTelemetryTransport& getTelemetry();
+    // Radio and CPU activity so far, for PowerModel
+    static PowerInputs getPowerInputs();
+
+    // Prints notification, loop, power and scheduler metrics to stdout
+    static void printReport(double wallSeconds);
+};
+
+#endif // SIMULATOR_H
@@ -0,0 +1,46 @@
+#include "backoff.h"
+
+ExponentialBackoff::ExponentialBackoff(uint32_t baseMs, uint32_t maxMs, uint32_t seed)
+    : baseMs(baseMs), maxMs(maxMs), attempts(0), rngState(1) {
+    this->seed(seed);
+}
+
+uint32_t ExponentialBackoff::nextRandom() {
+    // xorshift32: cheap and good enough to decorrelate retry times
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+void ExponentialBackoff::configure(uint32_t baseMs, uint32_t maxMs) {
+    this->baseMs = baseMs;
+    this->maxMs = maxMs;
+}
+
+uint32_t ExponentialBackoff::nextDelay() {
+    uint32_t ceiling = baseMs;
+    for (uint32_t i = 0; i < attempts && ceiling < maxMs; i++) {
+        ceiling *= 2;
+    }
+    if (ceiling > maxMs) {
+        ceiling = maxMs;
+    }
+    attempts++;
+
+    uint32_t half = ceiling / 2;
+    return half + nextRandom() % (ceiling - half + 1);
+}
+
+void ExponentialBackoff::reset() {
+    attempts = 0;
+}
+
+void ExponentialBackoff::seed(uint32_t seed) {
+    // xorshift has a fixed point at zero
+    rngState = seed != 0 ? seed : 0x9E3779B9u;
+}
+
+uint32_t ExponentialBackoff::getAttempts() const {
+    return attempts;
+}
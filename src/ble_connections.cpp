@@ -0,0 +1,143 @@
+#include "ble_connections.h"
+
+NotifyBudget::NotifyBudget() : tokens(0), burst(0), refillMs(1), refilledAt(0) {}
+
+void NotifyBudget::reset(uint16_t newBurst, uint32_t newRefillMs, uint32_t now) {
+    burst = newBurst;
+    refillMs = newRefillMs > 0 ? newRefillMs : 1;
+    tokens = newBurst;
+    refilledAt = now;
+}
+
+uint16_t NotifyBudget::available(uint32_t now) {
+    // Whole tokens only; the remainder carries over to the next call
+    uint32_t earned = (now - refilledAt) / refillMs;
+    if (earned > 0) {
+        uint32_t total = tokens + earned;
+        tokens = total < burst ? (uint16_t)total : burst;
+        refilledAt = tokens < burst ? refilledAt + earned * refillMs : now;
+    }
+    return tokens;
+}
+
+bool NotifyBudget::take(uint32_t now) {
+    if (available(now) == 0) {
+        return false;
+    }
+    tokens--;
+    return true;
+}
+
+BLEConnectionTable::BLEConnectionTable() {
+    clear();
+}
+
+void BLEConnectionTable::clear() {
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+        slots[i].handle = BLE_CONN_HANDLE_INVALID;
+        slots[i].subscriptions = 0;
+        slots[i].historyRequested = false;
+        slots[i].historyActive = false;
+    }
+}
+
+BLEConnection* BLEConnectionTable::add(uint16_t handle, uint32_t now) {
+    if (handle == BLE_CONN_HANDLE_INVALID) {
+        return nullptr;
+    }
+    BLEConnection* existing = find(handle);
+    if (existing != nullptr) {
+        return existing;
+    }
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+        BLEConnection& slot = slots[i];
+        if (slot.isOpen()) {
+            continue;
+        }
+        slot.mtu = DEFAULT_MTU;
+        slot.dataLength = 0;
+        slot.interval = 0;
+        slot.latency = 0;
+        slot.timeout = 0;
+        slot.subscriptions = 0;
+        slot.lastNotifiedSeq = BLE_NO_SEQUENCE;
+        slot.temperatureBehind = false;
+        slot.historyRequested = false;
+        slot.historyRequestSeq = 0;
+        slot.historyRequestRanged = false;
+        slot.historyRequestRange = 0;
+        slot.historyRequestPoints = 0;
+        slot.historyActive = false;
+        slot.historyTier = 0;
+        slot.historyNextSeq = 0;
+        slot.budget.reset(NOTIFY_BURST, NOTIFY_REFILL_MS, now);
+        slot.link.reset(now);
+        __atomic_store_n(&slot.handle, handle, __ATOMIC_RELEASE);
+        return &slot;
+    }
+    return nullptr;
+}
+
+bool BLEConnectionTable::remove(uint16_t handle) {
+    BLEConnection* slot = find(handle);
+    if (slot == nullptr) {
+        return false;
+    }
+    __atomic_store_n(&slot->handle, (uint16_t)BLE_CONN_HANDLE_INVALID, __ATOMIC_RELEASE);
+    slot->subscriptions = 0;
+    return true;
+}
+
+BLEConnection* BLEConnectionTable::find(uint16_t handle) {
+    if (handle == BLE_CONN_HANDLE_INVALID) {
+        return nullptr;
+    }
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+        if (__atomic_load_n(&slots[i].handle, __ATOMIC_ACQUIRE) == handle) {
+            return &slots[i];
+        }
+    }
+    return nullptr;
+}
+
+int BLEConnectionTable::count() const {
+    int open = 0;
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+        if (slots[i].isOpen()) {
+            open++;
+        }
+    }
+    return open;
+}
+
+bool BLEConnectionTable::setMTU(uint16_t handle, uint16_t mtu) {
+    BLEConnection* slot = find(handle);
+    if (slot == nullptr) {
+        return false;
+    }
+    slot->mtu = mtu;
+    return true;
+}
+
+bool BLEConnectionTable::setSubscribed(uint16_t handle, BLENotifyTarget target, bool subscribed) {
+    BLEConnection* slot = find(handle);
+    if (slot == nullptr || target < 0 || target >= NOTIFY_TARGET_COUNT) {
+        return false;
+    }
+    if (subscribed) {
+        __atomic_fetch_or(&slot->subscriptions, 1u << target, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_and(&slot->subscriptions, ~(1u << target), __ATOMIC_RELAXED);
+    }
+    return true;
+}
+
+int BLEConnectionTable::countSubscribed(BLENotifyTarget target) const {
+    int subscribed = 0;
+    for (int i = 0; i < MAX_CONNECTIONS; i++) {
+        if (slots[i].isOpen() && slots[i].isSubscribed(target)) {
+            subscribed++;
+        }
+    }
+    return subscribed;
+}
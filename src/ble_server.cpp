@@ -1,256 +1,832 @@
 #include "ble_server.h"
-
-#ifdef ARDUINO
+#include "scheduler.h"
 #include "temperature_service.h"
+#include "history_codec.h"
+#include "timing_stats.h"
+#include "memory_monitor.h"
+#include "logger.h"
+#include <stdio.h>
 
 // Static member definitions
 NimBLEServer* BLEServerManager::pServer = nullptr;
 NimBLEService* BLEServerManager::pService = nullptr;
 NimBLECharacteristic* BLEServerManager::pCharacteristic = nullptr;
+NimBLECharacteristic* BLEServerManager::pDiagnosticsCharacteristic = nullptr;
+NimBLECharacteristic* BLEServerManager::pConfigCharacteristic = nullptr;
 NimBLEService* BLEServerManager::pTempService = nullptr;
 NimBLECharacteristic* BLEServerManager::pTempCharacteristic = nullptr;
 NimBLECharacteristic* BLEServerManager::pTempMaxCharacteristic = nullptr;
 NimBLECharacteristic* BLEServerManager::pTempMinCharacteristic = nullptr;
 NimBLECharacteristic* BLEServerManager::pTempConfigCharacteristic = nullptr;
-bool BLEServerManager::deviceConnected = false;
-bool BLEServerManager::oldDeviceConnected = false;
+NimBLECharacteristic* BLEServerManager::pTempHistoryCharacteristic = nullptr;
+NimBLECharacteristic* BLEServerManager::pTempPackedCharacteristic = nullptr;
+BLEConnectionTable BLEServerManager::connections;
+volatile bool BLEServerManager::connectionsChanged = false;
+volatile bool BLEServerManager::notifyPolicyChanged = false;
 uint32_t BLEServerManager::value = 0;
+int BLEServerManager::loopTaskId = Scheduler::INVALID_TASK;
+int BLEServerManager::counterTaskId = Scheduler::INVALID_TASK;
+int BLEServerManager::historyTaskId = Scheduler::INVALID_TASK;
+int BLEServerManager::temperatureTaskId = Scheduler::INVALID_TASK;
+int BLEServerManager::diagnosticsTaskId = Scheduler::INVALID_TASK;
+int BLEServerManager::advertisingTaskId = Scheduler::INVALID_TASK;
+int BLEServerManager::knownConnections = 0;
+BLEAdvertisingMode BLEServerManager::advertisingMode = ADVERTISING_FAST;
+uint32_t BLEServerManager::fastAdvertisingSince = 0;
+NotifyPolicy BLEServerManager::notifyPolicy;
+TemperatureReading BLEServerManager::publishedReading;
+uint8_t BLEServerManager::notifiedUnit = 0;
+
+NimBLEService** const BLEServerManager::serviceSlots[GATT_SERVICE_COUNT] = {
+    &BLEServerManager::pService,
+    &BLEServerManager::pTempService,
+};
+
+NimBLECharacteristic** const BLEServerManager::characteristicSlots[GATT_CHARACTERISTIC_COUNT] = {
+    &BLEServerManager::pCharacteristic,
+    &BLEServerManager::pDiagnosticsCharacteristic,
+    &BLEServerManager::pConfigCharacteristic,
+    &BLEServerManager::pTempCharacteristic,
+    &BLEServerManager::pTempMaxCharacteristic,
+    &BLEServerManager::pTempMinCharacteristic,
+    &BLEServerManager::pTempPackedCharacteristic,
+    &BLEServerManager::pTempConfigCharacteristic,
+    &BLEServerManager::pTempHistoryCharacteristic,
+};
+
+// Callback objects live for the whole run; NimBLE only keeps pointers.
+// SubscriptionCallbacks is shared by every notifiable characteristic
+// without write handling.
+static MyServerCallbacks serverCallbacks;
+static SubscriptionCallbacks subscriptionCallbacks;
+static MyCharacteristicCallbacks characteristicCallbacks;
+static ConfigCallbacks configCallbacks;
+static TempConfigCallbacks tempConfigCallbacks;
+static TempHistoryCallbacks tempHistoryCallbacks;
+
+static NimBLECharacteristicCallbacks* const GATT_CALLBACK_OBJECTS[GATT_CALLBACKS_COUNT] = {
+    nullptr,
+    &subscriptionCallbacks,
+    &characteristicCallbacks,
+    &configCallbacks,
+    &tempConfigCallbacks,
+    &tempHistoryCallbacks,
+};
 
 // Server callback implementations
-void MyServerCallbacks::onConnect(NimBLEServer* pServer) {
-    BLEServerManager::setDeviceConnectionState(true);
-    Serial.println("Client connected");
+void MyServerCallbacks::onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
+    BLEServerManager::onConnect(desc->conn_handle);
+    LOG_INFO("Client connected (handle %u, %d connected)",
+             (unsigned)desc->conn_handle, BLEServerManager::getConnectionCount());
 
-    // Start advertising again to allow multiple connections
+    // Keep advertising while connection slots remain; fails harmlessly when full
     NimBLEDevice::startAdvertising();
 }
 
-void MyServerCallbacks::onDisconnect(NimBLEServer* pServer) {
-    BLEServerManager::setDeviceConnectionState(false);
-    Serial.println("Client disconnected - start advertising");
+void MyServerCallbacks::onDisconnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
+    BLEServerManager::onDisconnect(desc->conn_handle);
+    LOG_INFO("Client disconnected (handle %u) - start advertising", (unsigned)desc->conn_handle);
+}
+
+void MyServerCallbacks::onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) {
+    BLEServerManager::setPeerMTU(desc->conn_handle, MTU);
+    LOG_INFO("MTU updated: %u (handle %u)", (unsigned)MTU, (unsigned)desc->conn_handle);
+}
+
+void SubscriptionCallbacks::onSubscribe(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc,
+                                        uint16_t subValue) {
+    // subValue: 0 = off, 1 = notify, 2 = indicate, 3 = both
+    BLEServerManager::onSubscribe(desc->conn_handle, pCharacteristic, subValue != 0);
 }
 
 // Characteristic callback implementations
 void MyCharacteristicCallbacks::onRead(NimBLECharacteristic* pCharacteristic) {
-    Serial.print("Read request received. Current value: ");
-    Serial.println(pCharacteristic->getValue().c_str());
+    LOG_DEBUG("Read request received. Current value: %s", pCharacteristic->getValue().c_str());
 }
 
 void MyCharacteristicCallbacks::onWrite(NimBLECharacteristic* pCharacteristic) {
     std::string value = pCharacteristic->getValue();
-    Serial.print("Write request received. New value: ");
-    Serial.println(value.c_str());
-
-    if (value.length() > 0) {
-        Serial.print("Data written: ");
-        for (int i = 0; i < value.length(); i++) {
-            Serial.print(value[i]);
-        }
-        Serial.println();
-    }
+    // Length-bounded, so embedded or missing terminators are fine
+    LOG_INFO("Write request received. New value: %.*s", (int)value.length(), value.data());
 }
 
 // Temperature config callback implementation
+// Byte 0 selects the unit; an optional notify policy block may follow
 void TempConfigCallbacks::onWrite(NimBLECharacteristic* pCharacteristic) {
     std::string value = pCharacteristic->getValue();
     
     if (value.length() > 0) {
         uint8_t unitValue = (uint8_t)value[0];
-        Serial.print("Temperature unit config write received: ");
-        Serial.println(unitValue);
+        LOG_INFO("Temperature unit config write received: %u", (unsigned)unitValue);
         
         if (unitValue == 0 || unitValue == 1) {
             TemperatureService::setUnit((TemperatureUnit)unitValue);
-            Serial.println("Temperature unit updated successfully");
+            LOG_INFO("Temperature unit updated successfully");
+        } else {
+            LOG_WARN("Invalid temperature unit value. Use 0 for Celsius, 1 for Fahrenheit");
+        }
+    }
+    
+    NotifyPolicyConfig config;
+    if (value.length() > 1 &&
+        NotifyPolicy::decodeConfig((const uint8_t*)value.data() + 1, value.length() - 1, config)) {
+        if (BLEServerManager::setNotifyPolicy(config)) {
+            LOG_INFO("Temperature notify policy updated successfully");
         } else {
-            Serial.println("Invalid temperature unit value. Use 0 for Celsius, 1 for Fahrenheit");
+            LOG_WARN("Invalid notify policy. Min interval must not exceed max interval");
         }
     }
 }
 
+// Config characteristic: versioned TLV records, see config_store.h
+// The stack only lets paired links write; the store checks again before
+// taking the passkey
+void ConfigCallbacks::onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc) {
+    BLEServerManager::configWritten(pCharacteristic,
+                                    desc->sec_state.encrypted && desc->sec_state.authenticated);
+}
+
+static const size_t HISTORY_RANGE_REQUEST_SIZE = 6;   // u32 seconds + u16 point budget
+
+static uint32_t readU32(const std::string& value, size_t offset) {
+    return (uint32_t)(uint8_t)value[offset] |
+           ((uint32_t)(uint8_t)value[offset + 1] << 8) |
+           ((uint32_t)(uint8_t)value[offset + 2] << 16) |
+           ((uint32_t)(uint8_t)value[offset + 3] << 24);
+}
+
+// History dump request, little-endian: either an optional u32 start sequence
+// for raw samples, or a range request of u32 seconds back from the newest
+// sample (0 = everything) and a u16 point budget (0 = no limit)
+void TempHistoryCallbacks::onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc) {
+    std::string value = pCharacteristic->getValue();
+    if (value.length() >= HISTORY_RANGE_REQUEST_SIZE) {
+        uint32_t seconds = readU32(value, 0);
+        uint16_t maxPoints = (uint16_t)((uint8_t)value[4] | ((uint8_t)value[5] << 8));
+        // Ranges past the ms clock's reach ask for everything
+        uint32_t rangeMs = seconds > UINT32_MAX / 1000 ? 0 : seconds * 1000;
+        LOG_INFO("History requested for the last %lu s in at most %u points (handle %u)",
+                 (unsigned long)seconds, (unsigned)maxPoints, (unsigned)desc->conn_handle);
+        BLEServerManager::requestHistoryRange(desc->conn_handle, rangeMs, maxPoints);
+        return;
+    }
+    uint32_t fromSeq = 0;
+    if (value.length() >= 4) {
+        fromSeq = readU32(value, 0);
+    }
+    LOG_INFO("History dump requested from sequence %lu (handle %u)",
+             (unsigned long)fromSeq, (unsigned)desc->conn_handle);
+    BLEServerManager::requestHistoryDump(desc->conn_handle, fromSeq);
+}
+
+// Both keep the little-endian bytes, so this is a copy
+static NimBLEUUID toNimBLEUUID(const GattUUID128& uuid) {
+    return NimBLEUUID(uuid.bytes, sizeof(uuid.bytes), false);
+}
+
 // BLE Server Manager implementations
 void BLEServerManager::init() {
-    Serial.println("Initializing BLE Server...");
+    LOG_INFO("Initializing BLE Server...");
+
+    // The previous stack instance, if any, took its connections with it
+    connections.clear();
 
     // Initialize NimBLE
     NimBLEDevice::init(DEVICE_NAME);
+    // Offered in every MTU exchange; one full notification per LL packet
+    NimBLEDevice::setMTU(LinkTuning::PREFERRED_MTU);
 
     // Set security
     NimBLEDevice::setSecurityAuth(true, true, true);
-    NimBLEDevice::setSecurityPasskey(123456);
+    NimBLEDevice::setSecurityPasskey(ConfigStore::get(CONFIG_BLE_PASSKEY));
     NimBLEDevice::setSecurityIOCap(BLE_HS_IO_DISPLAY_ONLY);
 
-    // Create BLE Server
+    // Create BLE Server; the callbacks are static, so NimBLE must not delete them
     pServer = NimBLEDevice::createServer();
-    pServer->setCallbacks(new MyServerCallbacks());
-
-    // Create BLE Service
-    pService = pServer->createService(SERVICE_UUID);
-
-    // Create BLE Characteristic
-    pCharacteristic = pService->createCharacteristic(
-                         CHARACTERISTIC_UUID,
-                         NIMBLE_PROPERTY::READ   |
-                         NIMBLE_PROPERTY::WRITE  |
-                         NIMBLE_PROPERTY::NOTIFY |
-                         NIMBLE_PROPERTY::INDICATE
-                       );
+    pServer->setCallbacks(&serverCallbacks, false);
 
-    pCharacteristic->setCallbacks(new MyCharacteristicCallbacks());
+    // Build the GATT database from ble_gatt_table.h. The UUIDs were parsed
+    // by the compiler and the callbacks are statics, so nothing here parses
+    // text or allocates on our side.
+    for (int i = 0; i < GATT_SERVICE_COUNT; i++) {
+        *serviceSlots[i] = pServer->createService(toNimBLEUUID(GATT_SERVICES[i].uuid));
+    }
+    for (int i = 0; i < GATT_CHARACTERISTIC_COUNT; i++) {
+        const GattCharacteristicDef& def = GATT_CHARACTERISTICS[i];
+        NimBLECharacteristic* characteristic = (*serviceSlots[def.service])->createCharacteristic(
+            toNimBLEUUID(def.uuid), def.properties);
+        characteristic->setCallbacks(GATT_CALLBACK_OBJECTS[def.callbacks]);
+        *characteristicSlots[i] = characteristic;
+    }
     pCharacteristic->setValue("Hello ESP32-S3");
 
-    // Start the service
-    pService->start();
-
-    // Create Environmental Sensing Service for temperature
-    pTempService = pServer->createService(ENV_SENSING_SERVICE_UUID);
-    
-    // Create Temperature Characteristics (all are READ and NOTIFY)
-    pTempCharacteristic = pTempService->createCharacteristic(
-                             TEMPERATURE_CHAR_UUID,
-                             NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY
-                           );
-    
-    pTempMaxCharacteristic = pTempService->createCharacteristic(
-                                TEMP_MAX_CHAR_UUID,
-                                NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY
-                              );
-    
-    pTempMinCharacteristic = pTempService->createCharacteristic(
-                                TEMP_MIN_CHAR_UUID,
-                                NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY
-                              );
-    
-    // Temperature config characteristic (READ and WRITE for unit configuration)
-    pTempConfigCharacteristic = pTempService->createCharacteristic(
-                                   TEMP_CONFIG_CHAR_UUID,
-                                   NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE
-                                 );
-    
-    pTempConfigCharacteristic->setCallbacks(new TempConfigCallbacks());
-    
     // Set initial values
-    uint8_t initialUnit = (uint8_t)TemperatureService::getUnit();
-    pTempConfigCharacteristic->setValue(&initialUnit, 1);
-    
-    // Start the temperature service
-    pTempService->start();
+    notifyPolicy.configure(getNotifyPolicy());
+    notifyPolicyChanged = false;
+    ConfigStore::subscribe(configChanged);
+    updateConfigValue();
+
+    // Start the services
+    for (int i = 0; i < GATT_SERVICE_COUNT; i++) {
+        (*serviceSlots[i])->start();
+    }
 
     // Start advertising
     NimBLEAdvertising *pAdvertising = NimBLEDevice::getAdvertising();
-    pAdvertising->addServiceUUID(SERVICE_UUID);
-    pAdvertising->addServiceUUID(ENV_SENSING_SERVICE_UUID);
+    for (int i = 0; i < GATT_SERVICE_COUNT; i++) {
+        if (GATT_SERVICES[i].advertised) {
+            pAdvertising->addServiceUUID(toNimBLEUUID(GATT_SERVICES[i].uuid));
+        }
+    }
     pAdvertising->setScanResponse(false);
     pAdvertising->setMinPreferred(0x0);  // set value to 0x00 to not advertise this parameter
+    knownConnections = 0;
+    advertisingTaskId = Scheduler::INVALID_TASK;
+    setAdvertisingMode(ADVERTISING_FAST);
     NimBLEDevice::startAdvertising();
 
-    Serial.println("BLE GATT Server started!");
-    Serial.println("Device name: " + String(DEVICE_NAME));
-    Serial.println("Service UUID: " + String(SERVICE_UUID));
-    Serial.println("Characteristic UUID: " + String(CHARACTERISTIC_UUID));
-    Serial.println("Temperature Service UUID: " + String(ENV_SENSING_SERVICE_UUID));
-    Serial.println("Waiting for a client connection to notify...");
+    // Register periodic work with the scheduler
+    if (!Scheduler::isScheduled(loopTaskId)) {
+        loopTaskId = Scheduler::addPeriodic("ble", loop, CONNECTION_CHECK_INTERVAL);
+    }
+    if (!Scheduler::isScheduled(counterTaskId)) {
+        counterTaskId = Scheduler::addPeriodic("ble-counter", notifyCounter, COUNTER_NOTIFY_INTERVAL);
+    }
+    if (!Scheduler::isScheduled(historyTaskId)) {
+        historyTaskId = Scheduler::addPeriodic("ble-history", streamHistory, HISTORY_IDLE_INTERVAL);
+    }
+    if (!Scheduler::isScheduled(temperatureTaskId)) {
+        temperatureTaskId = Scheduler::addPeriodic("ble-temp", publishTemperature,
+                                                   notifyPolicy.getConfig().maxInterval);
+    }
+    if (!Scheduler::isScheduled(diagnosticsTaskId)) {
+        diagnosticsTaskId = Scheduler::addPeriodic("ble-diag", publishDiagnostics, DIAGNOSTICS_INTERVAL);
+    }
+    TemperatureService::setChangeCallback(temperatureChanged);
+
+    LOG_INFO("BLE GATT Server started!");
+    LOG_INFO("Device name: " DEVICE_NAME);
+    LOG_INFO("Service UUID: " SERVICE_UUID);
+    LOG_INFO("Characteristic UUID: " CHARACTERISTIC_UUID);
+    LOG_INFO("Temperature Service UUID: " ENV_SENSING_SERVICE_UUID);
+    LOG_INFO("Waiting for a client connection to notify...");
 }
 
 void BLEServerManager::loop() {
-    // Check if device is connected
-    if (deviceConnected) {
+    ScopedTimer timer(PROBE_BLE);
+
+    // A slot freed up: make sure we are connectable again. NimBLE normally
+    // restarts advertising itself; give the stack a moment before we do.
+    if (__atomic_exchange_n(&connectionsChanged, false, __ATOMIC_RELAXED)) {
+        // A central that just left probably wants back in soon; once one
+        // is connected, further ones are rare enough for slow advertising
+        int count = connections.count();
+        if (count < knownConnections) {
+            setAdvertisingMode(ADVERTISING_FAST);
+        } else if (count > knownConnections && advertisingMode != ADVERTISING_SLOW) {
+            setAdvertisingMode(ADVERTISING_SLOW);
+        }
+        knownConnections = count;
+        if (count < BLEConnectionTable::MAX_CONNECTIONS &&
+            !NimBLEDevice::getAdvertising()->isAdvertising()) {
+            Scheduler::addOneShot("ble-adv", restartAdvertising, ADVERTISING_RESTART_DELAY);
+        }
+    }
+
+    uint32_t now = millis();
+    for (int i = 0; i < BLEConnectionTable::MAX_CONNECTIONS; i++) {
+        BLEConnection& connection = connections.at(i);
+        if (connection.isOpen()) {
+            refreshLink(connection);
+            tuneLink(connection, now);
+        }
+    }
+}
+
+// The central may pick other parameters than requested, or change them later
+void BLEServerManager::refreshLink(BLEConnection& connection) {
+    NimBLEConnInfo info = pServer->getPeerIDInfo(connection.handle);
+    connection.interval = info.getConnInterval();
+    connection.latency = info.getConnLatency();
+    connection.timeout = info.getConnTimeout();
+}
+
+void BLEServerManager::tuneLink(BLEConnection& connection, uint32_t now) {
+    bool bulk = connection.historyActive || connection.historyRequested;
+    LinkProfile profile = connection.link.update(bulk, now);
+    if (profile == LINK_PROFILE_NONE) {
+        return;
+    }
+    const LinkParams& params = LinkTuning::paramsFor(profile);
+    pServer->updateConnParams(connection.handle, params.minInterval, params.maxInterval,
+                              params.latency, params.timeout);
+    LOG_DEBUG("Requested %s connection parameters (handle %u)",
+              profile == LINK_PROFILE_BULK ? "bulk" : "idle", (unsigned)connection.handle);
+}
+
+// New intervals only apply from the next start, so running advertising is
+// restarted. Fast advertising falls back to slow after FAST_ADVERTISING_TIME.
+void BLEServerManager::setAdvertisingMode(BLEAdvertisingMode mode) {
+    NimBLEAdvertising* advertising = NimBLEDevice::getAdvertising();
+    bool fast = mode == ADVERTISING_FAST;
+    bool running = advertising->isAdvertising();
+    if (running) {
+        advertising->stop();
+    }
+    advertising->setMinInterval(fast ? FAST_ADVERTISING_MIN : SLOW_ADVERTISING_MIN);
+    advertising->setMaxInterval(fast ? FAST_ADVERTISING_MAX : SLOW_ADVERTISING_MAX);
+    advertisingMode = mode;
+    if (running) {
+        advertising->start();
+    }
+
+    if (fast) {
+        fastAdvertisingSince = millis();
+        if (!Scheduler::isScheduled(advertisingTaskId)) {
+            advertisingTaskId = Scheduler::addOneShot("ble-adv-slow", slowAdvertising, FAST_ADVERTISING_TIME);
+        }
+    }
+}
+
+void BLEServerManager::slowAdvertising() {
+    // The one-shot is done once it runs; never test its recycled id again
+    advertisingTaskId = Scheduler::INVALID_TASK;
+    if (advertisingMode != ADVERTISING_FAST) {
+        return;
+    }
+    // Fast advertising restarted since this was armed: wait out the rest
+    uint32_t elapsed = millis() - fastAdvertisingSince;
+    if (elapsed < FAST_ADVERTISING_TIME) {
+        advertisingTaskId = Scheduler::addOneShot("ble-adv-slow", slowAdvertising, FAST_ADVERTISING_TIME - elapsed);
+        return;
+    }
+    setAdvertisingMode(ADVERTISING_SLOW);
+    LOG_INFO("Advertising slowed down");
+}
+
+NimBLECharacteristic* BLEServerManager::targetCharacteristic(BLENotifyTarget target) {
+    switch (target) {
+        case NOTIFY_COUNTER:        return pCharacteristic;
+        case NOTIFY_TEMPERATURE:    return pTempCharacteristic;
+        case NOTIFY_TEMP_MAX:       return pTempMaxCharacteristic;
+        case NOTIFY_TEMP_MIN:       return pTempMinCharacteristic;
+        case NOTIFY_TEMP_PACKED:    return pTempPackedCharacteristic;
+        case NOTIFY_HISTORY:        return pTempHistoryCharacteristic;
+        case NOTIFY_DIAGNOSTICS:    return pDiagnosticsCharacteristic;
+        default:                    return nullptr;
+    }
+}
+
+bool BLEServerManager::notifyConnection(BLEConnection& connection, BLENotifyTarget target,
+                                        const uint8_t* data, size_t length, uint32_t now) {
+    NimBLECharacteristic* characteristic = targetCharacteristic(target);
+    if (characteristic == nullptr || !connection.isOpen() || !connection.isSubscribed(target) ||
+        !connection.budget.take(now)) {
+        return false;
+    }
+    size_t maxLength = connection.mtu - BLE_NOTIFY_OVERHEAD;
+    if (length > maxLength) {
+        length = maxLength;
+    }
+    // Addressed to this peer only; the stack consumes the buffer either way
+    os_mbuf* om = ble_hs_mbuf_from_flat(data, (uint16_t)length);
+    if (om == nullptr) {
+        return false;
+    }
+    return ble_gattc_notify_custom(connection.handle, characteristic->getHandle(), om) == 0;
+}
+
+int BLEServerManager::notifySubscribers(BLENotifyTarget target, const uint8_t* data, size_t length) {
+    uint32_t now = millis();
+    int sent = 0;
+    for (int i = 0; i < BLEConnectionTable::MAX_CONNECTIONS; i++) {
+        if (notifyConnection(connections.at(i), target, data, length, now)) {
+            sent++;
+        }
+    }
+    return sent;
+}
+
+void BLEServerManager::notifyCounter() {
+    if (connections.count() > 0) {
         // Update characteristic value periodically
         value++;
-        String newValue = "Count: " + String(value);
+        char newValue[24];
+        int length = snprintf(newValue, sizeof(newValue), "Count: %lu", (unsigned long)value);
         updateValue(newValue);
-        notify();
+        notifySubscribers(NOTIFY_COUNTER, (const uint8_t*)newValue, (size_t)length);
 
-        Serial.println("Sent notification: " + newValue);
-        delay(3000); // Delay between notifications
+        LOG_DEBUG("Sent notification: %s", newValue);
     }
+}
 
-    // Handle disconnecting
-    if (!deviceConnected && oldDeviceConnected) {
-        delay(500); // Give the bluetooth stack the chance to get things ready
-        pServer->startAdvertising(); // Restart advertising
-        Serial.println("Restarted advertising");
-        oldDeviceConnected = deviceConnected;
+void BLEServerManager::streamHistory() {
+    ScopedTimer timer(PROBE_BLE_HISTORY);
+    uint32_t now = millis();
+
+    // Dumps include samples the sampling task has queued but not yet published
+    TemperatureService::processSamples();
+
+    // Each peer has its own dump position, paced by its own notify budget
+    bool streaming = false;
+    for (int i = 0; i < BLEConnectionTable::MAX_CONNECTIONS; i++) {
+        BLEConnection& connection = connections.at(i);
+        if (!connection.isOpen()) {
+            continue;
+        }
+        if (__atomic_exchange_n(&connection.historyRequested, false, __ATOMIC_ACQUIRE)) {
+            connection.historyTier = TIER_RAW;
+            connection.historyNextSeq = connection.historyRequestSeq;
+            if (connection.historyRequestRanged) {
+                // The tier is picked against the history as it is now
+                HistorySelection selection = HistoryTierSelector::select(
+                    TemperatureService::getHistory(), TemperatureService::getRollup(),
+                    connection.historyRequestRange, connection.historyRequestPoints);
+                connection.historyTier = (uint8_t)selection.tier;
+                connection.historyNextSeq = selection.firstSeq;
+                LOG_INFO("History range served at tier %u: %lu points (handle %u)",
+                         (unsigned)selection.tier, (unsigned long)selection.points,
+                         (unsigned)connection.handle);
+            }
+            connection.historyActive = true;
+            connection.link.startBulk(now);
+            // Ask for the short interval before the first frames go out
+            tuneLink(connection, now);
+        }
+        if (connection.historyActive && streamHistoryTo(connection, now)) {
+            streaming = true;
+        }
     }
 
-    // Handle connecting
-    if (deviceConnected && !oldDeviceConnected) {
-        // Do stuff here on connecting
-        oldDeviceConnected = deviceConnected;
+    // Keep streaming at a short interval until every dump has caught up
+    if (streaming) {
+        Scheduler::setPeriod(historyTaskId, HISTORY_STREAM_INTERVAL);
+    } else {
+        Scheduler::setPeriod(historyTaskId, HISTORY_IDLE_INTERVAL);
     }
 }
 
-bool BLEServerManager::isConnected() {
-    return deviceConnected;
+bool BLEServerManager::streamHistoryTo(BLEConnection& connection, uint32_t now) {
+    if (!connection.isSubscribed(NOTIFY_HISTORY)) {
+        // Nobody would receive the frames
+        connection.historyActive = false;
+        connection.link.finishBulk(now);
+        return false;
+    }
+
+    // Each frame fills one notification at this peer's MTU
+    uint8_t frame[BLE_MAX_MTU - BLE_NOTIFY_OVERHEAD];
+    size_t frameSize = connection.mtu - BLE_NOTIFY_OVERHEAD;
+    for (int i = 0; i < HISTORY_FRAMES_PER_PASS && connection.historyActive; i++) {
+        if (connection.budget.available(now) == 0) {
+            break;
+        }
+        size_t length;
+        if (connection.historyTier == TIER_RAW) {
+            length = HistoryFrameEncoder::encodeRange(TemperatureService::getHistory(),
+                                                      connection.historyNextSeq, frame, frameSize);
+        } else {
+            length = RollupFrameEncoder::encodeRange(TemperatureService::getRollup(),
+                                                     (HistoryTier)connection.historyTier,
+                                                     connection.historyNextSeq, frame, frameSize);
+        }
+        if (notifyConnection(connection, NOTIFY_HISTORY, frame, length, now)) {
+            connection.link.addBulkBytes(length);
+        }
+        if (length == 0 || (frame[1] & HISTORY_FLAG_LAST)) {
+            connection.historyActive = false;
+            connection.link.finishBulk(now);
+        }
+    }
+    return connection.historyActive;
 }
 
-void BLEServerManager::updateValue(const String& newValue) {
-    if (pCharacteristic) {
-        pCharacteristic->setValue(newValue.c_str());
+void BLEServerManager::publishTemperature() {
+    ScopedTimer timer(PROBE_BLE_TEMP);
+    uint32_t now = millis();
+
+    // Samples queued by the sampling task are folded in here, on this task
+    TemperatureService::processSamples();
+
+    if (__atomic_exchange_n(&notifyPolicyChanged, false, __ATOMIC_RELAXED)) {
+        notifyPolicy.configure(getNotifyPolicy());
+    }
+
+    // Idle passes leave the characteristics untouched
+    if (TemperatureService::takeDirty()) {
+        uint8_t previousUnit = publishedReading.unit;
+        TemperatureService::getReading(publishedReading);
+        updateTemperature(publishedReading);
+        if (publishedReading.unit != previousUnit) {
+            updateConfigValue();
+        }
+        if (publishedReading.unit != notifiedUnit) {
+            // Values in a different unit are not comparable with the last one sent
+            notifyPolicy.forceNext();
+        }
+    }
+
+    bool connected = connections.count() > 0;
+    if (connected && notifyPolicy.evaluate(publishedReading.current, now)) {
+        notifyTemperature();
+        notifyPolicy.markNotified(publishedReading.current, now);
+        notifiedUnit = publishedReading.unit;
+    } else {
+        // Peers that subscribed since the last notification, or ran out of budget
+        for (int i = 0; i < BLEConnectionTable::MAX_CONNECTIONS; i++) {
+            BLEConnection& connection = connections.at(i);
+            if (connection.isOpen() && connection.temperatureBehind) {
+                notifyTemperatureTo(connection, now);
+            }
+        }
+    }
+
+    // Sleep until a rate-limited change or the heartbeat is due; new readings trigger us early
+    uint32_t wait = notifyPolicy.timeUntilDue(now);
+    if (wait == 0 || !connected) {
+        wait = notifyPolicy.getConfig().maxInterval;
+    }
+    for (int i = 0; i < BLEConnectionTable::MAX_CONNECTIONS; i++) {
+        BLEConnection& connection = connections.at(i);
+        if (connection.isOpen() && connection.temperatureBehind && wait > BLEConnectionTable::NOTIFY_REFILL_MS) {
+            // Retry once the budget has a token again
+            wait = BLEConnectionTable::NOTIFY_REFILL_MS;
+        }
     }
+    Scheduler::setPeriod(temperatureTaskId, wait);
 }
 
-void BLEServerManager::notify() {
-    if (pCharacteristic && deviceConnected) {
-        pCharacteristic->notify();
+void BLEServerManager::publishDiagnostics() {
+    // Probes recorded by the other tasks may be mid-update; good enough for diagnostics
+    uint8_t snapshot[TIMING_SNAPSHOT_SIZE + LINK_DIAGNOSTICS_SIZE + MEMORY_SNAPSHOT_MAX_SIZE];
+    size_t length = TimingStats::encodeSnapshot(snapshot, sizeof(snapshot));
+
+    // Followed by the link count and one entry per open connection
+    uint8_t* links = snapshot + length;
+    length++;
+    links[0] = 0;
+    for (int i = 0; i < BLEConnectionTable::MAX_CONNECTIONS; i++) {
+        LinkInfo info;
+        if (getLinkInfo(connections.at(i).handle, info)) {
+            length += LinkTuning::encodeInfo(info, snapshot + length, sizeof(snapshot) - length);
+            links[0]++;
+        }
     }
+    // Then the heap and stack watermarks sampled by the network lane
+    length += MemoryMonitor::encodeSnapshot(snapshot + length, sizeof(snapshot) - length);
+    pDiagnosticsCharacteristic->setValue(snapshot, length);
+    notifySubscribers(NOTIFY_DIAGNOSTICS, snapshot, length);
 }
 
-void BLEServerManager::setDeviceConnectionState(bool connected) {
-    deviceConnected = connected;
+void BLEServerManager::temperatureChanged() {
+    // Runs in the sampling task for new samples, in the NimBLE host task for unit writes
+    Scheduler::trigger(temperatureTaskId);
 }
 
-#else
+bool BLEServerManager::setNotifyPolicy(const NotifyPolicyConfig& config) {
+    ConfigUpdate updates[] = {
+        { CONFIG_NOTIFY_ABS_DEADBAND, config.absoluteDeadband },
+        { CONFIG_NOTIFY_REL_DEADBAND, config.relativeDeadband },
+        { CONFIG_NOTIFY_MIN_INTERVAL, config.minInterval },
+        { CONFIG_NOTIFY_MAX_INTERVAL, config.maxInterval },
+    };
+    return ConfigStore::apply(updates, sizeof(updates) / sizeof(updates[0]));
+}
 
-// Static member definitions for native/unit-test builds
-NimBLEServer* BLEServerManager::pServer = nullptr;
-NimBLEService* BLEServerManager::pService = nullptr;
-NimBLECharacteristic* BLEServerManager::pCharacteristic = nullptr;
-bool BLEServerManager::deviceConnected = false;
-bool BLEServerManager::oldDeviceConnected = false;
-uint32_t BLEServerManager::value = 0;
+NotifyPolicyConfig BLEServerManager::getNotifyPolicy() {
+    NotifyPolicyConfig config;
+    config.absoluteDeadband = (uint16_t)ConfigStore::get(CONFIG_NOTIFY_ABS_DEADBAND);
+    config.relativeDeadband = (uint16_t)ConfigStore::get(CONFIG_NOTIFY_REL_DEADBAND);
+    config.minInterval = ConfigStore::get(CONFIG_NOTIFY_MIN_INTERVAL);
+    config.maxInterval = ConfigStore::get(CONFIG_NOTIFY_MAX_INTERVAL);
+    return config;
+}
+
+void BLEServerManager::configWritten(NimBLECharacteristic* characteristic, bool secureLink) {
+    std::string value = characteristic->getValue();
+    if (ConfigStore::applyEncoded((const uint8_t*)value.data(), value.length(), secureLink)) {
+        LOG_INFO("Configuration write applied (%u bytes)", (unsigned)value.length());
+    } else {
+        LOG_WARN("Configuration write rejected (%u bytes)", (unsigned)value.length());
+    }
+    // The written bytes replaced the readable value; put the settings back
+    updateConfigValue();
+}
 
-void BLEServerManager::init() {}
+// Runs in the task that changed the setting, usually the NimBLE host task
+void BLEServerManager::configChanged(ConfigKey key, uint32_t value) {
+    switch (key) {
+        case CONFIG_BLE_PASSKEY:
+            // Used from the next pairing on
+            NimBLEDevice::setSecurityPasskey(value);
+            return;
+        case CONFIG_NOTIFY_ABS_DEADBAND:
+        case CONFIG_NOTIFY_REL_DEADBAND:
+        case CONFIG_NOTIFY_MIN_INTERVAL:
+        case CONFIG_NOTIFY_MAX_INTERVAL:
+            notifyPolicyChanged = true;
+            Scheduler::trigger(temperatureTaskId);
+            break;
+        default:
+            break;
+    }
+    updateConfigValue();
+}
 
-void BLEServerManager::loop() {}
+// Both config characteristics read back the current settings
+void BLEServerManager::updateConfigValue() {
+    if (pTempConfigCharacteristic) {
+        uint8_t config[TEMP_CONFIG_SIZE];
+        config[0] = (uint8_t)ConfigStore::get(CONFIG_TEMP_UNIT);
+        NotifyPolicy::encodeConfig(getNotifyPolicy(), config + 1, sizeof(config) - 1);
+        pTempConfigCharacteristic->setValue(config, sizeof(config));
+    }
+    if (pConfigCharacteristic) {
+        uint8_t encoded[CONFIG_MAX_ENCODED_SIZE];
+        size_t length = ConfigStore::encode(encoded, sizeof(encoded));
+        pConfigCharacteristic->setValue(encoded, length);
+    }
+}
+
+void BLEServerManager::onConnect(uint16_t connHandle) {
+    BLEConnection* connection = connections.add(connHandle, millis());
+    if (connection == nullptr) {
+        LOG_WARN("No free connection slot for handle %u", (unsigned)connHandle);
+    } else {
+        // Don't wait for the central: bulk transfers need the large MTU and
+        // long LL packets, and many centrals never ask for either
+        ble_gattc_exchange_mtu(connHandle, nullptr, nullptr);
+        pServer->setDataLen(connHandle, LinkTuning::DATA_LENGTH);
+        connection->dataLength = LinkTuning::DATA_LENGTH;
+    }
+    connectionsChanged = true;
+    Scheduler::trigger(loopTaskId);
+}
+
+void BLEServerManager::onDisconnect(uint16_t connHandle) {
+    // Only this peer's state goes; the others keep their subscriptions and dumps
+    connections.remove(connHandle);
+    connectionsChanged = true;
+    Scheduler::trigger(loopTaskId);
+}
+
+void BLEServerManager::onSubscribe(uint16_t connHandle, NimBLECharacteristic* characteristic, bool subscribed) {
+    for (int target = 0; target < NOTIFY_TARGET_COUNT; target++) {
+        if (targetCharacteristic((BLENotifyTarget)target) != characteristic) {
+            continue;
+        }
+        connections.setSubscribed(connHandle, (BLENotifyTarget)target, subscribed);
+        BLEConnection* connection = connections.find(connHandle);
+        if (subscribed && connection != nullptr && (NOTIFY_TEMPERATURE_MASK & (1u << target))) {
+            // Send the current reading rather than wait for the next heartbeat
+            connection->temperatureBehind = true;
+            Scheduler::trigger(temperatureTaskId);
+        }
+    }
+}
+
+void BLEServerManager::requestHistoryDump(uint16_t connHandle, uint32_t fromSeq) {
+    // Called from the NimBLE host task; the dump runs from the scheduler
+    BLEConnection* connection = connections.find(connHandle);
+    if (connection == nullptr) {
+        return;
+    }
+    connection->historyRequestSeq = fromSeq;
+    connection->historyRequestRanged = false;
+    __atomic_store_n(&connection->historyRequested, true, __ATOMIC_RELEASE);
+    Scheduler::trigger(historyTaskId);
+}
+
+void BLEServerManager::requestHistoryRange(uint16_t connHandle, uint32_t rangeMs, uint16_t maxPoints) {
+    // Called from the NimBLE host task; the tier is picked on the BLE task
+    BLEConnection* connection = connections.find(connHandle);
+    if (connection == nullptr) {
+        return;
+    }
+    connection->historyRequestRange = rangeMs;
+    connection->historyRequestPoints = maxPoints;
+    connection->historyRequestRanged = true;
+    __atomic_store_n(&connection->historyRequested, true, __ATOMIC_RELEASE);
+    Scheduler::trigger(historyTaskId);
+}
+
+void BLEServerManager::setPeerMTU(uint16_t connHandle, uint16_t mtu) {
+    if (mtu < BLE_DEFAULT_MTU) {
+        mtu = BLE_DEFAULT_MTU;
+    } else if (mtu > BLE_MAX_MTU) {
+        mtu = BLE_MAX_MTU;
+    }
+    connections.setMTU(connHandle, mtu);
+}
+
+uint16_t BLEServerManager::getPeerMTU(uint16_t connHandle) {
+    BLEConnection* connection = connections.find(connHandle);
+    return connection != nullptr ? connection->mtu : 0;
+}
+
+bool BLEServerManager::getLinkInfo(uint16_t connHandle, LinkInfo& info) {
+    BLEConnection* connection = connections.find(connHandle);
+    if (connection == nullptr) {
+        return false;
+    }
+    info.handle = connHandle;
+    info.mtu = connection->mtu;
+    info.dataLength = connection->dataLength;
+    info.interval = connection->interval;
+    info.latency = connection->latency;
+    info.timeout = connection->timeout;
+    info.profile = (uint8_t)connection->link.getRequested();
+    info.throughput = connection->link.getThroughput(millis());
+    return true;
+}
+
+bool BLEServerManager::isSubscribed(uint16_t connHandle, BLENotifyTarget target) {
+    BLEConnection* connection = connections.find(connHandle);
+    return connection != nullptr && connection->isSubscribed(target);
+}
+
+uint32_t BLEServerManager::getLastNotifiedSequence(uint16_t connHandle) {
+    BLEConnection* connection = connections.find(connHandle);
+    return connection != nullptr ? connection->lastNotifiedSeq : BLE_NO_SEQUENCE;
+}
+
+void BLEServerManager::restartAdvertising() {
+    if (pServer->startAdvertising()) {
+        LOG_INFO("Restarted advertising");
+    }
+}
 
 bool BLEServerManager::isConnected() {
-    return deviceConnected;
+    return connections.count() > 0;
 }
 
-void BLEServerManager::updateValue(const String& /*newValue*/) {}
+int BLEServerManager::getConnectionCount() {
+    return connections.count();
+}
 
-void BLEServerManager::notify() {}
+BLEAdvertisingMode BLEServerManager::getAdvertisingMode() {
+    return NimBLEDevice::getAdvertising()->isAdvertising() ? advertisingMode : ADVERTISING_OFF;
+}
 
-void BLEServerManager::setDeviceConnectionState(bool connected) {
-    deviceConnected = connected;
+void BLEServerManager::updateValue(const char* newValue) {
+    if (pCharacteristic) {
+        pCharacteristic->setValue(newValue);
+    }
 }
 
-#endif
+void BLEServerManager::notify() {
+    if (pCharacteristic) {
+        std::string current = pCharacteristic->getValue();
+        notifySubscribers(NOTIFY_COUNTER, (const uint8_t*)current.data(), current.size());
+    }
+}
 
-void BLEServerManager::updateTemperature(float current, float max, float min) {
+void BLEServerManager::updateTemperature(const TemperatureReading& reading) {
     if (pTempCharacteristic) {
-        // Convert float to int16_t for BLE (multiply by 100 to keep 2 decimal places)
-        int16_t currentInt = (int16_t)(current * 100);
-        int16_t maxInt = (int16_t)(max * 100);
-        int16_t minInt = (int16_t)(min * 100);
-        
-        pTempCharacteristic->setValue((uint8_t*)&currentInt, 2);
-        pTempMaxCharacteristic->setValue((uint8_t*)&maxInt, 2);
-        pTempMinCharacteristic->setValue((uint8_t*)&minInt, 2);
+        // Legacy per-value characteristics: int16_t, value * 100
+        pTempCharacteristic->setValue((uint8_t*)&reading.current, 2);
+        pTempMaxCharacteristic->setValue((uint8_t*)&reading.max, 2);
+        pTempMinCharacteristic->setValue((uint8_t*)&reading.min, 2);
+    }
+    if (pTempPackedCharacteristic) {
+        uint8_t payload[TEMPERATURE_PAYLOAD_SIZE];
+        size_t length = TemperaturePayload::encode(reading, payload, sizeof(payload));
+        pTempPackedCharacteristic->setValue(payload, length);
     }
 }
 
 void BLEServerManager::notifyTemperature() {
-    if (deviceConnected) {
-        if (pTempCharacteristic) {
-            pTempCharacteristic->notify();
-        }
-        if (pTempMaxCharacteristic) {
-            pTempMaxCharacteristic->notify();
-        }
-        if (pTempMinCharacteristic) {
-            pTempMinCharacteristic->notify();
+    uint32_t now = millis();
+    for (int i = 0; i < BLEConnectionTable::MAX_CONNECTIONS; i++) {
+        BLEConnection& connection = connections.at(i);
+        if (connection.isOpen()) {
+            notifyTemperatureTo(connection, now);
         }
     }
 }
+
+void BLEServerManager::notifyTemperatureTo(BLEConnection& connection, uint32_t now) {
+    // A peer gets either all the values it subscribed to for this reading or
+    // none, so current/max/min never mix readings; short budget retries later
+    uint32_t subscribed = connection.subscriptions & NOTIFY_TEMPERATURE_MASK;
+    int needed = __builtin_popcount(subscribed);
+    if (needed == 0) {
+        connection.temperatureBehind = false;
+        return;
+    }
+    if (connection.budget.available(now) < needed) {
+        connection.temperatureBehind = true;
+        return;
+    }
+
+    // A client that subscribes to the packed characteristic alone gets a
+    // single notification per reading
+    uint8_t payload[TEMPERATURE_PAYLOAD_SIZE];
+    size_t length = TemperaturePayload::encode(publishedReading, payload, sizeof(payload));
+    notifyConnection(connection, NOTIFY_TEMP_PACKED, payload, length, now);
+    notifyConnection(connection, NOTIFY_TEMPERATURE, (const uint8_t*)&publishedReading.current, 2, now);
+    notifyConnection(connection, NOTIFY_TEMP_MAX, (const uint8_t*)&publishedReading.max, 2, now);
+    notifyConnection(connection, NOTIFY_TEMP_MIN, (const uint8_t*)&publishedReading.min, 2, now);
+    connection.lastNotifiedSeq = publishedReading.sequence;
+    connection.temperatureBehind = false;
+}
@@ -0,0 +1,79 @@
+#include "boot_profile.h"
+#include "platform.h"
+#include "logger.h"
+#include <string.h>
+
+static const char* const PHASE_NAMES[BOOT_PHASE_COUNT] = {
+    "setup",
+    "config",
+    "advertising",
+    "sensors",
+    "setup-done",
+    "wifi-start",
+    "first-sample",
+    "wifi-connected"
+};
+
+// Static member definitions
+uint32_t BootProfile::times[BOOT_PHASE_COUNT];
+uint32_t BootProfile::claimed = 0;
+uint32_t BootProfile::reached = 0;
+
+void BootProfile::reset() {
+    memset(times, 0, sizeof(times));
+    __atomic_store_n(&claimed, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&reached, 0, __ATOMIC_RELEASE);
+}
+
+void BootProfile::mark(BootPhase phase) {
+    if (phase < 0 || phase >= BOOT_PHASE_COUNT) {
+        return;
+    }
+    uint32_t bit = 1u << phase;
+    // Marks on hot paths cost one load once the phase is done
+    if (__atomic_load_n(&claimed, __ATOMIC_RELAXED) & bit) {
+        return;
+    }
+    // Only the first caller stores a time, whichever task it runs on
+    if (__atomic_fetch_or(&claimed, bit, __ATOMIC_RELAXED) & bit) {
+        return;
+    }
+    times[phase] = (uint32_t)micros();
+    __atomic_fetch_or(&reached, bit, __ATOMIC_RELEASE);
+}
+
+bool BootProfile::isReached(BootPhase phase) {
+    if (phase < 0 || phase >= BOOT_PHASE_COUNT) {
+        return false;
+    }
+    return (__atomic_load_n(&reached, __ATOMIC_ACQUIRE) & (1u << phase)) != 0;
+}
+
+bool BootProfile::getTime(BootPhase phase, uint32_t& micros) {
+    if (!isReached(phase)) {
+        return false;
+    }
+    micros = times[phase];
+    return true;
+}
+
+const char* BootProfile::getName(BootPhase phase) {
+    if (phase < 0 || phase >= BOOT_PHASE_COUNT) {
+        return "unknown";
+    }
+    return PHASE_NAMES[phase];
+}
+
+void BootProfile::printReport() {
+    LOG_INFO("Boot profile (%s start):", FAST_START ? "fast" : "normal");
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        BootPhase phase = (BootPhase)i;
+        uint32_t at;
+        if (getTime(phase, at)) {
+            LOG_INFO("  %-14s %6lu.%lu ms", getName(phase), (unsigned long)(at / 1000),
+                     (unsigned long)(at % 1000 / 100));
+        } else {
+            LOG_INFO("  %-14s not reached", getName(phase));
+        }
+    }
+}
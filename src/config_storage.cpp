@@ -0,0 +1,87 @@
+#include "config_storage.h"
+
+#ifdef ARDUINO
+#include <Preferences.h>
+
+static const char* CONFIG_BLOB_KEY = "config";
+
+NvsConfigStorage::NvsConfigStorage(const char* nvsNamespace)
+    : nvsNamespace(nvsNamespace) {
+}
+
+bool NvsConfigStorage::load(uint8_t* data, size_t capacity, size_t& length) {
+    Preferences preferences;
+    if (!preferences.begin(nvsNamespace, true)) {
+        return false;   // namespace not created yet: first boot
+    }
+    size_t stored = preferences.getBytesLength(CONFIG_BLOB_KEY);
+    bool ok = stored > 0 && stored <= capacity &&
+              preferences.getBytes(CONFIG_BLOB_KEY, data, capacity) == stored;
+    preferences.end();
+    length = ok ? stored : 0;
+    return ok;
+}
+
+bool NvsConfigStorage::save(const uint8_t* data, size_t length) {
+    Preferences preferences;
+    if (!preferences.begin(nvsNamespace, false)) {
+        return false;
+    }
+    bool ok = preferences.putBytes(CONFIG_BLOB_KEY, data, length) == length;
+    preferences.end();
+    return ok;
+}
+
+#else
+
+#include <string.h>
+
+MemoryConfigStorage::MemoryConfigStorage() {
+    reset();
+}
+
+void MemoryConfigStorage::reset() {
+    blob.clear();
+    stored = false;
+    failing = false;
+    saveCount = 0;
+}
+
+void MemoryConfigStorage::setContents(const uint8_t* data, size_t length) {
+    blob.assign(data, data + length);
+    stored = true;
+}
+
+const std::vector<uint8_t>& MemoryConfigStorage::getContents() const {
+    return blob;
+}
+
+bool MemoryConfigStorage::hasContents() const {
+    return stored;
+}
+
+void MemoryConfigStorage::setFailing(bool fail) {
+    failing = fail;
+}
+
+bool MemoryConfigStorage::load(uint8_t* data, size_t capacity, size_t& length) {
+    if (!stored || blob.size() > capacity) {
+        return false;
+    }
+    if (!blob.empty()) {
+        memcpy(data, blob.data(), blob.size());
+    }
+    length = blob.size();
+    return true;
+}
+
+bool MemoryConfigStorage::save(const uint8_t* data, size_t length) {
+    if (failing) {
+        return false;
+    }
+    setContents(data, length);
+    saveCount++;
+    return true;
+}
+
+#endif
@@ -0,0 +1,355 @@
+#include "config_store.h"
+#include "platform.h"
+#include "scheduler.h"
+#include "temperature_units.h"
+#include "notify_policy.h"
+#include "wifi_manager.h"
+#include "logger.h"
+
+#ifdef ARDUINO
+static NvsConfigStorage defaultStorage("config");
+
+// BLE writes come in on the host task while the lanes read; a spinlock
+// keeps a batch from being seen half applied, and from being checked
+// against values another writer has changed since
+static portMUX_TYPE configLock = portMUX_INITIALIZER_UNLOCKED;
+#define CONFIG_LOCK() portENTER_CRITICAL(&configLock)
+#define CONFIG_UNLOCK() portEXIT_CRITICAL(&configLock)
+#else
+static MemoryConfigStorage defaultStorage;
+
+// Native builds run every lane on the one simulator thread
+#define CONFIG_LOCK()
+#define CONFIG_UNLOCK()
+#endif
+
+// Tags are part of the wire format: append new settings, never renumber
+const ConfigField ConfigStore::schema[CONFIG_KEY_COUNT] = {
+    // tag  name              size  min    max        default
+    {  1, "unit",               1,  0,     1,         CELSIUS, 0 },
+    {  2, "sample_interval",    4,  1000,  3600000,   30000, 0 },
+    {  3, "notify_abs",         2,  0,     0xFFFF,    NotifyPolicy::DEFAULT_ABSOLUTE_DEADBAND, 0 },
+    {  4, "notify_rel",         2,  0,     1000,      NotifyPolicy::DEFAULT_RELATIVE_DEADBAND, 0 },
+    {  5, "notify_min",         4,  0,     0xFFFF,    NotifyPolicy::DEFAULT_MIN_INTERVAL, 0 },
+    {  6, "notify_max",         4,  1000,  65535000,  NotifyPolicy::DEFAULT_MAX_INTERVAL, 0 },
+    {  7, "wifi_timeout",       4,  1000,  120000,    WIFI_TIMEOUT_MS, 0 },
+    {  8, "wifi_backoff_base",  4,  100,   60000,     2000, 0 },
+    {  9, "wifi_backoff_max",   4,  1000,  3600000,   300000, 0 },
+    { 10, "ble_passkey",        4,  0,     999999,    BLE_PASSKEY, CONFIG_FLAG_SECRET },
+};
+
+// Static member definitions
+uint32_t ConfigStore::values[CONFIG_KEY_COUNT];
+ConfigStorage* ConfigStore::storage = &defaultStorage;
+ConfigChangeCallback ConfigStore::subscribers[ConfigStore::MAX_SUBSCRIBERS];
+int ConfigStore::subscriberCount = 0;
+volatile bool ConfigStore::dirty = false;
+volatile uint32_t ConfigStore::changedAt = 0;
+uint32_t ConfigStore::saveFailures = 0;
+int ConfigStore::saveTaskId = Scheduler::INVALID_TASK;
+
+// Modules may read their settings before init() runs, so the defaults are
+// in place from the start
+struct ConfigDefaultsLoader {
+    ConfigDefaultsLoader() {
+        ConfigStore::loadDefaults();
+    }
+};
+static ConfigDefaultsLoader defaultsLoader;
+
+// Runs before the lane tasks start
+void ConfigStore::init() {
+    loadDefaults();
+    dirty = false;
+    saveFailures = 0;
+
+    uint8_t blob[CONFIG_MAX_ENCODED_SIZE];
+    size_t length = 0;
+    if (storage != nullptr && storage->load(blob, sizeof(blob), length)) {
+        uint32_t candidate[CONFIG_KEY_COUNT];
+        for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+            candidate[i] = values[i];
+        }
+        if (decode(blob, length, candidate, nullptr, false, true) && consistent(candidate)) {
+            for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+                values[i] = candidate[i];
+            }
+            LOG_INFO("Configuration restored (%u bytes)", (unsigned)length);
+        } else {
+            LOG_WARN("Stored configuration unusable, using defaults");
+        }
+    } else {
+        LOG_INFO("No stored configuration, using defaults");
+    }
+
+    if (!Scheduler::isScheduled(saveTaskId)) {
+        saveTaskId = Scheduler::addPeriodic("config-save", saveJob, SAVE_IDLE_INTERVAL);
+    }
+}
+
+void ConfigStore::setStorage(ConfigStorage* newStorage) {
+    storage = newStorage;
+}
+
+void ConfigStore::loadDefaults() {
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        values[i] = schema[i].defaultValue;
+    }
+}
+
+void ConfigStore::resetToDefaults() {
+    uint32_t candidate[CONFIG_KEY_COUNT];
+    bool updated[CONFIG_KEY_COUNT];
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        candidate[i] = schema[i].defaultValue;
+        updated[i] = true;
+    }
+    commit(candidate, updated);
+}
+
+uint32_t ConfigStore::get(ConfigKey key) {
+    return values[key];
+}
+
+const ConfigField& ConfigStore::getField(ConfigKey key) {
+    return schema[key];
+}
+
+bool ConfigStore::set(ConfigKey key, uint32_t value) {
+    ConfigUpdate update = { key, value };
+    return apply(&update, 1);
+}
+
+bool ConfigStore::apply(const ConfigUpdate* updates, int count) {
+    uint32_t candidate[CONFIG_KEY_COUNT];
+    bool updated[CONFIG_KEY_COUNT] = {};
+    for (int i = 0; i < count; i++) {
+        if (updates[i].key < 0 || updates[i].key >= CONFIG_KEY_COUNT ||
+            !inRange(updates[i].key, updates[i].value)) {
+            return false;
+        }
+        candidate[updates[i].key] = updates[i].value;
+        updated[updates[i].key] = true;
+    }
+    return commit(candidate, updated);
+}
+
+bool ConfigStore::inRange(int key, uint32_t value) {
+    return value >= schema[key].minValue && value <= schema[key].maxValue;
+}
+
+bool ConfigStore::consistent(const uint32_t* candidate) {
+    return candidate[CONFIG_NOTIFY_MIN_INTERVAL] <= candidate[CONFIG_NOTIFY_MAX_INTERVAL] &&
+           candidate[CONFIG_WIFI_BACKOFF_BASE] <= candidate[CONFIG_WIFI_BACKOFF_MAX];
+}
+
+// Stores the updated settings of a range-checked candidate and tells the
+// subscribers what changed. The updates go onto the live values and the
+// cross-field rules are checked in the same critical section, so a
+// concurrent writer's batch is neither overwritten with stale values nor
+// combined with this one into an inconsistent set. False, storing nothing,
+// if the result breaks a cross-field rule.
+bool ConfigStore::commit(const uint32_t* candidate, const bool* updated) {
+    uint32_t merged[CONFIG_KEY_COUNT];
+    bool changed[CONFIG_KEY_COUNT];
+    bool any = false;
+    CONFIG_LOCK();
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        merged[i] = updated[i] ? candidate[i] : values[i];
+    }
+    if (!consistent(merged)) {
+        CONFIG_UNLOCK();
+        return false;
+    }
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        changed[i] = values[i] != merged[i];
+        any = any || changed[i];
+        values[i] = merged[i];
+    }
+    CONFIG_UNLOCK();
+    if (!any) {
+        return true;
+    }
+
+    changedAt = (uint32_t)millis();
+    dirty = true;
+    Scheduler::trigger(saveTaskId);
+
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if (!changed[i]) {
+            continue;
+        }
+        if (schema[i].flags & CONFIG_FLAG_SECRET) {
+            LOG_INFO("Config %s changed", schema[i].name);
+        } else {
+            LOG_INFO("Config %s = %lu", schema[i].name, (unsigned long)merged[i]);
+        }
+        for (int s = 0; s < subscriberCount; s++) {
+            subscribers[s]((ConfigKey)i, merged[i]);
+        }
+    }
+    return true;
+}
+
+bool ConfigStore::subscribe(ConfigChangeCallback callback) {
+    for (int i = 0; i < subscriberCount; i++) {
+        if (subscribers[i] == callback) {
+            return true;
+        }
+    }
+    if (callback == nullptr || subscriberCount >= MAX_SUBSCRIBERS) {
+        return false;
+    }
+    subscribers[subscriberCount++] = callback;
+    return true;
+}
+
+void ConfigStore::clearSubscribers() {
+    subscriberCount = 0;
+}
+
+int ConfigStore::findTag(uint8_t tag) {
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if (schema[i].tag == tag) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+size_t ConfigStore::encode(uint8_t* buffer, size_t capacity, bool includeSecrets) {
+    if (capacity < CONFIG_MAX_ENCODED_SIZE) {
+        return 0;
+    }
+    uint32_t snapshot[CONFIG_KEY_COUNT];
+    CONFIG_LOCK();
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        snapshot[i] = values[i];
+    }
+    CONFIG_UNLOCK();
+
+    size_t length = 0;
+    buffer[length++] = CONFIG_FORMAT_VERSION;
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if ((schema[i].flags & CONFIG_FLAG_SECRET) && !includeSecrets) {
+            continue;
+        }
+        buffer[length++] = schema[i].tag;
+        buffer[length++] = schema[i].size;
+        for (uint8_t b = 0; b < schema[i].size; b++) {
+            buffer[length++] = (uint8_t)(snapshot[i] >> (8 * b));
+        }
+    }
+    return length;
+}
+
+// Strict decoding (BLE writes) fails on the first bad record; lenient
+// decoding (stored blobs) keeps the default of a setting whose stored value
+// no longer fits the schema and stops at a truncated record. `updated`, if
+// given, marks the settings that had a record.
+bool ConfigStore::decode(const uint8_t* data, size_t length, uint32_t* candidate, bool* updated,
+                         bool strict, bool allowSecrets) {
+    if (length < 1 || data[0] == 0) {
+        return false;
+    }
+    if (data[0] > CONFIG_FORMAT_VERSION) {
+        // Records of a newer format may mean something else entirely
+        LOG_WARN("Config format %u not supported", (unsigned)data[0]);
+        return false;
+    }
+    // Format 1 is the first; conversions from older formats go here
+
+    size_t pos = 1;
+    while (pos < length) {
+        if (length - pos < CONFIG_RECORD_HEADER) {
+            return !strict;
+        }
+        uint8_t tag = data[pos];
+        uint8_t size = data[pos + 1];
+        pos += CONFIG_RECORD_HEADER;
+        if (size == 0 || size > 4 || length - pos < size) {
+            return !strict;
+        }
+        uint32_t value = 0;
+        for (uint8_t b = 0; b < size; b++) {
+            value |= (uint32_t)data[pos + b] << (8 * b);
+        }
+        pos += size;
+
+        int key = findTag(tag);
+        if (key < 0) {
+            continue;   // a setting this firmware does not know
+        }
+        if ((schema[key].flags & CONFIG_FLAG_SECRET) && !allowSecrets) {
+            LOG_WARN("Config %s needs an authenticated link", schema[key].name);
+            return false;
+        }
+        if (!inRange(key, value)) {
+            LOG_WARN("Config %s = %lu out of range", schema[key].name, (unsigned long)value);
+            if (strict) {
+                return false;
+            }
+            continue;
+        }
+        candidate[key] = value;
+        if (updated != nullptr) {
+            updated[key] = true;
+        }
+    }
+    return true;
+}
+
+bool ConfigStore::applyEncoded(const uint8_t* data, size_t length, bool secureLink) {
+    uint32_t candidate[CONFIG_KEY_COUNT];
+    bool updated[CONFIG_KEY_COUNT] = {};
+    if (!decode(data, length, candidate, updated, true, secureLink)) {
+        return false;
+    }
+    return commit(candidate, updated);
+}
+
+// Network lane: waits for SAVE_DELAY of quiet after the last change
+void ConfigStore::saveJob() {
+    uint32_t now = (uint32_t)millis();
+    uint32_t quiet = now - changedAt;
+    if (dirty && quiet < SAVE_DELAY) {
+        Scheduler::setPeriod(saveTaskId, SAVE_DELAY - quiet);
+        return;
+    }
+    if (dirty) {
+        save();
+    }
+    // A failed save comes back after another SAVE_DELAY
+    Scheduler::setPeriod(saveTaskId, dirty ? SAVE_DELAY : SAVE_IDLE_INTERVAL);
+}
+
+bool ConfigStore::save() {
+    // Cleared first: a change during the write marks it dirty again
+    dirty = false;
+    if (storage == nullptr) {
+        return true;
+    }
+    uint8_t blob[CONFIG_MAX_ENCODED_SIZE];
+    size_t length = encode(blob, sizeof(blob), true);
+    if (!storage->save(blob, length)) {
+        dirty = true;
+        changedAt = (uint32_t)millis();
+        saveFailures++;
+        LOG_WARN("Saving the configuration failed");
+        return false;
+    }
+    LOG_DEBUG("Configuration saved (%u bytes)", (unsigned)length);
+    return true;
+}
+
+bool ConfigStore::flush() {
+    return dirty ? save() : true;
+}
+
+bool ConfigStore::isDirty() {
+    return dirty;
+}
+
+uint32_t ConfigStore::getSaveFailures() {
+    return saveFailures;
+}
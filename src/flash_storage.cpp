@@ -0,0 +1,185 @@
+#include "flash_storage.h"
+
+#ifdef ARDUINO
+
+PartitionFlashStorage::PartitionFlashStorage(const char* label) : label(label), partition(nullptr) {}
+
+bool PartitionFlashStorage::begin() {
+    if (partition == nullptr) {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    }
+    return partition != nullptr;
+}
+
+uint32_t PartitionFlashStorage::size() {
+    return begin() ? partition->size : 0;
+}
+
+uint32_t PartitionFlashStorage::sectorSize() {
+    return SPI_FLASH_SEC_SIZE;
+}
+
+bool PartitionFlashStorage::read(uint32_t offset, void* data, uint32_t length) {
+    return partition != nullptr && esp_partition_read(partition, offset, data, length) == ESP_OK;
+}
+
+bool PartitionFlashStorage::write(uint32_t offset, const void* data, uint32_t length) {
+    return partition != nullptr && esp_partition_write(partition, offset, data, length) == ESP_OK;
+}
+
+bool PartitionFlashStorage::erase(uint32_t offset) {
+    return partition != nullptr && esp_partition_erase_range(partition, offset, SPI_FLASH_SEC_SIZE) == ESP_OK;
+}
+
+#else
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FileFlashStorage::FileFlashStorage()
+    : image(nullptr), imageSize(0), sector(4096), fd(-1), powerCutArmed(false), powerBudget(0),
+      powered(true), noise(1), bytesWritten(0), eraseCount(0), readCount(0), bytesRead(0) {}
+
+FileFlashStorage::~FileFlashStorage() {
+    close();
+}
+
+bool FileFlashStorage::open(const char* path, uint32_t size, uint32_t sectorSize) {
+    close();
+    if (sectorSize == 0 || size == 0 || size % sectorSize != 0) {
+        return false;
+    }
+    fd = ::open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    bool fresh = fstat(fd, &info) != 0 || (uint32_t)info.st_size != size;
+    if (fresh && ftruncate(fd, size) != 0) {
+        close();
+        return false;
+    }
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close();
+        return false;
+    }
+    image = (uint8_t*)mapped;
+    imageSize = size;
+    sector = sectorSize;
+    sectorErases.assign(size / sectorSize, 0);
+    if (fresh) {
+        format();
+    }
+    return true;
+}
+
+void FileFlashStorage::close() {
+    if (image != nullptr) {
+        msync(image, imageSize, MS_SYNC);
+        munmap(image, imageSize);
+        image = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    imageSize = 0;
+}
+
+void FileFlashStorage::format() {
+    if (image != nullptr) {
+        memset(image, 0xFF, imageSize);
+    }
+}
+
+void FileFlashStorage::cutPowerAfter(uint32_t bytes, uint32_t seed) {
+    powerCutArmed = true;
+    powerBudget = bytes;
+    noise = seed != 0 ? seed : 1;
+}
+
+void FileFlashStorage::restorePower() {
+    powerCutArmed = false;
+    powered = true;
+}
+
+bool FileFlashStorage::isPowered() const {
+    return powered;
+}
+
+uint32_t FileFlashStorage::getEraseCount(uint32_t sectorIndex) const {
+    return sectorIndex < sectorErases.size() ? sectorErases[sectorIndex] : 0;
+}
+
+bool FileFlashStorage::inRange(uint32_t offset, uint32_t length) const {
+    return image != nullptr && offset <= imageSize && length <= imageSize - offset;
+}
+
+// How many of `length` bytes complete before the power goes
+uint32_t FileFlashStorage::spend(uint32_t length) {
+    if (!powerCutArmed) {
+        return length;
+    }
+    if (length < powerBudget) {
+        powerBudget -= length;
+        return length;
+    }
+    uint32_t done = powerBudget;
+    powerBudget = 0;
+    powered = false;
+    return done;
+}
+
+uint32_t FileFlashStorage::size() {
+    return imageSize;
+}
+
+uint32_t FileFlashStorage::sectorSize() {
+    return sector;
+}
+
+bool FileFlashStorage::read(uint32_t offset, void* data, uint32_t length) {
+    if (!inRange(offset, length)) {
+        return false;
+    }
+    memcpy(data, image + offset, length);
+    readCount++;
+    bytesRead += length;
+    return true;
+}
+
+bool FileFlashStorage::write(uint32_t offset, const void* data, uint32_t length) {
+    if (!powered || !inRange(offset, length)) {
+        return false;
+    }
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t done = spend(length);
+    // NOR programming only ever clears bits
+    for (uint32_t i = 0; i < done; i++) {
+        image[offset + i] &= bytes[i];
+    }
+    bytesWritten += done;
+    if (done < length) {
+        noise = noise * 1103515245u + 12345u;
+        image[offset + done] &= (uint8_t)(bytes[done] | (noise >> 16));
+        return false;
+    }
+    return true;
+}
+
+bool FileFlashStorage::erase(uint32_t offset) {
+    if (!powered || offset % sector != 0 || !inRange(offset, sector)) {
+        return false;
+    }
+    uint32_t done = spend(sector);
+    memset(image + offset, 0xFF, done);
+    eraseCount++;
+    sectorErases[offset / sector]++;
+    return done == sector;
+}
+
+#endif
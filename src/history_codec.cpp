@@ -0,0 +1,319 @@
+#include "history_codec.h"
+#include <string.h>
+
+size_t Varint::encode(uint32_t value, uint8_t* out) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+size_t Varint::decode(const uint8_t* data, size_t length, uint32_t& value) {
+    uint32_t result = 0;
+    for (size_t i = 0; i < length && i < MAX_BYTES; i++) {
+        uint8_t byte = data[i];
+        if (i == MAX_BYTES - 1 && byte > 0x0F) {
+            return 0; // does not fit in 32 bits
+        }
+        result |= (uint32_t)(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+static void writeU32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t readU32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+HistoryFrameEncoder::HistoryFrameEncoder(uint8_t* buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), length(0), count(0),
+      lastTimestamp(0), lastDelta(0), lastValue(0) {}
+
+bool HistoryFrameEncoder::begin(uint32_t firstSeq) {
+    length = 0;
+    count = 0;
+    if (capacity < HISTORY_FRAME_HEADER) {
+        return false;
+    }
+    buffer[0] = HISTORY_FRAME_VERSION;
+    buffer[1] = 0;
+    writeU32(buffer + 2, firstSeq);
+    buffer[6] = 0;
+    length = HISTORY_FRAME_HEADER;
+    return true;
+}
+
+bool HistoryFrameEncoder::add(const HistorySample& sample) {
+    if (length == 0 || count == 255) {
+        return false;
+    }
+
+    uint8_t scratch[2 * Varint::MAX_BYTES];
+    size_t used;
+    uint32_t delta = sample.timestamp - lastTimestamp;
+    if (count == 0) {
+        used = Varint::encode(sample.timestamp, scratch);
+        used += Varint::encode(Varint::zigzag(sample.value), scratch + used);
+        delta = 0;
+    } else {
+        // Periodic sampling makes the delta-of-delta almost always zero
+        used = Varint::encode(Varint::zigzag((int32_t)(delta - lastDelta)), scratch);
+        used += Varint::encode(Varint::zigzag(sample.value - lastValue), scratch + used);
+    }
+
+    if (length + used > capacity) {
+        return false;
+    }
+    memcpy(buffer + length, scratch, used);
+    length += used;
+    count++;
+    lastTimestamp = sample.timestamp;
+    lastDelta = delta;
+    lastValue = sample.value;
+    return true;
+}
+
+size_t HistoryFrameEncoder::finish(bool last) {
+    if (length == 0) {
+        return 0;
+    }
+    buffer[1] = last ? HISTORY_FLAG_LAST : 0;
+    buffer[6] = count;
+    return length;
+}
+
+uint8_t HistoryFrameEncoder::getCount() const {
+    return count;
+}
+
+size_t HistoryFrameEncoder::encodeRange(const TemperatureHistory& history, uint32_t& nextSeq,
+                                        uint8_t* buffer, size_t capacity) {
+    // Samples older than the buffer are gone; the client sees the jump in firstSeq
+    uint32_t first = history.getFirstSequence();
+    uint32_t end = history.getNextSequence();
+    if ((int32_t)(nextSeq - first) < 0) {
+        nextSeq = first;
+    } else if ((int32_t)(nextSeq - end) > 0) {
+        nextSeq = end;
+    }
+
+    HistoryFrameEncoder encoder(buffer, capacity);
+    if (!encoder.begin(nextSeq)) {
+        return 0;
+    }
+
+    HistorySample sample;
+    while (nextSeq != end && history.getSample(nextSeq, sample) && encoder.add(sample)) {
+        nextSeq++;
+    }
+    return encoder.finish(nextSeq == end);
+}
+
+int HistoryFrameDecoder::decode(const uint8_t* data, size_t length, HistoryFrameHeader& header,
+                                HistorySample* samples, size_t maxSamples) {
+    if (length < HISTORY_FRAME_HEADER || data[0] != HISTORY_FRAME_VERSION) {
+        return -1;
+    }
+    header.version = data[0];
+    header.flags = data[1];
+    header.firstSeq = readU32(data + 2);
+    header.count = data[6];
+    if (header.count > maxSamples) {
+        return -1;
+    }
+
+    size_t pos = HISTORY_FRAME_HEADER;
+    uint32_t timestamp = 0;
+    uint32_t delta = 0;
+    // Wide enough that a corrupt delta can not overflow before the range check
+    int64_t value = 0;
+    for (int i = 0; i < header.count; i++) {
+        uint32_t first;
+        uint32_t second;
+        size_t used = Varint::decode(data + pos, length - pos, first);
+        if (used == 0) {
+            return -1;
+        }
+        pos += used;
+        used = Varint::decode(data + pos, length - pos, second);
+        if (used == 0) {
+            return -1;
+        }
+        pos += used;
+
+        if (i == 0) {
+            timestamp = first;
+            value = Varint::unzigzag(second);
+        } else {
+            delta += (uint32_t)Varint::unzigzag(first);
+            timestamp += delta;
+            value += (int64_t)Varint::unzigzag(second);
+        }
+        if (value < -32768 || value > 32767) {
+            return -1;
+        }
+        samples[i].timestamp = timestamp;
+        samples[i].value = (int16_t)value;
+    }
+
+    // Trailing bytes mean the frame was not produced by this encoder version
+    return pos == length ? header.count : -1;
+}
+
+RollupFrameEncoder::RollupFrameEncoder(uint8_t* buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity), length(0), count(0), width(0), lastIndex(0), lastMean(0) {}
+
+bool RollupFrameEncoder::begin(HistoryTier tier, uint32_t firstSeq) {
+    length = 0;
+    count = 0;
+    width = HistoryRollup::getWidth(tier);
+    if (capacity < HISTORY_ROLLUP_FRAME_HEADER || width == 0) {
+        return false;
+    }
+    buffer[0] = HISTORY_ROLLUP_FRAME_VERSION;
+    buffer[1] = 0;
+    buffer[2] = (uint8_t)tier;
+    writeU32(buffer + 3, firstSeq);
+    buffer[7] = 0;
+    length = HISTORY_ROLLUP_FRAME_HEADER;
+    return true;
+}
+
+bool RollupFrameEncoder::add(const RollupBucket& bucket) {
+    if (length == 0 || count == 255 || bucket.count == 0) {
+        return false;
+    }
+
+    // Starts are multiples of the width, so the index is exact; a step can be
+    // negative once the ms clock wraps
+    uint32_t index = bucket.start / width;
+    int16_t mean = bucket.mean();
+    uint8_t scratch[5 * Varint::MAX_BYTES];
+    size_t used;
+    if (count == 0) {
+        used = Varint::encode(Varint::zigzag((int32_t)index), scratch);
+        used += Varint::encode(Varint::zigzag(mean), scratch + used);
+    } else {
+        used = Varint::encode(Varint::zigzag((int32_t)(index - lastIndex)), scratch);
+        used += Varint::encode(Varint::zigzag(mean - lastMean), scratch + used);
+    }
+    used += Varint::encode((uint32_t)(mean - bucket.min), scratch + used);
+    used += Varint::encode((uint32_t)(bucket.max - mean), scratch + used);
+    used += Varint::encode(bucket.count, scratch + used);
+
+    if (length + used > capacity) {
+        return false;
+    }
+    memcpy(buffer + length, scratch, used);
+    length += used;
+    count++;
+    lastIndex = index;
+    lastMean = mean;
+    return true;
+}
+
+size_t RollupFrameEncoder::finish(bool last) {
+    if (length == 0) {
+        return 0;
+    }
+    buffer[1] = last ? HISTORY_FLAG_LAST : 0;
+    buffer[7] = count;
+    return length;
+}
+
+uint8_t RollupFrameEncoder::getCount() const {
+    return count;
+}
+
+size_t RollupFrameEncoder::encodeRange(const HistoryRollup& rollup, HistoryTier tier, uint32_t& nextSeq,
+                                       uint8_t* buffer, size_t capacity) {
+    // Buckets that left the ring are gone; the client sees the jump in firstSeq
+    uint32_t first = rollup.getFirstSequence(tier);
+    uint32_t end = rollup.getNextSequence(tier);
+    if ((int32_t)(nextSeq - first) < 0) {
+        nextSeq = first;
+    } else if ((int32_t)(nextSeq - end) > 0) {
+        nextSeq = end;
+    }
+
+    RollupFrameEncoder encoder(buffer, capacity);
+    if (!encoder.begin(tier, nextSeq)) {
+        return 0;
+    }
+
+    // The newest bucket goes out as it stands; it may still be filling
+    RollupBucket bucket;
+    while (nextSeq != end && rollup.getBucket(tier, nextSeq, bucket) && encoder.add(bucket)) {
+        nextSeq++;
+    }
+    return encoder.finish(nextSeq == end);
+}
+
+int RollupFrameDecoder::decode(const uint8_t* data, size_t length, RollupFrameHeader& header,
+                               RollupPoint* points, size_t maxPoints) {
+    if (length < HISTORY_ROLLUP_FRAME_HEADER || data[0] != HISTORY_ROLLUP_FRAME_VERSION) {
+        return -1;
+    }
+    header.version = data[0];
+    header.flags = data[1];
+    header.tier = data[2];
+    header.firstSeq = readU32(data + 3);
+    header.count = data[7];
+    uint32_t width = HistoryRollup::getWidth((HistoryTier)header.tier);
+    if (width == 0 || header.count > maxPoints) {
+        return -1;
+    }
+
+    size_t pos = HISTORY_ROLLUP_FRAME_HEADER;
+    uint32_t index = 0;
+    // Wide enough that a corrupt delta can not overflow before the range check
+    int64_t mean = 0;
+    for (int i = 0; i < header.count; i++) {
+        uint32_t fields[5];
+        for (int f = 0; f < 5; f++) {
+            size_t used = Varint::decode(data + pos, length - pos, fields[f]);
+            if (used == 0) {
+                return -1;
+            }
+            pos += used;
+        }
+
+        if (i == 0) {
+            index = (uint32_t)Varint::unzigzag(fields[0]);
+            mean = Varint::unzigzag(fields[1]);
+        } else {
+            index += (uint32_t)Varint::unzigzag(fields[0]);
+            mean += (int64_t)Varint::unzigzag(fields[1]);
+        }
+        if (mean < -32768 || mean > 32767 || fields[2] > 65535 || fields[3] > 65535 ||
+            fields[4] == 0 || fields[4] > 0xFFFF) {
+            return -1;
+        }
+        int32_t minValue = (int32_t)mean - (int32_t)fields[2];
+        int32_t maxValue = (int32_t)mean + (int32_t)fields[3];
+        if (minValue < -32768 || maxValue > 32767) {
+            return -1;
+        }
+        points[i].start = index * width;
+        points[i].mean = (int16_t)mean;
+        points[i].min = (int16_t)minValue;
+        points[i].max = (int16_t)maxValue;
+        points[i].count = (uint16_t)fields[4];
+    }
+
+    // Trailing bytes mean the frame was not produced by this encoder version
+    return pos == length ? header.count : -1;
+}
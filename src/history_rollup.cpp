@@ -0,0 +1,211 @@
+#include "history_rollup.h"
+
+static const uint32_t TIER_WIDTHS[TIER_COUNT] = {
+    0,
+    60000UL,     // 1 minute
+    900000UL,    // 15 minutes
+    3600000UL    // 1 hour
+};
+
+static const uint16_t MAX_BUCKET_COUNT = 0xFFFF;
+
+int16_t RollupBucket::mean() const {
+    if (count == 0) {
+        return 0;
+    }
+    if (sum >= 0) {
+        return (int16_t)((sum + count / 2) / count);
+    }
+    return (int16_t)-((-sum + count / 2) / count);
+}
+
+HistoryRollup::HistoryRollup() {
+    const uint32_t capacities[ROLLUP_TIERS] = { BUCKETS_1_MIN, BUCKETS_15_MIN, BUCKETS_1_HOUR };
+    RollupBucket* next = storage;
+    for (int i = 0; i < ROLLUP_TIERS; i++) {
+        tiers[i].buckets = next;
+        tiers[i].width = TIER_WIDTHS[i + 1];
+        tiers[i].mask = capacities[i] - 1;
+        next += capacities[i];
+    }
+    clear();
+}
+
+void HistoryRollup::clear() {
+    for (int i = 0; i < ROLLUP_TIERS; i++) {
+        tiers[i].nextSeq = 0;
+    }
+}
+
+const HistoryRollup::Tier* HistoryRollup::find(HistoryTier tier) const {
+    if (tier <= TIER_RAW || tier >= TIER_COUNT) {
+        return nullptr;
+    }
+    return &tiers[tier - 1];
+}
+
+void HistoryRollup::add(uint32_t timestamp, int16_t value) {
+    for (int i = 0; i < ROLLUP_TIERS; i++) {
+        Tier& tier = tiers[i];
+        uint32_t start = timestamp - timestamp % tier.width;
+
+        if (tier.nextSeq > 0) {
+            RollupBucket& newest = tier.buckets[(tier.nextSeq - 1) & tier.mask];
+            if ((int32_t)(start - newest.start) <= 0) {
+                // A full bucket stops counting rather than overflow its sum
+                if (newest.count < MAX_BUCKET_COUNT) {
+                    newest.sum += value;
+                    newest.count++;
+                    if (value < newest.min) newest.min = value;
+                    if (value > newest.max) newest.max = value;
+                }
+                continue;
+            }
+        }
+
+        // Crossed a boundary: the oldest bucket makes room when the ring is full
+        RollupBucket& bucket = tier.buckets[tier.nextSeq & tier.mask];
+        bucket.start = start;
+        bucket.sum = value;
+        bucket.count = 1;
+        bucket.min = value;
+        bucket.max = value;
+        tier.nextSeq++;
+    }
+}
+
+uint32_t HistoryRollup::getWidth(HistoryTier tier) {
+    if (tier < 0 || tier >= TIER_COUNT) {
+        return 0;
+    }
+    return TIER_WIDTHS[tier];
+}
+
+uint32_t HistoryRollup::getCapacity(HistoryTier tier) const {
+    const Tier* source = find(tier);
+    return source != nullptr ? source->mask + 1 : 0;
+}
+
+uint32_t HistoryRollup::size(HistoryTier tier) const {
+    const Tier* source = find(tier);
+    if (source == nullptr) {
+        return 0;
+    }
+    return source->nextSeq <= source->mask ? source->nextSeq : source->mask + 1;
+}
+
+uint32_t HistoryRollup::getFirstSequence(HistoryTier tier) const {
+    return getNextSequence(tier) - size(tier);
+}
+
+uint32_t HistoryRollup::getNextSequence(HistoryTier tier) const {
+    const Tier* source = find(tier);
+    return source != nullptr ? source->nextSeq : 0;
+}
+
+bool HistoryRollup::getBucket(HistoryTier tier, uint32_t seq, RollupBucket& bucket) const {
+    const Tier* source = find(tier);
+    if (source == nullptr || seq - getFirstSequence(tier) >= size(tier)) {
+        return false;
+    }
+    bucket = source->buckets[seq & source->mask];
+    return true;
+}
+
+// Age in ms of the end of a bucket, as seen from `newest`; 0 while open
+static uint32_t bucketAge(const RollupBucket& bucket, uint32_t width, uint32_t newest) {
+    uint32_t sinceStart = newest - bucket.start;
+    return sinceStart < width ? 0 : sinceStart - (width - 1);
+}
+
+uint32_t HistoryRollup::findFirst(HistoryTier tier, uint32_t newest, uint32_t rangeMs) const {
+    const Tier* source = find(tier);
+    uint32_t low = getFirstSequence(tier);
+    uint32_t high = getNextSequence(tier);
+    if (source == nullptr) {
+        return high;
+    }
+    // Ages fall with the sequence number; unsigned ages survive the clock wrapping
+    while (low != high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (bucketAge(source->buckets[mid & source->mask], source->width, newest) <= rangeMs) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+// First stored sample at most `rangeMs` older than `newest`
+static uint32_t findFirstSample(const TemperatureHistory& raw, uint32_t newest, uint32_t rangeMs) {
+    uint32_t low = raw.getFirstSequence();
+    uint32_t high = raw.getNextSequence();
+    while (low != high) {
+        uint32_t mid = low + (high - low) / 2;
+        HistorySample sample;
+        raw.getSample(mid, sample);
+        if (newest - sample.timestamp <= rangeMs) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+HistorySelection HistoryTierSelector::select(const TemperatureHistory& raw, const HistoryRollup& rollup,
+                                             uint32_t rangeMs, uint32_t maxPoints) {
+    HistorySelection selection;
+    selection.tier = TIER_RAW;
+    selection.firstSeq = raw.getNextSequence();
+    selection.points = 0;
+
+    HistorySample newest;
+    if (raw.size() == 0 || !raw.getSample(raw.getNextSequence() - 1, newest)) {
+        return selection;
+    }
+    if (rangeMs == 0) {
+        rangeMs = UINT32_MAX;
+    }
+
+    for (int i = TIER_RAW; i < TIER_COUNT; i++) {
+        HistoryTier tier = (HistoryTier)i;
+        uint32_t first;
+        uint32_t next;
+        uint32_t oldestAge;
+        bool complete;
+        if (tier == TIER_RAW) {
+            HistorySample sample;
+            raw.getSample(raw.getFirstSequence(), sample);
+            first = findFirstSample(raw, newest.timestamp, rangeMs);
+            next = raw.getNextSequence();
+            oldestAge = newest.timestamp - sample.timestamp;
+            complete = raw.getFirstSequence() == 0;
+        } else {
+            RollupBucket bucket;
+            rollup.getBucket(tier, rollup.getFirstSequence(tier), bucket);
+            first = rollup.findFirst(tier, newest.timestamp, rangeMs);
+            next = rollup.getNextSequence(tier);
+            oldestAge = newest.timestamp - bucket.start;
+            complete = rollup.getFirstSequence(tier) == 0;
+        }
+
+        // A tier that already dropped part of the range is no good while a
+        // coarser one may still have it; the hourly tier keeps the oldest
+        uint32_t points = next - first;
+        bool reaches = complete || tier == TIER_1_HOUR || oldestAge >= rangeMs;
+        if (reaches && (maxPoints == 0 || points <= maxPoints)) {
+            selection.tier = tier;
+            selection.firstSeq = first;
+            selection.points = points;
+            return selection;
+        }
+    }
+
+    // Too many even at an hour each: the newest buckets only
+    selection.tier = TIER_1_HOUR;
+    selection.firstSeq = rollup.getNextSequence(TIER_1_HOUR) - maxPoints;
+    selection.points = maxPoints;
+    return selection;
+}
@@ -0,0 +1,97 @@
+#include "link_tuning.h"
+
+// Bulk: 7.5-15 ms, no latency, 4 s timeout
+const LinkParams LinkTuning::BULK_PARAMS = { 6, 12, 0, 400 };
+// Idle: 100-200 ms, skip up to 4 events, 6 s timeout (> 2 x 5 x 200 ms)
+const LinkParams LinkTuning::IDLE_PARAMS = { 80, 160, 4, 600 };
+
+static void writeU16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void writeU32(uint8_t* out, uint32_t value) {
+    writeU16(out, (uint16_t)value);
+    writeU16(out + 2, (uint16_t)(value >> 16));
+}
+
+LinkTuning::LinkTuning() {
+    reset(0);
+}
+
+// A new connection counts as bulk traffic, so it starts on the short interval
+void LinkTuning::reset(uint32_t now) {
+    requested = LINK_PROFILE_NONE;
+    lastBulkAt = now;
+    measuring = false;
+    bulkStartedAt = now;
+    bulkBytes = 0;
+    throughput = 0;
+}
+
+LinkProfile LinkTuning::update(bool bulkPending, uint32_t now) {
+    if (bulkPending) {
+        lastBulkAt = now;
+    }
+    LinkProfile wanted = now - lastBulkAt < IDLE_AFTER ? LINK_PROFILE_BULK : LINK_PROFILE_IDLE;
+    if (wanted == requested) {
+        return LINK_PROFILE_NONE;
+    }
+    requested = wanted;
+    return wanted;
+}
+
+LinkProfile LinkTuning::getRequested() const {
+    return (LinkProfile)requested;
+}
+
+const LinkParams& LinkTuning::paramsFor(LinkProfile profile) {
+    return profile == LINK_PROFILE_IDLE ? IDLE_PARAMS : BULK_PARAMS;
+}
+
+void LinkTuning::startBulk(uint32_t now) {
+    measuring = true;
+    bulkStartedAt = now;
+    bulkBytes = 0;
+    lastBulkAt = now;
+}
+
+void LinkTuning::addBulkBytes(size_t bytes) {
+    bulkBytes += (uint32_t)bytes;
+}
+
+void LinkTuning::finishBulk(uint32_t now) {
+    if (!measuring) {
+        return;
+    }
+    throughput = getThroughput(now);
+    measuring = false;
+    lastBulkAt = now;
+}
+
+// Payload bytes per second; a transfer that took no measurable time counts
+// as one millisecond
+uint32_t LinkTuning::getThroughput(uint32_t now) const {
+    if (!measuring) {
+        return throughput;
+    }
+    uint32_t elapsed = now - bulkStartedAt;
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+    return (uint32_t)((uint64_t)bulkBytes * 1000 / elapsed);
+}
+
+size_t LinkTuning::encodeInfo(const LinkInfo& info, uint8_t* buffer, size_t capacity) {
+    if (capacity < LINK_INFO_SIZE) {
+        return 0;
+    }
+    writeU16(buffer, info.handle);
+    writeU16(buffer + 2, info.mtu);
+    writeU16(buffer + 4, info.dataLength);
+    writeU16(buffer + 6, info.interval);
+    writeU16(buffer + 8, info.latency);
+    buffer[10] = info.profile;
+    writeU32(buffer + 11, info.throughput);
+    return LINK_INFO_SIZE;
+}
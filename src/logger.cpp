@@ -0,0 +1,167 @@
+#include "logger.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+static TaskHandle_t drainTaskHandle = nullptr;
+static const UBaseType_t DRAIN_PRIORITY = 1;          // just above idle
+static const uint32_t DRAIN_IDLE_MS = 100;            // re-check even without a wakeup
+#endif
+
+static const char LEVEL_TAGS[] = "-EWIDV";
+
+LogRing::LogRing() {
+    clear();
+}
+
+void LogRing::clear() {
+    head = 0;
+    tail = 0;
+}
+
+size_t LogRing::available() const {
+    return __atomic_load_n(&head, __ATOMIC_ACQUIRE) - __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+}
+
+bool LogRing::push(const char* data, size_t length) {
+    uint32_t writeIndex = head;
+    uint32_t readIndex = __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    if (length > CAPACITY - (writeIndex - readIndex)) {
+        return false;
+    }
+
+    // At most two copies: up to the end of the buffer, then from the start
+    uint32_t offset = writeIndex & (CAPACITY - 1);
+    size_t first = CAPACITY - offset;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(buffer + offset, data, first);
+    memcpy(buffer, data + first, length - first);
+
+    __atomic_store_n(&head, writeIndex + (uint32_t)length, __ATOMIC_RELEASE);
+    return true;
+}
+
+size_t LogRing::pop(char* out, size_t capacity) {
+    uint32_t readIndex = tail;
+    uint32_t writeIndex = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    size_t length = writeIndex - readIndex;
+    if (length > capacity) {
+        length = capacity;
+    }
+
+    uint32_t offset = readIndex & (CAPACITY - 1);
+    size_t first = CAPACITY - offset;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(out, buffer + offset, first);
+    memcpy(out + first, buffer, length - first);
+
+    __atomic_store_n(&tail, readIndex + (uint32_t)length, __ATOMIC_RELEASE);
+    return length;
+}
+
+// Static member definitions
+LogRing Logger::ring;
+volatile bool Logger::producerBusy = false;
+volatile uint32_t Logger::dropped = 0;
+
+static size_t formatLine(char* out, size_t capacity, uint8_t level, const char* format, va_list args) {
+    if (capacity < 6) {
+        return 0;
+    }
+    out[0] = '[';
+    out[1] = LEVEL_TAGS[level <= LOG_LEVEL_VERBOSE ? level : 0];
+    out[2] = ']';
+    out[3] = ' ';
+    size_t length = 4;
+
+    // Truncate long messages but always keep room for the newline
+    int written = vsnprintf(out + length, capacity - length - 1, format, args);
+    if (written > 0) {
+        length += (size_t)written < capacity - length - 1 ? (size_t)written : capacity - length - 2;
+    }
+    out[length++] = '\n';
+    out[length] = '\0';
+    return length;
+}
+
+size_t Logger::format(char* out, size_t capacity, uint8_t level, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t length = formatLine(out, capacity, level, format, args);
+    va_end(args);
+    return length;
+}
+
+void Logger::write(uint8_t level, const char* format, ...) {
+    char line[LOG_LINE_SIZE];
+    va_list args;
+    va_start(args, format);
+    size_t length = formatLine(line, sizeof(line), level, format, args);
+    va_end(args);
+    enqueue(line, length);
+}
+
+void Logger::enqueue(const char* line, size_t length) {
+    // The ring has one producer slot; a second task arriving meanwhile drops its line
+    if (__atomic_test_and_set(&producerBusy, __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    bool queued = ring.push(line, length);
+#ifndef ARDUINO
+    // Drained inline while still holding the slot, so threads in the native
+    // tests never run two consumers at once
+    flush();
+#endif
+    __atomic_clear(&producerBusy, __ATOMIC_RELEASE);
+
+    if (!queued) {
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+    }
+#ifdef ARDUINO
+    if (drainTaskHandle != nullptr) {
+        xTaskNotifyGive(drainTaskHandle);
+    }
+#endif
+}
+
+void Logger::flush() {
+    // Consumer side of the ring: only the drain task calls this on target
+    char chunk[64];
+    size_t length;
+    while ((length = ring.pop(chunk, sizeof(chunk))) > 0) {
+        Serial.write(chunk, length);
+    }
+}
+
+#ifdef ARDUINO
+static void drainTask(void*) {
+    for (;;) {
+        // Serial.write() may block on the UART; only this task ever waits on it
+        Logger::flush();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DRAIN_IDLE_MS));
+    }
+}
+#endif
+
+void Logger::begin() {
+#ifdef ARDUINO
+    if (drainTaskHandle == nullptr) {
+        xTaskCreate(drainTask, "log", Logger::DRAIN_STACK_SIZE, nullptr, DRAIN_PRIORITY, &drainTaskHandle);
+    }
+#endif
+}
+
+uint32_t Logger::getDropped() {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+void Logger::reset() {
+    ring.clear();
+    dropped = 0;
+}
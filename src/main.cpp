@@ -2,69 +2,239 @@
 #include "ble_server.h"
 #include "temperature_service.h"
 #include "wifi_manager.h"
+#include "telemetry_uplink.h"
+#include "scheduler.h"
+#include "config_store.h"
+#include "power_manager.h"
+#include "timing_stats.h"
+#include "memory_monitor.h"
+#include "boot_profile.h"
+#include "logger.h"
 
-static const char* TAG = "ESP32_BLE_MAIN";
+static const uint32_t STATUS_PRINT_INTERVAL = 30000;  // print status every 30 seconds
+static const uint32_t SAMPLE_LOG_INTERVAL = 60000;    // move published samples to flash
+static const uint32_t MAX_IDLE_MS = 1000;             // upper bound on a single idle sleep
+
+// One scheduler lane per FreeRTOS task. NimBLE's host task and the WiFi
+// driver both live on core 0, so BLE publishing runs next to its stack there
+// while sampling and the (sometimes slow) network work share core 1. Sampling
+// has the highest priority so a WiFi reconnect never delays a reading.
+enum FirmwareLane {
+    LANE_SAMPLING = 0,
+    LANE_BLE,
+    LANE_NETWORK
+};
+
+struct LaneTaskConfig {
+    const char* name;
+    int core;
+    uint8_t priority;
+    uint32_t stackSize;
+};
+
+#ifdef CONFIG_BT_NIMBLE_HOST_TASK_STACK_SIZE
+static const uint32_t NIMBLE_HOST_STACK_SIZE = CONFIG_BT_NIMBLE_HOST_TASK_STACK_SIZE;
+#else
+static const uint32_t NIMBLE_HOST_STACK_SIZE = 4096;   // NimBLE-Arduino's default
+#endif
+
+static const LaneTaskConfig LANE_TASKS[Scheduler::MAX_LANES] = {
+    { "sampling", 1, 3, 3072 },
+    { "ble",      0, 2, 4096 },
+    { "network",  1, 1, 4096 },
+};
+
+static void printStatus() {
+    LOG_INFO("Status: BLE Server running, Connected: %s",
+             BLEServerManager::isConnected() ? "Yes" : "No");
+    LOG_INFO("WiFi Status: %s", WiFiManager::isConnected() ? "Connected" : "Disconnected");
+    if (WiFiManager::isConnected()) {
+        LOG_INFO("WiFi IP: %s", WiFiManager::getIPAddress().c_str());
+        LOG_INFO("WiFi RSSI: %d dBm", WiFiManager::getRSSI());
+    }
+    for (int i = 0; i < TemperatureService::getSensorCount(); i++) {
+        SensorStats stats;
+        if (TemperatureService::getSensorStats(i, stats)) {
+            LOG_INFO("Sensor %s: %lu readings, %lu errors, %lu timeouts",
+                     TemperatureService::getSensorName(i), (unsigned long)stats.readings,
+                     (unsigned long)stats.errors, (unsigned long)stats.timeouts);
+        }
+    }
+    if (TelemetryUplink::isEnabled()) {
+        uint32_t acked = 0;
+        LOG_INFO("Uplink: %lu batches acked, %lu failed, %lu oversized, %lu queued, %lu downsampled, %lu dropped",
+                 (unsigned long)TelemetryUplink::getPublishedBatches(),
+                 (unsigned long)TelemetryUplink::getFailedPublishes(),
+                 (unsigned long)TelemetryUplink::getOversizedBatches(),
+                 (unsigned long)TelemetryUplink::getQueuedSamples(),
+                 (unsigned long)TelemetryUplink::getDownsampledSamples(),
+                 (unsigned long)TelemetryUplink::getDroppedSamples());
+        if (TelemetryUplink::getAckedSequence(acked)) {
+            LOG_INFO("Uplink: acked through sample %lu", (unsigned long)acked);
+        }
+    }
+    uint64_t active = PowerManager::getResidency(POWER_ACTIVE);
+    uint64_t idle = PowerManager::getResidency(POWER_IDLE);
+    uint64_t sleep = PowerManager::getResidency(POWER_LIGHT_SLEEP);
+    uint64_t total = active + idle + sleep;
+    if (total > 0) {
+        LOG_INFO("Power: %lu%% active, %lu%% idle, %lu%% light sleep, %lu wakeups, advertising %s",
+                 (unsigned long)(active * 100 / total), (unsigned long)(idle * 100 / total),
+                 (unsigned long)(sleep * 100 / total), (unsigned long)PowerManager::getWakeups(),
+                 BLEServerManager::getAdvertisingMode() == ADVERTISING_FAST ? "fast" : "slow");
+    }
+    if (TemperatureService::getDroppedLogSamples() > 0) {
+        LOG_WARN("Samples not logged to flash: %lu", (unsigned long)TemperatureService::getDroppedLogSamples());
+    }
+    if (Logger::getDropped() > 0) {
+        LOG_WARN("Log lines dropped: %lu", (unsigned long)Logger::getDropped());
+    }
+    TimingStats::printSummary();
+    MemoryMonitor::printSummary();
+}
+
+// Runs one lane's due jobs. The loop probe times the BLE lane only, since
+// a histogram must not be written by two tasks at once.
+static void runLane(int lane) {
+    Scheduler::setLane(lane);
+    if (lane == LANE_BLE) {
+        ScopedTimer timer(PROBE_LOOP);
+        Scheduler::runDue();
+    } else {
+        Scheduler::runDue();
+    }
+}
+
+#ifdef ARDUINO
+static void laneTask(void* parameter) {
+    int lane = (int)(intptr_t)parameter;
+    Scheduler::setLane(lane);
+    for (;;) {
+        runLane(lane);
+        // Sleep until the lane's next deadline (or until a trigger wakes it)
+        Scheduler::sleepUntilNext(MAX_IDLE_MS);
+    }
+}
+
+static void startLaneTasks() {
+    for (int lane = 0; lane < Scheduler::MAX_LANES; lane++) {
+        const LaneTaskConfig& config = LANE_TASKS[lane];
+        if (xTaskCreatePinnedToCore(laneTask, config.name, config.stackSize, (void*)(intptr_t)lane,
+                                    config.priority, nullptr, config.core) != pdPASS) {
+            LOG_ERROR("Failed to start %s task", config.name);
+        }
+    }
+}
+#endif
+
+// Starts the WiFi driver and the first association attempt. The driver
+// takes a few hundred ms to come up, which a fast start spends advertising.
+static void startWiFi() {
+    WiFiManager::init();
+    // The attempt completes in the background
+    WiFiManager::connect();
+    BootProfile::mark(BOOT_WIFI_START);
+}
+
+// The GATT server, including the change-driven temperature notifications
+static void startBLE() {
+    Scheduler::setLane(LANE_BLE);
+    BLEServerManager::init();
+    BootProfile::mark(BOOT_ADVERTISING);
+}
 
 void setup() {
+    BootProfile::mark(BOOT_SETUP);
     Serial.begin(115200);
-    Serial.println("\n=== ESP32-S3 BLE GATT Server Starting ===");
-    
-    // Add a small delay for serial to stabilize
+    Logger::begin();
+    LOG_INFO("=== ESP32-S3 BLE GATT Server Starting ===");
+
+#if !FAST_START
+    // Give a serial monitor time to attach before the first lines scroll by
     delay(1000);
-    
-    // Initialize WiFi Manager
-    WiFiManager::init();
-    
-    // Connect to WiFi
-    WiFiManager::connect();
-    
+#endif
+
+    TimingStats::reset();
+
+    // Clock down and light-sleep whenever every lane waits
+    PowerManager::begin();
+
+    // Jobs join the lane selected when they are registered
+    Scheduler::setLane(LANE_NETWORK);
+
+    // Settings first: every module below reads its own at init
+    ConfigStore::init();
+    BootProfile::mark(BOOT_CONFIG);
+
+#if FAST_START
+    // Advertise before anything else, so a central can find the device while
+    // the rest comes up; the first reading is published once it arrives
+    startBLE();
+    Scheduler::setLane(LANE_NETWORK);
+#endif
+
+    // Heap and stack watermarks; the tasks are found by name once they run
+    for (int lane = 0; lane < Scheduler::MAX_LANES; lane++) {
+        MemoryMonitor::watchTask(LANE_TASKS[lane].name, LANE_TASKS[lane].stackSize);
+    }
+    MemoryMonitor::watchTask("nimble_host", NIMBLE_HOST_STACK_SIZE);
+    MemoryMonitor::watchTask("log", Logger::DRAIN_STACK_SIZE);
+    MemoryMonitor::init();
+
+#if FAST_START
+    // The network lane starts WiFi as soon as it runs
+    Scheduler::addOneShot("wifi-start", startWiFi, 0);
+#else
+    startWiFi();
+#endif
+
+    Scheduler::addPeriodic("status", printStatus, STATUS_PRINT_INTERVAL, STATUS_PRINT_INTERVAL);
+    // Flash writes stall both cores' caches, so they stay in the least urgent lane
+    Scheduler::addPeriodic("sample-log", TemperatureService::writeLog, SAMPLE_LOG_INTERVAL, SAMPLE_LOG_INTERVAL);
+    Scheduler::addOneShot("boot-report", BootProfile::printReport, BootProfile::REPORT_DELAY);
+
     // Initialize Temperature Service
+    Scheduler::setLane(LANE_SAMPLING);
     TemperatureService::init();
-    
-    // Initialize BLE Server
-    BLEServerManager::init();
-    
-    Serial.println("Setup complete. Entering main loop...");
+    BootProfile::mark(BOOT_SENSORS);
+
+    // Upload the history once WiFi is up; publishing never waits on the server
+    Scheduler::setLane(LANE_NETWORK);
+    TelemetryUplink::init();
+
+    // The history belongs to the BLE lane, so the uplink collects from it there
+    Scheduler::setLane(LANE_BLE);
+    if (TelemetryUplink::isEnabled()) {
+        Scheduler::addPeriodic("uplink-collect", TelemetryUplink::collect, TelemetryUplink::COLLECT_INTERVAL);
+    }
+#if !FAST_START
+    startBLE();
+#endif
+
+    BootProfile::mark(BOOT_SETUP_DONE);
+    uint32_t doneAt = 0;
+    uint32_t advertisingAt = 0;
+    BootProfile::getTime(BOOT_SETUP_DONE, doneAt);
+    BootProfile::getTime(BOOT_ADVERTISING, advertisingAt);
+#ifdef ARDUINO
+    startLaneTasks();
+    LOG_INFO("Setup complete after %lu ms, advertising after %lu ms. Lane tasks running.",
+             (unsigned long)(doneAt / 1000), (unsigned long)(advertisingAt / 1000));
+#else
+    LOG_INFO("Setup complete after %lu ms, advertising after %lu ms. Entering main loop...",
+             (unsigned long)(doneAt / 1000), (unsigned long)(advertisingAt / 1000));
+#endif
 }
 
 void loop() {
-    // Maintain WiFi connection
-    WiFiManager::loop();
-    
-    // Update temperature readings (checks internally if 30 seconds have passed)
-    TemperatureService::update();
-    
-    // Update BLE temperature characteristics with current values
-    BLEServerManager::updateTemperature(
-        TemperatureService::getCurrentTemperature(),
-        TemperatureService::getMaxTemperature(),
-        TemperatureService::getMinTemperature()
-    );
-    
-    // Notify connected clients about temperature updates every 30 seconds
-    static unsigned long lastTempNotify = 0;
-    if (BLEServerManager::isConnected() && (millis() - lastTempNotify >= 30000)) {
-        BLEServerManager::notifyTemperature();
-        lastTempNotify = millis();
+#ifdef ARDUINO
+    // All work runs in the lane tasks; the Arduino loop task is not needed
+    vTaskDelete(nullptr);
+#else
+    // The simulator runs every lane on its one thread, in priority order
+    for (int lane = 0; lane < Scheduler::MAX_LANES; lane++) {
+        runLane(lane);
     }
-    
-    // Run BLE server loop
-    BLEServerManager::loop();
-    
-    // Add any additional application logic here
-    delay(100);
-    
-    // Example: Print status every 30 seconds
-    static unsigned long lastStatusPrint = 0;
-    if (millis() - lastStatusPrint > 30000) {
-        Serial.println("Status: BLE Server running, Connected: " + 
-                      String(BLEServerManager::isConnected() ? "Yes" : "No"));
-        Serial.println("WiFi Status: " + 
-                      String(WiFiManager::isConnected() ? "Connected" : "Disconnected"));
-        if (WiFiManager::isConnected()) {
-            Serial.println("WiFi IP: " + WiFiManager::getIPAddress());
-            Serial.println("WiFi RSSI: " + String(WiFiManager::getRSSI()) + " dBm");
-        }
-        lastStatusPrint = millis();
-    }
-}
\ No newline at end of file
+    Scheduler::sleepUntilNext(MAX_IDLE_MS);
+#endif
+}
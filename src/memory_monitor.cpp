@@ -0,0 +1,209 @@
+#include "memory_monitor.h"
+#include "scheduler.h"
+#include "logger.h"
+#include <string.h>
+
+#ifdef ARDUINO
+static EspMemoryProbe defaultProbe;
+#else
+static FakeMemoryProbe defaultProbe;
+#endif
+
+static const uint16_t STACK_UNKNOWN = 0xFFFF;
+
+// Static member definitions
+MemoryProbe* MemoryMonitor::probe = &defaultProbe;
+MemoryStats MemoryMonitor::stats;
+TaskStackStats MemoryMonitor::tasks[MemoryMonitor::MAX_TASKS];
+bool MemoryMonitor::stackWarned[MemoryMonitor::MAX_TASKS];
+int MemoryMonitor::taskCount = 0;
+uint8_t MemoryMonitor::fragmentationThreshold = MEMORY_FRAGMENTATION_WARNING;
+int MemoryMonitor::sampleTaskId = Scheduler::INVALID_TASK;
+
+void MemoryMonitor::init() {
+    sample();
+    if (!Scheduler::isScheduled(sampleTaskId)) {
+        sampleTaskId = Scheduler::addPeriodic("memory", sample, SAMPLE_INTERVAL, SAMPLE_INTERVAL);
+    }
+    LOG_INFO("Memory: %lu bytes free heap, largest block %lu",
+             (unsigned long)stats.heap.freeBytes, (unsigned long)stats.heap.largestFreeBlock);
+}
+
+void MemoryMonitor::reset() {
+    memset(&stats, 0, sizeof(stats));
+    memset(tasks, 0, sizeof(tasks));
+    memset(stackWarned, 0, sizeof(stackWarned));
+    taskCount = 0;
+    fragmentationThreshold = MEMORY_FRAGMENTATION_WARNING;
+}
+
+void MemoryMonitor::setProbe(MemoryProbe* newProbe) {
+    probe = newProbe;
+}
+
+void MemoryMonitor::setFragmentationThreshold(uint8_t percent) {
+    fragmentationThreshold = percent;
+}
+
+bool MemoryMonitor::watchTask(const char* name, uint32_t stackSize) {
+    for (int i = 0; i < taskCount; i++) {
+        if (strcmp(tasks[i].name, name) == 0) {
+            tasks[i].stackSize = stackSize;
+            return true;
+        }
+    }
+    if (taskCount >= MAX_TASKS) {
+        return false;
+    }
+    TaskStackStats& task = tasks[taskCount++];
+    task.name = name;
+    task.stackSize = stackSize;
+    task.minUnused = 0;
+    task.seen = false;
+    return true;
+}
+
+uint8_t MemoryMonitor::fragmentationOf(const HeapInfo& heap) {
+    if (heap.freeBytes == 0 || heap.largestFreeBlock >= heap.freeBytes) {
+        return 0;
+    }
+    return (uint8_t)(100 - (uint64_t)heap.largestFreeBlock * 100 / heap.freeBytes);
+}
+
+static uint32_t lowest(uint32_t current, uint32_t value, bool first) {
+    return (first || value < current) ? value : current;
+}
+
+void MemoryMonitor::sample() {
+    if (probe == nullptr) {
+        return;
+    }
+    HeapInfo heap;
+    if (probe->readHeap(heap)) {
+        bool first = stats.samples == 0;
+        stats.heap = heap;
+        // The allocator also sees dips between two samples
+        uint32_t minFree = heap.minFreeBytes < heap.freeBytes ? heap.minFreeBytes : heap.freeBytes;
+        stats.minFreeHeap = lowest(stats.minFreeHeap, minFree, first);
+        stats.minLargestFreeBlock = lowest(stats.minLargestFreeBlock, heap.largestFreeBlock, first);
+        stats.fragmentation = fragmentationOf(heap);
+        if (stats.fragmentation > stats.maxFragmentation) {
+            stats.maxFragmentation = stats.fragmentation;
+        }
+
+        if (!stats.fragmented && stats.fragmentation > fragmentationThreshold) {
+            stats.fragmented = true;
+            stats.fragmentationWarnings++;
+            LOG_WARN("Heap fragmented: %u%%, largest block %lu of %lu bytes free",
+                     (unsigned)stats.fragmentation, (unsigned long)heap.largestFreeBlock,
+                     (unsigned long)heap.freeBytes);
+        } else if (stats.fragmented &&
+                   stats.fragmentation + FRAGMENTATION_HYSTERESIS <= fragmentationThreshold) {
+            stats.fragmented = false;
+        }
+        stats.samples++;
+    }
+
+    HeapInfo psram;
+    if (probe->readPsram(psram)) {
+        bool first = !stats.hasPsram;
+        stats.hasPsram = true;
+        stats.psram = psram;
+        uint32_t minFree = psram.minFreeBytes < psram.freeBytes ? psram.minFreeBytes : psram.freeBytes;
+        stats.minFreePsram = lowest(stats.minFreePsram, minFree, first);
+    }
+
+    for (int i = 0; i < taskCount; i++) {
+        TaskStackStats& task = tasks[i];
+        uint32_t unused;
+        if (!probe->readStackHighWater(task.name, unused)) {
+            continue;
+        }
+        task.minUnused = lowest(task.minUnused, unused, !task.seen);
+        task.seen = true;
+        if (!stackWarned[i] && task.minUnused < STACK_WARNING_BYTES) {
+            stackWarned[i] = true;
+            LOG_WARN("Task %s stack nearly full: %lu of %lu bytes never used", task.name,
+                     (unsigned long)task.minUnused, (unsigned long)task.stackSize);
+        }
+    }
+}
+
+const MemoryStats& MemoryMonitor::getStats() {
+    return stats;
+}
+
+int MemoryMonitor::getTaskCount() {
+    return taskCount;
+}
+
+bool MemoryMonitor::getTaskStack(int index, TaskStackStats& task) {
+    if (index < 0 || index >= taskCount) {
+        return false;
+    }
+    task = tasks[index];
+    return true;
+}
+
+static void writeU16(uint8_t* out, uint32_t value) {
+    if (value > 0xFFFF) {
+        value = 0xFFFF;
+    }
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void writeU32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+size_t MemoryMonitor::getSnapshotSize() {
+    return MEMORY_SNAPSHOT_HEADER + taskCount * MEMORY_SNAPSHOT_TASK_SIZE;
+}
+
+size_t MemoryMonitor::encodeSnapshot(uint8_t* buffer, size_t capacity) {
+    size_t size = getSnapshotSize();
+    if (capacity < size) {
+        return 0;
+    }
+    buffer[0] = MEMORY_SNAPSHOT_VERSION;
+    buffer[1] = (stats.fragmented ? MEMORY_FLAG_FRAGMENTED : 0) | (stats.hasPsram ? MEMORY_FLAG_PSRAM : 0);
+    writeU32(buffer + 2, stats.heap.freeBytes);
+    writeU32(buffer + 6, stats.heap.largestFreeBlock);
+    writeU32(buffer + 10, stats.minFreeHeap);
+    writeU32(buffer + 14, stats.minLargestFreeBlock);
+    writeU32(buffer + 18, stats.psram.freeBytes);
+    writeU32(buffer + 22, stats.minFreePsram);
+    buffer[26] = stats.fragmentation;
+    buffer[27] = (uint8_t)taskCount;
+    uint8_t* out = buffer + MEMORY_SNAPSHOT_HEADER;
+    for (int i = 0; i < taskCount; i++) {
+        writeU16(out, tasks[i].stackSize);
+        writeU16(out + 2, tasks[i].seen ? tasks[i].minUnused : STACK_UNKNOWN);
+        out += MEMORY_SNAPSHOT_TASK_SIZE;
+    }
+    return size;
+}
+
+void MemoryMonitor::printSummary() {
+    if (stats.samples == 0) {
+        return;
+    }
+    LOG_INFO("Heap: %lu free (min %lu), largest block %lu (min %lu), %u%% fragmented (max %u%%)",
+             (unsigned long)stats.heap.freeBytes, (unsigned long)stats.minFreeHeap,
+             (unsigned long)stats.heap.largestFreeBlock, (unsigned long)stats.minLargestFreeBlock,
+             (unsigned)stats.fragmentation, (unsigned)stats.maxFragmentation);
+    if (stats.hasPsram) {
+        LOG_INFO("PSRAM: %lu of %lu free (min %lu)", (unsigned long)stats.psram.freeBytes,
+                 (unsigned long)stats.psram.totalBytes, (unsigned long)stats.minFreePsram);
+    }
+    for (int i = 0; i < taskCount; i++) {
+        if (tasks[i].seen) {
+            LOG_INFO("  stack %s: %lu of %lu bytes never used", tasks[i].name,
+                     (unsigned long)tasks[i].minUnused, (unsigned long)tasks[i].stackSize);
+        }
+    }
+}
@@ -0,0 +1,153 @@
+#include "memory_probe.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+static bool readRegion(uint32_t caps, HeapInfo& region) {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    region.totalBytes = info.total_free_bytes + info.total_allocated_bytes;
+    region.freeBytes = info.total_free_bytes;
+    region.largestFreeBlock = info.largest_free_block;
+    region.minFreeBytes = info.minimum_free_bytes;
+    return region.totalBytes > 0;
+}
+
+bool EspMemoryProbe::readHeap(HeapInfo& heap) {
+    return readRegion(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, heap);
+}
+
+bool EspMemoryProbe::readPsram(HeapInfo& psram) {
+    return readRegion(MALLOC_CAP_SPIRAM, psram);
+}
+
+bool EspMemoryProbe::readStackHighWater(const char* taskName, uint32_t& unusedBytes) {
+    TaskHandle_t task = xTaskGetHandle(taskName);
+    if (task == nullptr) {
+        return false;
+    }
+    // ESP-IDF counts stacks in bytes, not words
+    unusedBytes = uxTaskGetStackHighWaterMark(task);
+    return true;
+}
+
+#else
+
+#include <atomic>
+#include <string.h>
+
+static std::atomic<uint32_t> liveBytes(0);
+static std::atomic<uint32_t> peakBytes(0);
+
+void NativeHeap::allocated(size_t size) {
+    uint32_t live = liveBytes.fetch_add((uint32_t)size, std::memory_order_relaxed) + (uint32_t)size;
+    uint32_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void NativeHeap::released(size_t size) {
+    liveBytes.fetch_sub((uint32_t)size, std::memory_order_relaxed);
+}
+
+uint32_t NativeHeap::getLiveBytes() {
+    return liveBytes.load(std::memory_order_relaxed);
+}
+
+uint32_t NativeHeap::getPeakBytes() {
+    return peakBytes.load(std::memory_order_relaxed);
+}
+
+void NativeHeap::resetPeak() {
+    peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+FakeMemoryProbe::FakeMemoryProbe() : heapSize(DEFAULT_HEAP_SIZE) {
+    reset();
+}
+
+void FakeMemoryProbe::reset() {
+    NativeHeap::resetPeak();
+    baseline = NativeHeap::getLiveBytes();
+    heapScripted = false;
+    memset(&scriptedHeap, 0, sizeof(scriptedHeap));
+    hasPsram = false;
+    memset(&psramInfo, 0, sizeof(psramInfo));
+    stackCount = 0;
+}
+
+void FakeMemoryProbe::setHeapSize(uint32_t bytes) {
+    heapSize = bytes;
+}
+
+void FakeMemoryProbe::scriptHeap(uint32_t freeBytes, uint32_t largestFreeBlock) {
+    heapScripted = true;
+    scriptedHeap.totalBytes = heapSize;
+    scriptedHeap.freeBytes = freeBytes;
+    scriptedHeap.largestFreeBlock = largestFreeBlock;
+    scriptedHeap.minFreeBytes = freeBytes;
+}
+
+void FakeMemoryProbe::setPsram(uint32_t totalBytes, uint32_t freeBytes) {
+    hasPsram = totalBytes > 0;
+    psramInfo.totalBytes = totalBytes;
+    psramInfo.freeBytes = freeBytes;
+    psramInfo.largestFreeBlock = freeBytes;
+    if (psramInfo.minFreeBytes == 0 || freeBytes < psramInfo.minFreeBytes) {
+        psramInfo.minFreeBytes = freeBytes;
+    }
+}
+
+void FakeMemoryProbe::setStackHighWater(const char* taskName, uint32_t unusedBytes) {
+    for (int i = 0; i < stackCount; i++) {
+        if (strcmp(stacks[i].name, taskName) == 0) {
+            stacks[i].unusedBytes = unusedBytes;
+            return;
+        }
+    }
+    if (stackCount < MAX_STACKS) {
+        stacks[stackCount].name = taskName;
+        stacks[stackCount].unusedBytes = unusedBytes;
+        stackCount++;
+    }
+}
+
+static uint32_t usedSince(uint32_t bytes, uint32_t baseline, uint32_t heapSize) {
+    uint32_t used = bytes > baseline ? bytes - baseline : 0;
+    return used < heapSize ? used : heapSize;
+}
+
+bool FakeMemoryProbe::readHeap(HeapInfo& heap) {
+    if (heapScripted) {
+        heap = scriptedHeap;
+        return true;
+    }
+    // The host allocator does not fragment like the ESP-IDF one, so the
+    // largest block is all of the free space unless scripted
+    heap.totalBytes = heapSize;
+    heap.freeBytes = heapSize - usedSince(NativeHeap::getLiveBytes(), baseline, heapSize);
+    heap.largestFreeBlock = heap.freeBytes;
+    heap.minFreeBytes = heapSize - usedSince(NativeHeap::getPeakBytes(), baseline, heapSize);
+    return true;
+}
+
+bool FakeMemoryProbe::readPsram(HeapInfo& psram) {
+    if (!hasPsram) {
+        return false;
+    }
+    psram = psramInfo;
+    return true;
+}
+
+bool FakeMemoryProbe::readStackHighWater(const char* taskName, uint32_t& unusedBytes) {
+    for (int i = 0; i < stackCount; i++) {
+        if (strcmp(stacks[i].name, taskName) == 0) {
+            unusedBytes = stacks[i].unusedBytes;
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
@@ -1,15 +1,86 @@
-#ifndef ARDUINO
+#if !defined(ARDUINO) && !defined(PIO_UNIT_TESTING)
+// Host simulator: pio run -e native && .pio/build/native/program [days] [--verbose]
+// Runs the firmware against the fake NimBLE stack and a scripted access point,
+// then prints notification, loop-pass and scheduler metrics.
+#include "platform.h"
 #include "ble_server.h"
-#include <iostream>
+#include "sim_ble.h"
+#include "simulator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-int main() {
-    std::cout << "Native stub executable for BLEServerManager" << std::endl;
-    BLEServerManager::init();
-    if (BLEServerManager::isConnected()) {
-        std::cout << "Device connected" << std::endl;
-    } else {
-        std::cout << "Device not connected" << std::endl;
+static const uint16_t CENTRAL_MTU = 247;
+static uint16_t central = BLE_HS_CONN_HANDLE_NONE;
+
+// A phone that connects, subscribes to the temperature characteristics and
+// drops off again every few hours
+static void connectCentral() {
+    central = SimBLE::connect(CENTRAL_MTU);
+    if (central != BLE_HS_CONN_HANDLE_NONE) {
+        SimBLE::subscribe(central, CHARACTERISTIC_UUID);
+        SimBLE::subscribe(central, TEMPERATURE_CHAR_UUID);
+        SimBLE::subscribe(central, TEMP_PACKED_CHAR_UUID);
+        SimBLE::subscribe(central, TEMP_HISTORY_CHAR_UUID);
+    }
+}
+
+static void disconnectCentral() {
+    if (central != BLE_HS_CONN_HANDLE_NONE) {
+        SimBLE::disconnect(central);
+        central = BLE_HS_CONN_HANDLE_NONE;
+    }
+}
+
+static void requestHistory() {
+    if (central != BLE_HS_CONN_HANDLE_NONE) {
+        const uint8_t fromStart[4] = {0, 0, 0, 0};
+        SimBLE::write(central, TEMP_HISTORY_CHAR_UUID, fromStart, sizeof(fromStart));
     }
+}
+
+static void dropAccessPoint() {
+    Simulator::getRadio().setAccessPoint(false);
+}
+
+static void restoreAccessPoint() {
+    Simulator::getRadio().setAccessPoint(true);
+}
+
+int main(int argc, char** argv) {
+    double days = 1.0;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            days = std::atof(argv[i]);
+        }
+    }
+    if (days <= 0) {
+        std::fprintf(stderr, "usage: %s [days] [--verbose]\n", argv[0]);
+        return 1;
+    }
+
+    // Firmware output for a simulated day runs to tens of thousands of lines
+    Serial.setEnabled(verbose);
+    Simulator::begin();
+
+    const uint64_t HOUR = Simulator::HOUR;
+    const uint64_t DAY = Simulator::DAY;
+    Simulator::addEvent("central-connect", 5000, 6 * HOUR, connectCentral);
+    Simulator::addEvent("central-disconnect", 6 * HOUR - Simulator::MINUTE, 6 * HOUR, disconnectCentral);
+    Simulator::addEvent("history-dump", 5 * HOUR, DAY, requestHistory);
+    Simulator::addEvent("ap-down", 12 * HOUR, DAY, dropAccessPoint);
+    Simulator::addEvent("ap-up", 12 * HOUR + 10 * Simulator::MINUTE, DAY, restoreAccessPoint);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Simulator::runFor((uint64_t)(days * DAY));
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+    Serial.setEnabled(true);
+    Simulator::printReport(wall.count());
     return 0;
 }
 #endif
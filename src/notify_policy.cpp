@@ -0,0 +1,117 @@
+#include "notify_policy.h"
+
+NotifyPolicy::NotifyPolicy() {
+    config.absoluteDeadband = DEFAULT_ABSOLUTE_DEADBAND;
+    config.relativeDeadband = DEFAULT_RELATIVE_DEADBAND;
+    config.minInterval = DEFAULT_MIN_INTERVAL;
+    config.maxInterval = DEFAULT_MAX_INTERVAL;
+    reset();
+}
+
+bool NotifyPolicy::configure(const NotifyPolicyConfig& newConfig) {
+    if (newConfig.maxInterval == 0 || newConfig.minInterval > newConfig.maxInterval ||
+        newConfig.relativeDeadband > 1000) {
+        return false;
+    }
+    config = newConfig;
+    return true;
+}
+
+const NotifyPolicyConfig& NotifyPolicy::getConfig() const {
+    return config;
+}
+
+void NotifyPolicy::reset() {
+    notifiedOnce = false;
+    forced = false;
+    hasLatest = false;
+    lastValue = 0;
+    latestValue = 0;
+    lastNotifyTime = 0;
+}
+
+void NotifyPolicy::forceNext() {
+    forced = true;
+}
+
+bool NotifyPolicy::isSignificant(int16_t value) const {
+    if (forced || !notifiedOnce) {
+        return true;
+    }
+    int32_t change = (int32_t)value - lastValue;
+    if (change < 0) {
+        change = -change;
+    }
+    int32_t magnitude = lastValue < 0 ? -(int32_t)lastValue : lastValue;
+    int32_t threshold = magnitude * config.relativeDeadband / 1000;
+    if (threshold < config.absoluteDeadband) {
+        threshold = config.absoluteDeadband;
+    }
+    return change >= threshold && change > 0;
+}
+
+bool NotifyPolicy::evaluate(int16_t value, uint32_t now) {
+    latestValue = value;
+    hasLatest = true;
+    if (!notifiedOnce) {
+        return true;
+    }
+    uint32_t elapsed = now - lastNotifyTime;
+    if (isSignificant(value)) {
+        return elapsed >= config.minInterval;
+    }
+    return elapsed >= config.maxInterval;
+}
+
+void NotifyPolicy::markNotified(int16_t value, uint32_t now) {
+    notifiedOnce = true;
+    forced = false;
+    lastValue = value;
+    lastNotifyTime = now;
+}
+
+uint32_t NotifyPolicy::timeUntilDue(uint32_t now) const {
+    if (!notifiedOnce) {
+        return hasLatest ? 0 : config.maxInterval;
+    }
+    uint32_t elapsed = now - lastNotifyTime;
+    // A rate-limited change goes out when minInterval expires
+    uint32_t interval = (hasLatest && isSignificant(latestValue)) ? config.minInterval : config.maxInterval;
+    return elapsed >= interval ? 0 : interval - elapsed;
+}
+
+static void writeU16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t readU16(const uint8_t* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+size_t NotifyPolicy::encodeConfig(const NotifyPolicyConfig& config, uint8_t* buffer, size_t capacity) {
+    if (capacity < NOTIFY_POLICY_CONFIG_SIZE) {
+        return 0;
+    }
+    uint32_t minInterval = config.minInterval > 0xFFFF ? 0xFFFF : config.minInterval;
+    uint32_t maxSeconds = config.maxInterval / 1000;
+    if (maxSeconds > 0xFFFF) {
+        maxSeconds = 0xFFFF;
+    }
+    writeU16(buffer, config.absoluteDeadband);
+    writeU16(buffer + 2, config.relativeDeadband);
+    writeU16(buffer + 4, (uint16_t)minInterval);
+    writeU16(buffer + 6, (uint16_t)maxSeconds);
+    return NOTIFY_POLICY_CONFIG_SIZE;
+}
+
+bool NotifyPolicy::decodeConfig(const uint8_t* data, size_t length, NotifyPolicyConfig& config) {
+    if (length < NOTIFY_POLICY_CONFIG_SIZE) {
+        return false;
+    }
+    config.absoluteDeadband = readU16(data);
+    config.relativeDeadband = readU16(data + 2);
+    config.minInterval = readU16(data + 4);
+    config.maxInterval = (uint32_t)readU16(data + 6) * 1000;
+    return true;
+}
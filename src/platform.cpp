@@ -0,0 +1,85 @@
+#include "platform.h"
+
+#ifndef ARDUINO
+#include <cstdio>
+
+// Static member definitions for native/unit-test builds
+uint32_t NativeClock::nowMs = 0;
+
+NativeSerial Serial;
+
+String::String(double value, unsigned char decimalPlaces) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.*f", (int)decimalPlaces, value);
+    assign(buffer);
+}
+
+void NativeSerial::print(const char* text) {
+    if (!enabled) {
+        return;
+    }
+    std::fputs(text, stdout);
+}
+
+void NativeSerial::print(const String& text) {
+    print(text.c_str());
+}
+
+void NativeSerial::print(char c) {
+    if (!enabled) {
+        return;
+    }
+    std::fputc(c, stdout);
+}
+
+void NativeSerial::print(int number) {
+    if (!enabled) {
+        return;
+    }
+    std::printf("%d", number);
+}
+
+void NativeSerial::print(unsigned int number) {
+    if (!enabled) {
+        return;
+    }
+    std::printf("%u", number);
+}
+
+void NativeSerial::print(long number) {
+    if (!enabled) {
+        return;
+    }
+    std::printf("%ld", number);
+}
+
+void NativeSerial::print(unsigned long number) {
+    if (!enabled) {
+        return;
+    }
+    std::printf("%lu", number);
+}
+
+void NativeSerial::print(double number) {
+    if (!enabled) {
+        return;
+    }
+    // Arduino prints floating point values with two decimals by default
+    std::printf("%.2f", number);
+}
+
+void NativeSerial::println() {
+    if (!enabled) {
+        return;
+    }
+    std::fputc('\n', stdout);
+}
+
+size_t NativeSerial::write(const char* buffer, size_t size) {
+    if (!enabled) {
+        return size;
+    }
+    return std::fwrite(buffer, 1, size, stdout);
+}
+
+#endif
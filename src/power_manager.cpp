@@ -0,0 +1,152 @@
+#include "power_manager.h"
+#include "platform.h"
+#include "logger.h"
+#include "timing_stats.h"
+
+#ifdef ARDUINO
+#include <esp_pm.h>
+
+// Lanes on both cores report in; a spinlock keeps the bookkeeping consistent
+static portMUX_TYPE powerLock = portMUX_INITIALIZER_UNLOCKED;
+#define POWER_LOCK() portENTER_CRITICAL(&powerLock)
+#define POWER_UNLOCK() portEXIT_CRITICAL(&powerLock)
+#else
+// Native builds run every lane on the one simulator thread
+#define POWER_LOCK()
+#define POWER_UNLOCK()
+#endif
+
+// Static member definitions
+uint32_t PowerManager::idleLanes = 0;
+uint32_t PowerManager::wakeAt[Scheduler::MAX_LANES];
+PowerState PowerManager::state = POWER_ACTIVE;
+uint32_t PowerManager::stateSince = 0;
+uint64_t PowerManager::residency[POWER_STATE_COUNT];
+uint32_t PowerManager::wakeups = 0;
+#ifdef ARDUINO
+bool PowerManager::lightSleepEnabled = false;
+#else
+bool PowerManager::lightSleepEnabled = true;
+#endif
+
+void PowerManager::begin() {
+#ifdef ARDUINO
+#if CONFIG_PM_ENABLE
+    esp_pm_config_esp32s3_t config = {};
+    config.max_freq_mhz = CONFIG_ESP32S3_DEFAULT_CPU_FREQ_MHZ;
+    config.min_freq_mhz = POWER_MIN_CPU_MHZ;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    config.light_sleep_enable = true;
+#endif
+    esp_err_t err = esp_pm_configure(&config);
+    lightSleepEnabled = err == ESP_OK && config.light_sleep_enable;
+    if (err != ESP_OK) {
+        LOG_WARN("Power management not configured (error %d)", (int)err);
+    }
+#else
+    // No frequency scaling in this SDK build: run at the low clock throughout
+    setCpuFrequencyMhz(POWER_MIN_CPU_MHZ);
+    lightSleepEnabled = false;
+#endif
+    // Cycle-counter timings must follow the new clock
+    TimingStats::setCpuFrequency(getCpuFrequencyMhz());
+    LOG_INFO("Power management: CPU %lu MHz, light sleep %s", (unsigned long)getCpuFrequencyMhz(),
+             lightSleepEnabled ? "on" : "off");
+#endif
+    reset();
+}
+
+void PowerManager::reset() {
+    POWER_LOCK();
+    idleLanes = 0;
+    state = POWER_ACTIVE;
+    stateSince = (uint32_t)micros();
+    for (int i = 0; i < POWER_STATE_COUNT; i++) {
+        residency[i] = 0;
+    }
+    wakeups = 0;
+    POWER_UNLOCK();
+}
+
+// Caller holds the lock
+void PowerManager::switchTo(PowerState newState, uint32_t nowMicros) {
+    residency[state] += (uint32_t)(nowMicros - stateSince);
+    stateSince = nowMicros;
+    if (newState == POWER_ACTIVE && state != POWER_ACTIVE) {
+        wakeups++;
+    }
+    state = newState;
+}
+
+void PowerManager::enterIdle(uint32_t laneMask, uint32_t waitMs) {
+    uint32_t now = (uint32_t)millis();
+    if (waitMs > INT32_MAX) {
+        waitMs = INT32_MAX;     // keeps the wrap-safe comparison below valid
+    }
+    POWER_LOCK();
+    for (int lane = 0; lane < Scheduler::MAX_LANES; lane++) {
+        if (laneMask & (1u << lane)) {
+            wakeAt[lane] = now + waitMs;
+        }
+    }
+    idleLanes |= laneMask & ALL_LANES;
+    if (idleLanes == ALL_LANES) {
+        // Everything waits: the earliest deadline of any lane decides
+        uint32_t untilNext = UINT32_MAX;
+        for (int lane = 0; lane < Scheduler::MAX_LANES; lane++) {
+            uint32_t remaining = wakeAt[lane] - now;
+            if ((int32_t)remaining < 0) {
+                remaining = 0;
+            }
+            if (remaining < untilNext) {
+                untilNext = remaining;
+            }
+        }
+        bool sleep = lightSleepEnabled && untilNext >= POWER_LIGHT_SLEEP_MIN_MS;
+        switchTo(sleep ? POWER_LIGHT_SLEEP : POWER_IDLE, (uint32_t)micros());
+    }
+    POWER_UNLOCK();
+}
+
+void PowerManager::exitIdle(uint32_t laneMask) {
+    POWER_LOCK();
+    idleLanes &= ~laneMask;
+    if (state != POWER_ACTIVE) {
+        switchTo(POWER_ACTIVE, (uint32_t)micros());
+    }
+    POWER_UNLOCK();
+}
+
+PowerState PowerManager::getState() {
+    return state;
+}
+
+const char* PowerManager::getStateName(PowerState powerState) {
+    switch (powerState) {
+        case POWER_ACTIVE:      return "active";
+        case POWER_IDLE:        return "idle";
+        case POWER_LIGHT_SLEEP: return "light sleep";
+        default:                return "unknown";
+    }
+}
+
+uint64_t PowerManager::getResidency(PowerState powerState) {
+    if (powerState < 0 || powerState >= POWER_STATE_COUNT) {
+        return 0;
+    }
+    POWER_LOCK();
+    uint64_t total = residency[powerState];
+    if (powerState == state) {
+        total += (uint32_t)((uint32_t)micros() - stateSince);
+    }
+    POWER_UNLOCK();
+    return total;
+}
+
+uint32_t PowerManager::getWakeups() {
+    return wakeups;
+}
+
+bool PowerManager::isLightSleepEnabled() {
+    return lightSleepEnabled;
+}
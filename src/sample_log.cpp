@@ -0,0 +1,404 @@
+#include "sample_log.h"
+#include <string.h>
+
+#ifdef ARDUINO
+#include <esp_rom_crc.h>
+#endif
+
+namespace {
+
+const uint32_t SECTOR_MAGIC = 0x474F4C53;   // "SLOG"
+const uint16_t RECORD_MAGIC = 0x5253;       // "SR"
+
+struct SectorHeader {
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t firstSequence;
+    uint32_t crc;             // over the fields above
+};
+
+struct RecordHeader {
+    uint16_t magic;
+    uint8_t count;
+    uint8_t reserved;
+    uint32_t firstSequence;
+    int16_t max;
+    int16_t min;
+    uint32_t crc;             // over the fields above and the samples
+};
+
+struct RecordSample {
+    uint32_t timestamp;
+    int16_t value;
+    uint16_t reserved;
+};
+
+const uint32_t SECTOR_HEADER_SIZE = sizeof(SectorHeader);
+const uint32_t RECORD_HEADER_SIZE = sizeof(RecordHeader);
+const uint32_t RECORD_CRC_OFFSET = RECORD_HEADER_SIZE - sizeof(uint32_t);
+const uint32_t MAX_RECORD_SIZE = RECORD_HEADER_SIZE + SampleLog::BATCH_SIZE * sizeof(RecordSample);
+
+static_assert(sizeof(SectorHeader) == 16, "sector header layout is stored in flash");
+static_assert(sizeof(RecordHeader) == 16, "record header layout is stored in flash");
+static_assert(sizeof(RecordSample) == 8, "record sample layout is stored in flash");
+
+uint32_t recordCrc(const RecordHeader& header, const uint8_t* samples) {
+    uint32_t crc = SampleLog::crc32(&header, RECORD_CRC_OFFSET);
+    return SampleLog::crc32(samples, header.count * sizeof(RecordSample), crc);
+}
+
+bool isErased(const uint8_t* data, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        if (data[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+uint8_t SampleLog::buffer[SampleLog::MAX_SECTOR_SIZE];
+
+SampleLog::SampleLog() : storage(nullptr), sectorSize(0), sectorCount(0) {
+    end();
+}
+
+bool SampleLog::begin(FlashStorage* newStorage) {
+    end();
+    if (newStorage == nullptr) {
+        return false;
+    }
+    uint32_t size = newStorage->sectorSize();
+    if (size > MAX_SECTOR_SIZE || size < SECTOR_HEADER_SIZE + MAX_RECORD_SIZE) {
+        return false;
+    }
+    uint32_t count = newStorage->size() / size;
+    if (count > MAX_SECTORS) {
+        count = MAX_SECTORS;
+    }
+    if (count < 2) {
+        return false;
+    }
+    storage = newStorage;
+    sectorSize = size;
+    sectorCount = count;
+
+    // One pass over the whole area, a sector at a time
+    for (uint32_t i = 0; i < sectorCount; i++) {
+        scanSector(i);
+    }
+    if (head >= 0) {
+        nextSequence = sectors[head].firstSequence + sectors[head].samples;
+        loadLast();
+    }
+    return true;
+}
+
+void SampleLog::end() {
+    storage = nullptr;
+    sectorCount = 0;
+    head = -1;
+    headClosed = false;
+    nextSequence = 0;
+    tornRecords = 0;
+    hasLast = false;
+    pendingCount = 0;
+    recordsWritten = 0;
+    writeErrors = 0;
+}
+
+bool SampleLog::isReady() const {
+    return storage != nullptr;
+}
+
+// Indexes one sector; becomes the head if it is the newest seen so far
+bool SampleLog::scanSector(uint32_t index) {
+    SectorInfo& info = sectors[index];
+    info.generation = 0;
+    info.firstSequence = 0;
+    info.samples = 0;
+    info.used = 0;
+    if (!storage->read(index * sectorSize, buffer, sectorSize)) {
+        return false;
+    }
+
+    SectorHeader header;
+    memcpy(&header, buffer, sizeof(header));
+    if (header.magic != SECTOR_MAGIC || header.generation == 0 ||
+        header.crc != crc32(&header, sizeof(header) - sizeof(uint32_t))) {
+        return false;     // erased, torn while being opened, or never used
+    }
+    info.generation = header.generation;
+    info.firstSequence = header.firstSequence;
+
+    uint32_t offset = SECTOR_HEADER_SIZE;
+    bool torn = false;
+    RecordHeader record;
+    while (offset + RECORD_HEADER_SIZE <= sectorSize) {
+        const uint8_t* at = buffer + offset;
+        if (isErased(at, RECORD_HEADER_SIZE)) {
+            break;
+        }
+        memcpy(&record, at, sizeof(record));
+        uint32_t length = RECORD_HEADER_SIZE + record.count * sizeof(RecordSample);
+        if (record.magic != RECORD_MAGIC || record.count == 0 || record.count > BATCH_SIZE ||
+            offset + length > sectorSize || record.firstSequence != info.firstSequence + info.samples ||
+            record.crc != recordCrc(record, at + RECORD_HEADER_SIZE)) {
+            // Torn by a power cut; nothing valid follows it in this sector
+            tornRecords++;
+            torn = true;
+            break;
+        }
+        info.samples += record.count;
+        offset += length;
+    }
+    info.used = (uint16_t)offset;
+
+    if (head < 0 || info.generation > sectors[head].generation) {
+        head = (int)index;
+        headClosed = torn;
+    }
+    return true;
+}
+
+// The newest sample may sit in an earlier sector if the head was just opened
+void SampleLog::loadLast() {
+    uint32_t index = (uint32_t)head;
+    for (uint32_t walked = 0; walked < sectorCount && sectors[index].samples == 0; walked++) {
+        uint32_t previous = (index + sectorCount - 1) % sectorCount;
+        if (sectors[index].generation <= 1 || sectors[previous].generation != sectors[index].generation - 1) {
+            return;
+        }
+        index = previous;
+    }
+    const SectorInfo& info = sectors[index];
+    if (info.samples == 0 || !storage->read(index * sectorSize, buffer, info.used)) {
+        return;
+    }
+    uint32_t offset = SECTOR_HEADER_SIZE;
+    RecordHeader record;
+    for (;;) {
+        memcpy(&record, buffer + offset, sizeof(record));
+        uint32_t length = RECORD_HEADER_SIZE + record.count * sizeof(RecordSample);
+        if (offset + length >= info.used) {
+            break;
+        }
+        offset += length;
+    }
+    RecordSample sample;
+    memcpy(&sample, buffer + offset + RECORD_HEADER_SIZE + (record.count - 1) * sizeof(sample), sizeof(sample));
+    last.timestamp = sample.timestamp;
+    last.centiCelsius = sample.value;
+    last.max = record.max;
+    last.min = record.min;
+    hasLast = true;
+}
+
+bool SampleLog::openSector(uint32_t index) {
+    SectorInfo& info = sectors[index];
+    uint32_t generation = head >= 0 ? sectors[head].generation + 1 : 1;
+    info.generation = 0;
+    info.samples = 0;
+    info.used = 0;
+    if (!storage->erase(index * sectorSize)) {
+        writeErrors++;
+        return false;
+    }
+    SectorHeader header;
+    header.magic = SECTOR_MAGIC;
+    header.generation = generation;
+    header.firstSequence = nextSequence;
+    header.crc = crc32(&header, sizeof(header) - sizeof(uint32_t));
+    if (!storage->write(index * sectorSize, &header, sizeof(header))) {
+        writeErrors++;
+        return false;
+    }
+    info.generation = generation;
+    info.firstSequence = nextSequence;
+    info.used = SECTOR_HEADER_SIZE;
+    head = (int)index;
+    headClosed = false;
+    return true;
+}
+
+bool SampleLog::writeRecord() {
+    uint8_t record[MAX_RECORD_SIZE];
+    RecordHeader header;
+    header.magic = RECORD_MAGIC;
+    header.count = (uint8_t)pendingCount;
+    header.reserved = 0xFF;
+    header.firstSequence = nextSequence;
+    header.max = pending[pendingCount - 1].max;
+    header.min = pending[pendingCount - 1].min;
+    for (uint32_t i = 0; i < pendingCount; i++) {
+        RecordSample sample;
+        sample.timestamp = pending[i].timestamp;
+        sample.value = pending[i].centiCelsius;
+        sample.reserved = 0xFFFF;
+        memcpy(record + RECORD_HEADER_SIZE + i * sizeof(sample), &sample, sizeof(sample));
+    }
+    header.crc = recordCrc(header, record + RECORD_HEADER_SIZE);
+    memcpy(record, &header, sizeof(header));
+    uint32_t length = RECORD_HEADER_SIZE + pendingCount * sizeof(RecordSample);
+
+    if (head < 0 || headClosed || sectors[head].used + length > sectorSize) {
+        // Wear levelling: always the next sector in the ring, oldest data first
+        uint32_t next = head < 0 ? 0 : ((uint32_t)head + 1) % sectorCount;
+        if (!openSector(next)) {
+            return false;
+        }
+    }
+    SectorInfo& info = sectors[head];
+    if (!storage->write(head * sectorSize + info.used, record, length)) {
+        // Possibly half written: never append after it
+        writeErrors++;
+        headClosed = true;
+        return false;
+    }
+    info.used = (uint16_t)(info.used + length);
+    info.samples = (uint16_t)(info.samples + pendingCount);
+    nextSequence += pendingCount;
+    last = pending[pendingCount - 1];
+    hasLast = true;
+    pendingCount = 0;
+    recordsWritten++;
+    return true;
+}
+
+bool SampleLog::append(const LoggedSample& sample) {
+    if (storage == nullptr) {
+        return false;
+    }
+    if (pendingCount == BATCH_SIZE && !writeRecord()) {
+        return false;     // the batch is kept for the next attempt
+    }
+    pending[pendingCount++] = sample;
+    if (pendingCount == BATCH_SIZE) {
+        writeRecord();
+    }
+    return true;
+}
+
+bool SampleLog::flush() {
+    if (storage == nullptr) {
+        return false;
+    }
+    return pendingCount == 0 || writeRecord();
+}
+
+uint32_t SampleLog::getPendingCount() const {
+    return pendingCount;
+}
+
+// Walks back from the head through consecutive generations until `wanted`
+// samples are covered; `skip` is how many of the first sector's to pass over
+int SampleLog::oldestSector(uint32_t wanted, uint32_t& skip) const {
+    skip = 0;
+    if (head < 0) {
+        return -1;
+    }
+    uint32_t index = (uint32_t)head;
+    uint32_t total = sectors[index].samples;
+    for (uint32_t walked = 1; walked < sectorCount && total < wanted; walked++) {
+        uint32_t previous = (index + sectorCount - 1) % sectorCount;
+        if (sectors[index].generation <= 1 || sectors[previous].generation != sectors[index].generation - 1) {
+            break;
+        }
+        index = previous;
+        total += sectors[index].samples;
+    }
+    skip = total > wanted ? total - wanted : 0;
+    return (int)index;
+}
+
+void SampleLog::getSummary(SampleLogSummary& summary) const {
+    summary.samples = 0;
+    summary.sectorsUsed = 0;
+    summary.tornRecords = tornRecords;
+    summary.last = last;
+    if (head < 0) {
+        return;
+    }
+    uint32_t skip;
+    uint32_t index = (uint32_t)oldestSector(UINT32_MAX, skip);
+    for (;;) {
+        summary.samples += sectors[index].samples;
+        summary.sectorsUsed++;
+        if (index == (uint32_t)head) {
+            break;
+        }
+        index = (index + 1) % sectorCount;
+    }
+}
+
+uint32_t SampleLog::replay(uint32_t maxSamples, SampleLogVisitor visitor) {
+    uint32_t skip;
+    int first = oldestSector(maxSamples, skip);
+    if (first < 0 || maxSamples == 0) {
+        return 0;
+    }
+    uint32_t replayed = 0;
+    uint32_t index = (uint32_t)first;
+    for (;;) {
+        const SectorInfo& info = sectors[index];
+        if (storage->read(index * sectorSize, buffer, info.used)) {
+            // Already validated by the scan; the flash has not changed since
+            uint32_t offset = SECTOR_HEADER_SIZE;
+            RecordHeader record;
+            while (offset < info.used) {
+                memcpy(&record, buffer + offset, sizeof(record));
+                for (uint32_t i = 0; i < record.count; i++) {
+                    if (skip > 0) {
+                        skip--;
+                        continue;
+                    }
+                    RecordSample stored;
+                    memcpy(&stored, buffer + offset + RECORD_HEADER_SIZE + i * sizeof(stored), sizeof(stored));
+                    LoggedSample sample;
+                    sample.timestamp = stored.timestamp;
+                    sample.centiCelsius = stored.value;
+                    sample.max = record.max;
+                    sample.min = record.min;
+                    visitor(sample);
+                    replayed++;
+                }
+                offset += RECORD_HEADER_SIZE + record.count * sizeof(RecordSample);
+            }
+        }
+        if (index == (uint32_t)head) {
+            break;
+        }
+        index = (index + 1) % sectorCount;
+    }
+    return replayed;
+}
+
+uint32_t SampleLog::getRecordsWritten() const {
+    return recordsWritten;
+}
+
+uint32_t SampleLog::getWriteErrors() const {
+    return writeErrors;
+}
+
+// CRC-32 (IEEE 802.3, reflected). The chip uses the ROM's byte-wide table
+// routine, which keeps the boot scan inside its budget at 80 MHz; native
+// builds go a nibble at a time from a 16-entry table.
+uint32_t SampleLog::crc32(const void* data, size_t length, uint32_t crc) {
+#ifdef ARDUINO
+    return esp_rom_crc32_le(crc, (const uint8_t*)data, (uint32_t)length);
+#else
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    const uint8_t* bytes = (const uint8_t*)data;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ bytes[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (bytes[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+#endif
+}
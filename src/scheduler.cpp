@@ -0,0 +1,331 @@
+#include "scheduler.h"
+#include "platform.h"
+#include "power_manager.h"
+
+// Static member definitions
+Scheduler::Lane Scheduler::lanes[Scheduler::MAX_LANES];
+
+// Each scheduler task selects its lane once; tests and the simulator switch
+// lanes on the one host thread
+static thread_local int currentLane = 0;
+
+// millis() wraps every ~49 days; compare deadlines by signed distance
+static inline bool timeReached(uint32_t now, uint32_t deadline) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+void Scheduler::reset() {
+    for (int lane = 0; lane < MAX_LANES; lane++) {
+        Lane& l = lanes[lane];
+        for (int i = 0; i < MAX_TASKS; i++) {
+            l.tasks[i].callback = nullptr;
+            l.tasks[i].name = nullptr;
+            l.tasks[i].heapIndex = -1;
+            l.tasks[i].runCount = 0;
+            l.tasks[i].maxLateness = 0;
+        }
+        l.heapSize = 0;
+        l.nextOrder = 0;
+        l.pendingMask = 0;
+        l.owner = nullptr;
+    }
+    currentLane = 0;
+}
+
+void Scheduler::setLane(int lane) {
+    if (lane >= 0 && lane < MAX_LANES) {
+        currentLane = lane;
+    }
+}
+
+int Scheduler::getLane() {
+    return currentLane;
+}
+
+Scheduler::Lane& Scheduler::current() {
+    return lanes[currentLane];
+}
+
+// Job ids encode the lane: id = lane * MAX_TASKS + slot
+Scheduler::Task* Scheduler::find(int id) {
+    if (id < 0 || id >= MAX_JOBS) {
+        return nullptr;
+    }
+    return &lanes[id / MAX_TASKS].tasks[id % MAX_TASKS];
+}
+
+bool Scheduler::Lane::runsBefore(int a, int b) const {
+    int32_t diff = (int32_t)(tasks[a].deadline - tasks[b].deadline);
+    if (diff != 0) {
+        return diff < 0;
+    }
+    return (int32_t)(tasks[a].order - tasks[b].order) < 0;
+}
+
+void Scheduler::Lane::place(int pos, int slot) {
+    heap[pos] = slot;
+    tasks[slot].heapIndex = pos;
+}
+
+void Scheduler::Lane::siftUp(int pos) {
+    int slot = heap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!runsBefore(slot, heap[parent])) {
+            break;
+        }
+        place(pos, heap[parent]);
+        pos = parent;
+    }
+    place(pos, slot);
+}
+
+void Scheduler::Lane::siftDown(int pos) {
+    int slot = heap[pos];
+    while (true) {
+        int child = 2 * pos + 1;
+        if (child >= heapSize) {
+            break;
+        }
+        if (child + 1 < heapSize && runsBefore(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!runsBefore(heap[child], slot)) {
+            break;
+        }
+        place(pos, heap[child]);
+        pos = child;
+    }
+    place(pos, slot);
+}
+
+void Scheduler::Lane::removeAt(int pos) {
+    int slot = heap[pos];
+    tasks[slot].heapIndex = -1;
+    heapSize--;
+    if (pos == heapSize) {
+        return;
+    }
+    int moved = heap[heapSize];
+    place(pos, moved);
+    siftUp(pos);
+    siftDown(tasks[moved].heapIndex);
+}
+
+void Scheduler::Lane::applyPendingTriggers(uint32_t now) {
+    uint32_t pending = __atomic_exchange_n(&pendingMask, 0, __ATOMIC_ACQUIRE);
+    for (int slot = 0; pending != 0; slot++, pending >>= 1) {
+        Task& task = tasks[slot];
+        if ((pending & 1u) && task.callback != nullptr && task.heapIndex >= 0 &&
+            !timeReached(now, task.deadline)) {
+            task.deadline = now;
+            siftUp(task.heapIndex);
+        }
+    }
+}
+
+int Scheduler::addPeriodic(const char* name, TaskCallback callback, uint32_t period,
+                           uint32_t firstDelay, uint32_t now) {
+    Lane& lane = current();
+    if (!callback || lane.heapSize >= MAX_TASKS) {
+        return INVALID_TASK;
+    }
+
+    int slot = 0;
+    while (lane.tasks[slot].callback != nullptr) {
+        slot++;
+    }
+
+    Task& task = lane.tasks[slot];
+    task.callback = callback;
+    task.name = name;
+    task.period = period;
+    task.deadline = now + firstDelay;
+    task.order = lane.nextOrder++;
+    task.runCount = 0;
+    task.maxLateness = 0;
+
+    lane.place(lane.heapSize, slot);
+    lane.heapSize++;
+    lane.siftUp(lane.heapSize - 1);
+    return currentLane * MAX_TASKS + slot;
+}
+
+int Scheduler::addPeriodic(const char* name, TaskCallback callback, uint32_t period,
+                           uint32_t firstDelay) {
+    return addPeriodic(name, callback, period, firstDelay, (uint32_t)millis());
+}
+
+int Scheduler::addOneShot(const char* name, TaskCallback callback, uint32_t delayMs,
+                          uint32_t now) {
+    return addPeriodic(name, callback, 0, delayMs, now);
+}
+
+int Scheduler::addOneShot(const char* name, TaskCallback callback, uint32_t delayMs) {
+    return addOneShot(name, callback, delayMs, (uint32_t)millis());
+}
+
+bool Scheduler::cancel(int id) {
+    if (!isScheduled(id)) {
+        return false;
+    }
+    Lane& lane = lanes[id / MAX_TASKS];
+    int slot = id % MAX_TASKS;
+    __atomic_fetch_and(&lane.pendingMask, ~(1u << slot), __ATOMIC_RELAXED);
+    lane.removeAt(lane.tasks[slot].heapIndex);
+    lane.tasks[slot].callback = nullptr;
+    return true;
+}
+
+bool Scheduler::setPeriod(int id, uint32_t period) {
+    if (!isScheduled(id) || period == 0) {
+        return false;
+    }
+    Lane& lane = lanes[id / MAX_TASKS];
+    Task& task = lane.tasks[id % MAX_TASKS];
+    // Keep the phase of the last run but honour the new period right away
+    uint32_t lastRun = task.deadline - task.period;
+    task.period = period;
+    task.deadline = lastRun + period;
+    lane.siftUp(task.heapIndex);
+    lane.siftDown(task.heapIndex);
+    return true;
+}
+
+bool Scheduler::isScheduled(int id) {
+    Task* task = find(id);
+    return task != nullptr && task->callback != nullptr && task->heapIndex >= 0;
+}
+
+void Scheduler::trigger(int id) {
+    if (id < 0 || id >= MAX_JOBS) {
+        return;
+    }
+    int lane = id / MAX_TASKS;
+    __atomic_fetch_or(&lanes[lane].pendingMask, 1u << (id % MAX_TASKS), __ATOMIC_RELEASE);
+    wake(lane);
+}
+
+void Scheduler::wake() {
+    wake(currentLane);
+}
+
+int Scheduler::runDue(uint32_t now) {
+    Lane& lane = current();
+    lane.applyPendingTriggers(now);
+
+    int ran = 0;
+    while (lane.heapSize > 0 && timeReached(now, lane.tasks[lane.heap[0]].deadline)) {
+        Task& task = lane.tasks[lane.heap[0]];
+        TaskCallback callback = task.callback;
+
+        uint32_t lateness = now - task.deadline;
+        if (lateness > task.maxLateness) {
+            task.maxLateness = lateness;
+        }
+        task.runCount++;
+
+        if (task.period == 0) {
+            lane.removeAt(0);
+            task.callback = nullptr;
+        } else {
+            // Stay on the period grid; skip missed slots instead of bursting
+            task.deadline += task.period;
+            if (timeReached(now, task.deadline)) {
+                uint32_t missed = (now - task.deadline) / task.period + 1;
+                task.deadline += missed * task.period;
+            }
+            lane.siftDown(0);
+        }
+
+        callback();
+        ran++;
+    }
+    return ran;
+}
+
+int Scheduler::runDue() {
+    return runDue((uint32_t)millis());
+}
+
+uint32_t Scheduler::timeUntilNext(uint32_t now) {
+    Lane& lane = current();
+    if (__atomic_load_n(&lane.pendingMask, __ATOMIC_RELAXED) != 0) {
+        return 0;
+    }
+    if (lane.heapSize == 0) {
+        return UINT32_MAX;
+    }
+    uint32_t deadline = lane.tasks[lane.heap[0]].deadline;
+    return timeReached(now, deadline) ? 0 : deadline - now;
+}
+
+int Scheduler::taskCount() {
+    return current().heapSize;
+}
+
+const char* Scheduler::getName(int id) {
+    return isScheduled(id) ? find(id)->name : nullptr;
+}
+
+uint32_t Scheduler::getRunCount(int id) {
+    Task* task = find(id);
+    return task != nullptr ? task->runCount : 0;
+}
+
+uint32_t Scheduler::getMaxLateness(int id) {
+    Task* task = find(id);
+    return task != nullptr ? task->maxLateness : 0;
+}
+
+#ifdef ARDUINO
+
+void Scheduler::sleepUntilNext(uint32_t maxSleep) {
+    Lane& lane = current();
+    if (lane.owner == nullptr) {
+        __atomic_store_n(&lane.owner, (void*)xTaskGetCurrentTaskHandle(), __ATOMIC_RELEASE);
+    }
+    uint32_t wait = timeUntilNext((uint32_t)millis());
+    if (wait > maxSleep) {
+        wait = maxSleep;
+    }
+    if (wait > 0) {
+        // Blocks until the deadline or until wake() is called from another task
+        PowerManager::enterIdle(1u << currentLane, wait);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+        PowerManager::exitIdle(1u << currentLane);
+    }
+}
+
+void Scheduler::wake(int lane) {
+    if (lane < 0 || lane >= MAX_LANES) {
+        return;
+    }
+    void* owner = __atomic_load_n(&lanes[lane].owner, __ATOMIC_ACQUIRE);
+    if (owner != nullptr) {
+        xTaskNotifyGive((TaskHandle_t)owner);
+    }
+}
+
+#else
+
+void Scheduler::sleepUntilNext(uint32_t maxSleep) {
+    uint32_t now = (uint32_t)millis();
+    int selected = currentLane;
+    uint32_t wait = maxSleep;
+    for (int lane = 0; lane < MAX_LANES; lane++) {
+        currentLane = lane;
+        uint32_t laneWait = timeUntilNext(now);
+        if (laneWait < wait) {
+            wait = laneWait;
+        }
+    }
+    currentLane = selected;
+    PowerManager::enterIdle(PowerManager::ALL_LANES, wait);
+    delay(wait);
+    PowerManager::exitIdle(PowerManager::ALL_LANES);
+}
+
+void Scheduler::wake(int) {}
+
+#endif
@@ -0,0 +1,153 @@
+#include "telemetry_transport.h"
+
+#ifdef ARDUINO
+#include <HTTPClient.h>
+#include <string.h>
+
+HttpTelemetryTransport::HttpTelemetryTransport(const char* url)
+    : url(url), task(nullptr), bodyLength(0), busy(false), abandoned(false),
+      result(TELEMETRY_PUBLISH_FAILED) {}
+
+// Runs the blocking HTTP request, one per notification
+void HttpTelemetryTransport::worker(void* parameter) {
+    HttpTelemetryTransport* self = (HttpTelemetryTransport*)parameter;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        HTTPClient http;
+        http.setConnectTimeout(TIMEOUT_MS);
+        http.setTimeout(TIMEOUT_MS);
+        int code = -1;
+        if (http.begin(self->url)) {
+            http.addHeader("Content-Type", "application/json");
+            code = http.POST((uint8_t*)self->body, self->bodyLength);
+            http.end();
+        }
+        self->result = code >= 200 && code < 300 ? TELEMETRY_PUBLISH_ACKED : TELEMETRY_PUBLISH_FAILED;
+        __atomic_store_n(&self->busy, false, __ATOMIC_RELEASE);
+    }
+}
+
+bool HttpTelemetryTransport::publish(const char* payload, size_t length) {
+    if (__atomic_load_n(&busy, __ATOMIC_ACQUIRE) || length > MAX_PAYLOAD) {
+        return false;
+    }
+    if (task == nullptr &&
+        xTaskCreatePinnedToCore(worker, "uplink-http", 6144, this, 1, &task, 1) != pdPASS) {
+        task = nullptr;
+        return false;
+    }
+    memcpy(body, payload, length);
+    bodyLength = length;
+    abandoned = false;
+    busy = true;
+    xTaskNotifyGive(task);
+    return true;
+}
+
+size_t HttpTelemetryTransport::maxPayload() const {
+    return MAX_PAYLOAD;
+}
+
+TelemetryPublishResult HttpTelemetryTransport::poll() {
+    if (__atomic_load_n(&busy, __ATOMIC_ACQUIRE)) {
+        return TELEMETRY_PUBLISH_BUSY;
+    }
+    return abandoned ? TELEMETRY_PUBLISH_FAILED : result;
+}
+
+void HttpTelemetryTransport::cancel() {
+    // HTTPClient can not be interrupted: the request runs into its timeout on
+    // the worker task, publish() refuses until then and the result is dropped
+    abandoned = true;
+}
+
+#else
+
+#include <stdlib.h>
+
+FakeTelemetryTransport::FakeTelemetryTransport()
+    : busy(false), online(true), latency(0), startedAt(0), payloadLimit(DEFAULT_MAX_PAYLOAD), publishCount(0),
+      ackCount(0), cancelCount(0) {}
+
+void FakeTelemetryTransport::reset() {
+    busy = false;
+    online = true;
+    latency = 0;
+    payloadLimit = DEFAULT_MAX_PAYLOAD;
+    inFlight.clear();
+    sequences.clear();
+    lastPayload.clear();
+    publishCount = 0;
+    ackCount = 0;
+    cancelCount = 0;
+}
+
+void FakeTelemetryTransport::setOnline(bool isOnline) {
+    online = isOnline;
+}
+
+void FakeTelemetryTransport::setLatency(uint32_t ms) {
+    latency = ms;
+}
+
+void FakeTelemetryTransport::setMaxPayload(size_t length) {
+    payloadLimit = length;
+}
+
+bool FakeTelemetryTransport::isBusy() const {
+    return busy;
+}
+
+// Keeps the sequence numbers of a batch: {"uptime":..,"samples":[[seq,t,v],..]}
+void FakeTelemetryTransport::record(const std::string& payload) {
+    lastPayload = payload;
+    size_t position = payload.find("\"samples\":[");
+    if (position == std::string::npos) {
+        return;
+    }
+    position += 10;     // the array's own bracket
+    while ((position = payload.find('[', position + 1)) != std::string::npos) {
+        sequences.push_back((uint32_t)strtoul(payload.c_str() + position + 1, nullptr, 10));
+    }
+}
+
+bool FakeTelemetryTransport::publish(const char* payload, size_t length) {
+    if (busy || length > payloadLimit) {
+        return false;
+    }
+    busy = true;
+    startedAt = (uint32_t)millis();
+    inFlight.assign(payload, length);
+    publishCount++;
+    return true;
+}
+
+size_t FakeTelemetryTransport::maxPayload() const {
+    return payloadLimit;
+}
+
+TelemetryPublishResult FakeTelemetryTransport::poll() {
+    if (!busy) {
+        return TELEMETRY_PUBLISH_FAILED;
+    }
+    if (!online) {
+        busy = false;
+        return TELEMETRY_PUBLISH_FAILED;
+    }
+    if ((uint32_t)millis() - startedAt < latency) {
+        return TELEMETRY_PUBLISH_BUSY;
+    }
+    busy = false;
+    ackCount++;
+    record(inFlight);
+    return TELEMETRY_PUBLISH_ACKED;
+}
+
+void FakeTelemetryTransport::cancel() {
+    if (busy) {
+        busy = false;
+        cancelCount++;
+    }
+}
+
+#endif
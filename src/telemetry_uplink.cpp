@@ -0,0 +1,274 @@
+#include "telemetry_uplink.h"
+#include "temperature_service.h"
+#include "wifi_manager.h"
+#include "scheduler.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ARDUINO
+static HttpTelemetryTransport defaultTransport(TELEMETRY_URL);
+TelemetryTransport* TelemetryUplink::transport = TELEMETRY_URL[0] != '\0' ? &defaultTransport : nullptr;
+#else
+static FakeTelemetryTransport defaultTransport;
+TelemetryTransport* TelemetryUplink::transport = &defaultTransport;
+#endif
+
+static const uint32_t RETRY_BASE_MS = 5000;
+static const uint32_t RETRY_MAX_MS = 300000;
+
+// Static member definitions
+SpscQueue<TelemetrySample, TelemetryUplink::QUEUE_SIZE> TelemetryUplink::queue;
+bool TelemetryUplink::collecting = false;
+uint32_t TelemetryUplink::cursor = 0;
+uint32_t TelemetryUplink::stride = 1;
+volatile uint32_t TelemetryUplink::droppedSamples = 0;
+volatile uint32_t TelemetryUplink::downsampledSamples = 0;
+TelemetrySample TelemetryUplink::batch[TelemetryUplink::BATCH_SAMPLES];
+uint32_t TelemetryUplink::batchCount = 0;
+uint32_t TelemetryUplink::batchSent = 0;
+uint32_t TelemetryUplink::batchStartedAt = 0;
+bool TelemetryUplink::inFlight = false;
+uint32_t TelemetryUplink::publishStartedAt = 0;
+bool TelemetryUplink::linkUp = false;
+bool TelemetryUplink::retryPending = false;
+uint32_t TelemetryUplink::retryAt = 0;
+ExponentialBackoff TelemetryUplink::backoff(RETRY_BASE_MS, RETRY_MAX_MS);
+bool TelemetryUplink::hasAcked = false;
+uint32_t TelemetryUplink::ackedSequence = 0;
+uint32_t TelemetryUplink::publishedBatches = 0;
+uint32_t TelemetryUplink::failedPublishes = 0;
+uint32_t TelemetryUplink::oversizedBatches = 0;
+char TelemetryUplink::payload[TelemetryUplink::PAYLOAD_SIZE];
+int TelemetryUplink::loopTaskId = Scheduler::INVALID_TASK;
+
+// Runs before the lane tasks start, so it may reset both sides
+void TelemetryUplink::init() {
+    if (inFlight && transport != nullptr) {
+        transport->cancel();
+    }
+    queue.clear();
+    collecting = false;
+    stride = 1;
+    droppedSamples = 0;
+    downsampledSamples = 0;
+    batchCount = 0;
+    inFlight = false;
+    linkUp = false;
+    retryPending = false;
+    backoff.reset();
+    hasAcked = false;
+    publishedBatches = 0;
+    failedPublishes = 0;
+    oversizedBatches = 0;
+
+    if (transport == nullptr) {
+        LOG_INFO("Telemetry uplink disabled (no TELEMETRY_URL)");
+        return;
+    }
+    if (!Scheduler::isScheduled(loopTaskId)) {
+        loopTaskId = Scheduler::addPeriodic("uplink", loop, CHECK_INTERVAL);
+    }
+    LOG_INFO("Telemetry uplink initialized, %lu samples per batch", (unsigned long)BATCH_SAMPLES);
+}
+
+void TelemetryUplink::setTransport(TelemetryTransport* newTransport) {
+    transport = newTransport;
+}
+
+bool TelemetryUplink::isEnabled() {
+    return transport != nullptr;
+}
+
+// Publishing task: copy new history samples into the queue until it is full
+void TelemetryUplink::collect() {
+    if (transport == nullptr) {
+        return;
+    }
+    const TemperatureHistory& history = TemperatureService::getHistory();
+    uint32_t first = history.getFirstSequence();
+    uint32_t next = history.getNextSequence();
+    if (!collecting || (int32_t)(next - cursor) < 0) {
+        // First pass, or the history was cleared and numbering restarted
+        cursor = first;
+        collecting = true;
+    } else if ((int32_t)(cursor - first) < 0) {
+        droppedSamples += first - cursor;
+        cursor = first;
+    }
+
+    // A backlog is thinned with one stride until it is worked off, so it
+    // costs at most BACKLOG_SAMPLES however long it was
+    uint32_t needed = (next - cursor + BACKLOG_SAMPLES - 1) / BACKLOG_SAMPLES;
+    if (needed > stride) {
+        stride = needed;
+    }
+    HistorySample sample;
+    while (cursor != next && history.getSample(cursor, sample)) {
+        TelemetrySample item = { cursor, sample.timestamp, sample.value };
+        if (!queue.push(item)) {
+            break;  // the rest waits in the history
+        }
+        // Skip ahead by the stride, but never past the newest sample
+        uint32_t remaining = next - 1 - cursor;
+        uint32_t step = remaining == 0 ? 1 : (remaining < stride ? remaining : stride);
+        downsampledSamples += step - 1;
+        cursor += step;
+    }
+    if (cursor == next) {
+        stride = 1;
+    }
+}
+
+// Network task: batch, publish and wait for the ack, one step per pass
+void TelemetryUplink::loop() {
+    if (transport == nullptr) {
+        return;
+    }
+    uint32_t now = (uint32_t)millis();
+    bool connected = WiFiManager::isConnected();
+    if (connected && !linkUp) {
+        // (Re)connected: resume right away after the last acked sample
+        retryPending = false;
+        backoff.reset();
+        if (hasAcked) {
+            LOG_INFO("Telemetry uplink resuming after sample %lu", (unsigned long)ackedSequence);
+        }
+    }
+    linkUp = connected;
+
+    if (inFlight) {
+        TelemetryPublishResult result = transport->poll();
+        if (result == TELEMETRY_PUBLISH_BUSY) {
+            if (connected && now - publishStartedAt < PUBLISH_TIMEOUT) {
+                return;
+            }
+            transport->cancel();
+            result = TELEMETRY_PUBLISH_FAILED;
+        }
+        finishPublish(result, now);
+    }
+
+    fillBatch(now);
+    if (!connected || batchCount == 0) {
+        return;
+    }
+    if (retryPending && (int32_t)(now - retryAt) < 0) {
+        return;
+    }
+    if (batchCount < BATCH_SAMPLES && now - batchStartedAt < BATCH_INTERVAL) {
+        return;
+    }
+    publishBatch(now);
+}
+
+void TelemetryUplink::fillBatch(uint32_t now) {
+    TelemetrySample item;
+    while (batchCount < BATCH_SAMPLES && queue.pop(item)) {
+        if (batchCount == 0) {
+            batchStartedAt = now;
+        }
+        batch[batchCount++] = item;
+    }
+}
+
+void TelemetryUplink::publishBatch(uint32_t now) {
+    size_t limit = transport->maxPayload();
+    uint32_t count = 0;
+    size_t length = encodeBatch(now, limit, count);
+    if (count < batchCount) {
+        oversizedBatches++;
+        if (count == 0) {
+            // Not even one sample fits; back off rather than retry every pass
+            uint32_t delayMs = backoff.nextDelay();
+            retryPending = true;
+            retryAt = now + delayMs;
+            LOG_WARN("Telemetry transport limit of %lu bytes is too small for one sample", (unsigned long)limit);
+            return;
+        }
+        LOG_WARN("Telemetry batch over the %lu byte transport limit, sending %lu of %lu samples",
+                 (unsigned long)limit, (unsigned long)count, (unsigned long)batchCount);
+    }
+    if (!transport->publish(payload, length)) {
+        return;     // the transport is still busy; try again next pass
+    }
+    batchSent = count;
+    inFlight = true;
+    publishStartedAt = now;
+}
+
+void TelemetryUplink::finishPublish(TelemetryPublishResult result, uint32_t now) {
+    inFlight = false;
+    if (result == TELEMETRY_PUBLISH_ACKED) {
+        // Samples a split batch left behind move up and go out next
+        ackedSequence = batch[batchSent - 1].sequence;
+        hasAcked = true;
+        memmove(batch, batch + batchSent, (batchCount - batchSent) * sizeof(batch[0]));
+        batchCount -= batchSent;
+        publishedBatches++;
+        retryPending = false;
+        backoff.reset();
+        return;
+    }
+    // Keep the batch; it goes out again after the backoff
+    failedPublishes++;
+    uint32_t delayMs = backoff.nextDelay();
+    retryPending = true;
+    retryAt = now + delayMs;
+    LOG_WARN("Telemetry publish failed, retrying in %lu ms", (unsigned long)delayMs);
+}
+
+// Encodes as many samples from the front of the batch as fit in `limit`
+// bytes and reports that number in `count`
+size_t TelemetryUplink::encodeBatch(uint32_t now, size_t limit, uint32_t& count) {
+    static const size_t CLOSING = 2;    // "]}"
+    if (limit > PAYLOAD_SIZE - 1) {
+        limit = PAYLOAD_SIZE - 1;
+    }
+    size_t length = (size_t)snprintf(payload, PAYLOAD_SIZE, "{\"uptime\":%lu,\"samples\":[", (unsigned long)now);
+    count = 0;
+    char item[40];
+    while (count < batchCount) {
+        size_t itemLength = (size_t)snprintf(item, sizeof(item), "%s[%lu,%lu,%d]", count > 0 ? "," : "",
+                                             (unsigned long)batch[count].sequence,
+                                             (unsigned long)batch[count].timestamp,
+                                             (int)batch[count].centiCelsius);
+        if (length + itemLength + CLOSING > limit) {
+            break;
+        }
+        memcpy(payload + length, item, itemLength);
+        length += itemLength;
+        count++;
+    }
+    length += (size_t)snprintf(payload + length, PAYLOAD_SIZE - length, "]}");
+    return length;
+}
+
+bool TelemetryUplink::getAckedSequence(uint32_t& sequence) {
+    sequence = ackedSequence;
+    return hasAcked;
+}
+
+uint32_t TelemetryUplink::getPublishedBatches() {
+    return publishedBatches;
+}
+
+uint32_t TelemetryUplink::getFailedPublishes() {
+    return failedPublishes;
+}
+
+uint32_t TelemetryUplink::getOversizedBatches() {
+    return oversizedBatches;
+}
+
+uint32_t TelemetryUplink::getQueuedSamples() {
+    return queue.size() + batchCount;
+}
+
+uint32_t TelemetryUplink::getDroppedSamples() {
+    return droppedSamples;
+}
+
+uint32_t TelemetryUplink::getDownsampledSamples() {
+    return downsampledSamples;
+}
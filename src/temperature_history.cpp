@@ -0,0 +1,247 @@
+#include "temperature_history.h"
+#include "platform.h"
+#include <stdlib.h>
+
+static const uint32_t DEFAULT_WINDOW_SPANS[WINDOW_COUNT] = {
+    60000UL,     // 1 minute
+    3600000UL,   // 1 hour
+    86400000UL   // 24 hours
+};
+
+// Large buffers go to PSRAM on the N16R8 module, internal RAM otherwise
+static void* allocateStorage(size_t bytes) {
+#ifdef ARDUINO
+    if (psramFound()) {
+        void* block = ps_malloc(bytes);
+        if (block != nullptr) {
+            return block;
+        }
+    }
+#endif
+    return malloc(bytes);
+}
+
+TemperatureHistory::TemperatureHistory()
+    : capacity(0), mask(0), nextSeq(0), timestamps(nullptr), values(nullptr), storage(nullptr) {
+    for (int i = 0; i < WINDOW_COUNT; i++) {
+        windows[i].span = DEFAULT_WINDOW_SPANS[i];
+        windows[i].minDeque = nullptr;
+        windows[i].maxDeque = nullptr;
+        clearWindow(windows[i]);
+    }
+}
+
+TemperatureHistory::~TemperatureHistory() {
+    end();
+}
+
+bool TemperatureHistory::begin(uint32_t requestedCapacity) {
+    end();
+
+    // Round up to a power of two so sequence numbers map to slots with a mask
+    uint32_t newCapacity = 2;
+    while (newCapacity < requestedCapacity && newCapacity < 0x80000000UL) {
+        newCapacity <<= 1;
+    }
+
+    // One block: timestamps, two deques per window, then the 16-bit values
+    size_t words = (size_t)newCapacity * (1 + 2 * WINDOW_COUNT);
+    storage = allocateStorage(words * sizeof(uint32_t) + newCapacity * sizeof(int16_t));
+    if (storage == nullptr) {
+        return false;
+    }
+
+    uint32_t* block = (uint32_t*)storage;
+    timestamps = block;
+    for (int i = 0; i < WINDOW_COUNT; i++) {
+        windows[i].minDeque = block + newCapacity * (1 + 2 * i);
+        windows[i].maxDeque = block + newCapacity * (2 + 2 * i);
+    }
+    values = (int16_t*)(block + words);
+
+    capacity = newCapacity;
+    mask = newCapacity - 1;
+    clear();
+    return true;
+}
+
+void TemperatureHistory::end() {
+    free(storage);
+    storage = nullptr;
+    timestamps = nullptr;
+    values = nullptr;
+    for (int i = 0; i < WINDOW_COUNT; i++) {
+        windows[i].minDeque = nullptr;
+        windows[i].maxDeque = nullptr;
+    }
+    capacity = 0;
+    mask = 0;
+    nextSeq = 0;
+}
+
+void TemperatureHistory::clear() {
+    nextSeq = 0;
+    for (int i = 0; i < WINDOW_COUNT; i++) {
+        clearWindow(windows[i]);
+    }
+}
+
+int16_t TemperatureHistory::valueAt(uint32_t seq) const {
+    return values[seq & mask];
+}
+
+uint32_t TemperatureHistory::timestampAt(uint32_t seq) const {
+    return timestamps[seq & mask];
+}
+
+void TemperatureHistory::clearWindow(Window& window) {
+    window.firstSeq = nextSeq;
+    window.count = 0;
+    window.sum = 0;
+    window.sumSquares = 0;
+    window.minHead = window.minTail = 0;
+    window.maxHead = window.maxTail = 0;
+}
+
+void TemperatureHistory::pushToWindow(Window& window, uint32_t seq) {
+    int16_t value = valueAt(seq);
+    if (window.count == 0) {
+        window.firstSeq = seq;
+    }
+    window.count++;
+    window.sum += value;
+    window.sumSquares += (int32_t)value * value;
+
+    // Drop entries that can never be the extreme again
+    while (window.minTail != window.minHead &&
+           valueAt(window.minDeque[(window.minTail - 1) & mask]) >= value) {
+        window.minTail--;
+    }
+    window.minDeque[window.minTail++ & mask] = seq;
+
+    while (window.maxTail != window.maxHead &&
+           valueAt(window.maxDeque[(window.maxTail - 1) & mask]) <= value) {
+        window.maxTail--;
+    }
+    window.maxDeque[window.maxTail++ & mask] = seq;
+}
+
+void TemperatureHistory::popFromWindow(Window& window) {
+    uint32_t seq = window.firstSeq;
+    int16_t value = valueAt(seq);
+    window.count--;
+    window.sum -= value;
+    window.sumSquares -= (int32_t)value * value;
+
+    if (window.minHead != window.minTail && window.minDeque[window.minHead & mask] == seq) {
+        window.minHead++;
+    }
+    if (window.maxHead != window.maxTail && window.maxDeque[window.maxHead & mask] == seq) {
+        window.maxHead++;
+    }
+    window.firstSeq++;
+}
+
+void TemperatureHistory::add(uint32_t timestamp, int16_t value) {
+    if (capacity == 0) {
+        return;
+    }
+
+    // The slot about to be overwritten must leave every window first
+    if (nextSeq >= capacity) {
+        uint32_t evicted = nextSeq - capacity;
+        for (int i = 0; i < WINDOW_COUNT; i++) {
+            if (windows[i].count > 0 && windows[i].firstSeq == evicted) {
+                popFromWindow(windows[i]);
+            }
+        }
+    }
+
+    uint32_t seq = nextSeq++;
+    timestamps[seq & mask] = timestamp;
+    values[seq & mask] = value;
+
+    for (int i = 0; i < WINDOW_COUNT; i++) {
+        pushToWindow(windows[i], seq);
+    }
+    expire(timestamp);
+}
+
+void TemperatureHistory::expire(uint32_t now) {
+    for (int i = 0; i < WINDOW_COUNT; i++) {
+        Window& window = windows[i];
+        while (window.count > 0 && now - timestampAt(window.firstSeq) >= window.span) {
+            popFromWindow(window);
+        }
+    }
+}
+
+bool TemperatureHistory::setWindowSpan(HistoryWindow window, uint32_t spanMs) {
+    if (window < 0 || window >= WINDOW_COUNT || spanMs == 0) {
+        return false;
+    }
+
+    // Rare reconfiguration: rebuild this window from the stored samples
+    Window& target = windows[window];
+    target.span = spanMs;
+    clearWindow(target);
+    if (capacity == 0 || nextSeq == 0) {
+        return true;
+    }
+    for (uint32_t seq = getFirstSequence(); seq != nextSeq; seq++) {
+        pushToWindow(target, seq);
+    }
+    uint32_t latest = timestampAt(nextSeq - 1);
+    while (target.count > 0 && latest - timestampAt(target.firstSeq) >= target.span) {
+        popFromWindow(target);
+    }
+    return true;
+}
+
+uint32_t TemperatureHistory::getWindowSpan(HistoryWindow window) const {
+    if (window < 0 || window >= WINDOW_COUNT) {
+        return 0;
+    }
+    return windows[window].span;
+}
+
+bool TemperatureHistory::getStats(HistoryWindow window, WindowStats& stats) const {
+    if (window < 0 || window >= WINDOW_COUNT || windows[window].count == 0) {
+        return false;
+    }
+
+    const Window& source = windows[window];
+    int64_t n = source.count;
+    stats.count = source.count;
+    stats.mean = (float)source.sum / (float)n;
+    // Exact integer numerator keeps the variance free of cancellation error
+    stats.variance = (float)(n * source.sumSquares - source.sum * source.sum) / (float)(n * n);
+    stats.min = valueAt(source.minDeque[source.minHead & mask]);
+    stats.max = valueAt(source.maxDeque[source.maxHead & mask]);
+    return true;
+}
+
+uint32_t TemperatureHistory::getCapacity() const {
+    return capacity;
+}
+
+uint32_t TemperatureHistory::size() const {
+    return nextSeq < capacity ? nextSeq : capacity;
+}
+
+uint32_t TemperatureHistory::getFirstSequence() const {
+    return nextSeq - size();
+}
+
+uint32_t TemperatureHistory::getNextSequence() const {
+    return nextSeq;
+}
+
+bool TemperatureHistory::getSample(uint32_t seq, HistorySample& sample) const {
+    if (seq - getFirstSequence() >= size()) {
+        return false;
+    }
+    sample.timestamp = timestampAt(seq);
+    sample.value = valueAt(seq);
+    return true;
+}
@@ -0,0 +1,57 @@
+#include "temperature_payload.h"
+
+static void writeU16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void writeU32(uint8_t* out, uint32_t value) {
+    writeU16(out, (uint16_t)value);
+    writeU16(out + 2, (uint16_t)(value >> 16));
+}
+
+static uint16_t readU16(const uint8_t* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* in) {
+    return (uint32_t)readU16(in) | ((uint32_t)readU16(in + 2) << 16);
+}
+
+size_t TemperaturePayload::encode(const TemperatureReading& reading, uint8_t* out, size_t capacity) {
+    if (capacity < TEMPERATURE_PAYLOAD_SIZE) {
+        return 0;
+    }
+    out[0] = TEMPERATURE_PAYLOAD_VERSION;
+    out[1] = reading.unit;
+    writeU32(out + 2, reading.sequence);
+    writeU32(out + 6, reading.timestamp);
+    writeU16(out + 10, (uint16_t)reading.current);
+    writeU16(out + 12, (uint16_t)reading.max);
+    writeU16(out + 14, (uint16_t)reading.min);
+    return TEMPERATURE_PAYLOAD_SIZE;
+}
+
+bool TemperaturePayload::decode(const uint8_t* data, size_t length, TemperatureReading& reading) {
+    if (length < TEMPERATURE_PAYLOAD_SIZE || data[0] < TEMPERATURE_PAYLOAD_VERSION) {
+        return false;
+    }
+    reading.unit = data[1];
+    reading.sequence = readU32(data + 2);
+    reading.timestamp = readU32(data + 6);
+    reading.current = (int16_t)readU16(data + 10);
+    reading.max = (int16_t)readU16(data + 12);
+    reading.min = (int16_t)readU16(data + 14);
+    return true;
+}
+
+int16_t TemperaturePayload::toFixedPoint(float temperature) {
+    float scaled = temperature * 100.0f;
+    if (!(scaled > -32768.0f)) {
+        return -32768; // also catches NaN
+    }
+    if (scaled >= 32767.0f) {
+        return 32767;
+    }
+    return (int16_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+}
@@ -0,0 +1,198 @@
+#include "temperature_sensor.h"
+#include "temperature_payload.h"
+
+FakeTemperatureSensor::FakeTemperatureSensor() : startedAt(0) {}
+
+const char* FakeTemperatureSensor::name() {
+    return "fake";
+}
+
+bool FakeTemperatureSensor::startConversion(uint32_t now) {
+    startedAt = now;
+    return true;
+}
+
+SensorPoll FakeTemperatureSensor::pollResult(uint32_t, int16_t& centiCelsius) {
+    // Pseudo-random variation based on time: -5 to +5 around the base
+    float baseTemp = -10.5f;
+    float variation = (float)(startedAt % 1000) / 1000.0f * 10.0f - 5.0f;
+    centiCelsius = TemperaturePayload::toFixedPoint(baseTemp + variation);
+    return SENSOR_READY;
+}
+
+ReplayTemperatureSensor::ReplayTemperatureSensor(const char* name, const int16_t* values, size_t count,
+                                                 uint32_t conversionMs)
+    : sensorName(name), values(values), count(count), conversionMs(conversionMs) {
+    reset();
+}
+
+void ReplayTemperatureSensor::reset() {
+    position = 0;
+    startedAt = 0;
+    converting = false;
+    startCount = 0;
+    pollCount = 0;
+}
+
+const char* ReplayTemperatureSensor::name() {
+    return sensorName;
+}
+
+bool ReplayTemperatureSensor::startConversion(uint32_t now) {
+    if (count == 0) {
+        return false;
+    }
+    startedAt = now;
+    converting = true;
+    startCount++;
+    return true;
+}
+
+SensorPoll ReplayTemperatureSensor::pollResult(uint32_t now, int16_t& centiCelsius) {
+    pollCount++;
+    if (!converting) {
+        return SENSOR_ERROR;
+    }
+    if (now - startedAt < conversionMs) {
+        return SENSOR_BUSY;
+    }
+    converting = false;
+    int16_t value = values[position];
+    position = (position + 1) % count;
+    if (value == REPLAY_ERROR) {
+        return SENSOR_ERROR;
+    }
+    centiCelsius = value;
+    return SENSOR_READY;
+}
+
+SensorRegistry::SensorRegistry() {
+    clear();
+}
+
+void SensorRegistry::clear() {
+    for (int i = 0; i < MAX_SENSORS; i++) {
+        slots[i].sensor = nullptr;
+        slots[i].pending = false;
+    }
+    sensorCount = 0;
+    nextPoll = 0;
+}
+
+int SensorRegistry::add(TemperatureSensor* sensor) {
+    if (sensor == nullptr || sensorCount >= MAX_SENSORS) {
+        return -1;
+    }
+    Slot& slot = slots[sensorCount];
+    slot.sensor = sensor;
+    slot.pending = false;
+    slot.startedAt = 0;
+    slot.stats.readings = 0;
+    slot.stats.errors = 0;
+    slot.stats.timeouts = 0;
+    slot.stats.lastTimestamp = 0;
+    slot.stats.last = 0;
+    slot.stats.min = INT16_MAX;
+    slot.stats.max = INT16_MIN;
+    publish(slot);
+    return sensorCount++;
+}
+
+int SensorRegistry::count() const {
+    return sensorCount;
+}
+
+TemperatureSensor* SensorRegistry::get(int index) {
+    return (index >= 0 && index < sensorCount) ? slots[index].sensor : nullptr;
+}
+
+void SensorRegistry::publish(Slot& slot) {
+    slot.published.write(slot.stats);
+}
+
+void SensorRegistry::startAll(uint32_t now) {
+    for (int i = 0; i < sensorCount; i++) {
+        // A sensor still converting from the last round is left to the timeout
+        start(i, now);
+    }
+}
+
+bool SensorRegistry::start(int index, uint32_t now) {
+    if (index < 0 || index >= sensorCount || slots[index].pending) {
+        return false;
+    }
+    Slot& slot = slots[index];
+    if (!slot.sensor->startConversion(now)) {
+        slot.stats.errors++;
+        publish(slot);
+        return false;
+    }
+    slot.pending = true;
+    slot.startedAt = now;
+    return true;
+}
+
+bool SensorRegistry::poll(uint32_t now, SensorReadingHandler handler) {
+    int first = nextPoll;
+    for (int n = 0; n < sensorCount; n++) {
+        int index = (first + n) % sensorCount;
+        Slot& slot = slots[index];
+        if (!slot.pending) {
+            continue;
+        }
+
+        int16_t value = 0;
+        SensorPoll result = slot.sensor->pollResult(now, value);
+        if (result == SENSOR_BUSY) {
+            if (now - slot.startedAt < CONVERSION_TIMEOUT) {
+                continue;
+            }
+            slot.stats.timeouts++;
+        } else if (result == SENSOR_ERROR) {
+            slot.stats.errors++;
+        } else {
+            slot.stats.readings++;
+            slot.stats.lastTimestamp = slot.startedAt;
+            slot.stats.last = value;
+            if (value < slot.stats.min) {
+                slot.stats.min = value;
+            }
+            if (value > slot.stats.max) {
+                slot.stats.max = value;
+            }
+        }
+        slot.pending = false;
+        publish(slot);
+        // Last, so the handler may start this sensor again
+        if (result == SENSOR_READY && handler) {
+            handler(index, slot.startedAt, value);
+        }
+    }
+    if (sensorCount > 0) {
+        nextPoll = (first + 1) % sensorCount;
+    }
+    return isPending();
+}
+
+bool SensorRegistry::isPending() const {
+    for (int i = 0; i < sensorCount; i++) {
+        if (slots[i].pending) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SensorRegistry::cancelAll() {
+    for (int i = 0; i < sensorCount; i++) {
+        slots[i].pending = false;
+    }
+}
+
+bool SensorRegistry::getStats(int index, SensorStats& stats) const {
+    if (index < 0 || index >= sensorCount) {
+        return false;
+    }
+    slots[index].published.read(stats);
+    return true;
+}
@@ -1,57 +1,347 @@
 #include "temperature_service.h"
+#include "scheduler.h"
+#include "timing_stats.h"
+#include "boot_profile.h"
+#include "logger.h"
 
 // Static member definitions
-float TemperatureService::currentTemp = -20.0f;
-float TemperatureService::maxTemp = -100.0f;
-float TemperatureService::minTemp = 100.0f;
-TemperatureUnit TemperatureService::unit = CELSIUS;
-unsigned long TemperatureService::lastUpdateTime = 0;
+TemperatureService::State TemperatureService::state = { 0, 0, -2000, -10000, 10000 };
+Seqlock<TemperatureService::State> TemperatureService::published;
+volatile TemperatureUnit TemperatureService::unit = CELSIUS;
+uint32_t TemperatureService::lastSampleMicros = 0;
+uint32_t TemperatureService::sampleInterval = 0;
+int TemperatureService::updateTaskId = Scheduler::INVALID_TASK;
+int TemperatureService::pollTaskId = Scheduler::INVALID_TASK;
+bool TemperatureService::hasReading = false;
+SensorRegistry TemperatureService::sensors;
+TemperatureFilter TemperatureService::filter;
+uint32_t TemperatureService::groupStartedAt = 0;
+uint32_t TemperatureService::groupReadings = 0;
+bool TemperatureService::restarted = false;
+TemperatureHistory TemperatureService::history;
+HistoryRollup TemperatureService::rollup;
+volatile bool TemperatureService::dirty = false;
+TemperatureChangeCallback TemperatureService::changeCallback = nullptr;
+SpscQueue<TemperatureSample, TemperatureService::SAMPLE_QUEUE_SIZE> TemperatureService::samples;
+volatile uint32_t TemperatureService::droppedSamples = 0;
+
+static FakeTemperatureSensor fakeSensor;
+
+#ifdef ARDUINO
+static PartitionFlashStorage defaultLogStorage("samplelog");
+FlashStorage* TemperatureService::logStorage = &defaultLogStorage;
+#else
+FlashStorage* TemperatureService::logStorage = nullptr;
+#endif
+SampleLog TemperatureService::sampleLog;
+uint32_t TemperatureService::logOffset = 0;
+SpscQueue<LoggedSample, TemperatureService::LOG_QUEUE_SIZE> TemperatureService::logQueue;
+volatile uint32_t TemperatureService::droppedLogSamples = 0;
 
 void TemperatureService::init() {
-    Serial.println("Initializing Temperature Service...");
-    currentTemp = generateFakeTemperature();
-    maxTemp = currentTemp;
-    minTemp = currentTemp;
-    lastUpdateTime = millis();
-    Serial.println("Temperature Service initialized");
+    LOG_INFO("Initializing Temperature Service...");
+    ConfigStore::subscribe(configChanged);
+    applyUnit((TemperatureUnit)ConfigStore::get(CONFIG_TEMP_UNIT));
+    sampleInterval = ConfigStore::get(CONFIG_SAMPLE_INTERVAL);
+    if (sensors.count() == 0) {
+        sensors.add(&fakeSensor);
+    }
+    sensors.cancelAll();
+    filter.reset();
+    groupReadings = 0;
+    samples.clear();
+    droppedSamples = 0;
+    hasReading = false;
+    state.sequence = 0;
+    state.timestamp = (uint32_t)millis();
+    state.current = 0;
+    state.max = 0;
+    state.min = 0;
+    published.write(state);
+    lastSampleMicros = (uint32_t)micros();
+    
+    // History storage is allocated once and reused across re-initialisation
+    if (history.getCapacity() == 0) {
+        if (!history.begin()) {
+            LOG_ERROR("Temperature history allocation failed");
+        }
+    } else {
+        history.clear();
+    }
+    rollup.clear();
+    restoreFromLog();
+
+    // Sample on a fixed-rate schedule instead of polling shouldUpdate()
+    if (!Scheduler::isScheduled(updateTaskId)) {
+        updateTaskId = Scheduler::addPeriodic("temperature", acquire, sampleInterval, sampleInterval);
+    } else {
+        Scheduler::setPeriod(updateTaskId, sampleInterval);
+    }
+
+    // First reading right away if the primary sensor converts instantly;
+    // slower sensors deliver it through the poll job
+    sensors.startAll((uint32_t)millis());
+    pollSensors();
+    processSamples();
+    LOG_INFO("Temperature Service initialized with %d sensor(s)", sensors.count());
 }
 
 void TemperatureService::update() {
     if (shouldUpdate()) {
-        currentTemp = generateFakeTemperature();
-        
-        // Update max and min temperatures
-        if (currentTemp > maxTemp) {
-            maxTemp = currentTemp;
+        sample();
+    }
+}
+
+void TemperatureService::sample() {
+    acquire();
+    processSamples();
+}
+
+// Sampling task: start conversions and collect what is ready, nothing else
+void TemperatureService::acquire() {
+    ScopedTimer timer(PROBE_TEMPERATURE);
+
+    // Jitter: distance of this sample from one period after the previous one
+    uint32_t nowMicros = (uint32_t)micros();
+    uint32_t configured = ConfigStore::get(CONFIG_SAMPLE_INTERVAL);
+    if (configured != sampleInterval) {
+        // Triggered by the change: this sample starts the new period
+        sampleInterval = configured;
+        Scheduler::setPeriod(updateTaskId, sampleInterval);
+    } else {
+        uint32_t interval = nowMicros - lastSampleMicros;
+        uint32_t expected = sampleInterval * 1000UL;
+        TimingStats::record(PROBE_SAMPLE_JITTER, interval > expected ? interval - expected : expected - interval);
+    }
+    lastSampleMicros = nowMicros;
+
+    sensors.startAll((uint32_t)millis());
+    pollSensors();
+}
+
+// Timed by its callers, so a sample counts once under PROBE_TEMPERATURE
+void TemperatureService::pollSensors() {
+    bool pending = false;
+    // An instant sensor restarted for oversampling is ready again right
+    // away, so keep polling while that happens; a slow one is left pending
+    for (int pass = 0; pass < TEMPERATURE_OVERSAMPLE; pass++) {
+        restarted = false;
+        pending = sensors.poll((uint32_t)millis(), sensorReading);
+        if (!restarted) {
+            break;
         }
-        if (currentTemp < minTemp) {
-            minTemp = currentTemp;
+    }
+
+    // Come back shortly while a conversion is still running; never wait here
+    if (pending && !Scheduler::isScheduled(pollTaskId)) {
+        pollTaskId = Scheduler::addOneShot("sensor-poll", pollJob, POLL_INTERVAL);
+    }
+}
+
+void TemperatureService::pollJob() {
+    ScopedTimer timer(PROBE_SENSOR_POLL);
+    // The one-shot is done once it runs; never test its recycled id again
+    pollTaskId = Scheduler::INVALID_TASK;
+    pollSensors();
+}
+
+// The edge between the sensors and everything downstream
+void TemperatureService::sensorReading(int index, uint32_t timestamp, int16_t centiCelsius) {
+    if (index != 0) {
+        return;     // secondary sensors only keep their stats in the registry
+    }
+    if (groupReadings++ == 0) {
+        groupStartedAt = timestamp;
+    }
+    int32_t filtered;
+    if (!filter.process(centiCelsius, filtered)) {
+        // Oversampling wants another conversion before it has a value
+        restarted = sensors.start(0, (uint32_t)millis());
+        return;
+    }
+    groupReadings = 0;
+
+    TemperatureSample reading;
+    reading.timestamp = groupStartedAt;
+    reading.centiCelsius = TemperatureUnits::saturate(filtered);
+    if (!samples.push(reading)) {
+        // The publisher is stalled; keep the queued samples and count the loss
+        __atomic_fetch_add(&droppedSamples, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (changeCallback) {
+        changeCallback();
+    }
+}
+
+// Publishing task: fold queued samples into the published state
+int TemperatureService::processSamples() {
+    TemperatureSample reading;
+    int processed = 0;
+    while (samples.pop(reading)) {
+        applySample(reading);
+        processed++;
+        if (sampleLog.isReady()) {
+            LoggedSample logged;
+            logged.timestamp = reading.timestamp - logOffset;
+            logged.centiCelsius = reading.centiCelsius;
+            logged.max = (int16_t)state.max;
+            logged.min = (int16_t)state.min;
+            if (!logQueue.push(logged)) {
+                __atomic_fetch_add(&droppedLogSamples, 1, __ATOMIC_RELAXED);
+            }
         }
-        
-        lastUpdateTime = millis();
-        
-        Serial.print("Temperature updated: Current=");
-        Serial.print(currentTemp);
-        Serial.print(unit == CELSIUS ? "°C" : "°F");
-        Serial.print(", Max=");
-        Serial.print(maxTemp);
-        Serial.print(unit == CELSIUS ? "°C" : "°F");
-        Serial.print(", Min=");
-        Serial.print(minTemp);
-        Serial.println(unit == CELSIUS ? "°C" : "°F");
     }
+    if (processed > 0) {
+        // One publish per batch; readers only ever see whole samples
+        published.write(state);
+        // The change callback already fired when the samples were queued
+        __atomic_store_n(&dirty, true, __ATOMIC_RELEASE);
+        TemperatureUnit shown = unit;
+        const char* symbol = shown == CELSIUS ? "°C" : "°F";
+        LOG_INFO("Temperature updated: Current=%.2f%s, Max=%.2f%s, Min=%.2f%s",
+                 TemperatureUnits::fromCentiCelsius(state.current, shown) / 100.0f, symbol,
+                 TemperatureUnits::fromCentiCelsius(state.max, shown) / 100.0f, symbol,
+                 TemperatureUnits::fromCentiCelsius(state.min, shown) / 100.0f, symbol);
+    }
+    return processed;
+}
+
+void TemperatureService::applySample(const TemperatureSample& reading) {
+    state.current = reading.centiCelsius;
+    
+    // Update max and min temperatures; the first sample seeds both
+    if (!hasReading || state.current > state.max) {
+        state.max = state.current;
+    }
+    if (!hasReading || state.current < state.min) {
+        state.min = state.current;
+    }
+    
+    state.timestamp = reading.timestamp;
+    // Samples are numbered from 0, like the history
+    state.sequence = hasReading ? state.sequence + 1 : 0;
+    hasReading = true;
+    history.add(reading.timestamp, reading.centiCelsius);
+    rollup.add(reading.timestamp, reading.centiCelsius);
+    BootProfile::mark(BOOT_FIRST_SAMPLE);
+}
+
+uint32_t TemperatureService::getDroppedSamples() {
+    return __atomic_load_n(&droppedSamples, __ATOMIC_RELAXED);
+}
+
+void TemperatureService::setLogStorage(FlashStorage* storage) {
+    logStorage = storage;
+}
+
+// Runs before any task is sampling or writing, so it may use both sides
+void TemperatureService::restoreFromLog() {
+    logQueue.clear();
+    droppedLogSamples = 0;
+    logOffset = 0;
+    uint32_t started = (uint32_t)micros();
+    if (!sampleLog.begin(logStorage)) {
+        if (logStorage != nullptr) {
+            LOG_WARN("Sample log unavailable; samples will not survive a reboot");
+        }
+        return;
+    }
+
+    SampleLogSummary summary;
+    sampleLog.getSummary(summary);
+    if (summary.samples > 0) {
+        // Downtime is unknown without a clock: the log's time simply continues,
+        // and this boot's first sample lands one interval after its last one
+        logOffset = state.timestamp - summary.last.timestamp - sampleInterval;
+        sampleLog.replay(history.getCapacity(), restoreSample);
+        state.sequence = history.getNextSequence() - 1;
+        state.timestamp = summary.last.timestamp + logOffset;
+        state.current = summary.last.centiCelsius;
+        state.max = summary.last.max;
+        state.min = summary.last.min;
+        hasReading = true;
+        published.write(state);
+    }
+    LOG_INFO("Sample log: %lu samples in %lu sectors, %lu torn records dropped, restored in %lu us",
+             (unsigned long)summary.samples, (unsigned long)summary.sectorsUsed,
+             (unsigned long)summary.tornRecords, (unsigned long)((uint32_t)micros() - started));
+}
+
+void TemperatureService::restoreSample(const LoggedSample& sample) {
+    history.add(sample.timestamp + logOffset, sample.centiCelsius);
+    rollup.add(sample.timestamp + logOffset, sample.centiCelsius);
+}
+
+// Network task: move published samples into the log; full batches go to flash
+void TemperatureService::writeLog() {
+    LoggedSample logged;
+    while (logQueue.pop(logged)) {
+        if (!sampleLog.append(logged)) {
+            LOG_WARN("Sample log write failed");
+        }
+    }
+}
+
+bool TemperatureService::flushLog() {
+    writeLog();
+    return sampleLog.flush();
+}
+
+uint32_t TemperatureService::getDroppedLogSamples() {
+    return __atomic_load_n(&droppedLogSamples, __ATOMIC_RELAXED);
+}
+
+int TemperatureService::addSensor(TemperatureSensor* sensor) {
+    return sensors.add(sensor);
+}
+
+void TemperatureService::clearSensors() {
+    sensors.clear();
+}
+
+int TemperatureService::getSensorCount() {
+    return sensors.count();
+}
+
+const char* TemperatureService::getSensorName(int index) {
+    TemperatureSensor* sensor = sensors.get(index);
+    return sensor != nullptr ? sensor->name() : nullptr;
+}
+
+bool TemperatureService::getSensorStats(int index, SensorStats& stats) {
+    return sensors.getStats(index, stats);
+}
+
+void TemperatureService::getSnapshot(TemperatureSnapshot& snapshot) {
+    State celsius;
+    published.read(celsius);
+    // Read the unit once so every value comes out in the same one
+    TemperatureUnit shown = unit;
+    snapshot.sequence = celsius.sequence;
+    snapshot.timestamp = celsius.timestamp;
+    snapshot.current = TemperatureUnits::fromCentiCelsius(celsius.current, shown);
+    snapshot.max = TemperatureUnits::fromCentiCelsius(celsius.max, shown);
+    snapshot.min = TemperatureUnits::fromCentiCelsius(celsius.min, shown);
+    snapshot.unit = shown;
 }
 
 float TemperatureService::getCurrentTemperature() {
-    return currentTemp;
+    TemperatureSnapshot snapshot;
+    getSnapshot(snapshot);
+    return snapshot.current / 100.0f;
 }
 
 float TemperatureService::getMaxTemperature() {
-    return maxTemp;
+    TemperatureSnapshot snapshot;
+    getSnapshot(snapshot);
+    return snapshot.max / 100.0f;
 }
 
 float TemperatureService::getMinTemperature() {
-    return minTemp;
+    TemperatureSnapshot snapshot;
+    getSnapshot(snapshot);
+    return snapshot.min / 100.0f;
 }
 
 TemperatureUnit TemperatureService::getUnit() {
@@ -59,47 +349,100 @@ TemperatureUnit TemperatureService::getUnit() {
 }
 
 void TemperatureService::setUnit(TemperatureUnit newUnit) {
+    ConfigStore::set(CONFIG_TEMP_UNIT, (uint32_t)newUnit);
+    // Also before init() has subscribed
+    applyUnit(newUnit);
+}
+
+// Stored values stay in Celsius; only the unit they are reported in changes
+void TemperatureService::applyUnit(TemperatureUnit newUnit) {
     if (unit != newUnit) {
-        if (newUnit == FAHRENHEIT && unit == CELSIUS) {
-            // Convert all temperatures to Fahrenheit
-            currentTemp = celsiusToFahrenheit(currentTemp);
-            maxTemp = celsiusToFahrenheit(maxTemp);
-            minTemp = celsiusToFahrenheit(minTemp);
-        } else if (newUnit == CELSIUS && unit == FAHRENHEIT) {
-            // Convert all temperatures to Celsius
-            currentTemp = fahrenheitToCelsius(currentTemp);
-            maxTemp = fahrenheitToCelsius(maxTemp);
-            minTemp = fahrenheitToCelsius(minTemp);
-        }
         unit = newUnit;
-        Serial.print("Temperature unit changed to: ");
-        Serial.println(unit == CELSIUS ? "Celsius" : "Fahrenheit");
+        markDirty();
+        LOG_INFO("Temperature unit changed to: %s", newUnit == CELSIUS ? "Celsius" : "Fahrenheit");
     }
 }
 
-bool TemperatureService::shouldUpdate() {
-    return (millis() - lastUpdateTime) >= UPDATE_INTERVAL;
+// Runs in the task that changed the setting
+void TemperatureService::configChanged(ConfigKey key, uint32_t value) {
+    if (key == CONFIG_TEMP_UNIT) {
+        applyUnit((TemperatureUnit)value);
+    } else if (key == CONFIG_SAMPLE_INTERVAL) {
+        // acquire() picks the new period up in the sampling task
+        Scheduler::trigger(updateTaskId);
+    }
 }
 
-float TemperatureService::generateFakeTemperature() {
-    // Generate a fake temperature between 15 and 30 degrees Celsius
-    // Using a simple pseudo-random variation based on time
-    float baseTemp = -10.5f; // Base temperature
-    float variation = (float)(millis() % 1000) / 1000.0f * 10.0f - 5.0f; // -5 to +5 variation
-    float temp = baseTemp + variation;
-    
-    // If we're in Fahrenheit mode, convert the generated Celsius value
-    if (unit == FAHRENHEIT) {
-        temp = celsiusToFahrenheit(temp);
+const TemperatureHistory& TemperatureService::getHistory() {
+    return history;
+}
+
+const HistoryRollup& TemperatureService::getRollup() {
+    return rollup;
+}
+
+bool TemperatureService::getWindowStats(HistoryWindow window, TemperatureStats& stats) {
+    WindowStats raw;
+    if (!history.getStats(window, raw)) {
+        return false;
     }
-    
-    return temp;
+
+    TemperatureUnit shown = unit;
+    stats.count = raw.count;
+    stats.mean = fromCentiCelsius(raw.mean, shown);
+    stats.min = fromCentiCelsius(raw.min, shown);
+    stats.max = fromCentiCelsius(raw.max, shown);
+    // Variance only scales with the unit; the offset cancels out
+    float scale = (shown == FAHRENHEIT) ? 9.0f / 5.0f / 100.0f : 1.0f / 100.0f;
+    stats.variance = raw.variance * scale * scale;
+    return true;
+}
+
+// Publishers consume the flag instead of re-sending unchanged values. A unit
+// change sets it from the NimBLE host task, which can preempt the publisher,
+// so the flag is only ever swapped atomically.
+void TemperatureService::markDirty() {
+    __atomic_store_n(&dirty, true, __ATOMIC_RELEASE);
+    if (changeCallback) {
+        changeCallback();
+    }
+}
+
+bool TemperatureService::isDirty() {
+    return __atomic_load_n(&dirty, __ATOMIC_ACQUIRE);
+}
+
+bool TemperatureService::takeDirty() {
+    return __atomic_exchange_n(&dirty, false, __ATOMIC_ACQ_REL);
+}
+
+void TemperatureService::setChangeCallback(TemperatureChangeCallback callback) {
+    changeCallback = callback;
+}
+
+uint32_t TemperatureService::getSequence() {
+    TemperatureSnapshot snapshot;
+    getSnapshot(snapshot);
+    return snapshot.sequence;
 }
 
-float TemperatureService::celsiusToFahrenheit(float celsius) {
-    return (celsius * 9.0f / 5.0f) + 32.0f;
+void TemperatureService::getReading(TemperatureReading& reading) {
+    TemperatureSnapshot snapshot;
+    getSnapshot(snapshot);
+    reading.sequence = snapshot.sequence;
+    reading.timestamp = snapshot.timestamp;
+    reading.current = snapshot.current;
+    reading.max = snapshot.max;
+    reading.min = snapshot.min;
+    reading.unit = (uint8_t)snapshot.unit;
+}
+
+bool TemperatureService::shouldUpdate() {
+    return (millis() - state.timestamp) >= ConfigStore::get(CONFIG_SAMPLE_INTERVAL);
 }
 
-float TemperatureService::fahrenheitToCelsius(float fahrenheit) {
-    return (fahrenheit - 32.0f) * 5.0f / 9.0f;
+// Window statistics are floats already; this is only ever presentation
+float TemperatureService::fromCentiCelsius(float centiCelsius, TemperatureUnit target) {
+    float celsius = centiCelsius / 100.0f;
+    return (target == FAHRENHEIT) ? celsius * 9.0f / 5.0f + 32.0f : celsius;
 }
@@ -0,0 +1,177 @@
+#include "timing_stats.h"
+#include "logger.h"
+#include <string.h>
+
+#ifndef ARDUINO
+#include <chrono>
+#endif
+
+static const char* const PROBE_NAMES[PROBE_COUNT] = {
+    "loop",
+    "wifi",
+    "temperature",
+    "ble",
+    "ble-temp",
+    "ble-history",
+    "sample-jitter",
+    "sensor-poll"
+};
+
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+void LatencyHistogram::clear() {
+    count = 0;
+    sum = 0;
+    maxValue = 0;
+    memset(buckets, 0, sizeof(buckets));
+}
+
+int LatencyHistogram::bucketFor(uint32_t value) {
+    if (value < 2 * SUB_BUCKETS) {
+        return (int)value;
+    }
+    int exponent = 31 - __builtin_clz(value);
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    int sub = (int)(value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return 2 * SUB_BUCKETS + (exponent - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + sub;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < 2 * SUB_BUCKETS) {
+        return (uint32_t)bucket;
+    }
+    int exponent = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS + 1;
+    int sub = (bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+    uint32_t width = 1u << (exponent - SUB_BUCKET_BITS);
+    return (1u << exponent) + (uint32_t)sub * width + width - 1;
+}
+
+void LatencyHistogram::record(uint32_t value) {
+    count++;
+    sum += value;
+    if (value > maxValue) {
+        maxValue = value;
+    }
+    buckets[bucketFor(value)]++;
+}
+
+uint32_t LatencyHistogram::getCount() const {
+    return count;
+}
+
+uint32_t LatencyHistogram::getMax() const {
+    return maxValue;
+}
+
+uint32_t LatencyHistogram::getMean() const {
+    return count > 0 ? (uint32_t)(sum / count) : 0;
+}
+
+uint32_t LatencyHistogram::percentile(uint16_t perMille) const {
+    if (count == 0) {
+        return 0;
+    }
+    // Rank of the requested quantile, rounded up so p100 is the last sample
+    uint64_t rank = ((uint64_t)count * perMille + 999) / 1000;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint32_t bound = bucketUpperBound(i);
+            return bound < maxValue ? bound : maxValue;
+        }
+    }
+    return maxValue;
+}
+
+LatencyHistogram TimingStats::histograms[PROBE_COUNT];
+uint32_t TimingStats::cyclesPerMicro = 240;
+
+void TimingStats::reset() {
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        histograms[i].clear();
+    }
+#ifdef ARDUINO
+    setCpuFrequency(getCpuFrequencyMhz());
+#endif
+}
+
+void TimingStats::setCpuFrequency(uint32_t mhz) {
+    // The cycle counter follows the CPU clock
+    cyclesPerMicro = mhz > 0 ? mhz : 1;
+}
+
+void TimingStats::record(TimingProbe probe, uint32_t micros) {
+    if (probe >= 0 && probe < PROBE_COUNT) {
+        histograms[probe].record(micros);
+    }
+}
+
+bool TimingStats::getSummary(TimingProbe probe, TimingSummary& summary) {
+    if (probe < 0 || probe >= PROBE_COUNT) {
+        return false;
+    }
+    const LatencyHistogram& histogram = histograms[probe];
+    summary.count = histogram.getCount();
+    summary.mean = histogram.getMean();
+    summary.p50 = histogram.percentile(500);
+    summary.p99 = histogram.percentile(990);
+    summary.max = histogram.getMax();
+    return summary.count > 0;
+}
+
+const char* TimingStats::getName(TimingProbe probe) {
+    return (probe >= 0 && probe < PROBE_COUNT) ? PROBE_NAMES[probe] : "";
+}
+
+static void writeU32(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+size_t TimingStats::encodeSnapshot(uint8_t* buffer, size_t capacity) {
+    if (capacity < TIMING_SNAPSHOT_SIZE) {
+        return 0;
+    }
+    buffer[0] = TIMING_SNAPSHOT_VERSION;
+    buffer[1] = PROBE_COUNT;
+    uint8_t* out = buffer + 2;
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        TimingSummary summary;
+        getSummary((TimingProbe)i, summary);
+        writeU32(out, summary.count);
+        writeU32(out + 4, summary.p50);
+        writeU32(out + 8, summary.p99);
+        writeU32(out + 12, summary.max);
+        out += TIMING_SNAPSHOT_PROBE_SIZE;
+    }
+    return TIMING_SNAPSHOT_SIZE;
+}
+
+void TimingStats::printSummary() {
+    LOG_INFO("Timing (us): probe count p50 p99 max");
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        TimingSummary summary;
+        if (!getSummary((TimingProbe)i, summary)) {
+            continue;
+        }
+        LOG_INFO("  %s %lu %lu %lu %lu", PROBE_NAMES[i], (unsigned long)summary.count,
+                 (unsigned long)summary.p50, (unsigned long)summary.p99, (unsigned long)summary.max);
+    }
+}
+
+#ifndef ARDUINO
+uint32_t TimingStats::nativeMicros() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
@@ -1,168 +1,211 @@
 #include "wifi_manager.h"
+#include "scheduler.h"
+#include "config_store.h"
+#include "timing_stats.h"
+#include "boot_profile.h"
+#include "logger.h"
 
 #ifdef ARDUINO
+static ArduinoWiFiRadio defaultRadio;
+#else
+static FakeWiFiRadio defaultRadio;
+#endif
+
+// Radio events waiting for the next loop() pass
+static const uint32_t EVENT_GOT_IP = 1u << RADIO_EVENT_GOT_IP;
+static const uint32_t EVENT_DISCONNECTED = 1u << RADIO_EVENT_DISCONNECTED;
 
 // Static member definitions
-bool WiFiManager::connected = false;
-unsigned long WiFiManager::lastConnectionAttempt = 0;
+WiFiRadio* WiFiManager::radio = &defaultRadio;
+WiFiState WiFiManager::state = WIFI_STATE_IDLE;
+bool WiFiManager::autoReconnect = false;
+unsigned long WiFiManager::stateEnteredAt = 0;
+unsigned long WiFiManager::retryDelay = 0;
 int WiFiManager::connectionAttempts = 0;
+volatile uint32_t WiFiManager::pendingEvents = 0;
+ExponentialBackoff WiFiManager::backoff(ConfigStore::getField(CONFIG_WIFI_BACKOFF_BASE).defaultValue,
+                                        ConfigStore::getField(CONFIG_WIFI_BACKOFF_MAX).defaultValue);
+int WiFiManager::loopTaskId = Scheduler::INVALID_TASK;
 
 void WiFiManager::init() {
-    Serial.println("Initializing WiFi Manager...");
-    
+    LOG_INFO("Initializing WiFi Manager...");
+    uint32_t started = (uint32_t)millis();
+
     // Set WiFi mode to station (client)
-    WiFi.mode(WIFI_STA);
-    
-    // Disconnect from any previous connections
-    WiFi.disconnect();
-    delay(100);
-    
-    Serial.println("WiFi Manager initialized");
+    radio->setStationMode();
+
+    // Drop any association left from before a restart; begin() does not
+    // need the driver to settle first
+    radio->disconnect();
+
+    radio->setEventHandler(onRadioEvent);
+    backoff.seed(radio->randomSeed());
+    backoff.reset();
+    connectionAttempts = 0;
+    pendingEvents = 0;
+    autoReconnect = false;
+    enterState(WIFI_STATE_IDLE, millis());
+
+    // Keep the connection maintained from the scheduler. The polls count
+    // from before the driver started, which can take a few hundred ms, so
+    // they stay in step with other 1 s jobs registered alongside init().
+    if (!Scheduler::isScheduled(loopTaskId)) {
+        loopTaskId = Scheduler::addPeriodic("wifi", loop, CHECK_INTERVAL, CHECK_INTERVAL, started);
+    }
+
+    LOG_INFO("WiFi Manager initialized");
 }
 
 void WiFiManager::connect() {
-    if (connected) {
-        return; // Already connected
-    }
-    
-    if (connectionAttempts >= MAX_CONNECTION_ATTEMPTS && 
-        (millis() - lastConnectionAttempt) < RECONNECT_INTERVAL) {
-        return; // Wait before retrying
-    }
-    
-    // Reset connection attempts if enough time has passed
-    if ((millis() - lastConnectionAttempt) >= RECONNECT_INTERVAL) {
-        connectionAttempts = 0;
-    }
-    
-    Serial.println("Connecting to WiFi...");
-    Serial.print("SSID: ");
-    Serial.println(WIFI_SSID);
-    
-    lastConnectionAttempt = millis();
-    connectionAttempts++;
-    
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-    
-    unsigned long startAttemptTime = millis();
-    
-    // Wait for connection with timeout
-    while (WiFi.status() != WL_CONNECTED && 
-           millis() - startAttemptTime < WIFI_TIMEOUT_MS) {
-        delay(500);
-        Serial.print(".");
-    }
-    Serial.println();
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        connected = true;
-        connectionAttempts = 0; // Reset attempts on success
-        Serial.println("WiFi connected successfully!");
-        Serial.print("IP Address: ");
-        Serial.println(WiFi.localIP());
-        Serial.print("MAC Address: ");
-        Serial.println(WiFi.macAddress());
-        Serial.print("Signal Strength (RSSI): ");
-        Serial.print(WiFi.RSSI());
-        Serial.println(" dBm");
-    } else {
-        connected = false;
-        Serial.println("WiFi connection failed!");
-        Serial.print("Connection attempt ");
-        Serial.print(connectionAttempts);
-        Serial.print(" of ");
-        Serial.println(MAX_CONNECTION_ATTEMPTS);
-        
-        if (connectionAttempts >= MAX_CONNECTION_ATTEMPTS) {
-            Serial.println("Maximum connection attempts reached. Will retry in 30 seconds.");
-        }
+    // Non-blocking: start an attempt now and let loop() track its progress
+    autoReconnect = true;
+    if (state == WIFI_STATE_IDLE || state == WIFI_STATE_BACKOFF) {
+        startAttempt(millis());
     }
 }
 
 void WiFiManager::disconnect() {
-    if (connected) {
-        Serial.println("Disconnecting from WiFi...");
-        WiFi.disconnect();
-        connected = false;
-        Serial.println("WiFi disconnected");
+    autoReconnect = false;
+    if (state != WIFI_STATE_IDLE) {
+        LOG_INFO("Disconnecting from WiFi...");
+        radio->disconnect();
+        enterState(WIFI_STATE_IDLE, millis());
+        LOG_INFO("WiFi disconnected");
     }
 }
 
 void WiFiManager::loop() {
-    // Check if connection was lost
-    if (connected && WiFi.status() != WL_CONNECTED) {
-        connected = false;
-        Serial.println("WiFi connection lost!");
-    }
-    
-    // Try to reconnect if not connected
-    if (!connected && WiFi.status() != WL_CONNECTED) {
-        connect();
+    ScopedTimer timer(PROBE_WIFI);
+    unsigned long now = millis();
+    uint32_t events = __atomic_exchange_n(&pendingEvents, 0, __ATOMIC_RELAXED);
+    WiFiLinkStatus link = radio->status();
+
+    switch (state) {
+        case WIFI_STATE_IDLE:
+            if (autoReconnect) {
+                startAttempt(now);
+            }
+            break;
+
+        case WIFI_STATE_CONNECTING:
+            if (link == RADIO_LINK_UP || (events & EVENT_GOT_IP)) {
+                connectionAttempts = 0; // Reset attempts on success
+                backoff.reset();
+                enterState(WIFI_STATE_CONNECTED, now);
+                BootProfile::mark(BOOT_WIFI_CONNECTED);
+                LOG_INFO("WiFi connected successfully!");
+                LOG_INFO("IP Address: %s", radio->localIP().c_str());
+                LOG_INFO("MAC Address: %s", radio->macAddress().c_str());
+                LOG_INFO("Signal Strength (RSSI): %d dBm", radio->rssi());
+            } else if (link == RADIO_LINK_FAILED) {
+                failAttempt(now, "rejected");
+            } else if (now - stateEnteredAt >= ConfigStore::get(CONFIG_WIFI_TIMEOUT)) {
+                failAttempt(now, "timeout");
+            }
+            break;
+
+        case WIFI_STATE_CONNECTED:
+            if (link != RADIO_LINK_UP || (events & EVENT_DISCONNECTED)) {
+                LOG_WARN("WiFi connection lost!");
+                if (autoReconnect) {
+                    startAttempt(now);
+                } else {
+                    enterState(WIFI_STATE_IDLE, now);
+                }
+            }
+            break;
+
+        case WIFI_STATE_BACKOFF:
+            if (now - stateEnteredAt >= retryDelay) {
+                startAttempt(now);
+            }
+            break;
     }
 }
 
-bool WiFiManager::isConnected() {
-    return connected && WiFi.status() == WL_CONNECTED;
+void WiFiManager::enterState(WiFiState newState, unsigned long now) {
+    state = newState;
+    stateEnteredAt = now;
 }
 
-String WiFiManager::getIPAddress() {
-    if (isConnected()) {
-        return WiFi.localIP().toString();
-    }
-    return "Not connected";
-}
+void WiFiManager::startAttempt(unsigned long now) {
+    LOG_INFO("Connecting to WiFi...");
+    LOG_INFO("SSID: %s", WIFI_SSID);
 
-String WiFiManager::getMACAddress() {
-    return WiFi.macAddress();
+    // Drop events left over from the previous attempt
+    pendingEvents = 0;
+    connectionAttempts++;
+    radio->begin(WIFI_SSID, WIFI_PASSWORD);
+    enterState(WIFI_STATE_CONNECTING, now);
 }
 
-int WiFiManager::getRSSI() {
-    if (isConnected()) {
-        return WiFi.RSSI();
-    }
-    return 0;
-}
+void WiFiManager::failAttempt(unsigned long now, const char* reason) {
+    radio->disconnect();
+    backoff.configure(ConfigStore::get(CONFIG_WIFI_BACKOFF_BASE), ConfigStore::get(CONFIG_WIFI_BACKOFF_MAX));
+    retryDelay = backoff.nextDelay();
+    enterState(WIFI_STATE_BACKOFF, now);
 
-String WiFiManager::getSSID() {
-    if (isConnected()) {
-        return WiFi.SSID();
-    }
-    return "Not connected";
+    LOG_WARN("WiFi connection failed (%s), attempt %d. Retrying in %lu ms",
+             reason, connectionAttempts, (unsigned long)retryDelay);
 }
 
-#else
+void WiFiManager::onRadioEvent(WiFiRadioEvent event) {
+    // Called from the WiFi event task; the state machine picks it up on the next pass
+    __atomic_fetch_or(&pendingEvents, 1u << event, __ATOMIC_RELAXED);
+    Scheduler::trigger(loopTaskId);
+}
 
-// Static member definitions for native/unit-test builds
-bool WiFiManager::connected = false;
-unsigned long WiFiManager::lastConnectionAttempt = 0;
-int WiFiManager::connectionAttempts = 0;
+void WiFiManager::setRadio(WiFiRadio* newRadio) {
+    radio = newRadio;
+}
 
-void WiFiManager::init() {}
+WiFiState WiFiManager::getState() {
+    return state;
+}
 
-void WiFiManager::connect() {}
+const char* WiFiManager::getStateName() {
+    switch (state) {
+        case WIFI_STATE_IDLE:       return "idle";
+        case WIFI_STATE_CONNECTING: return "connecting";
+        case WIFI_STATE_CONNECTED:  return "connected";
+        case WIFI_STATE_BACKOFF:    return "backoff";
+    }
+    return "unknown";
+}
 
-void WiFiManager::disconnect() {}
+int WiFiManager::getConnectionAttempts() {
+    return connectionAttempts;
+}
 
-void WiFiManager::loop() {}
+unsigned long WiFiManager::getRetryDelay() {
+    return retryDelay;
+}
 
 bool WiFiManager::isConnected() {
-    return false;
+    return state == WIFI_STATE_CONNECTED && radio->status() == RADIO_LINK_UP;
 }
 
 String WiFiManager::getIPAddress() {
+    if (isConnected()) {
+        return radio->localIP();
+    }
     return "Not connected";
 }
 
 String WiFiManager::getMACAddress() {
-    return "00:00:00:00:00:00";
+    return radio->macAddress();
 }
 
 int WiFiManager::getRSSI() {
+    if (isConnected()) {
+        return radio->rssi();
+    }
     return 0;
 }
 
 String WiFiManager::getSSID() {
+    if (isConnected()) {
+        return radio->ssid();
+    }
     return "Not connected";
 }
-
-#endif
@@ -0,0 +1,141 @@
+#include "wifi_radio.h"
+
+#ifdef ARDUINO
+#include <WiFi.h>
+#include <esp_random.h>
+
+static WiFiRadioEventHandler radioEventHandler = nullptr;
+
+// Runs in the WiFi event task; only forwards the event
+static void onArduinoWiFiEvent(arduino_event_id_t event) {
+    if (radioEventHandler == nullptr) {
+        return;
+    }
+    if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+        radioEventHandler(RADIO_EVENT_GOT_IP);
+    } else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        radioEventHandler(RADIO_EVENT_DISCONNECTED);
+    }
+}
+
+void ArduinoWiFiRadio::setStationMode() {
+    WiFi.mode(WIFI_STA);
+}
+
+void ArduinoWiFiRadio::begin(const char* ssid, const char* password) {
+    WiFi.begin(ssid, password);
+}
+
+void ArduinoWiFiRadio::disconnect() {
+    WiFi.disconnect();
+}
+
+WiFiLinkStatus ArduinoWiFiRadio::status() {
+    switch (WiFi.status()) {
+        case WL_CONNECTED:
+            return RADIO_LINK_UP;
+        case WL_CONNECT_FAILED:
+        case WL_NO_SSID_AVAIL:
+            return RADIO_LINK_FAILED;
+        default:
+            return RADIO_LINK_DOWN;
+    }
+}
+
+void ArduinoWiFiRadio::setEventHandler(WiFiRadioEventHandler handler) {
+    static bool registered = false;
+    radioEventHandler = handler;
+    if (!registered) {
+        WiFi.onEvent(onArduinoWiFiEvent);
+        registered = true;
+    }
+}
+
+uint32_t ArduinoWiFiRadio::randomSeed() {
+    return esp_random();
+}
+
+String ArduinoWiFiRadio::localIP() {
+    return WiFi.localIP().toString();
+}
+
+String ArduinoWiFiRadio::macAddress() {
+    return WiFi.macAddress();
+}
+
+int ArduinoWiFiRadio::rssi() {
+    return WiFi.RSSI();
+}
+
+String ArduinoWiFiRadio::ssid() {
+    return WiFi.SSID();
+}
+
+#else
+
+FakeWiFiRadio::FakeWiFiRadio()
+    : linkStatus(RADIO_LINK_DOWN), eventHandler(nullptr), beginCount(0), disconnectCount(0) {}
+
+void FakeWiFiRadio::reset() {
+    linkStatus = RADIO_LINK_DOWN;
+    connectedSsid = "";
+    beginCount = 0;
+    disconnectCount = 0;
+}
+
+void FakeWiFiRadio::setLinkStatus(WiFiLinkStatus status) {
+    linkStatus = status;
+}
+
+void FakeWiFiRadio::emit(WiFiRadioEvent event) {
+    if (event == RADIO_EVENT_GOT_IP) {
+        linkStatus = RADIO_LINK_UP;
+    } else if (linkStatus == RADIO_LINK_UP) {
+        linkStatus = RADIO_LINK_DOWN;
+    }
+    if (eventHandler != nullptr) {
+        eventHandler(event);
+    }
+}
+
+void FakeWiFiRadio::setStationMode() {}
+
+void FakeWiFiRadio::begin(const char* ssid, const char* /*password*/) {
+    beginCount++;
+    connectedSsid = ssid;
+}
+
+void FakeWiFiRadio::disconnect() {
+    disconnectCount++;
+    linkStatus = RADIO_LINK_DOWN;
+}
+
+WiFiLinkStatus FakeWiFiRadio::status() {
+    return linkStatus;
+}
+
+void FakeWiFiRadio::setEventHandler(WiFiRadioEventHandler handler) {
+    eventHandler = handler;
+}
+
+uint32_t FakeWiFiRadio::randomSeed() {
+    return 1; // deterministic backoff jitter
+}
+
+String FakeWiFiRadio::localIP() {
+    return "192.168.4.2";
+}
+
+String FakeWiFiRadio::macAddress() {
+    return "00:00:00:00:00:00";
+}
+
+int FakeWiFiRadio::rssi() {
+    return -55;
+}
+
+String FakeWiFiRadio::ssid() {
+    return connectedSsid;
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include <unity.h>
+#include "../../include/ble_connections.h"
+
+static BLEConnectionTable table;
+
+void setUp(void) {
+    table.clear();
+}
+
+void tearDown(void) {
+}
+
+// Test that the budget allows a burst, then one notification per refill period
+void test_budget_burst_and_refill() {
+    NotifyBudget budget;
+    budget.reset(3, 20, 1000);
+    TEST_ASSERT_TRUE(budget.take(1000));
+    TEST_ASSERT_TRUE(budget.take(1000));
+    TEST_ASSERT_TRUE(budget.take(1000));
+    TEST_ASSERT_FALSE(budget.take(1000));
+    TEST_ASSERT_FALSE(budget.take(1019));
+    TEST_ASSERT_TRUE(budget.take(1020));
+    TEST_ASSERT_FALSE(budget.take(1030));
+
+    // Partial periods carry over instead of being lost
+    TEST_ASSERT_TRUE(budget.take(1040));
+
+    // A long idle refills to the burst size, not beyond
+    TEST_ASSERT_EQUAL_UINT16(3, budget.available(100000));
+}
+
+// Test that the budget survives millis() wraparound
+void test_budget_wraparound() {
+    NotifyBudget budget;
+    budget.reset(2, 10, 0xFFFFFFF0u);
+    budget.take(0xFFFFFFF0u);
+    budget.take(0xFFFFFFF0u);
+    TEST_ASSERT_FALSE(budget.take(0xFFFFFFF5u));
+    TEST_ASSERT_TRUE(budget.take(0x00000000u));
+}
+
+// Test slot allocation, lookup and release
+void test_table_add_remove() {
+    TEST_ASSERT_EQUAL(0, table.count());
+    BLEConnection* first = table.add(1, 0);
+    BLEConnection* second = table.add(7, 0);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_NOT_NULL(second);
+    TEST_ASSERT_TRUE(first != second);
+    TEST_ASSERT_TRUE(table.add(1, 0) == first);
+    TEST_ASSERT_EQUAL(2, table.count());
+    TEST_ASSERT_EQUAL_UINT16(BLEConnectionTable::DEFAULT_MTU, first->mtu);
+    TEST_ASSERT_EQUAL_UINT32(BLE_NO_SEQUENCE, first->lastNotifiedSeq);
+
+    TEST_ASSERT_TRUE(table.remove(1));
+    TEST_ASSERT_FALSE(table.remove(1));
+    TEST_ASSERT_NULL(table.find(1));
+    TEST_ASSERT_TRUE(table.find(7) == second);
+    TEST_ASSERT_NULL(table.add(BLE_CONN_HANDLE_INVALID, 0));
+}
+
+// Test that the table refuses peers beyond its slots
+void test_table_full() {
+    for (int i = 0; i < BLEConnectionTable::MAX_CONNECTIONS; i++) {
+        TEST_ASSERT_NOT_NULL(table.add((uint16_t)(i + 1), 0));
+    }
+    TEST_ASSERT_NULL(table.add(100, 0));
+    table.remove(1);
+    TEST_ASSERT_NOT_NULL(table.add(100, 0));
+}
+
+// Test per-connection subscription bits and MTU
+void test_table_subscriptions() {
+    table.add(1, 0);
+    table.add(2, 0);
+    TEST_ASSERT_TRUE(table.setSubscribed(1, NOTIFY_TEMP_PACKED, true));
+    TEST_ASSERT_TRUE(table.setSubscribed(2, NOTIFY_TEMP_PACKED, true));
+    TEST_ASSERT_TRUE(table.setSubscribed(2, NOTIFY_HISTORY, true));
+    TEST_ASSERT_FALSE(table.setSubscribed(3, NOTIFY_HISTORY, true));
+    TEST_ASSERT_EQUAL(2, table.countSubscribed(NOTIFY_TEMP_PACKED));
+    TEST_ASSERT_EQUAL(1, table.countSubscribed(NOTIFY_HISTORY));
+
+    table.setSubscribed(2, NOTIFY_TEMP_PACKED, false);
+    TEST_ASSERT_FALSE(table.find(2)->isSubscribed(NOTIFY_TEMP_PACKED));
+    TEST_ASSERT_TRUE(table.find(2)->isSubscribed(NOTIFY_HISTORY));
+
+    TEST_ASSERT_TRUE(table.setMTU(2, 185));
+    TEST_ASSERT_EQUAL_UINT16(185, table.find(2)->mtu);
+    TEST_ASSERT_EQUAL_UINT16(BLEConnectionTable::DEFAULT_MTU, table.find(1)->mtu);
+
+    // A reused slot starts clean
+    table.remove(2);
+    table.add(9, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, table.find(9)->subscriptions);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_budget_burst_and_refill);
+    RUN_TEST(test_budget_wraparound);
+    RUN_TEST(test_table_add_remove);
+    RUN_TEST(test_table_full);
+    RUN_TEST(test_table_subscriptions);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -1,61 +0,0 @@
-#include <unity.h>
-//#include <Arduino.h>
-#include "../src/ble_server.h"
-
-// Test that the BLE server can be initialized
-void test_ble_server_init() {
-    // This would normally initialize the BLE stack
-    // For unit tests, we'd need to mock the NimBLE functions
-    TEST_ASSERT_TRUE(true); // Placeholder
-}
-
-// Test that device name is correctly set
-void test_device_name() {
-    String deviceName = DEVICE_NAME;
-    TEST_ASSERT_EQUAL_STRING("ESP32-S3-BLE-Device", deviceName.c_str());
-}
-
-// Test that UUIDs are valid format
-void test_uuid_format() {
-    String serviceUUID = SERVICE_UUID;
-    String charUUID = CHARACTERISTIC_UUID;
-    
-    // Basic UUID format validation (length check)
-    TEST_ASSERT_EQUAL(36, serviceUUID.length());
-    TEST_ASSERT_EQUAL(36, charUUID.length());
-    
-    // Check for dashes in correct positions
-    TEST_ASSERT_EQUAL('-', serviceUUID[8]);
-    TEST_ASSERT_EQUAL('-', serviceUUID[13]);
-    TEST_ASSERT_EQUAL('-', serviceUUID[18]);
-    TEST_ASSERT_EQUAL('-', serviceUUID[23]);
-}
-
-// Test connection status management
-void test_connection_status() {
-    // Initially should not be connected
-    TEST_ASSERT_FALSE(BLEServerManager::isConnected());
-}
-
-void setUp(void) {
-    // Set up test environment
-}
-
-void tearDown(void) {
-    // Clean up after tests
-}
-
-void setup() {
-    delay(2000); // Wait for serial
-    
-    UNITY_BEGIN();
-    RUN_TEST(test_device_name);
-    RUN_TEST(test_uuid_format);
-    RUN_TEST(test_connection_status);
-    RUN_TEST(test_ble_server_init);
-    UNITY_END();
-}
-
-void loop() {
-    // Nothing to do in loop for tests
-}
\ No newline at end of file
@@ -0,0 +1,476 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/ble_server.h"
+#include "../../include/temperature_service.h"
+#include "../../include/history_codec.h"
+#include "../../include/scheduler.h"
+#include <string.h>
+
+// Test that device name is correctly set
+void test_device_name() {
+    String deviceName = DEVICE_NAME;
+    TEST_ASSERT_EQUAL_STRING("ESP32-S3-BLE-Device", deviceName.c_str());
+}
+
+// Test that UUIDs are valid format
+void test_uuid_format() {
+    String serviceUUID = SERVICE_UUID;
+    String charUUID = CHARACTERISTIC_UUID;
+
+    // Basic UUID format validation (length check)
+    TEST_ASSERT_EQUAL(36, serviceUUID.length());
+    TEST_ASSERT_EQUAL(36, charUUID.length());
+
+    // Check for dashes in correct positions
+    TEST_ASSERT_EQUAL('-', serviceUUID[8]);
+    TEST_ASSERT_EQUAL('-', serviceUUID[13]);
+    TEST_ASSERT_EQUAL('-', serviceUUID[18]);
+    TEST_ASSERT_EQUAL('-', serviceUUID[23]);
+}
+
+// The device name and UUID checks run everywhere; the rest drive the fake
+// NimBLE stack from sim/ and only build natively
+#ifndef ARDUINO
+#include "sim_ble.h"
+
+// Test that the BLE server can be initialized
+void test_ble_server_init() {
+    BLEServerManager::init();
+
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+    TEST_ASSERT_NOT_NULL(SimBLE::findCharacteristic(CHARACTERISTIC_UUID));
+    TEST_ASSERT_NOT_NULL(SimBLE::findCharacteristic(TEMPERATURE_CHAR_UUID));
+    TEST_ASSERT_NOT_NULL(SimBLE::findCharacteristic(TEMP_MAX_CHAR_UUID));
+    TEST_ASSERT_NOT_NULL(SimBLE::findCharacteristic(TEMP_MIN_CHAR_UUID));
+    TEST_ASSERT_NOT_NULL(SimBLE::findCharacteristic(TEMP_CONFIG_CHAR_UUID));
+    TEST_ASSERT_NOT_NULL(SimBLE::findCharacteristic(TEMP_HISTORY_CHAR_UUID));
+    TEST_ASSERT_NOT_NULL(SimBLE::findCharacteristic(TEMP_PACKED_CHAR_UUID));
+}
+
+// Test connection status management
+void test_connection_status() {
+    // Initially should not be connected
+    TEST_ASSERT_FALSE(BLEServerManager::isConnected());
+
+    BLEServerManager::init();
+    uint16_t conn = SimBLE::connect(247);
+    TEST_ASSERT_NOT_EQUAL(BLE_HS_CONN_HANDLE_NONE, conn);
+    TEST_ASSERT_TRUE(BLEServerManager::isConnected());
+    TEST_ASSERT_EQUAL_UINT16(247, BLEServerManager::getPeerMTU(conn));
+
+    // The server keeps advertising so further clients can connect
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+    SimBLE::disconnect(conn);
+    TEST_ASSERT_FALSE(BLEServerManager::isConnected());
+    TEST_ASSERT_EQUAL_UINT16(0, BLEServerManager::getPeerMTU(conn));
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+}
+
+// Test that peers connect and disconnect independently, up to the slot limit
+void test_multiple_connections() {
+    BLEServerManager::init();
+    uint16_t first = SimBLE::connect(247);
+    uint16_t second = SimBLE::connect(23);
+    TEST_ASSERT_EQUAL(2, BLEServerManager::getConnectionCount());
+    TEST_ASSERT_EQUAL_UINT16(247, BLEServerManager::getPeerMTU(first));
+    TEST_ASSERT_EQUAL_UINT16(BLE_DEFAULT_MTU, BLEServerManager::getPeerMTU(second));
+
+    SimBLE::subscribe(first, TEMP_PACKED_CHAR_UUID);
+    SimBLE::subscribe(second, TEMP_PACKED_CHAR_UUID);
+
+    // One peer leaving does not disconnect the other
+    SimBLE::disconnect(first);
+    TEST_ASSERT_TRUE(BLEServerManager::isConnected());
+    TEST_ASSERT_EQUAL(1, BLEServerManager::getConnectionCount());
+    TEST_ASSERT_TRUE(BLEServerManager::isSubscribed(second, NOTIFY_TEMP_PACKED));
+
+    // Fill every slot; the controller stops advertising when none are left
+    for (int i = 1; i < BLEConnectionTable::MAX_CONNECTIONS; i++) {
+        TEST_ASSERT_NOT_EQUAL(BLE_HS_CONN_HANDLE_NONE, SimBLE::connect());
+    }
+    TEST_ASSERT_EQUAL(BLEConnectionTable::MAX_CONNECTIONS, BLEServerManager::getConnectionCount());
+    TEST_ASSERT_FALSE(SimBLE::isAdvertising());
+    TEST_ASSERT_EQUAL_UINT16(BLE_HS_CONN_HANDLE_NONE, SimBLE::connect());
+
+    // A freed slot makes the device connectable again
+    SimBLE::disconnect(second);
+    Scheduler::runDue(NativeClock::now());
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+}
+
+// Notifications received per connection and characteristic
+static uint32_t received[8][4];
+
+static int characteristicIndex(const NimBLEUUID& uuid) {
+    if (uuid == NimBLEUUID(TEMP_PACKED_CHAR_UUID)) return 0;
+    if (uuid == NimBLEUUID(TEMPERATURE_CHAR_UUID)) return 1;
+    if (uuid == NimBLEUUID(CHARACTERISTIC_UUID)) return 2;
+    return 3;
+}
+
+static void countReceived(uint16_t connHandle, const NimBLEUUID& uuid, const uint8_t* data, size_t length) {
+    if (connHandle < 8) {
+        received[connHandle][characteristicIndex(uuid)]++;
+    }
+}
+
+// Test that each peer only receives the characteristics it subscribed to
+void test_notifications_follow_subscriptions() {
+    BLEServerManager::init();
+    memset(received, 0, sizeof(received));
+    SimBLE::setNotifyHandler(countReceived);
+
+    uint16_t packedOnly = SimBLE::connect(247);
+    uint16_t legacy = SimBLE::connect(247);
+    uint16_t counterOnly = SimBLE::connect(247);
+    SimBLE::subscribe(packedOnly, TEMP_PACKED_CHAR_UUID);
+    SimBLE::subscribe(legacy, TEMPERATURE_CHAR_UUID);
+    SimBLE::subscribe(counterOnly, CHARACTERISTIC_UUID);
+
+    for (int pass = 0; pass < 10; pass++) {
+        Scheduler::runDue(NativeClock::now());
+        NativeClock::advance(1000);
+    }
+
+    // The subscription brings the current reading straight away
+    TEST_ASSERT_TRUE(received[packedOnly][0] >= 1);
+    TEST_ASSERT_EQUAL_UINT32(0, received[packedOnly][1] + received[packedOnly][2]);
+    TEST_ASSERT_TRUE(received[legacy][1] >= 1);
+    TEST_ASSERT_EQUAL_UINT32(0, received[legacy][0] + received[legacy][2]);
+    TEST_ASSERT_TRUE(received[counterOnly][2] >= 3);
+    TEST_ASSERT_EQUAL_UINT32(0, received[counterOnly][0] + received[counterOnly][1]);
+    TEST_ASSERT_EQUAL_UINT32(TemperatureService::getSequence(),
+                             BLEServerManager::getLastNotifiedSequence(packedOnly));
+    TEST_ASSERT_EQUAL_UINT32(BLE_NO_SEQUENCE, BLEServerManager::getLastNotifiedSequence(counterOnly));
+
+    // Unsubscribing stops the flow to that peer only
+    SimBLE::subscribe(legacy, TEMPERATURE_CHAR_UUID, false);
+    uint32_t legacyBefore = received[legacy][1];
+    uint32_t packedBefore = received[packedOnly][0];
+    for (int pass = 0; pass < 40; pass++) {
+        Scheduler::runDue(NativeClock::now());
+        NativeClock::advance(1000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(legacyBefore, received[legacy][1]);
+    TEST_ASSERT_TRUE(received[packedOnly][0] > packedBefore);
+}
+
+// Test that config writes change the unit and the notification policy
+void test_config_write() {
+    BLEServerManager::init();
+    uint16_t conn = SimBLE::connect();
+    SimBLE::pair(conn);
+
+    uint8_t config[1 + NOTIFY_POLICY_CONFIG_SIZE] = {FAHRENHEIT};
+    NotifyPolicyConfig policy = {50, 0, 2000, 60000};
+    NotifyPolicy::encodeConfig(policy, config + 1, NOTIFY_POLICY_CONFIG_SIZE);
+    TEST_ASSERT_TRUE(SimBLE::write(conn, TEMP_CONFIG_CHAR_UUID, config, sizeof(config)));
+
+    TEST_ASSERT_EQUAL(FAHRENHEIT, TemperatureService::getUnit());
+    TEST_ASSERT_EQUAL_UINT16(50, BLEServerManager::getNotifyPolicy().absoluteDeadband);
+    TEST_ASSERT_EQUAL_UINT32(60000, BLEServerManager::getNotifyPolicy().maxInterval);
+
+    // The readable value reflects the new settings
+    std::string value;
+    TEST_ASSERT_TRUE(SimBLE::read(conn, TEMP_CONFIG_CHAR_UUID, value));
+    TEST_ASSERT_EQUAL(sizeof(config), value.size());
+    TEST_ASSERT_EQUAL_MEMORY(config, value.data(), sizeof(config));
+
+    const uint8_t celsius = CELSIUS;
+    SimBLE::write(conn, TEMP_CONFIG_CHAR_UUID, &celsius, 1);
+    TEST_ASSERT_EQUAL(CELSIUS, TemperatureService::getUnit());
+    TEST_ASSERT_EQUAL_UINT16(50, BLEServerManager::getNotifyPolicy().absoluteDeadband);
+}
+
+// Test that the config characteristic applies valid writes and rejects invalid ones whole
+void test_config_characteristic() {
+    BLEServerManager::init();
+    uint16_t conn = SimBLE::connect();
+    SimBLE::pair(conn);
+
+    // [version][tag 3: absolute deadband][tag 6: max interval]
+    const uint8_t write[] = {
+        CONFIG_FORMAT_VERSION,
+        3, 2, 0x4B, 0x00,
+        6, 4, 0x60, 0xEA, 0x00, 0x00,
+    };
+    TEST_ASSERT_TRUE(SimBLE::write(conn, CONFIG_CHAR_UUID, write, sizeof(write)));
+    TEST_ASSERT_EQUAL_UINT16(75, BLEServerManager::getNotifyPolicy().absoluteDeadband);
+    TEST_ASSERT_EQUAL_UINT32(60000, BLEServerManager::getNotifyPolicy().maxInterval);
+
+    // Reads return every setting but the passkey
+    std::string before;
+    TEST_ASSERT_TRUE(SimBLE::read(conn, CONFIG_CHAR_UUID, before));
+    uint8_t expected[CONFIG_MAX_ENCODED_SIZE];
+    size_t length = ConfigStore::encode(expected, sizeof(expected));
+    TEST_ASSERT_EQUAL(length, before.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected, before.data(), length);
+
+    // Min interval above max: nothing changes and the readable value is restored
+    const uint8_t invalid[] = {
+        CONFIG_FORMAT_VERSION,
+        3, 2, 0x05, 0x00,
+        5, 4, 0x70, 0x11, 0x01, 0x00,
+    };
+    SimBLE::write(conn, CONFIG_CHAR_UUID, invalid, sizeof(invalid));
+    TEST_ASSERT_EQUAL_UINT16(75, BLEServerManager::getNotifyPolicy().absoluteDeadband);
+    std::string after;
+    TEST_ASSERT_TRUE(SimBLE::read(conn, CONFIG_CHAR_UUID, after));
+    TEST_ASSERT_TRUE(before == after);
+
+    // The legacy characteristic follows changes made through the new one
+    std::string legacy;
+    TEST_ASSERT_TRUE(SimBLE::read(conn, TEMP_CONFIG_CHAR_UUID, legacy));
+    NotifyPolicyConfig policy;
+    TEST_ASSERT_TRUE(NotifyPolicy::decodeConfig((const uint8_t*)legacy.data() + 1, legacy.size() - 1, policy));
+    TEST_ASSERT_EQUAL_UINT16(75, policy.absoluteDeadband);
+    ConfigStore::resetToDefaults();
+}
+
+// Test that only a passkey-paired link can change settings, the passkey above all
+void test_config_write_needs_authentication() {
+    BLEServerManager::init();
+    uint16_t conn = SimBLE::connect();
+
+    // [version][tag 10: passkey 111111]
+    const uint8_t passkey[] = { CONFIG_FORMAT_VERSION, 10, 4, 0x07, 0xB2, 0x01, 0x00 };
+    const uint8_t fahrenheit = FAHRENHEIT;
+    TEST_ASSERT_FALSE(SimBLE::write(conn, CONFIG_CHAR_UUID, passkey, sizeof(passkey)));
+    TEST_ASSERT_FALSE(SimBLE::write(conn, TEMP_CONFIG_CHAR_UUID, &fahrenheit, 1));
+    SimBLE::pair(conn, false);
+    TEST_ASSERT_FALSE(SimBLE::write(conn, CONFIG_CHAR_UUID, passkey, sizeof(passkey)));
+    TEST_ASSERT_EQUAL_UINT32(BLE_PASSKEY, ConfigStore::get(CONFIG_BLE_PASSKEY));
+    TEST_ASSERT_EQUAL(CELSIUS, TemperatureService::getUnit());
+
+    // Should a write get past the stack, the store still refuses the passkey
+    ble_gap_conn_desc desc;
+    TEST_ASSERT_TRUE(SimBLE::getConnDesc(conn, desc));
+    NimBLECharacteristic* characteristic = SimBLE::findCharacteristic(CONFIG_CHAR_UUID);
+    characteristic->setValue(passkey, sizeof(passkey));
+    characteristic->getCallbacks()->onWrite(characteristic, &desc);
+    TEST_ASSERT_EQUAL_UINT32(BLE_PASSKEY, ConfigStore::get(CONFIG_BLE_PASSKEY));
+
+    SimBLE::pair(conn);
+    TEST_ASSERT_TRUE(SimBLE::write(conn, CONFIG_CHAR_UUID, passkey, sizeof(passkey)));
+    TEST_ASSERT_EQUAL_UINT32(111111, ConfigStore::get(CONFIG_BLE_PASSKEY));
+    ConfigStore::resetToDefaults();
+}
+
+static uint32_t historyFrames = 0;
+static uint32_t historySamples = 0;
+static bool historyComplete = false;
+
+static void collectHistory(uint16_t connHandle, const NimBLEUUID& uuid, const uint8_t* data, size_t length) {
+    if (uuid != NimBLEUUID(TEMP_HISTORY_CHAR_UUID)) {
+        return;
+    }
+    HistoryFrameHeader header;
+    HistorySample samples[255];
+    int count = HistoryFrameDecoder::decode(data, length, header, samples, 255);
+    TEST_ASSERT_TRUE(count >= 0);
+    historyFrames++;
+    historySamples += count;
+    if (header.flags & HISTORY_FLAG_LAST) {
+        historyComplete = true;
+    }
+}
+
+// Test that a history dump streams every stored sample within the MTU
+void test_history_dump() {
+    for (int i = 0; i < 200; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::sample();
+    }
+    BLEServerManager::init();
+    uint16_t conn = SimBLE::connect(23);
+    SimBLE::subscribe(conn, TEMP_HISTORY_CHAR_UUID);
+
+    historyFrames = 0;
+    historySamples = 0;
+    historyComplete = false;
+    SimBLE::setNotifyHandler(collectHistory);
+    const uint8_t fromStart[4] = {0, 0, 0, 0};
+    SimBLE::write(conn, TEMP_HISTORY_CHAR_UUID, fromStart, sizeof(fromStart));
+
+    for (int pass = 0; pass < 100 && !historyComplete; pass++) {
+        Scheduler::runDue(NativeClock::now());
+        NativeClock::advance(20);
+    }
+    TEST_ASSERT_TRUE(historyComplete);
+    TEST_ASSERT_EQUAL_UINT32(TemperatureService::getHistory().size(), historySamples);
+    TEST_ASSERT_TRUE(historyFrames > 1);
+}
+
+static uint32_t framesTo[8];
+
+static void countHistoryFrames(uint16_t connHandle, const NimBLEUUID& uuid, const uint8_t* data, size_t length) {
+    if (uuid == NimBLEUUID(TEMP_HISTORY_CHAR_UUID) && connHandle < 8) {
+        framesTo[connHandle]++;
+    }
+}
+
+// Test that a dump goes only to the requesting peer, paced by its notify budget
+void test_history_dump_per_connection() {
+    for (int i = 0; i < 2000; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::sample();
+    }
+    BLEServerManager::init();
+    uint16_t requester = SimBLE::connect(23);
+    uint16_t bystander = SimBLE::connect(23);
+    SimBLE::subscribe(requester, TEMP_HISTORY_CHAR_UUID);
+    SimBLE::subscribe(bystander, TEMP_HISTORY_CHAR_UUID);
+    SimBLE::subscribe(bystander, TEMP_PACKED_CHAR_UUID);
+
+    memset(framesTo, 0, sizeof(framesTo));
+    SimBLE::setNotifyHandler(countHistoryFrames);
+    const uint8_t fromStart[4] = {0, 0, 0, 0};
+    SimBLE::write(requester, TEMP_HISTORY_CHAR_UUID, fromStart, sizeof(fromStart));
+
+    // Run one second of 20 ms passes; the budget caps the frame rate
+    uint32_t start = NativeClock::now();
+    while (NativeClock::now() - start < 1000) {
+        Scheduler::runDue(NativeClock::now());
+        NativeClock::advance(20);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, framesTo[bystander]);
+    TEST_ASSERT_TRUE(framesTo[requester] > 10);
+    TEST_ASSERT_LESS_OR_EQUAL(BLEConnectionTable::NOTIFY_BURST + 1000 / BLEConnectionTable::NOTIFY_REFILL_MS,
+                              framesTo[requester]);
+
+    // The other peer still gets its temperature updates during the dump
+    TEST_ASSERT_NOT_EQUAL(BLE_NO_SEQUENCE, BLEServerManager::getLastNotifiedSequence(bystander));
+}
+
+static uint32_t rollupPoints = 0;
+static uint8_t rollupTier = TIER_RAW;
+
+static void collectRollup(uint16_t connHandle, const NimBLEUUID& uuid, const uint8_t* data, size_t length) {
+    if (uuid != NimBLEUUID(TEMP_HISTORY_CHAR_UUID)) {
+        return;
+    }
+    RollupFrameHeader header;
+    RollupPoint points[255];
+    int count = RollupFrameDecoder::decode(data, length, header, points, 255);
+    TEST_ASSERT_TRUE(count >= 0);
+    rollupTier = header.tier;
+    rollupPoints += count;
+    if (header.flags & HISTORY_FLAG_LAST) {
+        historyComplete = true;
+    }
+}
+
+// Test that a range request is served from the tier the selector picks
+void test_history_range_request() {
+    for (int i = 0; i < 3000; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::sample();
+    }
+    BLEServerManager::init();
+    uint16_t conn = SimBLE::connect(23);
+    SimBLE::subscribe(conn, TEMP_HISTORY_CHAR_UUID);
+
+    rollupPoints = 0;
+    rollupTier = TIER_RAW;
+    historyComplete = false;
+    SimBLE::setNotifyHandler(collectRollup);
+    // The last 24 hours (86400 s) in at most 200 points
+    const uint8_t lastDay[6] = {0x80, 0x51, 0x01, 0x00, 200, 0};
+    SimBLE::write(conn, TEMP_HISTORY_CHAR_UUID, lastDay, sizeof(lastDay));
+
+    for (int pass = 0; pass < 100 && !historyComplete; pass++) {
+        Scheduler::runDue(NativeClock::now());
+        NativeClock::advance(20);
+    }
+    HistorySelection expected = HistoryTierSelector::select(TemperatureService::getHistory(),
+                                                            TemperatureService::getRollup(), 86400000UL, 200);
+    TEST_ASSERT_TRUE(historyComplete);
+    TEST_ASSERT_EQUAL(TIER_15_MIN, expected.tier);
+    TEST_ASSERT_EQUAL(expected.tier, rollupTier);
+    TEST_ASSERT_EQUAL_UINT32(expected.points, rollupPoints);
+}
+
+static void runScheduler(uint32_t durationMs) {
+    uint32_t end = NativeClock::now() + durationMs;
+    while ((int32_t)(NativeClock::now() - end) < 0) {
+        Scheduler::runDue(NativeClock::now());
+        NativeClock::advance(100);
+    }
+}
+
+// Test that a disconnect while an advertising restart is queued still falls back to slow
+void test_fast_advertising_times_out_after_quick_disconnect() {
+    BLEServerManager::init();
+    runScheduler(BLEServerManager::FAST_ADVERTISING_TIME + 1000);
+    TEST_ASSERT_EQUAL(ADVERTISING_SLOW, BLEServerManager::getAdvertisingMode());
+
+    // The controller does not resume advertising after the connect, so the
+    // next pass queues "ble-adv", reusing the slot of the finished fall-back
+    uint16_t conn = SimBLE::connect(247);
+    NimBLEDevice::getAdvertising()->stop();
+    BLEServerManager::loop();
+
+    // The central leaves before the restart ran
+    NativeClock::advance(200);
+    SimBLE::disconnect(conn);
+    BLEServerManager::loop();
+    TEST_ASSERT_EQUAL(ADVERTISING_FAST, BLEServerManager::getAdvertisingMode());
+
+    runScheduler(BLEServerManager::FAST_ADVERTISING_TIME + 1000);
+    TEST_ASSERT_EQUAL(ADVERTISING_SLOW, BLEServerManager::getAdvertisingMode());
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+}
+
+void setUp(void) {
+    SimBLE::reset();
+    Scheduler::reset();
+    NativeClock::set(0);
+    TemperatureService::init();
+    TemperatureService::setUnit(CELSIUS);
+}
+
+void tearDown(void) {
+    SimBLE::reset();
+}
+#else
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+#endif
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_device_name);
+    RUN_TEST(test_uuid_format);
+#ifndef ARDUINO
+    RUN_TEST(test_connection_status);
+    RUN_TEST(test_multiple_connections);
+    RUN_TEST(test_notifications_follow_subscriptions);
+    RUN_TEST(test_ble_server_init);
+    RUN_TEST(test_config_write);
+    RUN_TEST(test_config_characteristic);
+    RUN_TEST(test_config_write_needs_authentication);
+    RUN_TEST(test_history_dump);
+    RUN_TEST(test_history_dump_per_connection);
+    RUN_TEST(test_history_range_request);
+    RUN_TEST(test_fast_advertising_times_out_after_quick_disconnect);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do in loop for tests
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
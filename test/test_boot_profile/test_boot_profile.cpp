@@ -0,0 +1,104 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/boot_profile.h"
+
+// Budget from reset to advertising for a fast start
+static const uint32_t ADVERTISING_BUDGET_US = 300000;
+
+// Test that a phase keeps the time it was first marked
+void test_first_mark_wins() {
+    uint32_t at = 0;
+    TEST_ASSERT_FALSE(BootProfile::getTime(BOOT_CONFIG, at));
+
+    NativeClock::set(12);
+    BootProfile::mark(BOOT_CONFIG);
+    NativeClock::set(40);
+    BootProfile::mark(BOOT_CONFIG);
+
+    TEST_ASSERT_TRUE(BootProfile::isReached(BOOT_CONFIG));
+    TEST_ASSERT_TRUE(BootProfile::getTime(BOOT_CONFIG, at));
+    TEST_ASSERT_EQUAL_UINT32(12000, at);
+    TEST_ASSERT_FALSE(BootProfile::isReached(BOOT_SETUP));
+    TEST_ASSERT_FALSE(BootProfile::isReached(BOOT_PHASE_COUNT));
+
+    BootProfile::reset();
+    TEST_ASSERT_FALSE(BootProfile::isReached(BOOT_CONFIG));
+    BootProfile::printReport();
+}
+
+#ifndef ARDUINO
+#include "../../include/scheduler.h"
+#include "../../include/wifi_manager.h"
+#include "sim_ble.h"
+#include "simulator.h"
+
+static uint32_t timeOf(BootPhase phase) {
+    uint32_t at = 0;
+    TEST_ASSERT_TRUE_MESSAGE(BootProfile::getTime(phase, at), BootProfile::getName(phase));
+    return at;
+}
+
+// Test that a simulated boot advertises within budget, before WiFi starts
+void test_simulated_boot_advertises_first() {
+    Simulator::begin();
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+    uint32_t advertising = timeOf(BOOT_ADVERTISING);
+    TEST_ASSERT_TRUE(advertising <= ADVERTISING_BUDGET_US);
+    TEST_ASSERT_TRUE(timeOf(BOOT_CONFIG) <= advertising);
+    TEST_ASSERT_TRUE(advertising <= timeOf(BOOT_SENSORS));
+    // The network lane starts WiFi only once setup() returned
+    TEST_ASSERT_FALSE(BootProfile::isReached(BOOT_WIFI_START));
+
+    Simulator::runFor(10 * Simulator::SECOND);
+    TEST_ASSERT_TRUE(timeOf(BOOT_SETUP_DONE) <= timeOf(BOOT_WIFI_START));
+    TEST_ASSERT_TRUE(timeOf(BOOT_FIRST_SAMPLE) > 0);
+    TEST_ASSERT_TRUE(WiFiManager::isConnected());
+    TEST_ASSERT_TRUE(timeOf(BOOT_WIFI_START) + SimWiFiRadio::DEFAULT_ASSOCIATE_DELAY * 1000 <=
+                     timeOf(BOOT_WIFI_CONNECTED));
+
+    // Later connections do not move the boot figures
+    uint32_t connected = timeOf(BOOT_WIFI_CONNECTED);
+    Simulator::getRadio().setAccessPoint(false);
+    Simulator::runFor(Simulator::SECOND);
+    Simulator::getRadio().setAccessPoint(true);
+    Simulator::runFor(Simulator::MINUTE);
+    TEST_ASSERT_TRUE(WiFiManager::isConnected());
+    TEST_ASSERT_EQUAL_UINT32(connected, timeOf(BOOT_WIFI_CONNECTED));
+}
+#endif
+
+void setUp(void) {
+    Serial.setEnabled(false);
+    NativeClock::set(0);
+    BootProfile::reset();
+}
+
+void tearDown(void) {
+#ifndef ARDUINO
+    SimBLE::reset();
+#endif
+    Serial.setEnabled(true);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_mark_wins);
+#ifndef ARDUINO
+    RUN_TEST(test_simulated_boot_advertises_first);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
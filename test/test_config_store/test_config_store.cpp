@@ -0,0 +1,334 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/config_store.h"
+#include "../../include/scheduler.h"
+#include "../../include/temperature_service.h"
+#include "../../include/wifi_manager.h"
+#include "../../include/logger.h"
+#include <string.h>
+
+static MemoryConfigStorage storage;
+
+static ConfigKey changedKeys[CONFIG_KEY_COUNT * 2];
+static int changeCount = 0;
+
+static void recordChange(ConfigKey key, uint32_t value) {
+    if (changeCount < (int)(sizeof(changedKeys) / sizeof(changedKeys[0]))) {
+        changedKeys[changeCount] = key;
+    }
+    changeCount++;
+}
+
+static void processJob() {
+    TemperatureService::processSamples();
+}
+
+// Runs the firmware's jobs on the virtual clock, every lane on this thread
+static void runFor(uint32_t durationMs) {
+    uint32_t end = (uint32_t)millis() + durationMs;
+    while ((int32_t)(millis() - end) < 0) {
+        Scheduler::runDue();
+        Scheduler::sleepUntilNext(1000);
+    }
+}
+
+// A stored blob as an earlier firmware would have written it
+static size_t record(uint8_t* out, uint8_t tag, uint32_t value, uint8_t size) {
+    out[0] = tag;
+    out[1] = size;
+    for (uint8_t b = 0; b < size; b++) {
+        out[2 + b] = (uint8_t)(value >> (8 * b));
+    }
+    return CONFIG_RECORD_HEADER + size;
+}
+
+static void assertDefaults() {
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        TEST_ASSERT_EQUAL_UINT32(ConfigStore::getField((ConfigKey)i).defaultValue, ConfigStore::get((ConfigKey)i));
+    }
+}
+
+void setUp(void) {
+    Logger::reset();
+    Serial.setEnabled(false);
+    Scheduler::reset();
+    NativeClock::set(0);
+    storage.reset();
+    ConfigStore::setStorage(&storage);
+    ConfigStore::clearSubscribers();
+    ConfigStore::init();
+    changeCount = 0;
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+}
+
+// Test that every schema default lies in its own range, with unique tags
+void test_schema_is_consistent() {
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        const ConfigField& field = ConfigStore::getField((ConfigKey)i);
+        TEST_ASSERT_TRUE(field.defaultValue >= field.minValue);
+        TEST_ASSERT_TRUE(field.defaultValue <= field.maxValue);
+        TEST_ASSERT_TRUE(field.size == 1 || field.size == 2 || field.size == 4);
+        TEST_ASSERT_TRUE(field.size == 4 || field.maxValue < (1u << (8 * field.size)));
+        for (int j = 0; j < i; j++) {
+            TEST_ASSERT_NOT_EQUAL(ConfigStore::getField((ConfigKey)j).tag, field.tag);
+        }
+    }
+    assertDefaults();
+}
+
+// Test that out-of-range values and broken cross-field rules change nothing
+void test_validation_rejects_bad_values() {
+    TEST_ASSERT_FALSE(ConfigStore::set(CONFIG_TEMP_UNIT, 2));
+    TEST_ASSERT_FALSE(ConfigStore::set(CONFIG_SAMPLE_INTERVAL, 999));
+    TEST_ASSERT_FALSE(ConfigStore::set(CONFIG_BLE_PASSKEY, 1000000));
+    TEST_ASSERT_FALSE(ConfigStore::set(CONFIG_WIFI_BACKOFF_BASE, ConfigStore::get(CONFIG_WIFI_BACKOFF_MAX) + 1));
+    assertDefaults();
+    TEST_ASSERT_FALSE(ConfigStore::isDirty());
+
+    // A batch goes in whole or not at all
+    ConfigUpdate mixed[] = {
+        { CONFIG_SAMPLE_INTERVAL, 10000 },
+        { CONFIG_NOTIFY_MIN_INTERVAL, 5000 },
+        { CONFIG_NOTIFY_MAX_INTERVAL, 2000 },
+    };
+    TEST_ASSERT_FALSE(ConfigStore::apply(mixed, 3));
+    assertDefaults();
+
+    // Reordering min and max together is fine even though each alone is not
+    ConfigUpdate swap[] = {
+        { CONFIG_NOTIFY_MAX_INTERVAL, 600000 },
+        { CONFIG_NOTIFY_MIN_INTERVAL, 60000 },
+    };
+    TEST_ASSERT_TRUE(ConfigStore::apply(swap, 2));
+    TEST_ASSERT_EQUAL_UINT32(60000, ConfigStore::get(CONFIG_NOTIFY_MIN_INTERVAL));
+    TEST_ASSERT_EQUAL_UINT32(600000, ConfigStore::get(CONFIG_NOTIFY_MAX_INTERVAL));
+}
+
+// Test that subscribers hear about each changed setting once, and nothing else
+void test_subscribers_see_changes() {
+    ConfigStore::subscribe(recordChange);
+    ConfigStore::subscribe(recordChange);
+    ConfigUpdate updates[] = {
+        { CONFIG_TEMP_UNIT, FAHRENHEIT },
+        { CONFIG_SAMPLE_INTERVAL, ConfigStore::get(CONFIG_SAMPLE_INTERVAL) },
+        { CONFIG_WIFI_TIMEOUT, 5000 },
+    };
+    TEST_ASSERT_TRUE(ConfigStore::apply(updates, 3));
+    TEST_ASSERT_EQUAL(2, changeCount);
+    TEST_ASSERT_EQUAL(CONFIG_TEMP_UNIT, changedKeys[0]);
+    TEST_ASSERT_EQUAL(CONFIG_WIFI_TIMEOUT, changedKeys[1]);
+
+    TEST_ASSERT_TRUE(ConfigStore::set(CONFIG_WIFI_TIMEOUT, 5000));
+    TEST_ASSERT_EQUAL(2, changeCount);
+}
+
+// Test that the encoding round-trips and leaves secrets out of reads
+void test_encoding_round_trip() {
+    ConfigUpdate updates[] = {
+        { CONFIG_TEMP_UNIT, FAHRENHEIT },
+        { CONFIG_SAMPLE_INTERVAL, 120000 },
+        { CONFIG_NOTIFY_ABS_DEADBAND, 25 },
+        { CONFIG_BLE_PASSKEY, 424242 },
+    };
+    TEST_ASSERT_TRUE(ConfigStore::apply(updates, 4));
+
+    uint8_t full[CONFIG_MAX_ENCODED_SIZE];
+    uint8_t visible[CONFIG_MAX_ENCODED_SIZE];
+    size_t fullLength = ConfigStore::encode(full, sizeof(full), true);
+    size_t visibleLength = ConfigStore::encode(visible, sizeof(visible));
+    TEST_ASSERT_EQUAL(CONFIG_FORMAT_VERSION, full[0]);
+    TEST_ASSERT_EQUAL(fullLength - CONFIG_RECORD_HEADER - 4, visibleLength);
+    TEST_ASSERT_EQUAL(0, ConfigStore::encode(full, CONFIG_MAX_ENCODED_SIZE - 1));
+
+    ConfigStore::resetToDefaults();
+    assertDefaults();
+    // The blob holds the passkey, which only an authenticated link may write
+    TEST_ASSERT_FALSE(ConfigStore::applyEncoded(full, fullLength));
+    assertDefaults();
+    TEST_ASSERT_TRUE(ConfigStore::applyEncoded(full, fullLength, true));
+    TEST_ASSERT_EQUAL_UINT32(FAHRENHEIT, ConfigStore::get(CONFIG_TEMP_UNIT));
+    TEST_ASSERT_EQUAL_UINT32(120000, ConfigStore::get(CONFIG_SAMPLE_INTERVAL));
+    TEST_ASSERT_EQUAL_UINT32(25, ConfigStore::get(CONFIG_NOTIFY_ABS_DEADBAND));
+    TEST_ASSERT_EQUAL_UINT32(424242, ConfigStore::get(CONFIG_BLE_PASSKEY));
+
+    // Reading back and writing the same bytes changes nothing
+    uint8_t again[CONFIG_MAX_ENCODED_SIZE];
+    TEST_ASSERT_EQUAL(visibleLength, ConfigStore::encode(again, sizeof(again)));
+    TEST_ASSERT_EQUAL_MEMORY(visible, again, visibleLength);
+}
+
+// Test that a malformed or invalid write is rejected as a whole
+void test_bad_writes_change_nothing() {
+    uint8_t data[32];
+    size_t length = 1;
+    data[0] = CONFIG_FORMAT_VERSION;
+    length += record(data + length, 2, 60000, 4);
+    length += record(data + length, 1, 7, 1);       // no such unit
+    TEST_ASSERT_FALSE(ConfigStore::applyEncoded(data, length));
+    assertDefaults();
+
+    // Truncated record
+    length = 1;
+    length += record(data + length, 2, 60000, 4);
+    TEST_ASSERT_FALSE(ConfigStore::applyEncoded(data, length - 1));
+    // Unsupported format, and none at all
+    data[0] = CONFIG_FORMAT_VERSION + 1;
+    TEST_ASSERT_FALSE(ConfigStore::applyEncoded(data, length));
+    data[0] = 0;
+    TEST_ASSERT_FALSE(ConfigStore::applyEncoded(data, length));
+    TEST_ASSERT_FALSE(ConfigStore::applyEncoded(data, 0));
+    assertDefaults();
+
+    // Unknown tags are skipped; a partial write keeps the other settings
+    data[0] = CONFIG_FORMAT_VERSION;
+    length += record(data + length, 200, 0xDEADBEEF, 4);
+    TEST_ASSERT_TRUE(ConfigStore::applyEncoded(data, length));
+    TEST_ASSERT_EQUAL_UINT32(60000, ConfigStore::get(CONFIG_SAMPLE_INTERVAL));
+    TEST_ASSERT_EQUAL_UINT32(CELSIUS, ConfigStore::get(CONFIG_TEMP_UNIT));
+}
+
+// Test that a burst of changes is saved once, after the store went quiet
+void test_saves_are_debounced() {
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_TRUE(ConfigStore::set(CONFIG_NOTIFY_ABS_DEADBAND, 10 + i));
+        runFor(1000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, storage.saveCount);
+    TEST_ASSERT_TRUE(ConfigStore::isDirty());
+
+    runFor(ConfigStore::SAVE_DELAY);
+    TEST_ASSERT_EQUAL_UINT32(1, storage.saveCount);
+    TEST_ASSERT_FALSE(ConfigStore::isDirty());
+
+    // Nothing more to write until the next change
+    runFor(60000);
+    TEST_ASSERT_EQUAL_UINT32(1, storage.saveCount);
+
+    // A failed save is retried
+    storage.setFailing(true);
+    ConfigStore::set(CONFIG_TEMP_UNIT, FAHRENHEIT);
+    runFor(ConfigStore::SAVE_DELAY + 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, ConfigStore::getSaveFailures());
+    storage.setFailing(false);
+    runFor(ConfigStore::SAVE_DELAY + 1000);
+    TEST_ASSERT_EQUAL_UINT32(2, storage.saveCount);
+}
+
+// Test that saved settings, secrets included, come back after a reboot
+void test_settings_survive_reboot() {
+    ConfigUpdate updates[] = {
+        { CONFIG_SAMPLE_INTERVAL, 5000 },
+        { CONFIG_WIFI_BACKOFF_MAX, 60000 },
+        { CONFIG_BLE_PASSKEY, 13579 },
+    };
+    TEST_ASSERT_TRUE(ConfigStore::apply(updates, 3));
+    TEST_ASSERT_TRUE(ConfigStore::flush());
+    TEST_ASSERT_EQUAL_UINT32(1, storage.saveCount);
+
+    Scheduler::reset();
+    ConfigStore::init();
+    TEST_ASSERT_EQUAL_UINT32(5000, ConfigStore::get(CONFIG_SAMPLE_INTERVAL));
+    TEST_ASSERT_EQUAL_UINT32(60000, ConfigStore::get(CONFIG_WIFI_BACKOFF_MAX));
+    TEST_ASSERT_EQUAL_UINT32(13579, ConfigStore::get(CONFIG_BLE_PASSKEY));
+    TEST_ASSERT_FALSE(ConfigStore::isDirty());
+}
+
+// Test that blobs from other firmware versions load what they can
+void test_stored_blob_compatibility() {
+    // First boot after an update from firmware without a store: defaults, nothing written
+    TEST_ASSERT_FALSE(storage.hasContents());
+    assertDefaults();
+    runFor(60000);
+    TEST_ASSERT_EQUAL_UINT32(0, storage.saveCount);
+
+    // An older blob with fewer settings, narrower widths and a value that
+    // has since fallen out of range; a newer one adds a setting we do not know
+    uint8_t blob[32];
+    size_t length = 1;
+    blob[0] = CONFIG_FORMAT_VERSION;
+    length += record(blob + length, 1, FAHRENHEIT, 1);
+    length += record(blob + length, 3, 40, 1);
+    length += record(blob + length, 2, 500, 2);
+    length += record(blob + length, 99, 1, 1);
+    storage.setContents(blob, length);
+    ConfigStore::init();
+    TEST_ASSERT_EQUAL_UINT32(FAHRENHEIT, ConfigStore::get(CONFIG_TEMP_UNIT));
+    TEST_ASSERT_EQUAL_UINT32(40, ConfigStore::get(CONFIG_NOTIFY_ABS_DEADBAND));
+    TEST_ASSERT_EQUAL_UINT32(ConfigStore::getField(CONFIG_SAMPLE_INTERVAL).defaultValue,
+                             ConfigStore::get(CONFIG_SAMPLE_INTERVAL));
+    TEST_ASSERT_EQUAL_UINT32(WIFI_TIMEOUT_MS, ConfigStore::get(CONFIG_WIFI_TIMEOUT));
+
+    // A blob cut off mid-record keeps the records before the cut
+    storage.setContents(blob, 1 + 3 + 2);
+    ConfigStore::init();
+    TEST_ASSERT_EQUAL_UINT32(FAHRENHEIT, ConfigStore::get(CONFIG_TEMP_UNIT));
+    TEST_ASSERT_EQUAL_UINT32(ConfigStore::getField(CONFIG_NOTIFY_ABS_DEADBAND).defaultValue,
+                             ConfigStore::get(CONFIG_NOTIFY_ABS_DEADBAND));
+
+    // A future format, or one breaking a cross-field rule, is not trusted at all
+    blob[0] = CONFIG_FORMAT_VERSION + 1;
+    storage.setContents(blob, length);
+    ConfigStore::init();
+    assertDefaults();
+
+    length = 1;
+    blob[0] = CONFIG_FORMAT_VERSION;
+    length += record(blob + length, 1, FAHRENHEIT, 1);
+    length += record(blob + length, 5, 50000, 4);
+    length += record(blob + length, 6, 10000, 4);
+    storage.setContents(blob, length);
+    ConfigStore::init();
+    assertDefaults();
+}
+
+// Test that a new sample interval applies without a reboot
+void test_sample_interval_retunes() {
+    TemperatureService::clearSensors();
+    TemperatureService::init();
+    Scheduler::addPeriodic("process", processJob, 1000);
+    runFor(60000);
+    uint32_t before = TemperatureService::getSequence();
+
+    TEST_ASSERT_TRUE(ConfigStore::set(CONFIG_SAMPLE_INTERVAL, 5000));
+    runFor(60000);
+    uint32_t samples = TemperatureService::getSequence() - before;
+    TEST_ASSERT_TRUE(samples >= 12);
+    TEST_ASSERT_TRUE(samples <= 13);
+
+    // The unit follows the store as well
+    TemperatureService::setUnit(FAHRENHEIT);
+    TEST_ASSERT_EQUAL_UINT32(FAHRENHEIT, ConfigStore::get(CONFIG_TEMP_UNIT));
+    ConfigStore::set(CONFIG_TEMP_UNIT, CELSIUS);
+    TEST_ASSERT_EQUAL(CELSIUS, TemperatureService::getUnit());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_schema_is_consistent);
+    RUN_TEST(test_validation_rejects_bad_values);
+    RUN_TEST(test_subscribers_see_changes);
+    RUN_TEST(test_encoding_round_trip);
+    RUN_TEST(test_bad_writes_change_nothing);
+    RUN_TEST(test_saves_are_debounced);
+    RUN_TEST(test_settings_survive_reboot);
+    RUN_TEST(test_stored_blob_compatibility);
+    RUN_TEST(test_sample_interval_retunes);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
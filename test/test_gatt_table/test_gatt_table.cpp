@@ -0,0 +1,122 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/ble_gatt_table.h"
+
+// The table is checked by the compiler; a bad entry fails the build
+static_assert(gattServicesValid(), "GATT_SERVICES out of enum order or with a malformed UUID");
+static_assert(gattCharacteristicsValid(),
+              "GATT_CHARACTERISTICS out of enum order, with a malformed UUID, or with properties "
+              "its callbacks cannot serve");
+static_assert(gattServiceUUIDsUnique(), "two services share a UUID");
+static_assert(gattCharacteristicUUIDsUnique(), "two characteristics share a UUID");
+
+// The parser itself: little-endian bytes, either case of hex digits
+static_assert(GattUUID128(TEMPERATURE_CHAR_UUID).bytes[12] == 0x6E, "16-bit part of a SIG UUID");
+static_assert(GattUUID128(TEMPERATURE_CHAR_UUID).bytes[13] == 0x2A, "16-bit part of a SIG UUID");
+static_assert(GattUUID128(TEMPERATURE_CHAR_UUID).bytes[0] == 0xFB, "least significant byte first");
+static_assert(GattUUID128(SERVICE_UUID).bytes[15] == 0x12, "most significant byte last");
+static_assert(gattUUIDEqual(GattUUID128("0000181a-0000-1000-8000-00805F9B34FB"),
+                            GattUUID128(ENV_SENSING_SERVICE_UUID)), "case does not matter");
+static_assert(!gattIsUUID128("12345678-1234-1234-1234-123456789ab"), "too short");
+static_assert(!gattIsUUID128("12345678-1234-1234-1234-123456789abcd"), "too long");
+static_assert(!gattIsUUID128("12345678_1234-1234-1234-123456789abc"), "dash missing");
+static_assert(!gattIsUUID128("1234567g-1234-1234-1234-123456789abc"), "not hex");
+
+// The property rules reject what init() could not serve
+static_assert(!gattPropertiesValid({ GATT_CHAR_COUNTER, GATT_SERVICE_CUSTOM, CHARACTERISTIC_UUID,
+                                     NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY, GATT_CALLBACKS_CONFIG }),
+              "notify without subscription tracking");
+static_assert(!gattPropertiesValid({ GATT_CHAR_COUNTER, GATT_SERVICE_CUSTOM, CHARACTERISTIC_UUID,
+                                     NIMBLE_PROPERTY::WRITE, GATT_CALLBACKS_SUBSCRIPTION }),
+              "write without a write handler");
+static_assert(!gattPropertiesValid({ GATT_CHAR_COUNTER, GATT_SERVICE_CUSTOM, CHARACTERISTIC_UUID,
+                                     0, GATT_CALLBACKS_NONE }),
+              "no properties");
+
+#ifndef ARDUINO
+#include "../../include/ble_server.h"
+#include "../../include/scheduler.h"
+#include "sim_ble.h"
+
+// Test that the binary UUIDs name the same attributes as the text form
+void test_binary_uuid_matches_text() {
+    for (int i = 0; i < GATT_CHARACTERISTIC_COUNT; i++) {
+        const GattUUID128& uuid = GATT_CHARACTERISTICS[i].uuid;
+        NimBLEUUID binary(uuid.bytes, sizeof(uuid.bytes), false);
+        TEST_ASSERT_TRUE(binary == NimBLEUUID(uuid.text));
+    }
+    TEST_ASSERT_EQUAL_STRING("00002a6e-0000-1000-8000-00805f9b34fb",
+                             NimBLEUUID(GattUUID128(TEMPERATURE_CHAR_UUID).bytes, 16, false).toString().c_str());
+}
+
+// Test that init() registers every table entry with its properties and callbacks
+void test_init_builds_table() {
+    BLEServerManager::init();
+    for (int i = 0; i < GATT_CHARACTERISTIC_COUNT; i++) {
+        const GattCharacteristicDef& def = GATT_CHARACTERISTICS[i];
+        NimBLECharacteristic* characteristic = SimBLE::findCharacteristic(def.uuid.text);
+        TEST_ASSERT_NOT_NULL(characteristic);
+        TEST_ASSERT_EQUAL_UINT32(def.properties, characteristic->getProperties());
+        TEST_ASSERT_EQUAL(def.callbacks != GATT_CALLBACKS_NONE, characteristic->getCallbacks() != nullptr);
+    }
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+
+    // A restarted stack gets the same static callback objects again
+    NimBLECharacteristicCallbacks* callbacks = SimBLE::findCharacteristic(CONFIG_CHAR_UUID)->getCallbacks();
+    SimBLE::reset();
+    BLEServerManager::init();
+    TEST_ASSERT_TRUE(callbacks == SimBLE::findCharacteristic(CONFIG_CHAR_UUID)->getCallbacks());
+}
+
+// Test that a central still connects through the statically allocated server callbacks
+void test_server_callbacks_survive_restart() {
+    BLEServerManager::init();
+    SimBLE::reset();
+    BLEServerManager::init();
+    uint16_t conn = SimBLE::connect(247);
+    TEST_ASSERT_NOT_EQUAL(BLE_HS_CONN_HANDLE_NONE, conn);
+    TEST_ASSERT_EQUAL(1, BLEServerManager::getConnectionCount());
+    TEST_ASSERT_TRUE(SimBLE::subscribe(conn, TEMPERATURE_CHAR_UUID));
+    TEST_ASSERT_TRUE(BLEServerManager::isSubscribed(conn, NOTIFY_TEMPERATURE));
+}
+#endif
+
+void setUp(void) {
+    Serial.setEnabled(false);
+#ifndef ARDUINO
+    SimBLE::reset();
+    Scheduler::reset();
+    NativeClock::set(0);
+#endif
+}
+
+void tearDown(void) {
+#ifndef ARDUINO
+    SimBLE::reset();
+#endif
+    Serial.setEnabled(true);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+#ifndef ARDUINO
+    RUN_TEST(test_binary_uuid_matches_text);
+    RUN_TEST(test_init_builds_table);
+    RUN_TEST(test_server_callbacks_survive_restart);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
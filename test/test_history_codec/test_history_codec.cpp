@@ -0,0 +1,273 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/history_codec.h"
+
+static TemperatureHistory history;
+static HistoryRollup rollup;
+
+static uint32_t rngState = 99;
+static uint32_t nextRandom() {
+    rngState = rngState * 1103515245u + 12345u;
+    return rngState >> 8;
+}
+
+// Decode every frame of a dump and check it reproduces the history exactly
+static int dumpAndVerify(uint32_t fromSeq, size_t frameSize) {
+    uint8_t frame[600];
+    HistorySample decoded[255];
+    HistoryFrameHeader header;
+    uint32_t seq = fromSeq;
+    uint32_t expectedSeq = fromSeq < history.getFirstSequence() ? history.getFirstSequence() : fromSeq;
+    int frames = 0;
+
+    while (true) {
+        size_t length = HistoryFrameEncoder::encodeRange(history, seq, frame, frameSize);
+        TEST_ASSERT_TRUE(length >= HISTORY_FRAME_HEADER);
+        TEST_ASSERT_TRUE(length <= frameSize);
+        frames++;
+
+        int count = HistoryFrameDecoder::decode(frame, length, header, decoded, 255);
+        TEST_ASSERT_EQUAL(header.count, count);
+        TEST_ASSERT_EQUAL_UINT32(expectedSeq, header.firstSeq);
+        for (int i = 0; i < count; i++) {
+            HistorySample original;
+            TEST_ASSERT_TRUE(history.getSample(expectedSeq + i, original));
+            TEST_ASSERT_EQUAL_UINT32(original.timestamp, decoded[i].timestamp);
+            TEST_ASSERT_EQUAL_INT16(original.value, decoded[i].value);
+        }
+        expectedSeq += count;
+
+        if (header.flags & HISTORY_FLAG_LAST) {
+            break;
+        }
+        TEST_ASSERT_TRUE(count > 0);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(history.getNextSequence(), expectedSeq);
+    return frames;
+}
+
+// Test varint and zigzag encoding round trips, including the extremes
+void test_varint_round_trip() {
+    const uint32_t values[] = {0, 1, 127, 128, 300, 16383, 16384, 0x0FFFFFFFu, 0xFFFFFFFFu};
+    uint8_t buffer[Varint::MAX_BYTES];
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        size_t used = Varint::encode(values[i], buffer);
+        uint32_t decoded = 0;
+        TEST_ASSERT_EQUAL(used, Varint::decode(buffer, used, decoded));
+        TEST_ASSERT_EQUAL_UINT32(values[i], decoded);
+        // A truncated varint must be rejected
+        TEST_ASSERT_EQUAL(0, Varint::decode(buffer, used - 1, decoded));
+    }
+
+    const int32_t signedValues[] = {0, -1, 1, -64, 64, -32768, 32767, 2147483647, -2147483647 - 1};
+    for (size_t i = 0; i < sizeof(signedValues) / sizeof(signedValues[0]); i++) {
+        TEST_ASSERT_EQUAL_INT32(signedValues[i], Varint::unzigzag(Varint::zigzag(signedValues[i])));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, Varint::zigzag(-1));
+    TEST_ASSERT_EQUAL_UINT32(2, Varint::zigzag(1));
+}
+
+// Test random histories round trip at every MTU-derived frame size
+void test_history_dump_round_trip() {
+    history.begin(512);
+    uint32_t now = 123456;
+    for (int i = 0; i < 1500; i++) {
+        now += 1 + nextRandom() % 100000;
+        history.add(now, (int16_t)((int32_t)(nextRandom() % 65536) - 32768));
+    }
+
+    const size_t frameSizes[] = {20, 23, 61, 182, 244, 509};
+    for (size_t i = 0; i < sizeof(frameSizes) / sizeof(frameSizes[0]); i++) {
+        dumpAndVerify(0, frameSizes[i]);
+        dumpAndVerify(history.getNextSequence() - 7, frameSizes[i]);
+    }
+}
+
+// Test that periodic, slowly varying samples compress well
+void test_history_dump_compression() {
+    history.begin(4096);
+    int16_t value = 2150;
+    for (int i = 0; i < 120 * 24; i++) {
+        value += (int16_t)((int32_t)(nextRandom() % 21) - 10);
+        history.add(30000u * i, value);
+    }
+
+    // A day of 30 s samples fits in a few dozen 244-byte notifications
+    int frames = dumpAndVerify(0, 244);
+    TEST_ASSERT_LESS_OR_EQUAL(30, frames);
+}
+
+// Test the empty dump and requests past the newest sample
+void test_history_dump_empty_and_future() {
+    history.begin(16);
+    uint8_t frame[64];
+    HistorySample decoded[4];
+    HistoryFrameHeader header;
+
+    uint32_t seq = 0;
+    size_t length = HistoryFrameEncoder::encodeRange(history, seq, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(HISTORY_FRAME_HEADER, length);
+    TEST_ASSERT_EQUAL(0, HistoryFrameDecoder::decode(frame, length, header, decoded, 4));
+    TEST_ASSERT_TRUE(header.flags & HISTORY_FLAG_LAST);
+
+    history.add(0, 100);
+    seq = 50;
+    length = HistoryFrameEncoder::encodeRange(history, seq, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(0, HistoryFrameDecoder::decode(frame, length, header, decoded, 4));
+    TEST_ASSERT_EQUAL_UINT32(1, header.firstSeq);
+}
+
+// Test that evicted samples are skipped and the gap is visible to the client
+void test_history_dump_skips_evicted() {
+    history.begin(16);
+    for (int i = 0; i < 40; i++) {
+        history.add(i * 1000, (int16_t)i);
+    }
+    dumpAndVerify(3, 64);
+}
+
+// Test malformed frames are rejected
+void test_history_decode_rejects_malformed() {
+    history.begin(16);
+    for (int i = 0; i < 10; i++) {
+        history.add(i * 1000, (int16_t)(i * 3));
+    }
+    uint8_t frame[128];
+    uint32_t seq = 0;
+    size_t length = HistoryFrameEncoder::encodeRange(history, seq, frame, sizeof(frame));
+
+    HistorySample decoded[16];
+    HistoryFrameHeader header;
+    TEST_ASSERT_EQUAL(10, HistoryFrameDecoder::decode(frame, length, header, decoded, 16));
+    TEST_ASSERT_EQUAL(-1, HistoryFrameDecoder::decode(frame, length - 1, header, decoded, 16));
+    TEST_ASSERT_EQUAL(-1, HistoryFrameDecoder::decode(frame, 3, header, decoded, 16));
+    TEST_ASSERT_EQUAL(-1, HistoryFrameDecoder::decode(frame, length, header, decoded, 4));
+
+    frame[0] = HISTORY_FRAME_VERSION + 1;
+    TEST_ASSERT_EQUAL(-1, HistoryFrameDecoder::decode(frame, length, header, decoded, 16));
+
+    // A value delta that would overflow a 32-bit sum is out of range, not wrapped
+    uint8_t crafted[32] = { HISTORY_FRAME_VERSION, 0, 0, 0, 0, 0, 2 };
+    length = HISTORY_FRAME_HEADER;
+    length += Varint::encode(0, crafted + length);
+    length += Varint::encode(Varint::zigzag(32767), crafted + length);
+    length += Varint::encode(0, crafted + length);
+    length += Varint::encode(Varint::zigzag(INT32_MAX), crafted + length);
+    TEST_ASSERT_EQUAL(-1, HistoryFrameDecoder::decode(crafted, length, header, decoded, 16));
+}
+
+// Test a frame too small for the header is refused
+void test_history_encoder_tiny_buffer() {
+    uint8_t frame[4];
+    HistoryFrameEncoder encoder(frame, sizeof(frame));
+    TEST_ASSERT_FALSE(encoder.begin(0));
+    HistorySample sample = {0, 0};
+    TEST_ASSERT_FALSE(encoder.add(sample));
+    TEST_ASSERT_EQUAL(0, encoder.finish(true));
+}
+
+// Test rollup dumps reproduce every bucket of each tier, and truncated frames are rejected
+void test_rollup_dump_round_trip() {
+    uint32_t timestamp = 0;
+    for (int i = 0; i < 20000; i++) {
+        timestamp += 5000 + nextRandom() % 50000;
+        rollup.add(timestamp, (int16_t)((int32_t)(nextRandom() % 4001) - 2000));
+    }
+
+    uint8_t frame[244];
+    RollupPoint decoded[255];
+    RollupFrameHeader header;
+    for (int tier = TIER_1_MIN; tier < TIER_COUNT; tier++) {
+        uint32_t seq = 0;
+        uint32_t expectedSeq = rollup.getFirstSequence((HistoryTier)tier);
+        while (true) {
+            size_t length = RollupFrameEncoder::encodeRange(rollup, (HistoryTier)tier, seq, frame, sizeof(frame));
+            TEST_ASSERT_TRUE(length >= HISTORY_ROLLUP_FRAME_HEADER);
+            TEST_ASSERT_TRUE(length <= sizeof(frame));
+
+            int count = RollupFrameDecoder::decode(frame, length, header, decoded, 255);
+            TEST_ASSERT_EQUAL(header.count, count);
+            TEST_ASSERT_EQUAL(tier, header.tier);
+            TEST_ASSERT_EQUAL_UINT32(expectedSeq, header.firstSeq);
+            for (int i = 0; i < count; i++) {
+                RollupBucket original;
+                TEST_ASSERT_TRUE(rollup.getBucket((HistoryTier)tier, expectedSeq + i, original));
+                TEST_ASSERT_EQUAL_UINT32(original.start, decoded[i].start);
+                TEST_ASSERT_EQUAL_INT16(original.mean(), decoded[i].mean);
+                TEST_ASSERT_EQUAL_INT16(original.min, decoded[i].min);
+                TEST_ASSERT_EQUAL_INT16(original.max, decoded[i].max);
+                TEST_ASSERT_EQUAL_UINT16(original.count, decoded[i].count);
+            }
+            if (count > 0) {
+                TEST_ASSERT_EQUAL(-1, RollupFrameDecoder::decode(frame, length - 1, header, decoded, 255));
+            }
+            expectedSeq += count;
+
+            if (header.flags & HISTORY_FLAG_LAST) {
+                break;
+            }
+            TEST_ASSERT_TRUE(count > 0);
+        }
+        TEST_ASSERT_EQUAL_UINT32(rollup.getNextSequence((HistoryTier)tier), expectedSeq);
+    }
+
+    uint32_t seq = 0;
+    size_t length = RollupFrameEncoder::encodeRange(rollup, TIER_1_HOUR, seq, frame, sizeof(frame));
+    frame[0] = HISTORY_FRAME_VERSION;
+    TEST_ASSERT_EQUAL(-1, RollupFrameDecoder::decode(frame, length, header, decoded, 255));
+    frame[0] = HISTORY_ROLLUP_FRAME_VERSION;
+    frame[2] = TIER_RAW;
+    TEST_ASSERT_EQUAL(-1, RollupFrameDecoder::decode(frame, length, header, decoded, 255));
+
+    // A mean delta that would overflow a 32-bit sum is out of range, not wrapped
+    uint8_t crafted[64] = { HISTORY_ROLLUP_FRAME_VERSION, 0, TIER_1_HOUR, 0, 0, 0, 0, 2 };
+    length = HISTORY_ROLLUP_FRAME_HEADER;
+    const uint32_t fields[2][5] = {
+        { 0, Varint::zigzag(32767), 0, 0, 1 },
+        { Varint::zigzag(1), Varint::zigzag(INT32_MAX), 0, 0, 1 },
+    };
+    for (int p = 0; p < 2; p++) {
+        for (int f = 0; f < 5; f++) {
+            length += Varint::encode(fields[p][f], crafted + length);
+        }
+    }
+    TEST_ASSERT_EQUAL(-1, RollupFrameDecoder::decode(crafted, length, header, decoded, 255));
+}
+
+void setUp(void) {
+    rngState = 99;
+    rollup.clear();
+}
+
+void tearDown(void) {
+    history.end();
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_varint_round_trip);
+    RUN_TEST(test_history_dump_round_trip);
+    RUN_TEST(test_history_dump_compression);
+    RUN_TEST(test_history_dump_empty_and_future);
+    RUN_TEST(test_history_dump_skips_evicted);
+    RUN_TEST(test_history_decode_rejects_malformed);
+    RUN_TEST(test_history_encoder_tiny_buffer);
+    RUN_TEST(test_rollup_dump_round_trip);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do in loop for tests
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,203 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/history_rollup.h"
+#include <vector>
+
+static TemperatureHistory history;
+static HistoryRollup rollup;
+static std::vector<HistorySample> samples;
+
+static const uint32_t MINUTE = 60000UL;
+static const uint32_t HOUR = 60 * MINUTE;
+
+static uint32_t rngState = 4242;
+static uint32_t nextRandom() {
+    rngState = rngState * 1103515245u + 12345u;
+    return rngState >> 8;
+}
+
+static void addSample(uint32_t timestamp, int16_t value) {
+    history.add(timestamp, value);
+    rollup.add(timestamp, value);
+    HistorySample sample = { timestamp, value };
+    samples.push_back(sample);
+}
+
+static void addEvery(uint32_t& timestamp, uint32_t interval, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        timestamp += interval;
+        addSample(timestamp, (int16_t)(2000 + (int32_t)(nextRandom() % 1001) - 500));
+    }
+}
+
+// Recompute every stored bucket of a tier from all samples ever added
+static void checkAgainstBruteForce(HistoryTier tier) {
+    uint32_t width = HistoryRollup::getWidth(tier);
+    uint32_t first = rollup.getFirstSequence(tier);
+    uint32_t next = rollup.getNextSequence(tier);
+    TEST_ASSERT_TRUE(next - first <= rollup.getCapacity(tier));
+    if (first == next) {
+        TEST_ASSERT_TRUE(samples.empty());
+        return;
+    }
+
+    RollupBucket oldest;
+    TEST_ASSERT_TRUE(rollup.getBucket(tier, first, oldest));
+    uint32_t seq = first;
+    size_t i = 0;
+    while (i < samples.size() && samples[i].timestamp < oldest.start) {
+        i++;
+    }
+    while (i < samples.size()) {
+        uint32_t start = samples[i].timestamp - samples[i].timestamp % width;
+        int64_t sum = 0;
+        uint32_t count = 0;
+        int16_t minValue = 32767;
+        int16_t maxValue = -32768;
+        for (; i < samples.size() && samples[i].timestamp - samples[i].timestamp % width == start; i++) {
+            sum += samples[i].value;
+            count++;
+            if (samples[i].value < minValue) minValue = samples[i].value;
+            if (samples[i].value > maxValue) maxValue = samples[i].value;
+        }
+
+        RollupBucket bucket;
+        TEST_ASSERT_TRUE(rollup.getBucket(tier, seq, bucket));
+        TEST_ASSERT_EQUAL_UINT32(start, bucket.start);
+        TEST_ASSERT_EQUAL_UINT32(count, bucket.count);
+        TEST_ASSERT_EQUAL_INT32((int32_t)sum, bucket.sum);
+        TEST_ASSERT_EQUAL_INT16(minValue, bucket.min);
+        TEST_ASSERT_EQUAL_INT16(maxValue, bucket.max);
+        seq++;
+    }
+    // No bucket left over and none missing
+    TEST_ASSERT_EQUAL_UINT32(next, seq);
+}
+
+static void checkAllTiers() {
+    for (int tier = TIER_1_MIN; tier < TIER_COUNT; tier++) {
+        checkAgainstBruteForce((HistoryTier)tier);
+    }
+}
+
+// Test that incremental rollups match a recomputation, through gaps and ring wraps
+void test_rollups_match_brute_force() {
+    uint32_t timestamp = 12345;
+    for (int round = 0; round < 12; round++) {
+        // Jittered sampling, then a gap of up to a few hours without samples
+        for (int i = 0; i < 2000; i++) {
+            timestamp += 1000 + nextRandom() % 60000;
+            addSample(timestamp, (int16_t)((int32_t)(nextRandom() % 6001) - 3000));
+        }
+        timestamp += nextRandom() % (4 * HOUR);
+        checkAllTiers();
+    }
+    // The finer tiers wrapped; the hourly one keeps more than a week
+    TEST_ASSERT_EQUAL_UINT32(HistoryRollup::BUCKETS_1_MIN, rollup.size(TIER_1_MIN));
+    TEST_ASSERT_EQUAL_UINT32(HistoryRollup::BUCKETS_15_MIN, rollup.size(TIER_15_MIN));
+    TEST_ASSERT_TRUE(rollup.getFirstSequence(TIER_1_MIN) > 0);
+}
+
+// Test extreme values and the rounded mean
+void test_bucket_extremes() {
+    addSample(0, -32768);
+    addSample(1000, 32767);
+    addSample(2000, -3);
+    addSample(MINUTE, -1);
+    addSample(MINUTE + 1, -2);
+    checkAllTiers();
+
+    RollupBucket bucket;
+    TEST_ASSERT_TRUE(rollup.getBucket(TIER_1_MIN, 0, bucket));
+    TEST_ASSERT_EQUAL_INT16(-1, bucket.mean());
+    TEST_ASSERT_TRUE(rollup.getBucket(TIER_1_MIN, 1, bucket));
+    // -1.5 rounds away from zero, and stays within [min, max]
+    TEST_ASSERT_EQUAL_INT16(-2, bucket.mean());
+    TEST_ASSERT_FALSE(rollup.getBucket(TIER_1_MIN, 2, bucket));
+    TEST_ASSERT_FALSE(rollup.getBucket(TIER_RAW, 0, bucket));
+
+    rollup.clear();
+    TEST_ASSERT_EQUAL_UINT32(0, rollup.size(TIER_1_HOUR));
+}
+
+// Test that a range request gets the finest tier within its point budget
+void test_tier_selection() {
+    HistorySelection selection = HistoryTierSelector::select(history, rollup, HOUR, 100);
+    TEST_ASSERT_EQUAL(TIER_RAW, selection.tier);
+    TEST_ASSERT_EQUAL_UINT32(0, selection.points);
+
+    // Two days at 30 s: more than the raw ring holds
+    uint32_t timestamp = 0;
+    addEvery(timestamp, 30000, 5760);
+    TEST_ASSERT_TRUE(history.getFirstSequence() > 0);
+
+    selection = HistoryTierSelector::select(history, rollup, HOUR, 200);
+    TEST_ASSERT_EQUAL(TIER_RAW, selection.tier);
+    TEST_ASSERT_EQUAL_UINT32(121, selection.points);
+    TEST_ASSERT_EQUAL_UINT32(history.getNextSequence() - 121, selection.firstSeq);
+
+    selection = HistoryTierSelector::select(history, rollup, HOUR, 100);
+    TEST_ASSERT_EQUAL(TIER_1_MIN, selection.tier);
+    TEST_ASSERT_EQUAL_UINT32(61, selection.points);
+
+    // The 1-minute tier does not reach back a day
+    selection = HistoryTierSelector::select(history, rollup, 24 * HOUR, 200);
+    TEST_ASSERT_EQUAL(TIER_15_MIN, selection.tier);
+    TEST_ASSERT_EQUAL_UINT32(97, selection.points);
+
+    selection = HistoryTierSelector::select(history, rollup, 24 * HOUR, 5000);
+    TEST_ASSERT_EQUAL(TIER_RAW, selection.tier);
+    TEST_ASSERT_EQUAL_UINT32(2881, selection.points);
+
+    // A week asked for, two days kept: the 15-minute tier has them all
+    selection = HistoryTierSelector::select(history, rollup, 7 * 24 * HOUR, 0);
+    TEST_ASSERT_EQUAL(TIER_15_MIN, selection.tier);
+    TEST_ASSERT_EQUAL_UINT32(rollup.size(TIER_15_MIN), selection.points);
+
+    selection = HistoryTierSelector::select(history, rollup, 7 * 24 * HOUR, 100);
+    TEST_ASSERT_EQUAL(TIER_1_HOUR, selection.tier);
+    TEST_ASSERT_EQUAL_UINT32(rollup.size(TIER_1_HOUR), selection.points);
+    TEST_ASSERT_EQUAL_UINT32(0, selection.firstSeq);
+
+    // Over budget even hourly: the newest buckets
+    selection = HistoryTierSelector::select(history, rollup, 0, 20);
+    TEST_ASSERT_EQUAL(TIER_1_HOUR, selection.tier);
+    TEST_ASSERT_EQUAL_UINT32(20, selection.points);
+    TEST_ASSERT_EQUAL_UINT32(rollup.getNextSequence(TIER_1_HOUR) - 20, selection.firstSeq);
+}
+
+void setUp(void) {
+    Serial.setEnabled(false);
+    if (history.getCapacity() == 0) {
+        history.begin();
+    }
+    history.clear();
+    rollup.clear();
+    samples.clear();
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rollups_match_brute_force);
+    RUN_TEST(test_bucket_extremes);
+    RUN_TEST(test_tier_selection);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
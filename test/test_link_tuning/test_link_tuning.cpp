@@ -0,0 +1,255 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/link_tuning.h"
+
+// Test that a link stays on the bulk profile while bulk traffic is recent
+void test_profile_follows_bulk_traffic() {
+    LinkTuning link;
+    link.reset(0);
+
+    // A new connection starts on the short interval, requested once
+    TEST_ASSERT_EQUAL(LINK_PROFILE_BULK, link.update(false, 0));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link.update(false, 1000));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link.update(false, LinkTuning::IDLE_AFTER - 1));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_IDLE, link.update(false, LinkTuning::IDLE_AFTER));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_IDLE, link.getRequested());
+
+    // Bulk traffic switches back at once and holds for IDLE_AFTER after it stops
+    TEST_ASSERT_EQUAL(LINK_PROFILE_BULK, link.update(true, 20000));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link.update(true, 21000));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_NONE, link.update(false, 21000 + LinkTuning::IDLE_AFTER - 1));
+    TEST_ASSERT_EQUAL(LINK_PROFILE_IDLE, link.update(false, 21000 + LinkTuning::IDLE_AFTER));
+}
+
+// Test that the idle profile trades latency for fewer radio events within valid limits
+void test_profile_parameters() {
+    const LinkParams& bulk = LinkTuning::paramsFor(LINK_PROFILE_BULK);
+    const LinkParams& idle = LinkTuning::paramsFor(LINK_PROFILE_IDLE);
+    TEST_ASSERT_EQUAL_UINT16(6, bulk.minInterval);
+    TEST_ASSERT_EQUAL_UINT16(0, bulk.latency);
+    TEST_ASSERT_TRUE(idle.minInterval > bulk.maxInterval);
+    TEST_ASSERT_TRUE(idle.latency > 0);
+
+    // The supervision timeout must exceed twice the effective interval
+    const LinkParams* profiles[] = { &bulk, &idle };
+    for (int i = 0; i < 2; i++) {
+        uint32_t effectiveMs = (1 + profiles[i]->latency) * profiles[i]->maxInterval * 5 / 4;
+        TEST_ASSERT_TRUE(profiles[i]->timeout * 10u > 2 * effectiveMs);
+    }
+    TEST_ASSERT_EQUAL_UINT16(247, LinkTuning::PREFERRED_MTU);
+}
+
+// Test throughput of a running and of a finished bulk transfer
+void test_throughput() {
+    LinkTuning link;
+    link.reset(0);
+    TEST_ASSERT_EQUAL_UINT32(0, link.getThroughput(5000));
+
+    link.startBulk(1000);
+    link.addBulkBytes(12000);
+    link.addBulkBytes(12400);
+    TEST_ASSERT_EQUAL_UINT32(24400, link.getThroughput(2000));
+    link.finishBulk(3000);
+    TEST_ASSERT_EQUAL_UINT32(12200, link.getThroughput(3000));
+    // The last result stands until the next transfer
+    TEST_ASSERT_EQUAL_UINT32(12200, link.getThroughput(100000));
+    link.finishBulk(200000);
+    TEST_ASSERT_EQUAL_UINT32(12200, link.getThroughput(200000));
+}
+
+// Test the diagnostics wire format of one link
+void test_encode_info() {
+    LinkInfo info = { 0x0102, 247, 251, 6, 0, 400, LINK_PROFILE_BULK, 0x00012345 };
+    uint8_t buffer[LINK_INFO_SIZE];
+    TEST_ASSERT_EQUAL(0, LinkTuning::encodeInfo(info, buffer, sizeof(buffer) - 1));
+    TEST_ASSERT_EQUAL(LINK_INFO_SIZE, LinkTuning::encodeInfo(info, buffer, sizeof(buffer)));
+
+    const uint8_t expected[LINK_INFO_SIZE] = {
+        0x02, 0x01, 247, 0, 251, 0, 6, 0, 0, 0, LINK_PROFILE_BULK, 0x45, 0x23, 0x01, 0x00
+    };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, buffer, LINK_INFO_SIZE);
+}
+
+// The remaining tests drive the fake NimBLE stack from sim/
+#ifndef ARDUINO
+#include "../../include/ble_server.h"
+#include "../../include/temperature_service.h"
+#include "../../include/history_codec.h"
+#include "../../include/timing_stats.h"
+#include "../../include/memory_monitor.h"
+#include "../../include/scheduler.h"
+#include "sim_ble.h"
+
+static uint32_t historyFrames = 0;
+static size_t largestFrame = 0;
+static bool historyComplete = false;
+
+static void collectHistory(uint16_t connHandle, const NimBLEUUID& uuid, const uint8_t* data, size_t length) {
+    if (uuid != NimBLEUUID(TEMP_HISTORY_CHAR_UUID)) {
+        return;
+    }
+    historyFrames++;
+    if (length > largestFrame) {
+        largestFrame = length;
+    }
+    if (length > 1 && (data[1] & HISTORY_FLAG_LAST)) {
+        historyComplete = true;
+    }
+}
+
+static void runFor(uint32_t durationMs) {
+    uint32_t end = NativeClock::now() + durationMs;
+    while ((int32_t)(NativeClock::now() - end) < 0) {
+        Scheduler::runDue(NativeClock::now());
+        NativeClock::advance(20);
+    }
+}
+
+// Test that the server asks for its MTU and data length instead of waiting for the central
+void test_connect_requests_mtu_and_dle() {
+    BLEServerManager::init();
+
+    // The central supports more than the server offers
+    uint16_t large = SimBLE::connect(517);
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::PREFERRED_MTU, BLEServerManager::getPeerMTU(large));
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::DATA_LENGTH, SimBLE::getDataLength(large));
+
+    // A central limited to the default MTU keeps it
+    uint16_t small = SimBLE::connect();
+    TEST_ASSERT_EQUAL_UINT16(BLE_DEFAULT_MTU, BLEServerManager::getPeerMTU(small));
+
+    LinkInfo info;
+    TEST_ASSERT_TRUE(BLEServerManager::getLinkInfo(large, info));
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::PREFERRED_MTU, info.mtu);
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::DATA_LENGTH, info.dataLength);
+    TEST_ASSERT_FALSE(BLEServerManager::getLinkInfo(BLE_CONN_HANDLE_INVALID, info));
+}
+
+// Test that the interval is short around a history dump and long while idle
+void test_interval_follows_history_dump() {
+    for (int i = 0; i < 1000; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::sample();
+    }
+    BLEServerManager::init();
+    uint16_t conn = SimBLE::connect(247);
+    SimBLE::subscribe(conn, TEMP_HISTORY_CHAR_UUID);
+    ble_gap_conn_desc desc;
+
+    runFor(100);
+    SimBLE::getConnDesc(conn, desc);
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::BULK_PARAMS.minInterval, desc.conn_itvl);
+
+    runFor(LinkTuning::IDLE_AFTER + 1000);
+    SimBLE::getConnDesc(conn, desc);
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::IDLE_PARAMS.minInterval, desc.conn_itvl);
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::IDLE_PARAMS.latency, desc.conn_latency);
+    TEST_ASSERT_EQUAL_UINT32(2, SimBLE::getParamUpdates(conn));
+
+    // The dump switches to the short interval before its first frame
+    historyFrames = 0;
+    largestFrame = 0;
+    historyComplete = false;
+    SimBLE::setNotifyHandler(collectHistory);
+    const uint8_t fromStart[4] = {0, 0, 0, 0};
+    SimBLE::write(conn, TEMP_HISTORY_CHAR_UUID, fromStart, sizeof(fromStart));
+    Scheduler::runDue(NativeClock::now());
+    SimBLE::getConnDesc(conn, desc);
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::BULK_PARAMS.minInterval, desc.conn_itvl);
+    TEST_ASSERT_TRUE(historyFrames > 0);
+
+    while (!historyComplete) {
+        runFor(20);
+        TEST_ASSERT_TRUE(historyFrames < 1000);
+    }
+    // Frames fill the negotiated MTU
+    TEST_ASSERT_UINT32_WITHIN(8, LinkTuning::PREFERRED_MTU - BLE_NOTIFY_OVERHEAD, largestFrame);
+
+    // The negotiated values are picked up on the next connection check
+    runFor(1000);
+    LinkInfo info;
+    BLEServerManager::getLinkInfo(conn, info);
+    TEST_ASSERT_EQUAL_UINT32(LINK_PROFILE_BULK, info.profile);
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::BULK_PARAMS.minInterval, info.interval);
+    TEST_ASSERT_TRUE(info.throughput > 1000);
+
+    runFor(LinkTuning::IDLE_AFTER + 1000);
+    SimBLE::getConnDesc(conn, desc);
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::IDLE_PARAMS.minInterval, desc.conn_itvl);
+    BLEServerManager::getLinkInfo(conn, info);
+    TEST_ASSERT_EQUAL_UINT32(LINK_PROFILE_IDLE, info.profile);
+    TEST_ASSERT_TRUE(info.throughput > 1000);
+}
+
+// Test that the diagnostics characteristic lists every open link between the
+// timing snapshot and the memory watermarks
+void test_diagnostics_report_links() {
+    BLEServerManager::init();
+    uint16_t first = SimBLE::connect(247);
+    uint16_t second = SimBLE::connect();
+    runFor(11000);
+
+    std::string value;
+    TEST_ASSERT_TRUE(SimBLE::read(first, DIAGNOSTICS_CHAR_UUID, value));
+    TEST_ASSERT_EQUAL(TIMING_SNAPSHOT_SIZE + 1 + 2 * LINK_INFO_SIZE + MemoryMonitor::getSnapshotSize(), value.size());
+    const uint8_t* links = (const uint8_t*)value.data() + TIMING_SNAPSHOT_SIZE;
+    TEST_ASSERT_EQUAL_UINT8(2, links[0]);
+
+    const uint8_t* entry = links + 1;
+    TEST_ASSERT_EQUAL_UINT16(first, entry[0] | (entry[1] << 8));
+    TEST_ASSERT_EQUAL_UINT16(247, entry[2] | (entry[3] << 8));
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::DATA_LENGTH, entry[4] | (entry[5] << 8));
+    TEST_ASSERT_EQUAL_UINT16(LinkTuning::IDLE_PARAMS.minInterval, entry[6] | (entry[7] << 8));
+    TEST_ASSERT_EQUAL_UINT8(LINK_PROFILE_IDLE, entry[10]);
+    entry += LINK_INFO_SIZE;
+    TEST_ASSERT_EQUAL_UINT16(second, entry[0] | (entry[1] << 8));
+    TEST_ASSERT_EQUAL_UINT16(BLE_DEFAULT_MTU, entry[2] | (entry[3] << 8));
+}
+
+void setUp(void) {
+    Serial.setEnabled(false);
+    SimBLE::reset();
+    Scheduler::reset();
+    NativeClock::set(0);
+    TemperatureService::init();
+}
+
+void tearDown(void) {
+    SimBLE::reset();
+    Serial.setEnabled(true);
+}
+#else
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+#endif
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_profile_follows_bulk_traffic);
+    RUN_TEST(test_profile_parameters);
+    RUN_TEST(test_throughput);
+    RUN_TEST(test_encode_info);
+#ifndef ARDUINO
+    RUN_TEST(test_connect_requests_mtu_and_dle);
+    RUN_TEST(test_interval_follows_history_dump);
+    RUN_TEST(test_diagnostics_report_links);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
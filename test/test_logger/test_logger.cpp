@@ -0,0 +1,92 @@
+#include <unity.h>
+#include <string.h>
+#include "../../include/logger.h"
+
+void setUp(void) {
+    Logger::reset();
+    Serial.setEnabled(false);
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+}
+
+// Test that bytes come out in order across the wrap point
+void test_ring_wraps_in_order() {
+    static LogRing ring;
+    ring.clear();
+    char out[LogRing::CAPACITY];
+    char line[100];
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < (int)sizeof(line); i++) {
+            line[i] = (char)(round + i);
+        }
+        TEST_ASSERT_TRUE(ring.push(line, sizeof(line)));
+        TEST_ASSERT_EQUAL(sizeof(line), ring.available());
+        TEST_ASSERT_EQUAL(sizeof(line), ring.pop(out, sizeof(out)));
+        TEST_ASSERT_EQUAL_MEMORY(line, out, sizeof(line));
+    }
+    TEST_ASSERT_EQUAL(0, ring.pop(out, sizeof(out)));
+}
+
+// Test that a push that does not fit is rejected whole
+void test_ring_push_is_all_or_nothing() {
+    static LogRing ring;
+    ring.clear();
+    static char block[LogRing::CAPACITY];
+    memset(block, 'x', sizeof(block));
+    TEST_ASSERT_TRUE(ring.push(block, sizeof(block) - 4));
+    TEST_ASSERT_FALSE(ring.push("hello", 5));
+    TEST_ASSERT_TRUE(ring.push("hey!", 4));
+    TEST_ASSERT_EQUAL(LogRing::CAPACITY, ring.available());
+
+    // Partial pops free space for the next line
+    char out[16];
+    TEST_ASSERT_EQUAL(sizeof(out), ring.pop(out, sizeof(out)));
+    TEST_ASSERT_TRUE(ring.push("hello", 5));
+}
+
+// Test the line format, level tag and truncation
+void test_format_line() {
+    char line[LOG_LINE_SIZE];
+    size_t length = Logger::format(line, sizeof(line), LOG_LEVEL_WARN, "attempt %d of %s", 3, "five");
+    TEST_ASSERT_EQUAL_STRING("[W] attempt 3 of five\n", line);
+    TEST_ASSERT_EQUAL(strlen(line), length);
+
+    char small[16];
+    length = Logger::format(small, sizeof(small), LOG_LEVEL_INFO, "%s", "a message that is far too long");
+    TEST_ASSERT_EQUAL_STRING("[I] a message \n", small);
+    TEST_ASSERT_EQUAL(sizeof(small) - 1, length);
+}
+
+// Test that lines written through the macros drain without drops
+void test_write_drains() {
+    for (int i = 0; i < 1000; i++) {
+        LOG_INFO("Sent notification: Count: %d", i);
+    }
+    LOG_DEBUG("filtered at the default level: %d", 1);
+    TEST_ASSERT_EQUAL_UINT32(0, Logger::getDropped());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_wraps_in_order);
+    RUN_TEST(test_ring_push_is_all_or_nothing);
+    RUN_TEST(test_format_line);
+    RUN_TEST(test_write_drains);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
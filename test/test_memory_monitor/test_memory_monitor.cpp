@@ -0,0 +1,190 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/memory_monitor.h"
+#include "../../include/scheduler.h"
+
+static FakeMemoryProbe probe;
+
+static uint32_t readU16(const uint8_t* in) {
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t readU32(const uint8_t* in) {
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Test that the native heap follows the allocations seen by the hook
+void test_heap_follows_allocations() {
+    MemoryMonitor::sample();
+    uint32_t before = MemoryMonitor::getStats().heap.freeBytes;
+    TEST_ASSERT_EQUAL_UINT32(FakeMemoryProbe::DEFAULT_HEAP_SIZE, MemoryMonitor::getStats().heap.totalBytes);
+
+    uint8_t* block = new uint8_t[20000];
+    MemoryMonitor::sample();
+    TEST_ASSERT_EQUAL_UINT32(before - 20000, MemoryMonitor::getStats().heap.freeBytes);
+    delete[] block;
+
+    // Free again, but the low-water mark remembers the dip
+    MemoryMonitor::sample();
+    const MemoryStats& stats = MemoryMonitor::getStats();
+    TEST_ASSERT_EQUAL_UINT32(before, stats.heap.freeBytes);
+    TEST_ASSERT_EQUAL_UINT32(before - 20000, stats.minFreeHeap);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.samples);
+    TEST_ASSERT_EQUAL_UINT8(0, stats.fragmentation);
+}
+
+// Test that the allocator's own low-water mark counts even if no sample saw the dip
+void test_dip_between_samples() {
+    MemoryMonitor::sample();
+    uint32_t before = MemoryMonitor::getStats().heap.freeBytes;
+    delete[] new uint8_t[50000];
+    MemoryMonitor::sample();
+    TEST_ASSERT_EQUAL_UINT32(before, MemoryMonitor::getStats().heap.freeBytes);
+    TEST_ASSERT_EQUAL_UINT32(before - 50000, MemoryMonitor::getStats().minFreeHeap);
+}
+
+// Test that fragmentation warns once per crossing, with hysteresis
+void test_fragmentation_warning() {
+    MemoryMonitor::setFragmentationThreshold(50);
+
+    probe.scriptHeap(100000, 80000);
+    MemoryMonitor::sample();
+    TEST_ASSERT_EQUAL_UINT8(20, MemoryMonitor::getStats().fragmentation);
+    TEST_ASSERT_FALSE(MemoryMonitor::getStats().fragmented);
+
+    probe.scriptHeap(100000, 40000);
+    MemoryMonitor::sample();
+    TEST_ASSERT_TRUE(MemoryMonitor::getStats().fragmented);
+    TEST_ASSERT_EQUAL_UINT32(1, MemoryMonitor::getStats().fragmentationWarnings);
+
+    // Hovering around the threshold does not warn again
+    probe.scriptHeap(100000, 55000);
+    MemoryMonitor::sample();
+    probe.scriptHeap(100000, 45000);
+    MemoryMonitor::sample();
+    TEST_ASSERT_TRUE(MemoryMonitor::getStats().fragmented);
+    TEST_ASSERT_EQUAL_UINT32(1, MemoryMonitor::getStats().fragmentationWarnings);
+
+    // Clearly below, then above again
+    probe.scriptHeap(100000, 60000);
+    MemoryMonitor::sample();
+    TEST_ASSERT_FALSE(MemoryMonitor::getStats().fragmented);
+    probe.scriptHeap(90000, 30000);
+    MemoryMonitor::sample();
+
+    const MemoryStats& stats = MemoryMonitor::getStats();
+    TEST_ASSERT_EQUAL_UINT32(2, stats.fragmentationWarnings);
+    TEST_ASSERT_EQUAL_UINT8(67, stats.maxFragmentation);
+    TEST_ASSERT_EQUAL_UINT32(30000, stats.minLargestFreeBlock);
+    TEST_ASSERT_EQUAL_UINT32(90000, stats.minFreeHeap);
+}
+
+// Test that stack high-water marks and PSRAM keep their lowest values
+void test_stacks_and_psram() {
+    TEST_ASSERT_TRUE(MemoryMonitor::watchTask("ble", 4096));
+    TEST_ASSERT_TRUE(MemoryMonitor::watchTask("nimble_host", 4096));
+    TEST_ASSERT_TRUE(MemoryMonitor::watchTask("ble", 6144));
+    TEST_ASSERT_EQUAL(2, MemoryMonitor::getTaskCount());
+
+    probe.setStackHighWater("ble", 1500);
+    probe.setPsram(8388608, 8000000);
+    MemoryMonitor::sample();
+    probe.setStackHighWater("ble", 1800);
+    probe.setPsram(8388608, 8300000);
+    MemoryMonitor::sample();
+
+    TaskStackStats task;
+    TEST_ASSERT_TRUE(MemoryMonitor::getTaskStack(0, task));
+    TEST_ASSERT_EQUAL_STRING("ble", task.name);
+    TEST_ASSERT_EQUAL_UINT32(6144, task.stackSize);
+    TEST_ASSERT_TRUE(task.seen);
+    TEST_ASSERT_EQUAL_UINT32(1500, task.minUnused);
+
+    // Not started yet
+    TEST_ASSERT_TRUE(MemoryMonitor::getTaskStack(1, task));
+    TEST_ASSERT_FALSE(task.seen);
+    TEST_ASSERT_FALSE(MemoryMonitor::getTaskStack(2, task));
+
+    const MemoryStats& stats = MemoryMonitor::getStats();
+    TEST_ASSERT_TRUE(stats.hasPsram);
+    TEST_ASSERT_EQUAL_UINT32(8300000, stats.psram.freeBytes);
+    TEST_ASSERT_EQUAL_UINT32(8000000, stats.minFreePsram);
+}
+
+// Test the layout appended to the diagnostics characteristic
+void test_snapshot_layout() {
+    MemoryMonitor::watchTask("sampling", 3072);
+    MemoryMonitor::watchTask("log", 3072);
+    probe.setStackHighWater("sampling", 900);
+    probe.scriptHeap(100000, 30000);
+    MemoryMonitor::sample();
+
+    uint8_t snapshot[MEMORY_SNAPSHOT_MAX_SIZE];
+    size_t size = MEMORY_SNAPSHOT_HEADER + 2 * MEMORY_SNAPSHOT_TASK_SIZE;
+    TEST_ASSERT_EQUAL(size, MemoryMonitor::getSnapshotSize());
+    TEST_ASSERT_EQUAL(0, MemoryMonitor::encodeSnapshot(snapshot, size - 1));
+    TEST_ASSERT_EQUAL(size, MemoryMonitor::encodeSnapshot(snapshot, sizeof(snapshot)));
+
+    TEST_ASSERT_EQUAL_UINT8(MEMORY_SNAPSHOT_VERSION, snapshot[0]);
+    TEST_ASSERT_EQUAL_UINT8(MEMORY_FLAG_FRAGMENTED, snapshot[1]);
+    TEST_ASSERT_EQUAL_UINT32(100000, readU32(snapshot + 2));
+    TEST_ASSERT_EQUAL_UINT32(30000, readU32(snapshot + 6));
+    TEST_ASSERT_EQUAL_UINT32(100000, readU32(snapshot + 10));
+    TEST_ASSERT_EQUAL_UINT32(30000, readU32(snapshot + 14));
+    TEST_ASSERT_EQUAL_UINT8(70, snapshot[26]);
+    TEST_ASSERT_EQUAL_UINT8(2, snapshot[27]);
+
+    const uint8_t* tasks = snapshot + MEMORY_SNAPSHOT_HEADER;
+    TEST_ASSERT_EQUAL_UINT32(3072, readU16(tasks));
+    TEST_ASSERT_EQUAL_UINT32(900, readU16(tasks + 2));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFF, readU16(tasks + MEMORY_SNAPSHOT_TASK_SIZE + 2));
+}
+
+// Test that init() samples right away and then every SAMPLE_INTERVAL
+void test_sample_job() {
+    MemoryMonitor::init();
+    TEST_ASSERT_EQUAL_UINT32(1, MemoryMonitor::getStats().samples);
+    for (uint32_t t = 0; t <= 3 * MemoryMonitor::SAMPLE_INTERVAL; t += 1000) {
+        NativeClock::set(t);
+        Scheduler::runDue();
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, MemoryMonitor::getStats().samples);
+}
+
+void setUp(void) {
+    Serial.setEnabled(false);
+    Scheduler::reset();
+    NativeClock::set(0);
+    probe.reset();
+    MemoryMonitor::reset();
+    MemoryMonitor::setProbe(&probe);
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_heap_follows_allocations);
+    RUN_TEST(test_dip_between_samples);
+    RUN_TEST(test_fragmentation_warning);
+    RUN_TEST(test_stacks_and_psram);
+    RUN_TEST(test_snapshot_layout);
+    RUN_TEST(test_sample_job);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,251 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/notify_policy.h"
+#include "../../include/temperature_service.h"
+#include "../../include/scheduler.h"
+
+static NotifyPolicy policy;
+
+// One step of a scripted run: at time `at` the sensor reports `value`
+struct ScriptStep {
+    uint32_t at;
+    int16_t value;
+};
+
+// Drive the policy like the publish job does: evaluate on every new value and
+// whenever the policy says it is due, advancing the fake clock in between.
+// Returns the number of notifications and records their times.
+static int runScript(const ScriptStep* steps, int count, uint32_t endTime,
+                     uint32_t* notifyTimes, int maxNotifies) {
+    int notifies = 0;
+    int next = 0;
+    int16_t latest = steps[0].value;
+    NativeClock::set(steps[0].at);
+
+    while (NativeClock::now() <= endTime) {
+        uint32_t now = NativeClock::now();
+        while (next < count && steps[next].at <= now) {
+            latest = steps[next].value;
+            next++;
+        }
+        if (policy.evaluate(latest, now)) {
+            policy.markNotified(latest, now);
+            if (notifies < maxNotifies) {
+                notifyTimes[notifies] = now;
+            }
+            notifies++;
+        }
+
+        // Wake at whichever comes first: the policy deadline or the next reading
+        uint32_t wait = policy.timeUntilDue(now);
+        if (wait == 0) {
+            wait = policy.getConfig().maxInterval;
+        }
+        if (next < count && steps[next].at - now < wait) {
+            wait = steps[next].at - now;
+        }
+        NativeClock::advance(wait);
+    }
+    return notifies;
+}
+
+static void configure(uint16_t absolute, uint16_t relative, uint32_t minInterval, uint32_t maxInterval) {
+    NotifyPolicyConfig config = {absolute, relative, minInterval, maxInterval};
+    TEST_ASSERT_TRUE(policy.configure(config));
+}
+
+// Test that the first value is always sent
+void test_first_value_notifies() {
+    TEST_ASSERT_EQUAL_UINT32(NotifyPolicy::DEFAULT_MAX_INTERVAL, policy.timeUntilDue(0));
+    TEST_ASSERT_TRUE(policy.evaluate(2150, 0));
+    policy.markNotified(2150, 0);
+    TEST_ASSERT_FALSE(policy.evaluate(2150, 1));
+}
+
+// Test that a steady value only produces heartbeats at the max interval
+void test_steady_value_heartbeat_only() {
+    configure(10, 0, 1000, 30000);
+    const ScriptStep steps[] = {{0, 2150}, {5000, 2152}, {20000, 2145}, {40000, 2151}};
+    uint32_t times[8];
+
+    int notifies = runScript(steps, 4, 3600000, times, 8);
+    // Initial value plus one heartbeat every 30 s for an hour
+    TEST_ASSERT_EQUAL(121, notifies);
+    TEST_ASSERT_EQUAL_UINT32(0, times[0]);
+    TEST_ASSERT_EQUAL_UINT32(30000, times[1]);
+    TEST_ASSERT_EQUAL_UINT32(60000, times[2]);
+}
+
+// Test that a change beyond the deadband is sent as soon as it arrives
+void test_change_notifies_promptly() {
+    configure(10, 0, 1000, 30000);
+    const ScriptStep steps[] = {{0, 2150}, {12345, 2200}};
+    uint32_t times[4];
+
+    int notifies = runScript(steps, 2, 45000, times, 4);
+    TEST_ASSERT_EQUAL(3, notifies);
+    TEST_ASSERT_EQUAL_UINT32(12345, times[1]);
+    // The heartbeat restarts from the last notification
+    TEST_ASSERT_EQUAL_UINT32(42345, times[2]);
+}
+
+// Test that bursts of changes are rate limited to the min interval
+void test_changes_are_rate_limited() {
+    configure(10, 0, 5000, 60000);
+    const ScriptStep steps[] = {{0, 0}, {1000, 100}, {2000, 200}, {3000, 300}, {9000, 400}};
+    uint32_t times[8];
+
+    int notifies = runScript(steps, 5, 12000, times, 8);
+    TEST_ASSERT_EQUAL(3, notifies);
+    TEST_ASSERT_EQUAL_UINT32(0, times[0]);
+    // Changes at 1 s to 3 s are folded into one notification when the limit expires
+    TEST_ASSERT_EQUAL_UINT32(5000, times[1]);
+    TEST_ASSERT_EQUAL_UINT32(10000, times[2]);
+}
+
+// Test that a rate-limited change reports when it becomes due
+void test_pending_change_time_until_due() {
+    configure(10, 0, 5000, 60000);
+    policy.evaluate(0, 0);
+    policy.markNotified(0, 0);
+
+    TEST_ASSERT_EQUAL_UINT32(59000, policy.timeUntilDue(1000));
+    TEST_ASSERT_FALSE(policy.evaluate(500, 1000));
+    TEST_ASSERT_EQUAL_UINT32(4000, policy.timeUntilDue(1000));
+    TEST_ASSERT_EQUAL_UINT32(0, policy.timeUntilDue(5000));
+
+    // The value drifting back inside the deadband cancels the pending notification
+    TEST_ASSERT_FALSE(policy.evaluate(5, 2000));
+    TEST_ASSERT_EQUAL_UINT32(58000, policy.timeUntilDue(2000));
+}
+
+// Test that the relative deadband scales with the magnitude of the value
+void test_relative_deadband() {
+    configure(10, 10, 0, 60000);  // 1% of the last value, at least 0.10
+    policy.evaluate(10000, 0);
+    policy.markNotified(10000, 0);
+
+    TEST_ASSERT_FALSE(policy.evaluate(10050, 100));
+    TEST_ASSERT_FALSE(policy.evaluate(9901, 200));
+    TEST_ASSERT_TRUE(policy.evaluate(10100, 300));
+    policy.markNotified(10100, 300);
+
+    // Near zero the absolute deadband takes over
+    configure(10, 10, 0, 60000);
+    policy.reset();
+    policy.evaluate(-50, 0);
+    policy.markNotified(-50, 0);
+    TEST_ASSERT_FALSE(policy.evaluate(-45, 100));
+    TEST_ASSERT_TRUE(policy.evaluate(-60, 200));
+}
+
+// Test that forceNext sends the next value even if it did not move
+void test_force_next() {
+    configure(10, 0, 1000, 30000);
+    policy.evaluate(2150, 0);
+    policy.markNotified(2150, 0);
+
+    policy.forceNext();
+    TEST_ASSERT_FALSE(policy.evaluate(2150, 500));
+    TEST_ASSERT_TRUE(policy.evaluate(2150, 1000));
+    policy.markNotified(2150, 1000);
+    TEST_ASSERT_FALSE(policy.evaluate(2150, 2000));
+}
+
+// Test that invalid settings are rejected and the config round trips the wire format
+void test_config_validation_and_encoding() {
+    NotifyPolicyConfig bad = {10, 0, 5000, 1000};
+    TEST_ASSERT_FALSE(policy.configure(bad));
+    bad.minInterval = 0;
+    bad.maxInterval = 0;
+    TEST_ASSERT_FALSE(policy.configure(bad));
+    bad.maxInterval = 1000;
+    bad.relativeDeadband = 1001;
+    TEST_ASSERT_FALSE(policy.configure(bad));
+    TEST_ASSERT_EQUAL_UINT32(NotifyPolicy::DEFAULT_MAX_INTERVAL, policy.getConfig().maxInterval);
+
+    NotifyPolicyConfig config = {25, 5, 2500, 120000};
+    uint8_t buffer[NOTIFY_POLICY_CONFIG_SIZE];
+    TEST_ASSERT_EQUAL(NOTIFY_POLICY_CONFIG_SIZE, NotifyPolicy::encodeConfig(config, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_HEX8(25, buffer[0]);
+    TEST_ASSERT_EQUAL_HEX8(120, buffer[6]);
+
+    NotifyPolicyConfig decoded;
+    TEST_ASSERT_TRUE(NotifyPolicy::decodeConfig(buffer, sizeof(buffer), decoded));
+    TEST_ASSERT_EQUAL_UINT16(25, decoded.absoluteDeadband);
+    TEST_ASSERT_EQUAL_UINT16(5, decoded.relativeDeadband);
+    TEST_ASSERT_EQUAL_UINT32(2500, decoded.minInterval);
+    TEST_ASSERT_EQUAL_UINT32(120000, decoded.maxInterval);
+    TEST_ASSERT_FALSE(NotifyPolicy::decodeConfig(buffer, sizeof(buffer) - 1, decoded));
+    TEST_ASSERT_EQUAL(0, NotifyPolicy::encodeConfig(config, buffer, 4));
+}
+
+static int changeCallbacks = 0;
+static void countChange() {
+    changeCallbacks++;
+}
+
+// Test that the temperature service raises the dirty flag on new readings and unit changes
+void test_temperature_service_dirty_flag() {
+    changeCallbacks = 0;
+    TemperatureService::setChangeCallback(countChange);
+    TemperatureService::init();
+    TEST_ASSERT_TRUE(TemperatureService::takeDirty());
+    TEST_ASSERT_FALSE(TemperatureService::isDirty());
+
+    // Nothing happens until the update interval passes
+    TemperatureService::update();
+    TEST_ASSERT_FALSE(TemperatureService::takeDirty());
+
+    NativeClock::advance(30000);
+    TemperatureService::update();
+    TEST_ASSERT_TRUE(TemperatureService::takeDirty());
+
+    TemperatureService::setUnit(FAHRENHEIT);
+    TEST_ASSERT_TRUE(TemperatureService::takeDirty());
+    TemperatureService::setUnit(FAHRENHEIT);
+    TEST_ASSERT_FALSE(TemperatureService::takeDirty());
+    TemperatureService::setUnit(CELSIUS);
+
+    TEST_ASSERT_EQUAL(4, changeCallbacks);
+    TemperatureService::setChangeCallback(nullptr);
+    TemperatureService::takeDirty();
+}
+
+void setUp(void) {
+    policy = NotifyPolicy();
+    NativeClock::set(0);
+    Scheduler::reset();
+}
+
+void tearDown(void) {
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_value_notifies);
+    RUN_TEST(test_steady_value_heartbeat_only);
+    RUN_TEST(test_change_notifies_promptly);
+    RUN_TEST(test_changes_are_rate_limited);
+    RUN_TEST(test_pending_change_time_until_due);
+    RUN_TEST(test_relative_deadband);
+    RUN_TEST(test_force_next);
+    RUN_TEST(test_config_validation_and_encoding);
+    RUN_TEST(test_temperature_service_dirty_flag);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do in loop for tests
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,162 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/scheduler.h"
+#include "../../include/power_manager.h"
+#include "../../include/ble_server.h"
+
+// Test that residency follows the lanes: idle only once every lane waits
+void test_residency_tracks_lanes() {
+    NativeClock::set(0);
+    PowerManager::reset();
+
+    // One lane waiting keeps the CPU active
+    PowerManager::enterIdle(1u << 0, 500);
+    TEST_ASSERT_EQUAL(POWER_ACTIVE, PowerManager::getState());
+    delay(100);
+
+    // The last lane to wait decides, using the earliest deadline of all
+    PowerManager::enterIdle(PowerManager::ALL_LANES & ~1u, 1000);
+    TEST_ASSERT_EQUAL(POWER_LIGHT_SLEEP, PowerManager::getState());
+    delay(400);
+    PowerManager::exitIdle(1u << 0);
+    TEST_ASSERT_EQUAL(POWER_ACTIVE, PowerManager::getState());
+
+    TEST_ASSERT_EQUAL_UINT32(100000, (uint32_t)PowerManager::getResidency(POWER_ACTIVE));
+    TEST_ASSERT_EQUAL_UINT32(400000, (uint32_t)PowerManager::getResidency(POWER_LIGHT_SLEEP));
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)PowerManager::getResidency(POWER_IDLE));
+    TEST_ASSERT_EQUAL_UINT32(1, PowerManager::getWakeups());
+}
+
+// Test that a wait too short to pay for a light-sleep entry only idles
+void test_short_wait_idles() {
+    NativeClock::set(0);
+    PowerManager::reset();
+
+    PowerManager::enterIdle(PowerManager::ALL_LANES, POWER_LIGHT_SLEEP_MIN_MS - 1);
+    TEST_ASSERT_EQUAL(POWER_IDLE, PowerManager::getState());
+    delay(POWER_LIGHT_SLEEP_MIN_MS - 1);
+    PowerManager::exitIdle(PowerManager::ALL_LANES);
+
+    PowerManager::enterIdle(PowerManager::ALL_LANES, POWER_LIGHT_SLEEP_MIN_MS);
+    TEST_ASSERT_EQUAL(POWER_LIGHT_SLEEP, PowerManager::getState());
+    PowerManager::exitIdle(PowerManager::ALL_LANES);
+    TEST_ASSERT_EQUAL_UINT32(2, PowerManager::getWakeups());
+    TEST_ASSERT_EQUAL_STRING("light sleep", PowerManager::getStateName(POWER_LIGHT_SLEEP));
+}
+
+// Test that the scheduler reports its sleeps to the power manager
+void test_scheduler_sleeps_are_counted() {
+    Scheduler::reset();
+    NativeClock::set(0);
+    PowerManager::reset();
+    Scheduler::addPeriodic("tick", []() {}, 1000);
+
+    for (int i = 0; i < 10; i++) {
+        Scheduler::runDue();
+        Scheduler::sleepUntilNext(5000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, PowerManager::getWakeups());
+    TEST_ASSERT_EQUAL_UINT32(millis() * 1000, (uint32_t)PowerManager::getResidency(POWER_LIGHT_SLEEP));
+}
+
+// The simulator only exists on the host
+#ifndef ARDUINO
+#include "sim_ble.h"
+#include "simulator.h"
+#include "power_model.h"
+
+static uint16_t central = BLE_HS_CONN_HANDLE_NONE;
+
+static void connectCentral() {
+    central = SimBLE::connect(247);
+}
+
+static void disconnectCentral() {
+    SimBLE::disconnect(central);
+    central = BLE_HS_CONN_HANDLE_NONE;
+}
+
+// Test that advertising is fast after boot and after a disconnect, slow otherwise
+void test_advertising_adapts() {
+    Simulator::begin();
+    NimBLEAdvertising* advertising = NimBLEDevice::getAdvertising();
+    TEST_ASSERT_EQUAL(ADVERTISING_FAST, BLEServerManager::getAdvertisingMode());
+    TEST_ASSERT_EQUAL_UINT16(BLEServerManager::FAST_ADVERTISING_MIN, advertising->getMinInterval());
+
+    Simulator::runFor(BLEServerManager::FAST_ADVERTISING_TIME + 2 * Simulator::SECOND);
+    TEST_ASSERT_EQUAL(ADVERTISING_SLOW, BLEServerManager::getAdvertisingMode());
+    TEST_ASSERT_EQUAL_UINT16(BLEServerManager::SLOW_ADVERTISING_MIN, advertising->getMinInterval());
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+
+    Simulator::addEvent("connect", Simulator::MINUTE, 0, connectCentral);
+    Simulator::addEvent("disconnect", 10 * Simulator::MINUTE, 0, disconnectCentral);
+    Simulator::runFor(10 * Simulator::MINUTE + 5 * Simulator::SECOND - Simulator::getElapsed());
+    TEST_ASSERT_EQUAL(ADVERTISING_FAST, BLEServerManager::getAdvertisingMode());
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+
+    Simulator::runFor(BLEServerManager::FAST_ADVERTISING_TIME + 2 * Simulator::SECOND);
+    TEST_ASSERT_EQUAL(ADVERTISING_SLOW, BLEServerManager::getAdvertisingMode());
+    // Two 30 s stretches of fast advertising in ten and a half minutes
+    PowerInputs inputs = Simulator::getPowerInputs();
+    TEST_ASSERT_UINT32_WITHIN(5000, 60000, (uint32_t)inputs.fastAdvertisingMs);
+}
+
+// Test that a simulated day sleeps between jobs and yields a plausible energy estimate
+void test_simulated_day_energy() {
+    Simulator::begin();
+    Simulator::runFor(Simulator::DAY);
+
+    PowerInputs inputs = Simulator::getPowerInputs();
+    // Time only moves in sleeps, and every sleep of a second or so is light sleep
+    TEST_ASSERT_TRUE(inputs.lightSleepUs > 99 * inputs.idleUs);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)Simulator::getLoopPasses(), inputs.wakeups);
+    TEST_ASSERT_TRUE(inputs.slowAdvertisingMs > 23 * Simulator::HOUR);
+
+    // Dominated by the WiFi association, well under a constant 240 MHz CPU
+    double perDay = PowerModel::milliampHoursPerDay(inputs);
+    TEST_ASSERT_TRUE(perDay > 24 * PowerModel::WIFI_CONNECTED_MA * 0.9);
+    TEST_ASSERT_TRUE(perDay < 24 * PowerModel::ACTIVE_MA);
+
+    // Without WiFi the radios and CPU barely draw anything
+    inputs.wifiConnectedMs = 0;
+    inputs.publishes = 0;
+    TEST_ASSERT_TRUE(PowerModel::milliampHoursPerDay(inputs) < 24 * 2.0);
+}
+#endif
+
+void setUp(void) {
+    Serial.setEnabled(false);
+}
+
+void tearDown(void) {
+#ifndef ARDUINO
+    SimBLE::reset();
+#endif
+    Serial.setEnabled(true);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_residency_tracks_lanes);
+    RUN_TEST(test_short_wait_idles);
+    RUN_TEST(test_scheduler_sleeps_are_counted);
+#ifndef ARDUINO
+    RUN_TEST(test_advertising_adapts);
+    RUN_TEST(test_simulated_day_energy);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
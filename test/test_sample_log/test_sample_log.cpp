@@ -0,0 +1,333 @@
+#include <unity.h>
+#include <unistd.h>
+#include "../../include/platform.h"
+#include "../../include/scheduler.h"
+#include "../../include/flash_storage.h"
+#include "../../include/sample_log.h"
+#include "../../include/temperature_service.h"
+#include "../../include/logger.h"
+
+static const char* IMAGE_PATH = "/tmp/esp32_sample_log_test.img";
+
+// Small sectors so a few hundred samples wrap the ring several times
+static const uint32_t SMALL_SECTOR = 256;
+static const uint32_t SMALL_SECTORS = 6;
+
+static FileFlashStorage flash;
+
+// Samples replayed by the last replay() call
+static LoggedSample replayed[1024];
+static uint32_t replayedCount = 0;
+
+static void collect(const LoggedSample& sample) {
+    if (replayedCount < 1024) {
+        replayed[replayedCount] = sample;
+    }
+    replayedCount++;
+}
+
+static LoggedSample sampleNumber(uint32_t n) {
+    LoggedSample sample;
+    sample.timestamp = n * 30000;
+    sample.centiCelsius = (int16_t)(n % 20000);
+    sample.max = (int16_t)(n % 20000);
+    sample.min = 0;
+    return sample;
+}
+
+static uint32_t numberOf(const LoggedSample& sample) {
+    return sample.timestamp / 30000;
+}
+
+void setUp(void) {
+    Logger::reset();
+    Serial.setEnabled(false);
+    Scheduler::reset();
+    NativeClock::set(0);
+    replayedCount = 0;
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+    TemperatureService::setLogStorage(nullptr);
+    flash.close();
+    unlink(IMAGE_PATH);
+}
+
+// Test that the CRC is the standard CRC-32
+void test_crc32_check_value() {
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, SampleLog::crc32("123456789", 9));
+    TEST_ASSERT_EQUAL_HEX32(0, SampleLog::crc32("", 0));
+}
+
+// Test that flushed samples come back after a reboot, in order
+void test_append_and_recover() {
+    TEST_ASSERT_TRUE(flash.open(IMAGE_PATH, 64 * 1024));
+    SampleLog log;
+    TEST_ASSERT_TRUE(log.begin(&flash));
+    for (uint32_t i = 0; i < 20; i++) {
+        TEST_ASSERT_TRUE(log.append(sampleNumber(i)));
+    }
+    // Two full batches are on flash, the rest waits for a flush
+    TEST_ASSERT_EQUAL_UINT32(2, log.getRecordsWritten());
+    TEST_ASSERT_EQUAL_UINT32(20 - 2 * SampleLog::BATCH_SIZE, log.getPendingCount());
+    TEST_ASSERT_TRUE(log.flush());
+
+    SampleLog rebooted;
+    TEST_ASSERT_TRUE(rebooted.begin(&flash));
+    SampleLogSummary summary;
+    rebooted.getSummary(summary);
+    TEST_ASSERT_EQUAL_UINT32(20, summary.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.tornRecords);
+    TEST_ASSERT_EQUAL_UINT32(19 * 30000, summary.last.timestamp);
+    TEST_ASSERT_EQUAL_INT16(19, summary.last.centiCelsius);
+
+    TEST_ASSERT_EQUAL_UINT32(20, rebooted.replay(100, collect));
+    for (uint32_t i = 0; i < 20; i++) {
+        TEST_ASSERT_EQUAL_UINT32(i, numberOf(replayed[i]));
+    }
+    replayedCount = 0;
+    TEST_ASSERT_EQUAL_UINT32(5, rebooted.replay(5, collect));
+    TEST_ASSERT_EQUAL_UINT32(15, numberOf(replayed[0]));
+
+    // Appending continues after what is already there
+    TEST_ASSERT_TRUE(rebooted.append(sampleNumber(20)));
+    TEST_ASSERT_TRUE(rebooted.flush());
+    SampleLog again;
+    again.begin(&flash);
+    again.getSummary(summary);
+    TEST_ASSERT_EQUAL_UINT32(21, summary.samples);
+}
+
+// Test that the ring wraps, keeps the newest samples and wears every sector evenly
+void test_wraps_and_levels_wear() {
+    TEST_ASSERT_TRUE(flash.open(IMAGE_PATH, SMALL_SECTOR * SMALL_SECTORS, SMALL_SECTOR));
+    SampleLog log;
+    TEST_ASSERT_TRUE(log.begin(&flash));
+    const uint32_t total = 50 * SampleLog::BATCH_SIZE * SMALL_SECTORS;
+    for (uint32_t i = 0; i < total; i++) {
+        log.append(sampleNumber(i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, log.getWriteErrors());
+
+    uint32_t least = UINT32_MAX;
+    uint32_t most = 0;
+    for (uint32_t i = 0; i < SMALL_SECTORS; i++) {
+        uint32_t erases = flash.getEraseCount(i);
+        least = erases < least ? erases : least;
+        most = erases > most ? erases : most;
+    }
+    TEST_ASSERT_TRUE(least > 0);
+    TEST_ASSERT_TRUE(most - least <= 1);
+
+    SampleLog rebooted;
+    rebooted.begin(&flash);
+    SampleLogSummary summary;
+    rebooted.getSummary(summary);
+    TEST_ASSERT_EQUAL_UINT32(SMALL_SECTORS, summary.sectorsUsed);
+    uint32_t count = rebooted.replay(UINT32_MAX, collect);
+    TEST_ASSERT_EQUAL_UINT32(summary.samples, count);
+    TEST_ASSERT_TRUE(count >= (SMALL_SECTORS - 1) * 2 * SampleLog::BATCH_SIZE);
+    for (uint32_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT32(total - count + i, numberOf(replayed[i]));
+    }
+}
+
+// Test that a record torn by a power cut is dropped and the log carries on
+void test_torn_tail_is_discarded() {
+    TEST_ASSERT_TRUE(flash.open(IMAGE_PATH, 64 * 1024));
+    SampleLog log;
+    log.begin(&flash);
+    for (uint32_t i = 0; i < 2 * SampleLog::BATCH_SIZE; i++) {
+        log.append(sampleNumber(i));
+    }
+    // The third batch loses power half way through its record
+    flash.cutPowerAfter(40, 7);
+    for (uint32_t i = 2 * SampleLog::BATCH_SIZE; i < 3 * SampleLog::BATCH_SIZE; i++) {
+        log.append(sampleNumber(i));
+    }
+    TEST_ASSERT_FALSE(flash.isPowered());
+    flash.restorePower();
+
+    SampleLog rebooted;
+    rebooted.begin(&flash);
+    SampleLogSummary summary;
+    rebooted.getSummary(summary);
+    TEST_ASSERT_EQUAL_UINT32(2 * SampleLog::BATCH_SIZE, summary.samples);
+    TEST_ASSERT_EQUAL_UINT32(1, summary.tornRecords);
+    TEST_ASSERT_EQUAL_UINT32(2 * SampleLog::BATCH_SIZE - 1, numberOf(summary.last));
+
+    // New samples go to a fresh sector, after the surviving ones
+    for (uint32_t i = 100; i < 100 + SampleLog::BATCH_SIZE; i++) {
+        rebooted.append(sampleNumber(i));
+    }
+    SampleLog again;
+    again.begin(&flash);
+    again.getSummary(summary);
+    TEST_ASSERT_EQUAL_UINT32(3 * SampleLog::BATCH_SIZE, summary.samples);
+    TEST_ASSERT_EQUAL_UINT32(100 + SampleLog::BATCH_SIZE - 1, numberOf(summary.last));
+    again.replay(UINT32_MAX, collect);
+    TEST_ASSERT_EQUAL_UINT32(2 * SampleLog::BATCH_SIZE - 1, numberOf(replayed[2 * SampleLog::BATCH_SIZE - 1]));
+    TEST_ASSERT_EQUAL_UINT32(100, numberOf(replayed[2 * SampleLog::BATCH_SIZE]));
+}
+
+// Recovers, checks that the replay is one gap-free run ending at or after
+// the last durable sample, and returns the number after the newest one
+static uint32_t recoverAndCheck(uint32_t durable, uint32_t& newest) {
+    SampleLog log;
+    TEST_ASSERT_TRUE(log.begin(&flash));
+    SampleLogSummary summary;
+    log.getSummary(summary);
+    replayedCount = 0;
+    uint32_t count = log.replay(UINT32_MAX, collect);
+    TEST_ASSERT_EQUAL_UINT32(summary.samples, count);
+    if (count == 0) {
+        TEST_ASSERT_EQUAL_UINT32(0, durable);
+        newest = 0;
+        return 0;
+    }
+    for (uint32_t i = 1; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT32(numberOf(replayed[i - 1]) + 1, numberOf(replayed[i]));
+        TEST_ASSERT_EQUAL_INT16(replayed[i].timestamp / 30000 % 20000, replayed[i].centiCelsius);
+    }
+    newest = numberOf(replayed[count - 1]);
+    TEST_ASSERT_EQUAL_UINT32(newest, numberOf(summary.last));
+    TEST_ASSERT_TRUE(newest + 1 >= durable);
+    TEST_ASSERT_TRUE(newest + 1 <= durable + SampleLog::BATCH_SIZE);
+    return count;
+}
+
+// Test that no power cut, in any write or erase, loses a flushed sample or
+// lets a damaged one through, and that the log keeps working afterwards
+void test_power_cut_fuzz() {
+    TEST_ASSERT_TRUE(flash.open(IMAGE_PATH, SMALL_SECTOR * SMALL_SECTORS, SMALL_SECTOR));
+    uint32_t random = 12345;
+    for (uint32_t round = 0; round < 1000; round++) {
+        flash.format();
+        flash.restorePower();
+        uint32_t next = 0;
+        uint32_t durable = 0;
+
+        // Three boots, each cut short at a random point
+        for (int boot = 0; boot < 3; boot++) {
+            if (boot > 0) {
+                uint32_t newest;
+                next = recoverAndCheck(durable, newest) > 0 ? newest + 1 : 0;
+                durable = next;
+            }
+            SampleLog log;
+            TEST_ASSERT_TRUE(log.begin(&flash));
+            random = random * 1103515245u + 12345u;
+            flash.cutPowerAfter((random >> 8) % 6000, random);
+            for (uint32_t i = 0; i < 200 && flash.isPowered(); i++) {
+                log.append(sampleNumber(next++));
+                random = random * 1103515245u + 12345u;
+                if ((random >> 16) % 16 == 0) {
+                    log.flush();
+                }
+                if (flash.isPowered()) {
+                    durable = next - log.getPendingCount();
+                }
+            }
+            flash.restorePower();
+        }
+        uint32_t newest;
+        recoverAndCheck(durable, newest);
+    }
+}
+
+// Test that a reboot brings back max/min, the current value and the history
+void test_service_restores_from_log() {
+    TEST_ASSERT_TRUE(flash.open(IMAGE_PATH, 64 * 1024));
+    static const int16_t VALUES[] = { 2000, 2500, 1500, 2200, 3100 };
+    ReplayTemperatureSensor replay("replay", VALUES, 5);
+    TemperatureService::clearSensors();
+    TemperatureService::addSensor(&replay);
+    TemperatureService::setLogStorage(&flash);
+    TemperatureService::init();
+    for (int i = 0; i < 23; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::sample();
+    }
+    TemperatureService::writeLog();
+    TEST_ASSERT_TRUE(TemperatureService::flushLog());
+    TemperatureSnapshot before;
+    TemperatureService::getSnapshot(before);
+    TEST_ASSERT_EQUAL_UINT32(23, before.sequence);
+    TEST_ASSERT_TRUE(before.max > before.min);
+
+    // Reboot with the clock starting over; a slow sensor keeps init() from
+    // taking a reading of its own before we look
+    ReplayTemperatureSensor slow("slow", VALUES, 5, 750);
+    TemperatureService::clearSensors();
+    TemperatureService::addSensor(&slow);
+    NativeClock::set(1000);
+    Scheduler::reset();
+    TemperatureService::init();
+
+    TemperatureSnapshot after;
+    TemperatureService::getSnapshot(after);
+    TEST_ASSERT_EQUAL_UINT32(before.sequence, after.sequence);
+    TEST_ASSERT_EQUAL_INT16(before.current, after.current);
+    TEST_ASSERT_EQUAL_INT16(before.max, after.max);
+    TEST_ASSERT_EQUAL_INT16(before.min, after.min);
+    // The log's time continues: the last sample was one interval ago
+    TEST_ASSERT_EQUAL_UINT32(1000 - 30000, after.timestamp);
+    const TemperatureHistory& history = TemperatureService::getHistory();
+    TEST_ASSERT_EQUAL_UINT32(24, history.size());
+    HistorySample sample;
+    TEST_ASSERT_TRUE(history.getSample(0, sample));
+    TEST_ASSERT_EQUAL_UINT32(1000 - 24 * 30000, sample.timestamp);
+    TemperatureService::clearSensors();
+}
+
+// Test that recovering a full 1 MB log reads each sector once and nothing twice
+void test_full_scan_work_is_bounded() {
+    const uint32_t sectorSize = 4096;
+    TEST_ASSERT_TRUE(flash.open(IMAGE_PATH, SampleLog::MAX_SECTORS * sectorSize, sectorSize));
+    SampleLog log;
+    TEST_ASSERT_TRUE(log.begin(&flash));
+    // Enough to wrap the ring, so every sector is full
+    for (uint32_t n = 0; n < 120000; n++) {
+        log.append(sampleNumber(n));
+    }
+    TEST_ASSERT_TRUE(log.flush());
+
+    flash.readCount = 0;
+    flash.bytesRead = 0;
+    SampleLog recovered;
+    TEST_ASSERT_TRUE(recovered.begin(&flash));
+    SampleLogSummary summary;
+    recovered.getSummary(summary);
+    TEST_ASSERT_EQUAL_UINT32(SampleLog::MAX_SECTORS, summary.sectorsUsed);
+    TEST_ASSERT_EQUAL_UINT32(119999, numberOf(summary.last));
+    // The scan, plus at most one more read for the newest sample
+    TEST_ASSERT_TRUE(flash.readCount <= SampleLog::MAX_SECTORS + 1);
+    TEST_ASSERT_TRUE(flash.bytesRead <= (SampleLog::MAX_SECTORS + 1) * sectorSize);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc32_check_value);
+    RUN_TEST(test_append_and_recover);
+    RUN_TEST(test_wraps_and_levels_wear);
+    RUN_TEST(test_torn_tail_is_discarded);
+    RUN_TEST(test_power_cut_fuzz);
+    RUN_TEST(test_service_restores_from_log);
+    RUN_TEST(test_full_scan_work_is_bounded);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
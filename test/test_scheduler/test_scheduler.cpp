@@ -0,0 +1,250 @@
+#include <unity.h>
+#include <string.h>
+#include "../../include/platform.h"
+#include "../../include/scheduler.h"
+
+// Execution log shared by the test jobs
+static char runLog[64];
+static int runLogLength = 0;
+
+static void logRun(char tag) {
+    if (runLogLength < (int)sizeof(runLog) - 1) {
+        runLog[runLogLength++] = tag;
+        runLog[runLogLength] = '\0';
+    }
+}
+
+static void jobA() { logRun('A'); }
+static void jobB() { logRun('B'); }
+static void jobC() { logRun('C'); }
+
+static int selfCancelId = Scheduler::INVALID_TASK;
+static void jobSelfCancel() {
+    logRun('S');
+    Scheduler::cancel(selfCancelId);
+}
+
+// Test that due jobs run in deadline order
+void test_scheduler_runs_in_deadline_order() {
+    Scheduler::addPeriodic("a", jobA, 1000, 30, 0);
+    Scheduler::addPeriodic("b", jobB, 1000, 10, 0);
+    Scheduler::addPeriodic("c", jobC, 1000, 20, 0);
+
+    TEST_ASSERT_EQUAL(3, Scheduler::runDue(30));
+    TEST_ASSERT_EQUAL_STRING("BCA", runLog);
+}
+
+// Test that jobs sharing a deadline run in registration order
+void test_scheduler_ties_run_in_registration_order() {
+    Scheduler::addPeriodic("c", jobC, 100, 0, 0);
+    Scheduler::addPeriodic("a", jobA, 100, 0, 0);
+    Scheduler::addPeriodic("b", jobB, 100, 0, 0);
+
+    Scheduler::runDue(0);
+    Scheduler::runDue(100);
+    TEST_ASSERT_EQUAL_STRING("CABCAB", runLog);
+}
+
+// Test that nothing runs before its deadline
+void test_scheduler_does_not_run_early() {
+    Scheduler::addPeriodic("a", jobA, 100, 50, 0);
+
+    TEST_ASSERT_EQUAL(0, Scheduler::runDue(49));
+    TEST_ASSERT_EQUAL(50 - 10, (int)Scheduler::timeUntilNext(10));
+    TEST_ASSERT_EQUAL(1, Scheduler::runDue(50));
+    TEST_ASSERT_EQUAL(100, (int)Scheduler::timeUntilNext(50));
+}
+
+// Test that irregular loop timing does not accumulate drift
+void test_scheduler_fixed_rate_has_no_drift() {
+    static const uint32_t steps[] = {7, 13, 37, 3, 61, 29, 11};
+    int id = Scheduler::addPeriodic("a", jobA, 100, 100, 0);
+
+    uint32_t now = 0;
+    uint32_t maxStep = 0;
+    for (int i = 0; now < 100000; i++) {
+        uint32_t step = steps[i % 7];
+        if (step > maxStep) {
+            maxStep = step;
+        }
+        now += step;
+        Scheduler::runDue(now);
+    }
+
+    // One run per period boundary crossed, and lateness bounded by the step size
+    TEST_ASSERT_EQUAL(now / 100, Scheduler::getRunCount(id));
+    TEST_ASSERT_LESS_THAN(maxStep, Scheduler::getMaxLateness(id));
+    TEST_ASSERT_EQUAL(100 - (now % 100), (int)Scheduler::timeUntilNext(now));
+}
+
+// Test that a stalled loop skips missed periods instead of bursting
+void test_scheduler_skips_missed_periods() {
+    int id = Scheduler::addPeriodic("a", jobA, 100, 100, 0);
+
+    TEST_ASSERT_EQUAL(1, Scheduler::runDue(1050));
+    TEST_ASSERT_EQUAL(1, (int)Scheduler::getRunCount(id));
+    // Next deadline stays on the original 100 ms grid
+    TEST_ASSERT_EQUAL(50, (int)Scheduler::timeUntilNext(1050));
+}
+
+// Test that a loop sleeping until the next deadline runs every job on time
+void test_scheduler_sleep_until_next_has_zero_jitter() {
+    NativeClock::set(0);
+    int a = Scheduler::addPeriodic("a", jobA, 30, 30);
+    int b = Scheduler::addPeriodic("b", jobB, 70, 70);
+
+    while (millis() <= 21000) {
+        Scheduler::runDue();
+        Scheduler::sleepUntilNext(1000);
+    }
+
+    TEST_ASSERT_EQUAL(700, (int)Scheduler::getRunCount(a));
+    TEST_ASSERT_EQUAL(300, (int)Scheduler::getRunCount(b));
+    TEST_ASSERT_EQUAL(0, (int)Scheduler::getMaxLateness(a));
+    TEST_ASSERT_EQUAL(0, (int)Scheduler::getMaxLateness(b));
+}
+
+// Test that deadlines survive the 32-bit millis() wraparound
+void test_scheduler_handles_millis_wraparound() {
+    uint32_t start = 0xFFFFFF00u;
+    int id = Scheduler::addPeriodic("a", jobA, 100, 100, start);
+
+    uint32_t now = start;
+    for (int i = 0; i < 100; i++) {
+        now += 10;
+        Scheduler::runDue(now);
+    }
+
+    TEST_ASSERT_EQUAL(10, (int)Scheduler::getRunCount(id));
+    TEST_ASSERT_EQUAL(0, (int)Scheduler::getMaxLateness(id));
+}
+
+// Test one-shot jobs run once and release their slot
+void test_scheduler_one_shot() {
+    int id = Scheduler::addOneShot("a", jobA, 10, 0);
+
+    Scheduler::runDue(10);
+    Scheduler::runDue(1000);
+    TEST_ASSERT_EQUAL_STRING("A", runLog);
+    TEST_ASSERT_FALSE(Scheduler::isScheduled(id));
+    TEST_ASSERT_EQUAL(0, Scheduler::taskCount());
+}
+
+// Test cancellation, including a job cancelling itself
+void test_scheduler_cancel() {
+    int a = Scheduler::addPeriodic("a", jobA, 10, 10, 0);
+    selfCancelId = Scheduler::addPeriodic("s", jobSelfCancel, 10, 10, 0);
+
+    TEST_ASSERT_TRUE(Scheduler::cancel(a));
+    TEST_ASSERT_FALSE(Scheduler::cancel(a));
+    Scheduler::runDue(10);
+    Scheduler::runDue(20);
+    TEST_ASSERT_EQUAL_STRING("S", runLog);
+    TEST_ASSERT_EQUAL(0, Scheduler::taskCount());
+}
+
+// Test that a triggered job runs on the next pass ahead of its deadline
+void test_scheduler_trigger_runs_early() {
+    int a = Scheduler::addPeriodic("a", jobA, 1000, 1000, 0);
+    Scheduler::addPeriodic("b", jobB, 1000, 1000, 0);
+
+    Scheduler::trigger(a);
+    TEST_ASSERT_EQUAL(0, (int)Scheduler::timeUntilNext(5));
+    TEST_ASSERT_EQUAL(1, Scheduler::runDue(5));
+    TEST_ASSERT_EQUAL_STRING("A", runLog);
+    // The triggered job keeps its period from the run it just made
+    TEST_ASSERT_EQUAL(1, Scheduler::runDue(1000));
+    TEST_ASSERT_EQUAL_STRING("AB", runLog);
+    TEST_ASSERT_EQUAL(5, (int)Scheduler::timeUntilNext(1000));
+}
+
+// Test changing a period keeps the phase of the last run
+void test_scheduler_set_period() {
+    int id = Scheduler::addPeriodic("a", jobA, 1000, 0, 0);
+
+    Scheduler::runDue(0);
+    TEST_ASSERT_TRUE(Scheduler::setPeriod(id, 200));
+    TEST_ASSERT_EQUAL(200, (int)Scheduler::timeUntilNext(0));
+    TEST_ASSERT_FALSE(Scheduler::setPeriod(id, 0));
+}
+
+// Test that the fixed-size task table refuses to overflow
+void test_scheduler_capacity() {
+    for (int i = 0; i < Scheduler::MAX_TASKS; i++) {
+        TEST_ASSERT_NOT_EQUAL(Scheduler::INVALID_TASK, Scheduler::addPeriodic("x", jobA, 10, 0, 0));
+    }
+    TEST_ASSERT_EQUAL(Scheduler::INVALID_TASK, Scheduler::addPeriodic("x", jobA, 10, 0, 0));
+    TEST_ASSERT_EQUAL(Scheduler::INVALID_TASK, Scheduler::addPeriodic("x", nullptr, 10, 0, 0));
+}
+
+// Test that each lane only runs its own jobs and ids stay unique across lanes
+void test_scheduler_lanes_are_independent() {
+    int a = Scheduler::addPeriodic("a", jobA, 1000, 1000, 0);
+    Scheduler::setLane(1);
+    int b = Scheduler::addPeriodic("b", jobB, 100, 100, 0);
+    for (int i = 1; i < Scheduler::MAX_TASKS; i++) {
+        TEST_ASSERT_NOT_EQUAL(Scheduler::INVALID_TASK, Scheduler::addPeriodic("x", jobC, 1000, 1000, 0));
+    }
+    TEST_ASSERT_NOT_EQUAL(a, b);
+    TEST_ASSERT_EQUAL_STRING("b", Scheduler::getName(b));
+
+    // A full lane does not affect the others
+    Scheduler::setLane(2);
+    TEST_ASSERT_NOT_EQUAL(Scheduler::INVALID_TASK, Scheduler::addPeriodic("c", jobC, 100, 500, 0));
+
+    Scheduler::setLane(1);
+    TEST_ASSERT_EQUAL(1, Scheduler::runDue(100));
+    TEST_ASSERT_EQUAL_STRING("B", runLog);
+
+    // A trigger lands in the job's own lane, whichever lane calls it
+    Scheduler::trigger(a);
+    TEST_ASSERT_EQUAL(0, Scheduler::runDue(150));
+    Scheduler::setLane(0);
+    TEST_ASSERT_EQUAL(0, (int)Scheduler::timeUntilNext(150));
+    TEST_ASSERT_EQUAL(1, Scheduler::runDue(150));
+    TEST_ASSERT_EQUAL_STRING("BA", runLog);
+}
+
+void setUp(void) {
+    Scheduler::reset();
+    NativeClock::set(0);
+    runLog[0] = '\0';
+    runLogLength = 0;
+}
+
+void tearDown(void) {
+    // Clean up after tests
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_scheduler_runs_in_deadline_order);
+    RUN_TEST(test_scheduler_ties_run_in_registration_order);
+    RUN_TEST(test_scheduler_does_not_run_early);
+    RUN_TEST(test_scheduler_fixed_rate_has_no_drift);
+    RUN_TEST(test_scheduler_skips_missed_periods);
+    RUN_TEST(test_scheduler_sleep_until_next_has_zero_jitter);
+    RUN_TEST(test_scheduler_handles_millis_wraparound);
+    RUN_TEST(test_scheduler_one_shot);
+    RUN_TEST(test_scheduler_cancel);
+    RUN_TEST(test_scheduler_trigger_runs_early);
+    RUN_TEST(test_scheduler_set_period);
+    RUN_TEST(test_scheduler_capacity);
+    RUN_TEST(test_scheduler_lanes_are_independent);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do in loop for tests
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,120 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/ble_server.h"
+#include "../../include/temperature_service.h"
+#include "../../include/wifi_manager.h"
+
+// The simulator only exists on the host
+#ifndef ARDUINO
+#include "sim_ble.h"
+#include "simulator.h"
+
+static uint16_t central = BLE_HS_CONN_HANDLE_NONE;
+
+static void connectCentral() {
+    central = SimBLE::connect(247);
+    SimBLE::subscribe(central, CHARACTERISTIC_UUID);
+    SimBLE::subscribe(central, TEMP_PACKED_CHAR_UUID);
+}
+
+static void disconnectCentral() {
+    SimBLE::disconnect(central);
+    central = BLE_HS_CONN_HANDLE_NONE;
+}
+
+// Test that a simulated day without clients stays idle between deadlines
+void test_simulated_day_idle() {
+    Simulator::begin();
+    Simulator::runFor(Simulator::DAY);
+
+    TEST_ASSERT_TRUE(Simulator::getElapsed() >= Simulator::DAY);
+    // Only the 1 s WiFi and BLE polls wake the loop; there is no busy waiting
+    TEST_ASSERT_LESS_OR_EQUAL(100000, (uint32_t)Simulator::getLoopPasses());
+    TEST_ASSERT_EQUAL_UINT32(0, SimBLE::getNotifyCount());
+    TEST_ASSERT_TRUE(SimBLE::isAdvertising());
+    TEST_ASSERT_TRUE(WiFiManager::isConnected());
+
+    // Characteristic values change once per sample, not once per loop pass
+    uint32_t samples = TemperatureService::getSequence() + 1;
+    TEST_ASSERT_EQUAL_UINT32(samples, SimBLE::getSetValueCount(TEMP_PACKED_CHAR_UUID));
+}
+
+// Test notification counts for a client connected for part of the day
+void test_simulated_client_session() {
+    Simulator::begin();
+    Simulator::addEvent("connect", Simulator::HOUR, 0, connectCentral);
+    Simulator::addEvent("disconnect", 3 * Simulator::HOUR, 0, disconnectCentral);
+    Simulator::runFor(4 * Simulator::HOUR);
+
+    TEST_ASSERT_EQUAL_UINT32(1, SimBLE::getConnectCount());
+    TEST_ASSERT_FALSE(BLEServerManager::isConnected());
+
+    // Two hours of counter notifications every 3 s
+    TEST_ASSERT_UINT32_WITHIN(2, 2400, SimBLE::getNotifyCount(CHARACTERISTIC_UUID));
+    // A steady temperature only produces the 30 s heartbeat
+    TEST_ASSERT_UINT32_WITHIN(2, 240, SimBLE::getNotifyCount(TEMP_PACKED_CHAR_UUID));
+    TEST_ASSERT_EQUAL_UINT32(0, SimBLE::getNotifyCount(TEMPERATURE_CHAR_UUID));
+}
+
+static void dropAccessPoint() {
+    Simulator::getRadio().setAccessPoint(false);
+}
+
+static void restoreAccessPoint() {
+    Simulator::getRadio().setAccessPoint(true);
+}
+
+// Test that WiFi recovers after the access point disappears for a while
+void test_simulated_access_point_outage() {
+    Simulator::begin();
+    Simulator::addEvent("ap-down", Simulator::HOUR, 0, dropAccessPoint);
+    Simulator::addEvent("ap-up", Simulator::HOUR + 10 * Simulator::MINUTE, 0, restoreAccessPoint);
+
+    Simulator::runFor(Simulator::HOUR + 5 * Simulator::MINUTE);
+    TEST_ASSERT_FALSE(WiFiManager::isConnected());
+
+    // The backoff caps at 5 minutes, so the link is back well within that
+    Simulator::runFor(10 * Simulator::MINUTE);
+    TEST_ASSERT_TRUE(WiFiManager::isConnected());
+}
+
+void setUp(void) {
+    Serial.setEnabled(false);
+}
+
+void tearDown(void) {
+    SimBLE::reset();
+    Serial.setEnabled(true);
+}
+#else
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+#endif
+
+int runUnityTests() {
+    UNITY_BEGIN();
+#ifndef ARDUINO
+    RUN_TEST(test_simulated_day_idle);
+    RUN_TEST(test_simulated_client_session);
+    RUN_TEST(test_simulated_access_point_outage);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do in loop for tests
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
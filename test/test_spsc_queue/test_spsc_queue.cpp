@@ -0,0 +1,122 @@
+#include <unity.h>
+#include <thread>
+#include "../../include/spsc_queue.h"
+#include "../../include/temperature_service.h"
+#include "../../include/logger.h"
+
+struct Item {
+    uint32_t sequence;
+    uint32_t check;     // derived from sequence, catches torn copies
+};
+
+static const uint32_t STRESS_ITEMS = 1000000;
+
+void setUp(void) {
+    Logger::reset();
+    Serial.setEnabled(false);
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+}
+
+// Test FIFO order and the full/empty edges across the index wrap
+void test_queue_fifo_and_capacity() {
+    static SpscQueue<uint32_t, 4> queue;
+    uint32_t value = 0;
+    TEST_ASSERT_FALSE(queue.pop(value));
+    for (uint32_t round = 0; round < 10; round++) {
+        for (uint32_t i = 0; i < 4; i++) {
+            TEST_ASSERT_TRUE(queue.push(round * 4 + i));
+        }
+        TEST_ASSERT_FALSE(queue.push(99));
+        TEST_ASSERT_EQUAL_UINT32(4, queue.size());
+        for (uint32_t i = 0; i < 4; i++) {
+            TEST_ASSERT_TRUE(queue.pop(value));
+            TEST_ASSERT_EQUAL_UINT32(round * 4 + i, value);
+        }
+        TEST_ASSERT_TRUE(queue.empty());
+    }
+}
+
+// Test that a producer and a consumer thread hand over every item intact and in order
+void test_queue_threads_keep_order() {
+    static SpscQueue<Item, 64> queue;
+    queue.clear();
+
+    std::thread producer([]() {
+        for (uint32_t i = 0; i < STRESS_ITEMS; i++) {
+            Item item = { i, i * 2654435761u };
+            while (!queue.push(item)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    uint32_t errors = 0;
+    Item item;
+    while (expected < STRESS_ITEMS) {
+        if (!queue.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item.sequence != expected || item.check != expected * 2654435761u) {
+            errors++;
+        }
+        expected++;
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+// Test the sampling/publishing split with acquire() and processSamples() on separate threads
+void test_temperature_handoff_between_threads() {
+    static const uint32_t SAMPLES = 20000;
+    TemperatureService::setChangeCallback(nullptr);
+    TemperatureService::init();
+    uint32_t startSequence = TemperatureService::getSequence();
+
+    volatile bool producing = true;
+    std::thread sampler([&producing]() {
+        for (uint32_t i = 0; i < SAMPLES; i++) {
+            TemperatureService::acquire();
+        }
+        __atomic_store_n(&producing, false, __ATOMIC_RELEASE);
+    });
+
+    uint32_t processed = 0;
+    while (__atomic_load_n(&producing, __ATOMIC_ACQUIRE)) {
+        processed += TemperatureService::processSamples();
+    }
+    sampler.join();
+    processed += TemperatureService::processSamples();
+
+    // Every sample is either published or counted as dropped, never both or neither
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES, processed + TemperatureService::getDroppedSamples());
+    TEST_ASSERT_EQUAL_UINT32(startSequence + processed, TemperatureService::getSequence());
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_queue_fifo_and_capacity);
+    RUN_TEST(test_queue_threads_keep_order);
+    RUN_TEST(test_temperature_handoff_between_threads);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,235 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/scheduler.h"
+#include "../../include/temperature_service.h"
+#include "../../include/wifi_manager.h"
+#include "../../include/telemetry_uplink.h"
+#include "../../include/logger.h"
+
+static FakeWiFiRadio radio;
+static FakeTelemetryTransport server;
+
+// Runs the firmware's jobs on the virtual clock, every lane on this thread
+static void runFor(uint32_t durationMs) {
+    uint32_t end = (uint32_t)millis() + durationMs;
+    while ((int32_t)(millis() - end) < 0) {
+        Scheduler::runDue();
+        Scheduler::sleepUntilNext(1000);
+    }
+}
+
+static void processJob() {
+    TemperatureService::processSamples();
+}
+
+static void startFirmware() {
+    TemperatureService::init();
+    WiFiManager::init();
+    TelemetryUplink::init();
+    Scheduler::addPeriodic("process", processJob, 1000);
+    Scheduler::addPeriodic("uplink-collect", TelemetryUplink::collect, TelemetryUplink::COLLECT_INTERVAL);
+}
+
+static void connectWiFi() {
+    WiFiManager::connect();
+    radio.emit(RADIO_EVENT_GOT_IP);
+    WiFiManager::loop();
+}
+
+// Every acked sample exactly once, in order, with nothing missing
+static void assertContiguous(uint32_t first, uint32_t count) {
+    TEST_ASSERT_EQUAL_UINT32(count, server.sequences.size());
+    for (uint32_t i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_UINT32(first + i, server.sequences[i]);
+    }
+}
+
+void setUp(void) {
+    Logger::reset();
+    Serial.setEnabled(false);
+    Scheduler::reset();
+    NativeClock::set(0);
+    radio.reset();
+    WiFiManager::setRadio(&radio);
+    server.reset();
+    TelemetryUplink::setTransport(&server);
+    TemperatureService::clearSensors();
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+}
+
+// Test that samples go out in batches, on the interval or as soon as a batch is full
+void test_publishes_batches() {
+    startFirmware();
+    connectWiFi();
+    runFor(20 * 60000UL);
+
+    // 40 samples in 20 minutes: interval batches of about ten, none acked twice
+    TEST_ASSERT_EQUAL_UINT32(3, TelemetryUplink::getPublishedBatches());
+    TEST_ASSERT_EQUAL(3, server.ackCount);
+    TEST_ASSERT_TRUE(server.sequences.size() >= 30);
+    assertContiguous(0, server.sequences.size());
+    uint32_t acked = 0;
+    TEST_ASSERT_TRUE(TelemetryUplink::getAckedSequence(acked));
+    TEST_ASSERT_EQUAL_UINT32(server.sequences.back(), acked);
+    TEST_ASSERT_TRUE(server.lastPayload.find("{\"uptime\":") == 0);
+    TEST_ASSERT_EQUAL_UINT32(0, TelemetryUplink::getFailedPublishes());
+}
+
+// Test that a backlog built up offline is sent in full batches right after connecting
+void test_backlog_goes_out_in_full_batches() {
+    startFirmware();
+    runFor(20 * 60000UL);
+    TEST_ASSERT_EQUAL(0, server.publishCount);
+    TEST_ASSERT_EQUAL_UINT32(40, TelemetryUplink::getQueuedSamples());
+
+    connectWiFi();
+    runFor(5000);
+    // Two full batches back to back; the rest waits for the batch interval
+    TEST_ASSERT_EQUAL(2, server.ackCount);
+    assertContiguous(0, 2 * TelemetryUplink::BATCH_SAMPLES);
+    TEST_ASSERT_EQUAL_UINT32(0, TelemetryUplink::getDownsampledSamples());
+}
+
+// Test that a publish cut off by a WiFi drop is resent after the last ack once WiFi is back
+void test_resumes_after_last_ack() {
+    startFirmware();
+    connectWiFi();
+    runFor(6 * 60000UL);
+    TEST_ASSERT_EQUAL(1, server.ackCount);
+    uint32_t acked = 0;
+    TelemetryUplink::getAckedSequence(acked);
+
+    // The next publish is still waiting for its ack when the link drops
+    server.setLatency(10000);
+    while (!server.isBusy()) {
+        runFor(1000);
+        TEST_ASSERT_TRUE(millis() < 20 * 60000UL);
+    }
+    radio.emit(RADIO_EVENT_DISCONNECTED);
+    runFor(30 * 60000UL);
+    TEST_ASSERT_EQUAL(1, server.cancelCount);
+    TEST_ASSERT_EQUAL(1, server.ackCount);
+
+    server.setLatency(0);
+    connectWiFi();
+    runFor(10000);
+    uint32_t resumed = 0;
+    TelemetryUplink::getAckedSequence(resumed);
+    TEST_ASSERT_TRUE(resumed > acked);
+    // Nothing lost, nothing sent twice across the drop
+    assertContiguous(0, resumed + 1);
+}
+
+// Test that failed publishes back off instead of hammering the server, then catch up
+void test_backs_off_while_server_is_down() {
+    startFirmware();
+    connectWiFi();
+    server.setOnline(false);
+    runFor(30 * 60000UL);
+
+    // One attempt per backoff step (5 s doubling to 5 min), not one per pass
+    TEST_ASSERT_TRUE(server.publishCount >= 4);
+    TEST_ASSERT_TRUE(server.publishCount <= 16);
+    TEST_ASSERT_EQUAL_UINT32(server.publishCount, TelemetryUplink::getFailedPublishes());
+    TEST_ASSERT_EQUAL(0, server.ackCount);
+
+    server.setOnline(true);
+    runFor(10 * 60000UL);
+    TEST_ASSERT_TRUE(server.ackCount > 0);
+    assertContiguous(0, server.sequences.size());
+    TEST_ASSERT_TRUE(server.sequences.size() >= 70);
+}
+
+// Test that an outage longer than the history is thinned out and the overwritten part counted
+void test_long_outage_downsamples_and_drops() {
+    TemperatureService::init();
+    WiFiManager::init();
+    TelemetryUplink::init();
+    uint32_t capacity = TemperatureService::getHistory().getCapacity();
+
+    // 40 hours offline: the queue fills and the history wraps past the collector
+    for (uint32_t i = 0; i < capacity + 800; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::sample();
+        TelemetryUplink::collect();
+        TelemetryUplink::loop();
+    }
+    uint32_t next = TemperatureService::getHistory().getNextSequence();
+    uint32_t held = TelemetryUplink::QUEUE_SIZE + TelemetryUplink::BATCH_SAMPLES;
+    TEST_ASSERT_EQUAL_UINT32(held, TelemetryUplink::getQueuedSamples());
+    TEST_ASSERT_EQUAL_UINT32(next - capacity - held, TelemetryUplink::getDroppedSamples());
+
+    connectWiFi();
+    while (server.sequences.empty() || server.sequences.back() != next - 1) {
+        NativeClock::advance(1000);
+        TelemetryUplink::collect();
+        TelemetryUplink::loop();
+        TEST_ASSERT_TRUE(server.publishCount < 100);
+    }
+    TEST_ASSERT_TRUE(TelemetryUplink::getDownsampledSamples() > 0);
+    // Strictly increasing, with the whole retained history covered by a few hundred samples
+    TEST_ASSERT_TRUE(server.sequences.size() <= held + TelemetryUplink::BACKLOG_SAMPLES);
+    for (size_t i = 1; i < server.sequences.size(); i++) {
+        TEST_ASSERT_TRUE(server.sequences[i] > server.sequences[i - 1]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(next - held - TelemetryUplink::getDroppedSamples() -
+                                 TelemetryUplink::getDownsampledSamples(),
+                             server.sequences.size() - held);
+}
+
+// Test that a batch over the transport limit is split instead of being mistaken for a busy link
+void test_oversized_batch_is_split() {
+    startFirmware();
+    runFor(10 * 60000UL);
+    // Room for the header and about five samples
+    server.setMaxPayload(200);
+
+    connectWiFi();
+    runFor(5000);
+    TEST_ASSERT_TRUE(TelemetryUplink::getOversizedBatches() > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, TelemetryUplink::getFailedPublishes());
+    TEST_ASSERT_TRUE(server.lastPayload.size() <= 200);
+    // Every sample still goes out once, in order
+    TEST_ASSERT_TRUE(server.ackCount > 1);
+    assertContiguous(0, server.sequences.size());
+    TEST_ASSERT_TRUE(server.sequences.size() >= TelemetryUplink::BATCH_SAMPLES);
+
+    // A limit too small for a single sample backs off and holds on to the batch
+    uint32_t sent = server.sequences.size();
+    server.setMaxPayload(20);
+    runFor(10 * 60000UL);
+    TEST_ASSERT_EQUAL_UINT32(sent, server.sequences.size());
+    TEST_ASSERT_TRUE(TelemetryUplink::getOversizedBatches() <= 20);
+    server.setMaxPayload(FakeTelemetryTransport::DEFAULT_MAX_PAYLOAD);
+    runFor(10 * 60000UL);
+    assertContiguous(0, server.sequences.size());
+    TEST_ASSERT_TRUE(server.sequences.size() > sent);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_publishes_batches);
+    RUN_TEST(test_backlog_goes_out_in_full_batches);
+    RUN_TEST(test_resumes_after_last_ack);
+    RUN_TEST(test_backs_off_while_server_is_down);
+    RUN_TEST(test_long_outage_downsamples_and_drops);
+    RUN_TEST(test_oversized_batch_is_split);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,178 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/scheduler.h"
+#include "../../include/temperature_filter.h"
+#include "../../include/temperature_service.h"
+#include "../../include/logger.h"
+
+static const int32_t BASE = 2000;
+static const int32_t SPIKE = 9000;
+
+void setUp(void) {
+    Logger::reset();
+    Serial.setEnabled(false);
+    Scheduler::reset();
+    NativeClock::set(0);
+    TemperatureService::setChangeCallback(nullptr);
+    TemperatureService::clearSensors();
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+    TemperatureService::clearSensors();
+}
+
+// Test that oversampling emits one rounded average per N inputs
+void test_oversample_averages() {
+    OversampleStage<4> stage;
+    int32_t output = 0;
+    const int32_t up[] = { 1, 2, 2, 2 };
+    const int32_t down[] = { -1, -2, -2, -2 };
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_FALSE(stage.process(up[i], output));
+    }
+    TEST_ASSERT_TRUE(stage.process(up[3], output));
+    TEST_ASSERT_EQUAL_INT32(2, output);     // 1.75
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_FALSE(stage.process(down[i], output));
+    }
+    TEST_ASSERT_TRUE(stage.process(down[3], output));
+    TEST_ASSERT_EQUAL_INT32(-2, output);    // -1.75
+}
+
+// Test that a sliding median drops isolated spikes but follows a real step
+void test_median_rejects_spikes() {
+    MedianStage<3> stage;
+    const int32_t input[] = { BASE, BASE + 100, SPIKE, BASE, -SPIKE, BASE, 3000, 3000, 3000 };
+    const int32_t expected[] = { BASE, BASE + 50, BASE + 100, BASE + 100, BASE, BASE, BASE, 3000, 3000 };
+    for (int i = 0; i < 9; i++) {
+        int32_t output = 0;
+        TEST_ASSERT_TRUE(stage.process(input[i], output));
+        TEST_ASSERT_EQUAL_INT32(expected[i], output);
+    }
+}
+
+// Test that the EMA seeds on the first input and settles exactly on a step, either way
+void test_ema_settles_without_bias() {
+    EmaStage<2> stage;
+    int32_t output = 0;
+    TEST_ASSERT_TRUE(stage.process(-1000, output));
+    TEST_ASSERT_EQUAL_INT32(-1000, output);
+
+    int32_t previous = output;
+    for (int i = 0; i < 60; i++) {
+        stage.process(1000, output);
+        TEST_ASSERT_TRUE(output >= previous);
+        previous = output;
+    }
+    TEST_ASSERT_EQUAL_INT32(1000, output);
+    for (int i = 0; i < 60; i++) {
+        stage.process(-1000, output);
+    }
+    TEST_ASSERT_EQUAL_INT32(-1000, output);
+
+    // One spike moves it by a quarter of the step
+    stage.process(-1000 + 400, output);
+    TEST_ASSERT_EQUAL_INT32(-900, output);
+}
+
+// Test that stages compose and that trivial stages pass values through
+void test_pipeline_composition() {
+    FilterPipeline<OversampleStage<1>, MedianStage<1>, EmaStage<0> > passThrough;
+    const int32_t input[] = { BASE, SPIKE, -SPIKE, 0, -1 };
+    for (int i = 0; i < 5; i++) {
+        int32_t output = 0;
+        TEST_ASSERT_TRUE(passThrough.process(input[i], output));
+        TEST_ASSERT_EQUAL_INT32(input[i], output);
+    }
+
+    FilterPipeline<OversampleStage<2>, MedianStage<3> > pipeline;
+    TEST_ASSERT_EQUAL_UINT32(2, (FilterPipeline<OversampleStage<2>, MedianStage<3> >::INPUTS_PER_OUTPUT));
+    int32_t output = 0;
+    TEST_ASSERT_FALSE(pipeline.process(BASE, output));
+    TEST_ASSERT_TRUE(pipeline.process(BASE, output));
+    TEST_ASSERT_EQUAL_INT32(BASE, output);
+    pipeline.reset();
+    TEST_ASSERT_FALSE(pipeline.process(SPIKE, output));
+    TEST_ASSERT_TRUE(pipeline.process(SPIKE, output));
+    TEST_ASSERT_EQUAL_INT32(SPIKE, output);
+}
+
+// Test that the service's default filter keeps single spikes out of the output
+void test_default_filter_rejects_spikes() {
+    TemperatureFilter filter;
+    const uint32_t n = TemperatureFilter::INPUTS_PER_OUTPUT;
+    int32_t maxOutput = INT32_MIN;
+    int32_t minOutput = INT32_MAX;
+    for (uint32_t i = 0; i < 40 * n; i++) {
+        // A spike in every fifth oversampling group, alternately up and down
+        int32_t input = BASE;
+        if (i % (5 * n) == 2 * n) {
+            input = (i / (5 * n)) % 2 == 0 ? SPIKE : -SPIKE;
+        }
+        int32_t output;
+        if (filter.process(input, output)) {
+            maxOutput = output > maxOutput ? output : maxOutput;
+            minOutput = output < minOutput ? output : minOutput;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT32(BASE, maxOutput);
+    TEST_ASSERT_EQUAL_INT32(BASE, minOutput);
+}
+
+// Test that one wild reading no longer pins the service's max or min
+void test_service_max_min_ignore_spike() {
+    static int16_t values[6 * TemperatureFilter::INPUTS_PER_OUTPUT];
+    const uint32_t count = sizeof(values) / sizeof(values[0]);
+    for (uint32_t i = 0; i < count; i++) {
+        values[i] = BASE;
+    }
+    // A whole oversampled sample of spike, then one below
+    for (uint32_t i = 0; i < TemperatureFilter::INPUTS_PER_OUTPUT; i++) {
+        values[2 * TemperatureFilter::INPUTS_PER_OUTPUT + i] = SPIKE;
+        values[4 * TemperatureFilter::INPUTS_PER_OUTPUT + i] = -SPIKE;
+    }
+    ReplayTemperatureSensor replay("replay", values, count);
+    TemperatureService::addSensor(&replay);
+    TemperatureService::init();
+    for (int i = 0; i < 5; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::sample();
+    }
+
+    TemperatureSnapshot snapshot;
+    TemperatureService::getSnapshot(snapshot);
+    TEST_ASSERT_EQUAL_UINT32(5, snapshot.sequence);
+    TEST_ASSERT_EQUAL_INT16(BASE, snapshot.current);
+    TEST_ASSERT_EQUAL_INT16(BASE, snapshot.max);
+    TEST_ASSERT_EQUAL_INT16(BASE, snapshot.min);
+    SensorStats stats;
+    TEST_ASSERT_TRUE(TemperatureService::getSensorStats(0, stats));
+    TEST_ASSERT_EQUAL(SPIKE, stats.max);
+    TEST_ASSERT_EQUAL(-SPIKE, stats.min);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_oversample_averages);
+    RUN_TEST(test_median_rejects_spikes);
+    RUN_TEST(test_ema_settles_without_bias);
+    RUN_TEST(test_pipeline_composition);
+    RUN_TEST(test_default_filter_rejects_spikes);
+    RUN_TEST(test_service_max_min_ignore_spike);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,196 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/temperature_history.h"
+
+static TemperatureHistory history;
+
+// Small deterministic generator for sample values
+static uint32_t rngState = 12345;
+static int16_t nextValue() {
+    rngState = rngState * 1103515245u + 12345u;
+    return (int16_t)((int32_t)((rngState >> 8) % 6001) - 3000);
+}
+
+// Recompute a window the slow way and compare with the incremental result
+static void checkAgainstBruteForce(HistoryWindow window, uint32_t now) {
+    uint32_t span = history.getWindowSpan(window);
+    uint32_t count = 0;
+    int64_t sum = 0;
+    int64_t sumSquares = 0;
+    int16_t minValue = 32767;
+    int16_t maxValue = -32768;
+
+    for (uint32_t seq = history.getFirstSequence(); seq != history.getNextSequence(); seq++) {
+        HistorySample sample;
+        TEST_ASSERT_TRUE(history.getSample(seq, sample));
+        if (now - sample.timestamp >= span) {
+            continue;
+        }
+        count++;
+        sum += sample.value;
+        sumSquares += (int32_t)sample.value * sample.value;
+        if (sample.value < minValue) minValue = sample.value;
+        if (sample.value > maxValue) maxValue = sample.value;
+    }
+
+    WindowStats stats;
+    if (count == 0) {
+        TEST_ASSERT_FALSE(history.getStats(window, stats));
+        return;
+    }
+    TEST_ASSERT_TRUE(history.getStats(window, stats));
+    TEST_ASSERT_EQUAL_UINT32(count, stats.count);
+    TEST_ASSERT_EQUAL_INT16(minValue, stats.min);
+    TEST_ASSERT_EQUAL_INT16(maxValue, stats.max);
+
+    double mean = (double)sum / count;
+    double variance = (double)sumSquares / count - mean * mean;
+    TEST_ASSERT_FLOAT_WITHIN(0.01, mean, stats.mean);
+    TEST_ASSERT_FLOAT_WITHIN(variance * 1e-5 + 0.01, variance, stats.variance);
+}
+
+// Test that capacity is rounded up to a power of two
+void test_history_capacity_rounding() {
+    TEST_ASSERT_TRUE(history.begin(100));
+    TEST_ASSERT_EQUAL_UINT32(128, history.getCapacity());
+    TEST_ASSERT_EQUAL_UINT32(0, history.size());
+}
+
+// Test that the ring buffer keeps the newest samples with their sequence numbers
+void test_history_ring_overwrites_oldest() {
+    history.begin(8);
+    for (int i = 0; i < 20; i++) {
+        history.add(i * 1000, (int16_t)i);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(8, history.size());
+    TEST_ASSERT_EQUAL_UINT32(12, history.getFirstSequence());
+    TEST_ASSERT_EQUAL_UINT32(20, history.getNextSequence());
+
+    HistorySample sample;
+    TEST_ASSERT_FALSE(history.getSample(11, sample));
+    TEST_ASSERT_FALSE(history.getSample(20, sample));
+    TEST_ASSERT_TRUE(history.getSample(12, sample));
+    TEST_ASSERT_EQUAL_INT16(12, sample.value);
+    TEST_ASSERT_EQUAL_UINT32(12000, sample.timestamp);
+}
+
+// Test windowed min/max expire by time
+void test_history_window_expiry() {
+    history.begin(64);
+    history.add(0, 500);       // max, falls out of the 1 minute window first
+    history.add(30000, -200);  // min
+    history.add(59000, 100);
+
+    WindowStats stats;
+    TEST_ASSERT_TRUE(history.getStats(WINDOW_1_MIN, stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.count);
+    TEST_ASSERT_EQUAL_INT16(500, stats.max);
+
+    history.add(60000, 0);
+    TEST_ASSERT_TRUE(history.getStats(WINDOW_1_MIN, stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.count);
+    TEST_ASSERT_EQUAL_INT16(100, stats.max);
+    TEST_ASSERT_EQUAL_INT16(-200, stats.min);
+
+    // The hour window still sees everything
+    TEST_ASSERT_TRUE(history.getStats(WINDOW_1_HOUR, stats));
+    TEST_ASSERT_EQUAL_UINT32(4, stats.count);
+    TEST_ASSERT_EQUAL_INT16(500, stats.max);
+
+    // With no new samples the window empties out
+    history.expire(200000);
+    TEST_ASSERT_FALSE(history.getStats(WINDOW_1_MIN, stats));
+}
+
+// Test mean and variance of a known sequence
+void test_history_mean_variance() {
+    history.begin(16);
+    const int16_t values[] = {200, 400, 400, 400, 500, 500, 700, 900};
+    for (int i = 0; i < 8; i++) {
+        history.add(i * 1000, values[i]);
+    }
+
+    WindowStats stats;
+    TEST_ASSERT_TRUE(history.getStats(WINDOW_1_MIN, stats));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 500.0f, stats.mean);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 40000.0f, stats.variance);
+}
+
+// Test random inserts against a brute-force recomputation, across buffer wraparound
+void test_history_matches_brute_force() {
+    history.begin(256);
+    history.setWindowSpan(WINDOW_1_MIN, 20000);
+    history.setWindowSpan(WINDOW_1_HOUR, 600000);
+
+    uint32_t now = 0;
+    for (int i = 0; i < 3000; i++) {
+        now += 500 + (rngState % 3000);
+        history.add(now, nextValue());
+        checkAgainstBruteForce(WINDOW_1_MIN, now);
+        checkAgainstBruteForce(WINDOW_1_HOUR, now);
+        checkAgainstBruteForce(WINDOW_24_HOURS, now);
+    }
+}
+
+// Test that changing a window span rebuilds it from the stored samples
+void test_history_set_window_span() {
+    history.begin(64);
+    for (int i = 0; i < 40; i++) {
+        history.add(i * 1000, (int16_t)(i * 10));
+    }
+
+    TEST_ASSERT_TRUE(history.setWindowSpan(WINDOW_1_MIN, 10000));
+    checkAgainstBruteForce(WINDOW_1_MIN, 39000);
+
+    WindowStats stats;
+    history.getStats(WINDOW_1_MIN, stats);
+    TEST_ASSERT_EQUAL_UINT32(10, stats.count);
+    TEST_ASSERT_EQUAL_INT16(300, stats.min);
+    TEST_ASSERT_FALSE(history.setWindowSpan(WINDOW_1_MIN, 0));
+}
+
+// Test that a history without storage ignores samples
+void test_history_without_storage() {
+    TemperatureHistory empty;
+    empty.add(0, 100);
+
+    WindowStats stats;
+    TEST_ASSERT_EQUAL_UINT32(0, empty.size());
+    TEST_ASSERT_FALSE(empty.getStats(WINDOW_1_MIN, stats));
+}
+
+void setUp(void) {
+    rngState = 12345;
+}
+
+void tearDown(void) {
+    history.end();
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_history_capacity_rounding);
+    RUN_TEST(test_history_ring_overwrites_oldest);
+    RUN_TEST(test_history_window_expiry);
+    RUN_TEST(test_history_mean_variance);
+    RUN_TEST(test_history_matches_brute_force);
+    RUN_TEST(test_history_set_window_span);
+    RUN_TEST(test_history_without_storage);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do in loop for tests
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,102 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/temperature_payload.h"
+
+// Test the exact little-endian wire layout
+void test_payload_layout() {
+    TemperatureReading reading;
+    reading.sequence = 0x04030201;
+    reading.timestamp = 0x08070605;
+    reading.current = 2250;    // 0x08CA
+    reading.max = -1;          // 0xFFFF
+    reading.min = -2050;       // 0xF7FE
+    reading.unit = 1;
+
+    uint8_t payload[TEMPERATURE_PAYLOAD_SIZE];
+    TEST_ASSERT_EQUAL(TEMPERATURE_PAYLOAD_SIZE, TemperaturePayload::encode(reading, payload, sizeof(payload)));
+
+    const uint8_t expected[TEMPERATURE_PAYLOAD_SIZE] = {
+        TEMPERATURE_PAYLOAD_VERSION, 0x01,
+        0x01, 0x02, 0x03, 0x04,
+        0x05, 0x06, 0x07, 0x08,
+        0xCA, 0x08,
+        0xFF, 0xFF,
+        0xFE, 0xF7
+    };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, payload, TEMPERATURE_PAYLOAD_SIZE);
+}
+
+// Test encode/decode round trip
+void test_payload_round_trip() {
+    TemperatureReading reading = {123456, 987654321, -1234, 3276, -32768, 0};
+    uint8_t payload[TEMPERATURE_PAYLOAD_SIZE];
+    TemperaturePayload::encode(reading, payload, sizeof(payload));
+
+    TemperatureReading decoded;
+    TEST_ASSERT_TRUE(TemperaturePayload::decode(payload, sizeof(payload), decoded));
+    TEST_ASSERT_EQUAL_UINT32(reading.sequence, decoded.sequence);
+    TEST_ASSERT_EQUAL_UINT32(reading.timestamp, decoded.timestamp);
+    TEST_ASSERT_EQUAL_INT16(reading.current, decoded.current);
+    TEST_ASSERT_EQUAL_INT16(reading.max, decoded.max);
+    TEST_ASSERT_EQUAL_INT16(reading.min, decoded.min);
+    TEST_ASSERT_EQUAL_UINT8(reading.unit, decoded.unit);
+}
+
+// Test that short buffers and unknown versions are rejected, and longer
+// payloads from later versions still decode
+void test_payload_versioning() {
+    TemperatureReading reading = {1, 2, 3, 4, 5, 0};
+    uint8_t payload[TEMPERATURE_PAYLOAD_SIZE + 4] = {0};
+    TEST_ASSERT_EQUAL(0, TemperaturePayload::encode(reading, payload, TEMPERATURE_PAYLOAD_SIZE - 1));
+    TemperaturePayload::encode(reading, payload, sizeof(payload));
+
+    TemperatureReading decoded;
+    TEST_ASSERT_FALSE(TemperaturePayload::decode(payload, TEMPERATURE_PAYLOAD_SIZE - 1, decoded));
+
+    payload[0] = TEMPERATURE_PAYLOAD_VERSION + 1;
+    TEST_ASSERT_TRUE(TemperaturePayload::decode(payload, sizeof(payload), decoded));
+    TEST_ASSERT_EQUAL_INT16(3, decoded.current);
+
+    payload[0] = 0;
+    TEST_ASSERT_FALSE(TemperaturePayload::decode(payload, sizeof(payload), decoded));
+}
+
+// Test fixed-point conversion rounds and saturates instead of wrapping
+void test_payload_fixed_point() {
+    TEST_ASSERT_EQUAL_INT16(2250, TemperaturePayload::toFixedPoint(22.5f));
+    TEST_ASSERT_EQUAL_INT16(-1051, TemperaturePayload::toFixedPoint(-10.506f));
+    TEST_ASSERT_EQUAL_INT16(32767, TemperaturePayload::toFixedPoint(400.0f));
+    TEST_ASSERT_EQUAL_INT16(-32768, TemperaturePayload::toFixedPoint(-400.0f));
+}
+
+void setUp(void) {
+    // Set up test environment
+}
+
+void tearDown(void) {
+    // Clean up after tests
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_payload_layout);
+    RUN_TEST(test_payload_round_trip);
+    RUN_TEST(test_payload_versioning);
+    RUN_TEST(test_payload_fixed_point);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do in loop for tests
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,246 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/scheduler.h"
+#include "../../include/temperature_sensor.h"
+#include "../../include/temperature_service.h"
+#include "../../include/timing_stats.h"
+#include "../../include/logger.h"
+
+static const int16_t PRIMARY_VALUES[] = { 2000, 2100, ReplayTemperatureSensor::REPLAY_ERROR, 1900 };
+static const int16_t SECONDARY_VALUES[] = { -500, -400 };
+
+static ReplayTemperatureSensor primary("primary", PRIMARY_VALUES, 4);
+static ReplayTemperatureSensor secondary("secondary", SECONDARY_VALUES, 2);
+
+// Order in which the registry handed out readings
+static int readingOrder[8];
+static int readingCount = 0;
+
+static void recordReading(int index, uint32_t, int16_t) {
+    if (readingCount < 8) {
+        readingOrder[readingCount++] = index;
+    }
+}
+
+static int tickRuns = 0;
+static void tick() {
+    tickRuns++;
+}
+
+void setUp(void) {
+    Logger::reset();
+    Serial.setEnabled(false);
+    Scheduler::reset();
+    NativeClock::set(0);
+    primary.reset();
+    secondary.reset();
+    readingCount = 0;
+    tickRuns = 0;
+    TimingStats::reset();
+    TemperatureService::setChangeCallback(nullptr);
+    TemperatureService::clearSensors();
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+    TemperatureService::clearSensors();
+}
+
+// Test that the replay driver plays its values in order, wraps and reports errors
+void test_replay_sensor_plays_back() {
+    ReplayTemperatureSensor sensor("replay", PRIMARY_VALUES, 4, 100);
+    int16_t value = 0;
+    TEST_ASSERT_TRUE(sensor.startConversion(0));
+    TEST_ASSERT_EQUAL(SENSOR_BUSY, sensor.pollResult(99, value));
+    TEST_ASSERT_EQUAL(SENSOR_READY, sensor.pollResult(100, value));
+    TEST_ASSERT_EQUAL_INT16(2000, value);
+
+    const SensorPoll expected[] = { SENSOR_READY, SENSOR_ERROR, SENSOR_READY, SENSOR_READY };
+    const int16_t values[] = { 2100, 0, 1900, 2000 };
+    for (int i = 0; i < 4; i++) {
+        sensor.startConversion(1000 * (i + 1));
+        value = 0;
+        TEST_ASSERT_EQUAL(expected[i], sensor.pollResult(1000 * (i + 1) + 100, value));
+        TEST_ASSERT_EQUAL_INT16(values[i], value);
+    }
+}
+
+// Test that a slow sensor never holds up the others
+void test_registry_polls_without_waiting() {
+    ReplayTemperatureSensor slow("slow", SECONDARY_VALUES, 2, 750);
+    SensorRegistry registry;
+    TEST_ASSERT_EQUAL(0, registry.add(&slow));
+    TEST_ASSERT_EQUAL(1, registry.add(&primary));
+    TEST_ASSERT_EQUAL(2, registry.add(&secondary));
+
+    registry.startAll(0);
+    TEST_ASSERT_TRUE(registry.poll(0, recordReading));
+    // The fast sensors are done after one pass; the slow one is still converting
+    TEST_ASSERT_EQUAL(2, readingCount);
+    TEST_ASSERT_EQUAL(1, readingOrder[0]);
+    TEST_ASSERT_EQUAL(2, readingOrder[1]);
+    TEST_ASSERT_TRUE(registry.isPending());
+    TEST_ASSERT_TRUE(registry.poll(740, recordReading));
+    TEST_ASSERT_FALSE(registry.poll(750, recordReading));
+    TEST_ASSERT_EQUAL(3, readingCount);
+    TEST_ASSERT_EQUAL(0, readingOrder[2]);
+    TEST_ASSERT_EQUAL(3, (int)slow.pollCount);
+    TEST_ASSERT_EQUAL(1, (int)primary.pollCount);
+}
+
+// Test that each pass starts polling one sensor further along
+void test_registry_rotates_poll_order() {
+    ReplayTemperatureSensor other("other", SECONDARY_VALUES, 2);
+    SensorRegistry registry;
+    registry.add(&secondary);
+    registry.add(&other);
+
+    for (int pass = 0; pass < 3; pass++) {
+        registry.startAll(pass * 1000);
+        registry.poll(pass * 1000, recordReading);
+    }
+    const int expected[] = { 0, 1, 1, 0, 0, 1 };
+    TEST_ASSERT_EQUAL(6, readingCount);
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected, readingOrder, 6);
+}
+
+// Test that a conversion that never finishes is abandoned and counted
+void test_registry_times_out() {
+    ReplayTemperatureSensor stuck("stuck", SECONDARY_VALUES, 2, 100000);
+    SensorRegistry registry;
+    registry.add(&stuck);
+
+    registry.startAll(0);
+    TEST_ASSERT_TRUE(registry.poll(SensorRegistry::CONVERSION_TIMEOUT - 1, recordReading));
+    TEST_ASSERT_FALSE(registry.poll(SensorRegistry::CONVERSION_TIMEOUT, recordReading));
+    TEST_ASSERT_EQUAL(0, readingCount);
+
+    SensorStats stats;
+    TEST_ASSERT_TRUE(registry.getStats(0, stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.readings);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.timeouts);
+    TEST_ASSERT_FALSE(registry.getStats(1, stats));
+}
+
+// What the service should publish: the primary's good readings through a
+// filter configured like the service's
+struct ExpectedReadings {
+    uint32_t outputs;
+    int32_t last;
+    int32_t max;
+    int32_t min;
+};
+
+static ExpectedReadings filterReplay(const int16_t* values, size_t count, uint32_t conversions) {
+    TemperatureFilter reference;
+    ExpectedReadings expected = { 0, 0, INT32_MIN, INT32_MAX };
+    for (uint32_t i = 0; i < conversions; i++) {
+        int32_t filtered;
+        int16_t value = values[i % count];
+        if (value == ReplayTemperatureSensor::REPLAY_ERROR || !reference.process(value, filtered)) {
+            continue;
+        }
+        expected.outputs++;
+        expected.last = filtered;
+        expected.max = filtered > expected.max ? filtered : expected.max;
+        expected.min = filtered < expected.min ? filtered : expected.min;
+    }
+    return expected;
+}
+
+// Test that the primary sensor drives the published values and every sensor keeps stats
+void test_service_uses_primary_and_keeps_stats() {
+    TEST_ASSERT_EQUAL(0, TemperatureService::addSensor(&primary));
+    TEST_ASSERT_EQUAL(1, TemperatureService::addSensor(&secondary));
+    TemperatureService::init();
+
+    for (int i = 0; i < 3; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::sample();
+    }
+
+    // Failed conversions are skipped, not filtered
+    ExpectedReadings expected = filterReplay(PRIMARY_VALUES, 4, primary.startCount);
+    TEST_ASSERT_TRUE(expected.outputs >= 2);
+    TemperatureSnapshot snapshot;
+    TemperatureService::getSnapshot(snapshot);
+    TEST_ASSERT_EQUAL_UINT32(expected.outputs - 1, snapshot.sequence);
+    TEST_ASSERT_EQUAL_INT16(expected.last, snapshot.current);
+    TEST_ASSERT_EQUAL_INT16(expected.max, snapshot.max);
+    TEST_ASSERT_EQUAL_INT16(expected.min, snapshot.min);
+
+    // Secondary sensors are neither oversampled nor filtered
+    SensorStats stats;
+    TEST_ASSERT_EQUAL(2, TemperatureService::getSensorCount());
+    TEST_ASSERT_EQUAL_STRING("secondary", TemperatureService::getSensorName(1));
+    TEST_ASSERT_TRUE(TemperatureService::getSensorStats(0, stats));
+    TEST_ASSERT_EQUAL_UINT32(primary.startCount, stats.readings + stats.errors);
+    TEST_ASSERT_EQUAL_UINT32((primary.startCount + 1) / 4, stats.errors);
+    TEST_ASSERT_TRUE(TemperatureService::getSensorStats(1, stats));
+    TEST_ASSERT_EQUAL_UINT32(4, stats.readings);
+    TEST_ASSERT_EQUAL(-500, stats.min);
+    TEST_ASSERT_EQUAL(-400, stats.max);
+    TEST_ASSERT_EQUAL(-400, stats.last);
+}
+
+// Test that 750 ms conversions are polled in the background while other jobs stay on time
+void test_slow_sensor_does_not_block_the_lane() {
+    ReplayTemperatureSensor slow("ds18b20", PRIMARY_VALUES, 2, 750);
+    TemperatureService::addSensor(&slow);
+    TemperatureService::init();
+    int tickId = Scheduler::addPeriodic("tick", tick, 10, 10);
+
+    while (millis() < 40000) {
+        Scheduler::runDue();
+        Scheduler::sleepUntilNext(1000);
+    }
+    TemperatureService::processSamples();
+
+    // Two samples, each oversampled from back-to-back conversions
+    uint32_t conversions = 2 * TemperatureFilter::INPUTS_PER_OUTPUT;
+    ExpectedReadings expected = filterReplay(PRIMARY_VALUES, 2, conversions);
+    TemperatureSnapshot snapshot;
+    TemperatureService::getSnapshot(snapshot);
+    TEST_ASSERT_EQUAL_UINT32(1, snapshot.sequence);
+    TEST_ASSERT_EQUAL_INT16(expected.last, snapshot.current);
+    TEST_ASSERT_EQUAL_UINT32(30000, snapshot.timestamp);
+    TEST_ASSERT_EQUAL(0, (int)Scheduler::getMaxLateness(tickId));
+    // Every 10 ms up to, but not including, the 40 s mark
+    TEST_ASSERT_EQUAL(3999, tickRuns);
+    // Each conversion polled every 20 ms until done
+    TEST_ASSERT_EQUAL_UINT32(conversions, slow.startCount);
+    TEST_ASSERT_TRUE(slow.pollCount <= conversions * (750 / 20 + 2));
+
+    // One timing per acquire() (init() started the first sample itself);
+    // the background polls have their own probe
+    TimingSummary summary;
+    TEST_ASSERT_TRUE(TimingStats::getSummary(PROBE_TEMPERATURE, summary));
+    TEST_ASSERT_EQUAL_UINT32(1, summary.count);
+    TEST_ASSERT_TRUE(TimingStats::getSummary(PROBE_SENSOR_POLL, summary));
+    TEST_ASSERT_TRUE(summary.count > 0 && summary.count < slow.pollCount);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_sensor_plays_back);
+    RUN_TEST(test_registry_polls_without_waiting);
+    RUN_TEST(test_registry_rotates_poll_order);
+    RUN_TEST(test_registry_times_out);
+    RUN_TEST(test_service_uses_primary_and_keeps_stats);
+    RUN_TEST(test_slow_sensor_does_not_block_the_lane);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,132 @@
+#include <unity.h>
+#include <string.h>
+#include "../../include/platform.h"
+#include "../../include/scheduler.h"
+#include "../../include/temperature_service.h"
+#include "../../include/ble_server.h"
+
+// A steady 20.00 C, and a step from 20.00 to 25.00 C halfway through
+static const int16_t STEADY_VALUES[] = { 2000 };
+static int16_t risingValues[8 * TemperatureFilter::INPUTS_PER_OUTPUT];
+
+static void sampleTimes(int count) {
+    for (int i = 0; i < count; i++) {
+        NativeClock::advance(30000);
+        TemperatureService::sample();
+    }
+}
+
+// Test temperature service initialization
+void test_temperature_init() {
+    TemperatureService::init();
+    TEST_ASSERT_EQUAL_UINT32(0, TemperatureService::getSequence());
+
+    // The default fake sensor reads between -15.5 and -5.5 C
+    sampleTimes(1);
+    TEST_ASSERT_EQUAL_UINT32(1, TemperatureService::getSequence());
+    float temp = TemperatureService::getCurrentTemperature();
+    TEST_ASSERT_TRUE(temp >= -15.5f && temp <= -5.5f);
+}
+
+// Test temperature unit conversion
+void test_temperature_unit_conversion() {
+    ReplayTemperatureSensor steady("steady", STEADY_VALUES, 1);
+    TemperatureService::addSensor(&steady);
+    TemperatureService::init();
+    sampleTimes(1);
+
+    TemperatureService::setUnit(CELSIUS);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, TemperatureService::getCurrentTemperature());
+
+    // Converted from the stored centi-degrees, so toggling back is exact
+    TemperatureService::setUnit(FAHRENHEIT);
+    TEST_ASSERT_EQUAL_FLOAT(68.0f, TemperatureService::getCurrentTemperature());
+    TemperatureService::setUnit(CELSIUS);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, TemperatureService::getCurrentTemperature());
+}
+
+// Test temperature tracking (max/min)
+void test_temperature_tracking() {
+    const uint32_t count = sizeof(risingValues) / sizeof(risingValues[0]);
+    for (uint32_t i = 0; i < count; i++) {
+        risingValues[i] = i < count / 2 ? 2000 : 2500;
+    }
+    ReplayTemperatureSensor rising("rising", risingValues, count);
+    TemperatureService::addSensor(&rising);
+    TemperatureService::init();
+
+    // The first reading is current, max and min at once
+    sampleTimes(1);
+    TemperatureSnapshot snapshot;
+    TemperatureService::getSnapshot(snapshot);
+    TEST_ASSERT_EQUAL_INT16(2000, snapshot.current);
+    TEST_ASSERT_EQUAL_INT16(snapshot.current, snapshot.max);
+    TEST_ASSERT_EQUAL_INT16(snapshot.current, snapshot.min);
+
+    // The filter eases the step in; max follows it, min stays put
+    sampleTimes(7);
+    TemperatureService::getSnapshot(snapshot);
+    TEST_ASSERT_TRUE(snapshot.current > 2000 && snapshot.current <= 2500);
+    TEST_ASSERT_EQUAL_INT16(snapshot.current, snapshot.max);
+    TEST_ASSERT_EQUAL_INT16(2000, snapshot.min);
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, TemperatureService::getMinTemperature());
+}
+
+// Test temperature UUIDs are valid
+void test_temperature_uuids() {
+    // All UUIDs should be 36 characters (standard UUID format)
+    TEST_ASSERT_EQUAL(36, strlen(ENV_SENSING_SERVICE_UUID));
+    TEST_ASSERT_EQUAL(36, strlen(TEMPERATURE_CHAR_UUID));
+    TEST_ASSERT_EQUAL(36, strlen(TEMP_MAX_CHAR_UUID));
+    TEST_ASSERT_EQUAL(36, strlen(TEMP_MIN_CHAR_UUID));
+    TEST_ASSERT_EQUAL(36, strlen(TEMP_CONFIG_CHAR_UUID));
+}
+
+// Test temperature unit getter/setter
+void test_temperature_unit() {
+    TemperatureService::init();
+    TemperatureService::setUnit(CELSIUS);
+    TEST_ASSERT_EQUAL(CELSIUS, TemperatureService::getUnit());
+
+    // The unit is a stored setting
+    TemperatureService::setUnit(FAHRENHEIT);
+    TEST_ASSERT_EQUAL(FAHRENHEIT, TemperatureService::getUnit());
+    TEST_ASSERT_EQUAL_UINT32(FAHRENHEIT, ConfigStore::get(CONFIG_TEMP_UNIT));
+}
+
+void setUp(void) {
+    Serial.setEnabled(false);
+    Scheduler::reset();
+    NativeClock::set(0);
+    TemperatureService::clearSensors();
+    TemperatureService::setUnit(CELSIUS);
+}
+
+void tearDown(void) {
+    TemperatureService::clearSensors();
+    Serial.setEnabled(true);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_temperature_init);
+    RUN_TEST(test_temperature_unit_conversion);
+    RUN_TEST(test_temperature_tracking);
+    RUN_TEST(test_temperature_uuids);
+    RUN_TEST(test_temperature_unit);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,176 @@
+#include <unity.h>
+#include <thread>
+#include "../../include/seqlock.h"
+#include "../../include/temperature_service.h"
+#include "../../include/logger.h"
+
+// Every field derived from `sequence`, so a torn copy is easy to spot
+struct Record {
+    uint32_t sequence;
+    uint32_t doubled;
+    float value;
+    float above;
+    float below;
+};
+
+static const uint32_t WRITES = 2000000;
+static const int READERS = 3;
+
+// Range of the fake sensor in hundredths of each unit
+static const int16_t CELSIUS_LOW = -1550;
+static const int16_t CELSIUS_HIGH = -550;
+static const int16_t FAHRENHEIT_LOW = 410;
+static const int16_t FAHRENHEIT_HIGH = 2210;
+
+void setUp(void) {
+    Logger::reset();
+    Serial.setEnabled(false);
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+}
+
+// Test that readers on several threads only ever see whole writes, in order
+void test_seqlock_readers_never_see_torn_writes() {
+    static Seqlock<Record> lock;
+    volatile bool writing = true;
+    uint32_t errors[READERS] = {};
+    uint32_t reads[READERS] = {};
+
+    std::thread readers[READERS];
+    for (int r = 0; r < READERS; r++) {
+        readers[r] = std::thread([&, r]() {
+            uint32_t last = 0;
+            Record record;
+            while (__atomic_load_n(&writing, __ATOMIC_ACQUIRE)) {
+                lock.read(record);
+                if (record.sequence == 0) {
+                    continue;       // nothing written yet
+                }
+                float expected = (float)(record.sequence & 0xFFFF);
+                if (record.doubled != record.sequence * 2 || record.value != expected ||
+                    record.above != expected + 1.0f || record.below != expected - 1.0f ||
+                    record.sequence < last) {
+                    errors[r]++;
+                }
+                last = record.sequence;
+                reads[r]++;
+            }
+        });
+    }
+
+    Record record;
+    for (uint32_t i = 1; i <= WRITES; i++) {
+        float value = (float)(i & 0xFFFF);
+        record.sequence = i;
+        record.doubled = i * 2;
+        record.value = value;
+        record.above = value + 1.0f;
+        record.below = value - 1.0f;
+        lock.write(record);
+    }
+    __atomic_store_n(&writing, false, __ATOMIC_RELEASE);
+
+    for (int r = 0; r < READERS; r++) {
+        readers[r].join();
+        TEST_ASSERT_EQUAL_UINT32(0, errors[r]);
+        TEST_ASSERT_GREATER_THAN_UINT32(0, reads[r]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(WRITES, lock.getVersion());
+}
+
+static bool inUnitRange(int16_t value, TemperatureUnit unit) {
+    if (unit == FAHRENHEIT) {
+        return value >= FAHRENHEIT_LOW && value <= FAHRENHEIT_HIGH;
+    }
+    return value >= CELSIUS_LOW && value <= CELSIUS_HIGH;
+}
+
+// Test snapshots while one thread samples and another flips the unit, as the
+// BLE task and the NimBLE host task do on the device
+void test_snapshot_is_consistent_under_unit_changes() {
+    static const uint32_t SAMPLES = 100000;
+    TemperatureService::setChangeCallback(nullptr);
+    TemperatureService::setUnit(CELSIUS);
+    TemperatureService::init();
+
+    volatile bool running = true;
+    std::thread sampler([&running]() {
+        for (uint32_t i = 0; i < SAMPLES; i++) {
+            NativeClock::advance(7);
+            TemperatureService::sample();
+        }
+        __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+    });
+    std::thread configurator([&running]() {
+        while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+            TemperatureService::setUnit(FAHRENHEIT);
+            TemperatureService::setUnit(CELSIUS);
+        }
+    });
+
+    uint32_t errors = 0;
+    uint32_t snapshots = 0;
+    uint32_t lastSequence = 0;
+    TemperatureSnapshot snapshot;
+    while (__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        TemperatureService::getSnapshot(snapshot);
+        if (!inUnitRange(snapshot.current, snapshot.unit) || !inUnitRange(snapshot.max, snapshot.unit) ||
+            !inUnitRange(snapshot.min, snapshot.unit) || snapshot.min > snapshot.current ||
+            snapshot.current > snapshot.max || snapshot.sequence < lastSequence) {
+            errors++;
+        }
+        lastSequence = snapshot.sequence;
+        snapshots++;
+    }
+    sampler.join();
+    configurator.join();
+    TemperatureService::setUnit(CELSIUS);
+
+    TEST_ASSERT_EQUAL_UINT32(0, errors);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, snapshots);
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES, TemperatureService::getSequence());
+}
+
+// Test that a unit change converts every value of the next snapshot
+void test_snapshot_follows_unit() {
+    TemperatureService::setUnit(CELSIUS);
+    TemperatureService::init();
+    TemperatureSnapshot celsius;
+    TemperatureService::getSnapshot(celsius);
+
+    TemperatureService::setUnit(FAHRENHEIT);
+    TemperatureSnapshot fahrenheit;
+    TemperatureService::getSnapshot(fahrenheit);
+    TemperatureService::setUnit(CELSIUS);
+
+    TEST_ASSERT_EQUAL(CELSIUS, celsius.unit);
+    TEST_ASSERT_EQUAL(FAHRENHEIT, fahrenheit.unit);
+    TEST_ASSERT_EQUAL_UINT32(celsius.sequence, fahrenheit.sequence);
+    TEST_ASSERT_EQUAL_INT16(TemperatureUnits::fromCentiCelsius(celsius.current, FAHRENHEIT), fahrenheit.current);
+    TEST_ASSERT_EQUAL_INT16(TemperatureUnits::fromCentiCelsius(celsius.max, FAHRENHEIT), fahrenheit.max);
+    TEST_ASSERT_EQUAL_INT16(TemperatureUnits::fromCentiCelsius(celsius.min, FAHRENHEIT), fahrenheit.min);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_seqlock_readers_never_see_torn_writes);
+    RUN_TEST(test_snapshot_is_consistent_under_unit_changes);
+    RUN_TEST(test_snapshot_follows_unit);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,118 @@
+#include <unity.h>
+#include <math.h>
+#include "../../include/temperature_units.h"
+#include "../../include/temperature_payload.h"
+#include "../../include/temperature_service.h"
+#include "../../include/logger.h"
+
+void setUp(void) {
+    Logger::reset();
+    Serial.setEnabled(false);
+}
+
+void tearDown(void) {
+    Serial.setEnabled(true);
+    TemperatureService::setUnit(CELSIUS);
+}
+
+// Test every representable Celsius value against the exact conversion
+void test_fahrenheit_is_exactly_rounded() {
+    int32_t previous = INT32_MIN;
+    for (int32_t centi = INT16_MIN; centi <= INT16_MAX; centi++) {
+        int32_t fahrenheit = TemperatureUnits::celsiusToFahrenheit(centi);
+        double exact = centi * 9.0 / 5.0 + 3200.0;
+        TEST_ASSERT_TRUE(fabs(fahrenheit - exact) <= 0.41);   // off by at most 0.4 hundredths
+        TEST_ASSERT_TRUE(fahrenheit >= previous);
+        previous = fahrenheit;
+    }
+}
+
+// Test that values beyond the int16_t range saturate instead of wrapping
+void test_out_of_range_saturates() {
+    // 200 C is 392 F, which does not fit hundredths in an int16_t
+    TEST_ASSERT_EQUAL_INT16(20000, TemperatureUnits::fromCentiCelsius(20000, CELSIUS));
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, TemperatureUnits::fromCentiCelsius(20000, FAHRENHEIT));
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, TemperatureUnits::fromCentiCelsius(-20000, FAHRENHEIT));
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, TemperatureUnits::saturate(100000));
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, TemperatureUnits::saturate(-100000));
+
+    // The sensor edge saturates too, NaN included
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, TemperaturePayload::toFixedPoint(1000.0f));
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, TemperaturePayload::toFixedPoint(NAN));
+}
+
+// Test that a saturated reading survives the packed payload unchanged
+void test_out_of_range_encodes_safely() {
+    TemperatureReading reading;
+    reading.sequence = 7;
+    reading.timestamp = 1000;
+    reading.current = TemperatureUnits::fromCentiCelsius(20000, FAHRENHEIT);
+    reading.max = TemperatureUnits::fromCentiCelsius(32767, FAHRENHEIT);
+    reading.min = TemperatureUnits::fromCentiCelsius(-20000, FAHRENHEIT);
+    reading.unit = FAHRENHEIT;
+
+    uint8_t payload[TEMPERATURE_PAYLOAD_SIZE];
+    TEST_ASSERT_EQUAL(TEMPERATURE_PAYLOAD_SIZE, TemperaturePayload::encode(reading, payload, sizeof(payload)));
+    TemperatureReading decoded;
+    TEST_ASSERT_TRUE(TemperaturePayload::decode(payload, sizeof(payload), decoded));
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, decoded.current);
+    TEST_ASSERT_EQUAL_INT16(INT16_MAX, decoded.max);
+    TEST_ASSERT_EQUAL_INT16(INT16_MIN, decoded.min);
+}
+
+// Test that toggling the unit many times leaves every value exactly where it was
+void test_unit_toggles_never_drift() {
+    NativeClock::set(0);
+    TemperatureService::setUnit(CELSIUS);
+    TemperatureService::init();
+    for (int i = 0; i < 10; i++) {
+        NativeClock::advance(30123);
+        TemperatureService::sample();
+    }
+
+    TemperatureSnapshot before;
+    TemperatureService::getSnapshot(before);
+    TemperatureService::setUnit(FAHRENHEIT);
+    TemperatureSnapshot firstFahrenheit;
+    TemperatureService::getSnapshot(firstFahrenheit);
+
+    for (int i = 0; i < 10000; i++) {
+        TemperatureService::setUnit(CELSIUS);
+        TemperatureService::setUnit(FAHRENHEIT);
+    }
+    TemperatureSnapshot fahrenheit;
+    TemperatureService::getSnapshot(fahrenheit);
+    TEST_ASSERT_EQUAL_INT16(firstFahrenheit.current, fahrenheit.current);
+    TEST_ASSERT_EQUAL_INT16(firstFahrenheit.max, fahrenheit.max);
+    TEST_ASSERT_EQUAL_INT16(firstFahrenheit.min, fahrenheit.min);
+
+    TemperatureService::setUnit(CELSIUS);
+    TemperatureSnapshot after;
+    TemperatureService::getSnapshot(after);
+    TEST_ASSERT_EQUAL_INT16(before.current, after.current);
+    TEST_ASSERT_EQUAL_INT16(before.max, after.max);
+    TEST_ASSERT_EQUAL_INT16(before.min, after.min);
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fahrenheit_is_exactly_rounded);
+    RUN_TEST(test_out_of_range_saturates);
+    RUN_TEST(test_out_of_range_encodes_safely);
+    RUN_TEST(test_unit_toggles_never_drift);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,136 @@
+#include <unity.h>
+#include "../../include/timing_stats.h"
+#include <algorithm>
+#include <vector>
+
+void setUp(void) {
+    TimingStats::reset();
+}
+
+void tearDown(void) {
+}
+
+static uint32_t readU32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// Test that small values are exact and buckets tile the value range
+void test_bucket_mapping() {
+    for (uint32_t value = 0; value < 8; value++) {
+        TEST_ASSERT_EQUAL(value, LatencyHistogram::bucketFor(value));
+    }
+    TEST_ASSERT_EQUAL(8, LatencyHistogram::bucketFor(8));
+    TEST_ASSERT_EQUAL(9, LatencyHistogram::bucketFor(10));
+    TEST_ASSERT_EQUAL(LatencyHistogram::BUCKET_COUNT - 1, LatencyHistogram::bucketFor(0xFFFFFFFFu));
+
+    // Every bucket starts right after the previous one ends
+    for (int bucket = 1; bucket < LatencyHistogram::BUCKET_COUNT; bucket++) {
+        uint32_t start = LatencyHistogram::bucketUpperBound(bucket - 1) + 1;
+        TEST_ASSERT_EQUAL(bucket, LatencyHistogram::bucketFor(start));
+        TEST_ASSERT_EQUAL(bucket, LatencyHistogram::bucketFor(LatencyHistogram::bucketUpperBound(bucket)));
+    }
+}
+
+// Test that percentiles stay within one bucket (25%) of the exact value
+void test_percentiles_match_brute_force() {
+    LatencyHistogram histogram;
+    std::vector<uint32_t> values;
+    uint32_t state = 7;
+    for (int i = 0; i < 5000; i++) {
+        state = state * 1103515245u + 12345u;
+        // Mostly short passes with a long tail, like a real loop
+        uint32_t value = (state >> 16) % 200;
+        if (i % 50 == 0) {
+            value = 5000 + (state >> 8) % 100000;
+        }
+        values.push_back(value);
+        histogram.record(value);
+    }
+    std::sort(values.begin(), values.end());
+
+    const uint16_t quantiles[] = {500, 900, 990, 1000};
+    for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+        size_t rank = (values.size() * quantiles[q] + 999) / 1000;
+        uint32_t exact = values[rank - 1];
+        uint32_t estimate = histogram.percentile(quantiles[q]);
+        TEST_ASSERT_TRUE(estimate >= exact);
+        TEST_ASSERT_TRUE(estimate <= exact + exact / 4 + 1);
+    }
+    TEST_ASSERT_EQUAL_UINT32(values.back(), histogram.getMax());
+    TEST_ASSERT_EQUAL_UINT32(5000, histogram.getCount());
+}
+
+// Test that an empty histogram reports zeros
+void test_empty_histogram() {
+    LatencyHistogram histogram;
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.percentile(500));
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getMean());
+
+    TimingSummary summary;
+    TEST_ASSERT_FALSE(TimingStats::getSummary(PROBE_WIFI, summary));
+    TEST_ASSERT_EQUAL_UINT32(0, summary.count);
+}
+
+// Test that a scoped timer records one sample on scope exit
+void test_scoped_timer_records() {
+    {
+        ScopedTimer timer(PROBE_TEMPERATURE);
+    }
+    {
+        ScopedTimer timer(PROBE_TEMPERATURE);
+    }
+    TimingSummary summary;
+    TEST_ASSERT_TRUE(TimingStats::getSummary(PROBE_TEMPERATURE, summary));
+    TEST_ASSERT_EQUAL_UINT32(2, summary.count);
+    TEST_ASSERT_FALSE(TimingStats::getSummary(PROBE_BLE, summary));
+}
+
+// Test the diagnostics characteristic layout
+void test_snapshot_layout() {
+    TimingStats::record(PROBE_BLE, 100);
+    TimingStats::record(PROBE_BLE, 300);
+    TimingStats::record(PROBE_SAMPLE_JITTER, 7);
+
+    uint8_t snapshot[TIMING_SNAPSHOT_SIZE];
+    TEST_ASSERT_EQUAL(0, TimingStats::encodeSnapshot(snapshot, sizeof(snapshot) - 1));
+    TEST_ASSERT_EQUAL(TIMING_SNAPSHOT_SIZE, TimingStats::encodeSnapshot(snapshot, sizeof(snapshot)));
+    TEST_ASSERT_EQUAL_UINT8(TIMING_SNAPSHOT_VERSION, snapshot[0]);
+    TEST_ASSERT_EQUAL_UINT8(PROBE_COUNT, snapshot[1]);
+
+    const uint8_t* ble = snapshot + 2 + PROBE_BLE * TIMING_SNAPSHOT_PROBE_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(2, readU32(ble));
+    TEST_ASSERT_UINT32_WITHIN(25, 100, readU32(ble + 4));
+    TEST_ASSERT_EQUAL_UINT32(300, readU32(ble + 8));
+    TEST_ASSERT_EQUAL_UINT32(300, readU32(ble + 12));
+
+    const uint8_t* jitter = snapshot + 2 + PROBE_SAMPLE_JITTER * TIMING_SNAPSHOT_PROBE_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(1, readU32(jitter));
+    TEST_ASSERT_EQUAL_UINT32(7, readU32(jitter + 12));
+
+    const uint8_t* wifi = snapshot + 2 + PROBE_WIFI * TIMING_SNAPSHOT_PROBE_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(0, readU32(wifi));
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bucket_mapping);
+    RUN_TEST(test_percentiles_match_brute_force);
+    RUN_TEST(test_empty_histogram);
+    RUN_TEST(test_scoped_timer_records);
+    RUN_TEST(test_snapshot_layout);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif
@@ -0,0 +1,263 @@
+#include <unity.h>
+#include "../../include/platform.h"
+#include "../../include/wifi_manager.h"
+
+#ifndef ARDUINO
+static FakeWiFiRadio fakeRadio;
+#endif
+
+// Test WiFi manager initialization
+void test_wifi_init() {
+    WiFiManager::init();
+    // After init, should not be connected yet (no network configured in tests)
+    // This just ensures init doesn't crash
+    TEST_ASSERT_TRUE(true);
+}
+
+// Test WiFi MAC address retrieval
+void test_wifi_mac_address() {
+    WiFiManager::init();
+    String mac = WiFiManager::getMACAddress();
+    // MAC address should be 17 characters (XX:XX:XX:XX:XX:XX format)
+    TEST_ASSERT_EQUAL(17, mac.length());
+}
+
+// Test WiFi connection state (should be disconnected in test environment)
+void test_wifi_connection_state() {
+    WiFiManager::init();
+    // In test environment without valid credentials, should not be connected
+    bool connected = WiFiManager::isConnected();
+    TEST_ASSERT_FALSE(connected);
+}
+
+// Test WiFi IP address when disconnected
+void test_wifi_ip_disconnected() {
+    WiFiManager::init();
+    String ip = WiFiManager::getIPAddress();
+    // When disconnected, should return "Not connected"
+    TEST_ASSERT_EQUAL_STRING("Not connected", ip.c_str());
+}
+
+// Test WiFi SSID when disconnected
+void test_wifi_ssid_disconnected() {
+    WiFiManager::init();
+    String ssid = WiFiManager::getSSID();
+    // When disconnected, should return "Not connected"
+    TEST_ASSERT_EQUAL_STRING("Not connected", ssid.c_str());
+}
+
+// Test WiFi RSSI when disconnected
+void test_wifi_rssi_disconnected() {
+    WiFiManager::init();
+    int rssi = WiFiManager::getRSSI();
+    // When disconnected, RSSI should be 0
+    TEST_ASSERT_EQUAL(0, rssi);
+}
+
+#ifndef ARDUINO
+// Bring the state machine up to CONNECTED on the fake radio
+static void connectFakeRadio() {
+    WiFiManager::init();
+    WiFiManager::connect();
+    fakeRadio.setLinkStatus(RADIO_LINK_UP);
+    WiFiManager::loop();
+}
+
+// Test that connect() starts an attempt without blocking
+void test_wifi_connect_is_non_blocking() {
+    WiFiManager::init();
+    unsigned long before = millis();
+    WiFiManager::connect();
+
+    TEST_ASSERT_EQUAL(before, millis());
+    TEST_ASSERT_EQUAL(WIFI_STATE_CONNECTING, WiFiManager::getState());
+    TEST_ASSERT_EQUAL(1, fakeRadio.beginCount);
+    TEST_ASSERT_FALSE(WiFiManager::isConnected());
+}
+
+// Test CONNECTING -> CONNECTED once the link comes up
+void test_wifi_connecting_to_connected() {
+    connectFakeRadio();
+
+    TEST_ASSERT_EQUAL(WIFI_STATE_CONNECTED, WiFiManager::getState());
+    TEST_ASSERT_TRUE(WiFiManager::isConnected());
+    TEST_ASSERT_EQUAL_STRING("192.168.4.2", WiFiManager::getIPAddress().c_str());
+    TEST_ASSERT_EQUAL_STRING(WIFI_SSID, WiFiManager::getSSID().c_str());
+    TEST_ASSERT_EQUAL(0, WiFiManager::getConnectionAttempts());
+}
+
+// Test that a GOT_IP event completes the attempt
+void test_wifi_got_ip_event() {
+    WiFiManager::init();
+    WiFiManager::connect();
+    fakeRadio.emit(RADIO_EVENT_GOT_IP);
+    WiFiManager::loop();
+
+    TEST_ASSERT_EQUAL(WIFI_STATE_CONNECTED, WiFiManager::getState());
+}
+
+// Test CONNECTING -> BACKOFF when the attempt times out
+void test_wifi_timeout_enters_backoff() {
+    WiFiManager::init();
+    WiFiManager::connect();
+
+    delay(WIFI_TIMEOUT_MS - 1);
+    WiFiManager::loop();
+    TEST_ASSERT_EQUAL(WIFI_STATE_CONNECTING, WiFiManager::getState());
+
+    delay(1);
+    WiFiManager::loop();
+    TEST_ASSERT_EQUAL(WIFI_STATE_BACKOFF, WiFiManager::getState());
+    TEST_ASSERT_TRUE(WiFiManager::getRetryDelay() >= 1000 && WiFiManager::getRetryDelay() <= 2000);
+}
+
+// Test BACKOFF -> CONNECTING once the retry delay has elapsed
+void test_wifi_backoff_retries_after_delay() {
+    WiFiManager::init();
+    WiFiManager::connect();
+    delay(WIFI_TIMEOUT_MS);
+    WiFiManager::loop();
+
+    delay(WiFiManager::getRetryDelay() - 1);
+    WiFiManager::loop();
+    TEST_ASSERT_EQUAL(WIFI_STATE_BACKOFF, WiFiManager::getState());
+    TEST_ASSERT_EQUAL(1, fakeRadio.beginCount);
+
+    delay(1);
+    WiFiManager::loop();
+    TEST_ASSERT_EQUAL(WIFI_STATE_CONNECTING, WiFiManager::getState());
+    TEST_ASSERT_EQUAL(2, fakeRadio.beginCount);
+    TEST_ASSERT_EQUAL(2, WiFiManager::getConnectionAttempts());
+}
+
+// Test that retry delays grow exponentially with jitter and are capped
+void test_wifi_backoff_grows_and_caps() {
+    WiFiManager::init();
+    WiFiManager::connect();
+
+    unsigned long ceiling = 2000;
+    for (int attempt = 0; attempt < 12; attempt++) {
+        fakeRadio.setLinkStatus(RADIO_LINK_FAILED);
+        WiFiManager::loop();
+        TEST_ASSERT_EQUAL(WIFI_STATE_BACKOFF, WiFiManager::getState());
+
+        unsigned long retry = WiFiManager::getRetryDelay();
+        TEST_ASSERT_TRUE(retry >= ceiling / 2 && retry <= ceiling);
+
+        fakeRadio.setLinkStatus(RADIO_LINK_DOWN);
+        delay(retry);
+        WiFiManager::loop();
+        TEST_ASSERT_EQUAL(WIFI_STATE_CONNECTING, WiFiManager::getState());
+
+        ceiling = ceiling * 2 > 300000 ? 300000 : ceiling * 2;
+    }
+
+    // Success resets the backoff
+    fakeRadio.setLinkStatus(RADIO_LINK_UP);
+    WiFiManager::loop();
+    fakeRadio.emit(RADIO_EVENT_DISCONNECTED);
+    WiFiManager::loop();
+    fakeRadio.setLinkStatus(RADIO_LINK_FAILED);
+    WiFiManager::loop();
+    TEST_ASSERT_TRUE(WiFiManager::getRetryDelay() <= 2000);
+}
+
+// Test that a rejected association fails without waiting for the timeout
+void test_wifi_link_failure_skips_timeout() {
+    WiFiManager::init();
+    WiFiManager::connect();
+    fakeRadio.setLinkStatus(RADIO_LINK_FAILED);
+    WiFiManager::loop();
+
+    TEST_ASSERT_EQUAL(WIFI_STATE_BACKOFF, WiFiManager::getState());
+    TEST_ASSERT_EQUAL(2, fakeRadio.disconnectCount); // init() plus the failed attempt
+}
+
+// Test CONNECTED -> CONNECTING when the link drops
+void test_wifi_connection_lost_reconnects() {
+    connectFakeRadio();
+    fakeRadio.emit(RADIO_EVENT_DISCONNECTED);
+    WiFiManager::loop();
+
+    TEST_ASSERT_EQUAL(WIFI_STATE_CONNECTING, WiFiManager::getState());
+    TEST_ASSERT_EQUAL(2, fakeRadio.beginCount);
+    TEST_ASSERT_FALSE(WiFiManager::isConnected());
+}
+
+// Test that connect() during backoff retries right away
+void test_wifi_connect_during_backoff() {
+    WiFiManager::init();
+    WiFiManager::connect();
+    fakeRadio.setLinkStatus(RADIO_LINK_FAILED);
+    WiFiManager::loop();
+    fakeRadio.setLinkStatus(RADIO_LINK_DOWN);
+
+    WiFiManager::connect();
+    TEST_ASSERT_EQUAL(WIFI_STATE_CONNECTING, WiFiManager::getState());
+    TEST_ASSERT_EQUAL(2, fakeRadio.beginCount);
+}
+
+// Test that an explicit disconnect() stops automatic reconnection
+void test_wifi_disconnect_stops_reconnecting() {
+    connectFakeRadio();
+    WiFiManager::disconnect();
+
+    for (int i = 0; i < 10; i++) {
+        delay(WIFI_TIMEOUT_MS);
+        WiFiManager::loop();
+    }
+    TEST_ASSERT_EQUAL(WIFI_STATE_IDLE, WiFiManager::getState());
+    TEST_ASSERT_EQUAL(1, fakeRadio.beginCount);
+}
+#endif
+
+void setUp(void) {
+    // Set up test environment
+#ifndef ARDUINO
+    fakeRadio.reset();
+    WiFiManager::setRadio(&fakeRadio);
+    NativeClock::set(0);
+#endif
+}
+
+void tearDown(void) {
+    // Clean up after tests
+}
+
+int runUnityTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_wifi_init);
+    RUN_TEST(test_wifi_mac_address);
+    RUN_TEST(test_wifi_connection_state);
+    RUN_TEST(test_wifi_ip_disconnected);
+    RUN_TEST(test_wifi_ssid_disconnected);
+    RUN_TEST(test_wifi_rssi_disconnected);
+#ifndef ARDUINO
+    RUN_TEST(test_wifi_connect_is_non_blocking);
+    RUN_TEST(test_wifi_connecting_to_connected);
+    RUN_TEST(test_wifi_got_ip_event);
+    RUN_TEST(test_wifi_timeout_enters_backoff);
+    RUN_TEST(test_wifi_backoff_retries_after_delay);
+    RUN_TEST(test_wifi_backoff_grows_and_caps);
+    RUN_TEST(test_wifi_link_failure_skips_timeout);
+    RUN_TEST(test_wifi_connection_lost_reconnects);
+    RUN_TEST(test_wifi_connect_during_backoff);
+    RUN_TEST(test_wifi_disconnect_stops_reconnecting);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    delay(2000); // Wait for serial
+    runUnityTests();
+}
+
+void loop() {
+    // Nothing to do in loop for tests
+}
+#else
+int main() {
+    return runUnityTests();
+}
+#endif